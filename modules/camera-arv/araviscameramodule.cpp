@@ -20,11 +20,11 @@
 #include "araviscameramodule.h"
 
 #include "datactl/frametype.h"
-#include "datactl/vipsutils.h"
 #include <arv.h>
 #include <QDebug>
 
 #include "configwindow.h"
+#include "framestage.h"
 
 SYNTALOS_MODULE(AravisCameraModule)
 
@@ -40,6 +40,7 @@ private:
     std::shared_ptr<QArvCamera> m_camera;
     std::shared_ptr<QArvDecoder> m_decoder;
     TransformParams *m_tfParams;
+    FrameStage m_frameStage;
 
 public:
     explicit AravisCameraModule(AravisCameraModuleInfo *modInfo, QObject *parent = nullptr)
@@ -108,8 +109,12 @@ public:
         m_tfParams = m_configWindow->currentTransformParams();
 
         const auto roi = m_camera->getROI();
+        m_frameStage.setInputFormat(m_camera->getPixelFormatId(), roi.width(), roi.height());
+        m_frameStage.setTransform(m_tfParams->invert, m_tfParams->flip, m_tfParams->rot);
+
         // set the required stream metadata for video capture
-        m_outStream->setMetadataValue("size", QSize(roi.width(), roi.height()));
+        m_outStream->setMetadataValue(
+            "size", QSize(m_frameStage.outputWidth(), m_frameStage.outputHeight()));
         m_outStream->setMetadataValue("framerate", m_camera->getFPS());
 
         // start the stream
@@ -157,47 +162,30 @@ public:
             auto masterTime = std::chrono::duration_cast<microseconds_t>(
                 nanoseconds_t(frameSysTimeNs + offsetToMaster.count()));
 
-            QByteArray frame;
             size_t size;
-            const void *data;
-            data = arv_buffer_get_data(buffer, &size);
-            frame = QByteArray::fromRawData(static_cast<const char *>(data), size);
-
+            const void *data = arv_buffer_get_data(buffer, &size);
             if (m_decoder) {
-                if (frame.isEmpty())
+                if (data == nullptr || size == 0)
                     return;
 
                 clockSync->processTimestamp(
                     masterTime, std::chrono::duration_cast<microseconds_t>(nanoseconds_t(frameDevTimeNs)));
 
-                m_decoder->decode(frame);
-                cv::Mat img = m_decoder->getCvImage();
-
-                if (m_tfParams->invert) {
-                    int bits = img.depth() == CV_8U ? 8 : 16;
-                    cv::subtract((1 << bits) - 1, img, img);
-                }
-
-                if (m_tfParams->flip != -100)
-                    cv::flip(img, img, m_tfParams->flip);
-
-                switch (m_tfParams->rot) {
-                case 1:
-                    cv::transpose(img, img);
-                    cv::flip(img, img, 0);
-                    break;
+                // the transformation may be changed in the settings while we are running
+                m_frameStage.setTransform(m_tfParams->invert, m_tfParams->flip, m_tfParams->rot);
 
-                case 2:
-                    cv::flip(img, img, -1);
-                    break;
-
-                case 3:
-                    cv::transpose(img, img);
-                    cv::flip(img, img, 1);
-                    break;
+                // decode, transform and convert the frame in as few passes as possible
+                vips::VImage image;
+                if (m_frameStage.canProcessRaw()) {
+                    image = m_frameStage.processRaw(data, size);
+                } else {
+                    m_decoder->decode(QByteArray::fromRawData(static_cast<const char *>(data), size));
+                    image = m_frameStage.process(m_decoder->getCvImage());
                 }
+                if (image.is_null())
+                    return;
 
-                Frame syFrame(cvMatToVips(img), frameCount, usecToMsec(masterTime));
+                Frame syFrame(image, frameCount, usecToMsec(masterTime));
                 m_outStream->push(syFrame);
                 frameCount++;
             }
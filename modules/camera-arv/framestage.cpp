@@ -0,0 +1,440 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "framestage.h"
+
+#include <opencv2/imgproc.hpp>
+
+// output tile size, so rotated images are read in a cache-friendly pattern
+static constexpr int TILE_ROWS = 16;
+static constexpr int TILE_COLS = 64;
+
+/**
+ * Copy pixels from src to dst, with the source position of each output pixel
+ * determined by the source map. Inverts by XOR'ing with mask, left-shifts single-channel
+ * pixels by shift bits and optionally swaps the R and B channel.
+ */
+template<typename T, int SrcCn, bool SwapRB>
+static void orientKernel(
+    const uchar *src,
+    ptrdiff_t offset,
+    ptrdiff_t stepX,
+    ptrdiff_t stepY,
+    T *dst,
+    int outW,
+    int outH,
+    T mask,
+    int shift)
+{
+    constexpr int DstCn = SrcCn == 1 ? 1 : 3;
+    const int tileRowCount = (outH + TILE_ROWS - 1) / TILE_ROWS;
+
+    cv::parallel_for_(cv::Range(0, tileRowCount), [&](const cv::Range &range) {
+        for (int tile = range.start; tile < range.end; tile++) {
+            const int rowStart = tile * TILE_ROWS;
+            const int rowEnd = std::min(outH, rowStart + TILE_ROWS);
+
+            for (int colStart = 0; colStart < outW; colStart += TILE_COLS) {
+                const int colEnd = std::min(outW, colStart + TILE_COLS);
+
+                for (int oy = rowStart; oy < rowEnd; oy++) {
+                    const uchar *s = src + offset + oy * stepY + colStart * stepX;
+                    T *d = dst + (static_cast<size_t>(oy) * outW + colStart) * DstCn;
+
+                    for (int ox = colStart; ox < colEnd; ox++) {
+                        const auto px = reinterpret_cast<const T *>(s);
+                        if constexpr (SrcCn == 1) {
+                            d[0] = static_cast<T>(static_cast<T>(px[0] << shift) ^ mask);
+                        } else {
+                            d[0] = static_cast<T>(px[SwapRB ? 2 : 0] ^ mask);
+                            d[1] = static_cast<T>(px[1] ^ mask);
+                            d[2] = static_cast<T>(px[SwapRB ? 0 : 2] ^ mask);
+                        }
+
+                        d += DstCn;
+                        s += stepX;
+                    }
+                }
+            }
+        }
+    });
+}
+
+template<typename T, int SrcCn>
+static void orientKernelDispatchSwap(
+    bool swapRB,
+    const uchar *src,
+    ptrdiff_t offset,
+    ptrdiff_t stepX,
+    ptrdiff_t stepY,
+    T *dst,
+    int outW,
+    int outH,
+    T mask,
+    int shift)
+{
+    if (swapRB)
+        orientKernel<T, SrcCn, true>(src, offset, stepX, stepY, dst, outW, outH, mask, shift);
+    else
+        orientKernel<T, SrcCn, false>(src, offset, stepX, stepY, dst, outW, outH, mask, shift);
+}
+
+template<typename T>
+static void orientKernelDispatch(
+    int srcChannels,
+    bool swapRB,
+    const uchar *src,
+    ptrdiff_t offset,
+    ptrdiff_t stepX,
+    ptrdiff_t stepY,
+    T *dst,
+    int outW,
+    int outH,
+    T mask,
+    int shift)
+{
+    switch (srcChannels) {
+    case 1:
+        orientKernel<T, 1, false>(src, offset, stepX, stepY, dst, outW, outH, mask, shift);
+        break;
+    case 3:
+        orientKernelDispatchSwap<T, 3>(swapRB, src, offset, stepX, stepY, dst, outW, outH, mask, shift);
+        break;
+    case 4:
+        orientKernelDispatchSwap<T, 4>(swapRB, src, offset, stepX, stepY, dst, outW, outH, mask, shift);
+        break;
+    default:
+        throw vips::VError("Unsupported channel count for camera frame");
+    }
+}
+
+FrameStage::FrameStage()
+    : m_rawKind(RawKind::NONE),
+      m_bayerCode(-1),
+      m_shift(0),
+      m_width(0),
+      m_height(0),
+      m_invert(false),
+      m_flip(-100),
+      m_rot(0)
+{
+}
+
+void FrameStage::setInputFormat(ArvPixelFormat pixelFormat, int width, int height)
+{
+    m_width = width;
+    m_height = height;
+    m_rawKind = RawKind::NONE;
+    m_bayerCode = -1;
+    m_shift = 0;
+
+    // the shifts match what MonoUnpackedDecoder does, Bayer patterns map
+    // to the same OpenCV conversion BayerDecoder uses, but with RGB output
+    switch (pixelFormat) {
+    case ARV_PIXEL_FORMAT_MONO_8:
+        m_rawKind = RawKind::MONO8;
+        break;
+    case ARV_PIXEL_FORMAT_MONO_10:
+        m_rawKind = RawKind::MONO16;
+        m_shift = 6;
+        break;
+    case ARV_PIXEL_FORMAT_MONO_12:
+        m_rawKind = RawKind::MONO16;
+        m_shift = 4;
+        break;
+    case ARV_PIXEL_FORMAT_MONO_14:
+        m_rawKind = RawKind::MONO16;
+        m_shift = 2;
+        break;
+    case ARV_PIXEL_FORMAT_MONO_16:
+        m_rawKind = RawKind::MONO16;
+        break;
+
+    case ARV_PIXEL_FORMAT_RGB_8_PACKED:
+        m_rawKind = RawKind::RGB8;
+        break;
+    case ARV_PIXEL_FORMAT_BGR_8_PACKED:
+        m_rawKind = RawKind::BGR8;
+        break;
+    case ARV_PIXEL_FORMAT_RGBA_8_PACKED:
+        m_rawKind = RawKind::RGBA8;
+        break;
+    case ARV_PIXEL_FORMAT_BGRA_8_PACKED:
+        m_rawKind = RawKind::BGRA8;
+        break;
+
+    case ARV_PIXEL_FORMAT_BAYER_GR_8:
+        m_rawKind = RawKind::BAYER8;
+        m_bayerCode = cv::COLOR_BayerGB2RGB;
+        break;
+    case ARV_PIXEL_FORMAT_BAYER_RG_8:
+        m_rawKind = RawKind::BAYER8;
+        m_bayerCode = cv::COLOR_BayerBG2RGB;
+        break;
+    case ARV_PIXEL_FORMAT_BAYER_GB_8:
+        m_rawKind = RawKind::BAYER8;
+        m_bayerCode = cv::COLOR_BayerGR2RGB;
+        break;
+    case ARV_PIXEL_FORMAT_BAYER_BG_8:
+        m_rawKind = RawKind::BAYER8;
+        m_bayerCode = cv::COLOR_BayerRG2RGB;
+        break;
+
+#ifdef ARV_PIXEL_FORMAT_BAYER_GR_16
+    case ARV_PIXEL_FORMAT_BAYER_GR_16:
+        m_rawKind = RawKind::BAYER16;
+        m_bayerCode = cv::COLOR_BayerGB2RGB;
+        break;
+    case ARV_PIXEL_FORMAT_BAYER_RG_16:
+        m_rawKind = RawKind::BAYER16;
+        m_bayerCode = cv::COLOR_BayerBG2RGB;
+        break;
+    case ARV_PIXEL_FORMAT_BAYER_GB_16:
+        m_rawKind = RawKind::BAYER16;
+        m_bayerCode = cv::COLOR_BayerGR2RGB;
+        break;
+    case ARV_PIXEL_FORMAT_BAYER_BG_16:
+        m_rawKind = RawKind::BAYER16;
+        m_bayerCode = cv::COLOR_BayerRG2RGB;
+        break;
+#endif
+
+    default:
+        // everything else has to go through a decoder first
+        break;
+    }
+}
+
+void FrameStage::setTransform(bool invert, int flip, int rot)
+{
+    m_invert = invert;
+    m_flip = flip;
+    m_rot = ((rot % 4) + 4) % 4;
+}
+
+bool FrameStage::canProcessRaw() const
+{
+    return m_rawKind != RawKind::NONE;
+}
+
+int FrameStage::outputWidth() const
+{
+    return (m_rot % 2 == 0) ? m_width : m_height;
+}
+
+int FrameStage::outputHeight() const
+{
+    return (m_rot % 2 == 0) ? m_height : m_width;
+}
+
+bool FrameStage::isIdentity() const
+{
+    return !m_invert && m_flip == -100 && m_rot == 0;
+}
+
+FrameStage::SourceMap FrameStage::sourceMap(int width, int height, size_t pixBytes, size_t stride) const
+{
+    // source coordinates as affine function of the output coordinates:
+    // sx = ax * ox + bx * oy + cx, sy = ay * ox + by * oy + cy
+    // This matches a cv::flip() with the flip code, followed by the rotation.
+    ptrdiff_t ax = 1, bx = 0, cx = 0;
+    ptrdiff_t ay = 0, by = 1, cy = 0;
+    switch (m_rot) {
+    case 1:
+        // transpose, then flip around the x-axis
+        ax = 0, bx = -1, cx = width - 1;
+        ay = 1, by = 0, cy = 0;
+        break;
+    case 2:
+        ax = -1, bx = 0, cx = width - 1;
+        ay = 0, by = -1, cy = height - 1;
+        break;
+    case 3:
+        // transpose, then flip around the y-axis
+        ax = 0, bx = 1, cx = 0;
+        ay = -1, by = 0, cy = height - 1;
+        break;
+    }
+
+    const bool flipX = m_flip != -100 && m_flip != 0;
+    const bool flipY = m_flip != -100 && m_flip <= 0;
+    if (flipX) {
+        ax = -ax;
+        bx = -bx;
+        cx = width - 1 - cx;
+    }
+    if (flipY) {
+        ay = -ay;
+        by = -by;
+        cy = height - 1 - cy;
+    }
+
+    const auto pix = static_cast<ptrdiff_t>(pixBytes);
+    const auto row = static_cast<ptrdiff_t>(stride);
+    return SourceMap{cx * pix + cy * row, ax * pix + ay * row, bx * pix + by * row};
+}
+
+std::shared_ptr<Syntalos::FrameBufferPool> FrameStage::poolFor(size_t size)
+{
+    // share buffers with all other producers of equally sized frames in this process,
+    // we only remember the pool to avoid looking it up for every frame
+    if (!m_pool || m_pool->bufferSize() != size)
+        m_pool = Syntalos::FrameBufferPool::shared(size);
+    return m_pool;
+}
+
+vips::VImage FrameStage::orient(
+    const uchar *src,
+    int width,
+    int height,
+    size_t stride,
+    int depth,
+    int srcChannels,
+    bool swapRB,
+    int shift)
+{
+    const bool is16Bit = depth == CV_16U;
+    if (!is16Bit && depth != CV_8U)
+        throw vips::VError("Unsupported pixel depth for camera frame");
+
+    const int outChannels = srcChannels == 1 ? 1 : 3;
+    const int outW = (m_rot % 2 == 0) ? width : height;
+    const int outH = (m_rot % 2 == 0) ? height : width;
+    const size_t elemSize = is16Bit ? 2 : 1;
+
+    auto pool = poolFor(static_cast<size_t>(outW) * outH * outChannels * elemSize);
+    auto buffer = pool->acquire();
+
+    const auto map = sourceMap(width, height, srcChannels * elemSize, stride);
+    if (is16Bit)
+        orientKernelDispatch<uint16_t>(
+            srcChannels,
+            swapRB,
+            src,
+            map.offset,
+            map.stepX,
+            map.stepY,
+            static_cast<uint16_t *>(buffer),
+            outW,
+            outH,
+            m_invert ? 0xFFFF : 0,
+            shift);
+    else
+        orientKernelDispatch<uint8_t>(
+            srcChannels,
+            swapRB,
+            src,
+            map.offset,
+            map.stepX,
+            map.stepY,
+            static_cast<uint8_t *>(buffer),
+            outW,
+            outH,
+            m_invert ? 0xFF : 0,
+            shift);
+
+    auto vimg = pool->wrapImage(buffer, outW, outH, outChannels, is16Bit ? VIPS_FORMAT_USHORT : VIPS_FORMAT_UCHAR);
+    if (outChannels == 3)
+        vimg.set("interpretation", VIPS_INTERPRETATION_RGB);
+    return vimg;
+}
+
+vips::VImage FrameStage::processRaw(const void *data, size_t size)
+{
+    const auto pixCount = static_cast<size_t>(m_width) * m_height;
+    const auto src = static_cast<const uchar *>(data);
+
+    switch (m_rawKind) {
+    case RawKind::MONO8:
+        if (size < pixCount)
+            return {};
+        return orient(src, m_width, m_height, m_width, CV_8U, 1, false, 0);
+    case RawKind::MONO16:
+        if (size < pixCount * 2)
+            return {};
+        return orient(src, m_width, m_height, m_width * 2, CV_16U, 1, false, m_shift);
+    case RawKind::RGB8:
+    case RawKind::BGR8:
+        if (size < pixCount * 3)
+            return {};
+        return orient(src, m_width, m_height, m_width * 3, CV_8U, 3, m_rawKind == RawKind::BGR8, 0);
+    case RawKind::RGBA8:
+    case RawKind::BGRA8:
+        if (size < pixCount * 4)
+            return {};
+        return orient(src, m_width, m_height, m_width * 4, CV_8U, 4, m_rawKind == RawKind::BGRA8, 0);
+    case RawKind::BAYER8:
+    case RawKind::BAYER16:
+        break;
+    case RawKind::NONE:
+        throw vips::VError("Pixel format can not be processed without a decoder");
+    }
+
+    // Demosaicing needs a pixel neighborhood and can't be fused with reorienting,
+    // but we can at least let OpenCV write its output directly into a pooled buffer
+    // if there is nothing else to do.
+    const bool is16Bit = m_rawKind == RawKind::BAYER16;
+    if (size < pixCount * (is16Bit ? 2 : 1))
+        return {};
+    const cv::Mat raw(m_height, m_width, is16Bit ? CV_16UC1 : CV_8UC1, const_cast<uchar *>(src));
+
+    if (isIdentity()) {
+        auto pool = poolFor(pixCount * 3 * (is16Bit ? 2 : 1));
+        auto buffer = pool->acquire();
+        cv::Mat rgb(m_height, m_width, is16Bit ? CV_16UC3 : CV_8UC3, buffer);
+        try {
+            cv::cvtColor(raw, rgb, m_bayerCode);
+        } catch (const cv::Exception &) {
+            pool->release(buffer);
+            throw;
+        }
+
+        auto vimg = pool->wrapImage(buffer, m_width, m_height, 3, is16Bit ? VIPS_FORMAT_USHORT : VIPS_FORMAT_UCHAR);
+        vimg.set("interpretation", VIPS_INTERPRETATION_RGB);
+        return vimg;
+    }
+
+    cv::cvtColor(raw, m_demosaiced, m_bayerCode);
+    return orient(
+        m_demosaiced.data,
+        m_width,
+        m_height,
+        m_demosaiced.step,
+        is16Bit ? CV_16U : CV_8U,
+        3,
+        false,
+        0);
+}
+
+vips::VImage FrameStage::process(const cv::Mat &decoded)
+{
+    if (decoded.empty())
+        return {};
+
+    // decoders produce BGR images, we want RGB
+    return orient(
+        decoded.data,
+        decoded.cols,
+        decoded.rows,
+        decoded.step,
+        decoded.depth(),
+        decoded.channels(),
+        decoded.channels() >= 3,
+        0);
+}
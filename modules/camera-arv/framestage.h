@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <arv.h>
+#include <memory>
+#include <opencv2/core.hpp>
+
+#include "datactl/framebufferpool.h"
+#include "datactl/vips8-q.h"
+
+/**
+ * @brief Turns camera buffers into correctly oriented RGB/grayscale images
+ *
+ * Inverts, flips and rotates a frame and brings it into RGB channel order
+ * in a single pass, writing straight into pooled memory that the resulting
+ * VImage references without any further copy.
+ *
+ * Mono and packed RGB/BGR pixel formats, as well as 8 and 16 bit Bayer formats,
+ * are read directly from the raw camera buffer. All other formats need to be decoded
+ * by a QArvDecoder first, and the decoded (BGR-ordered) image is passed to process().
+ */
+class FrameStage
+{
+public:
+    explicit FrameStage();
+
+    /**
+     * Set the pixel format and dimensions of incoming raw frames.
+     */
+    void setInputFormat(ArvPixelFormat pixelFormat, int width, int height);
+
+    /**
+     * Set the transformation to apply. The flip code follows cv::flip(),
+     * with -100 meaning no flip, and rot is the amount of 90° counter-clockwise rotations.
+     */
+    void setTransform(bool invert, int flip, int rot);
+
+    /**
+     * True if frames of the current input format can be processed from the
+     * raw camera data, without a QArvDecoder.
+     */
+    bool canProcessRaw() const;
+
+    /**
+     * Process a raw camera buffer. Returns an empty image if the buffer is too small.
+     */
+    vips::VImage processRaw(const void *data, size_t size);
+
+    /**
+     * Process a decoded, BGR-ordered image with CV_8U or CV_16U depth and 1 or 3 channels.
+     */
+    vips::VImage process(const cv::Mat &decoded);
+
+    int outputWidth() const;
+    int outputHeight() const;
+
+private:
+    enum class RawKind {
+        NONE,
+        MONO8,
+        MONO16,
+        RGB8,
+        BGR8,
+        RGBA8,
+        BGRA8,
+        BAYER8,
+        BAYER16
+    };
+
+    struct SourceMap {
+        ptrdiff_t offset;
+        ptrdiff_t stepX;
+        ptrdiff_t stepY;
+    };
+
+    SourceMap sourceMap(int width, int height, size_t pixBytes, size_t stride) const;
+    bool isIdentity() const;
+    vips::VImage orient(
+        const uchar *src,
+        int width,
+        int height,
+        size_t stride,
+        int depth,
+        int srcChannels,
+        bool swapRB,
+        int shift);
+    std::shared_ptr<Syntalos::FrameBufferPool> poolFor(size_t size);
+
+    RawKind m_rawKind;
+    int m_bayerCode;
+    int m_shift;
+    int m_width;
+    int m_height;
+
+    bool m_invert;
+    int m_flip;
+    int m_rot;
+
+    cv::Mat m_demosaiced;
+    std::shared_ptr<Syntalos::FrameBufferPool> m_pool;
+};
@@ -18,6 +18,7 @@
  */
 
 #include "mono12packed.h"
+#include "unpackkernels.h"
 
 using namespace QArv;
 
@@ -26,38 +27,9 @@ Mono12PackedDecoder::Mono12PackedDecoder(QSize size_) :
 
 
 void Mono12PackedDecoder::decode(QByteArray frame) {
-    const uchar* dta = reinterpret_cast<const uchar*>(frame.constData());
-    const int h = size.height(), w = size.width();
-
-    int line = 0;
-    auto linestart = M.ptr<uint16_t>(0);
-    int outcurrent = 0;
-    const uchar* inptr = dta;
-    uint16_t pixel;
-    uchar* bytes = reinterpret_cast<uchar*>(&pixel);
-    while (inptr < dta + frame.size()) {
-        bytes[0] = inptr[1] << 4;
-        bytes[1] = inptr[0];
-        linestart[outcurrent++] = pixel;
-
-        if (outcurrent == w) {
-            if (++line == h) break;
-            linestart = M.ptr<uint16_t>(line);
-            outcurrent = 0;
-        }
-
-        bytes[0] = inptr[1] & 0xF0;
-        bytes[1] = inptr[2];
-        linestart[outcurrent++] = pixel;
-
-        if (outcurrent == w) {
-            if (++line == h) break;
-            linestart = M.ptr<uint16_t>(line);
-            outcurrent = 0;
-        }
-
-        inptr += 3;
-    }
+    // M is continuous, so all lines can be unpacked in one go
+    Unpack::mono12Packed(reinterpret_cast<const uint8_t*>(frame.constData()),
+                         frame.size(), M.ptr<uint16_t>(0), M.total());
 }
 
 const cv::Mat Mono12PackedDecoder::getCvImage() {
@@ -20,8 +20,10 @@
 #ifndef MONOUNPACKED_H
 #define MONOUNPACKED_H
 
+#include <cstring>
 #include <type_traits>
 #include "../qarvdecoder.h"
+#include "unpackkernels.h"
 
 namespace QArv
 {
@@ -31,6 +33,8 @@ class MonoUnpackedDecoder : public QArvDecoder {
 
     static_assert(sizeof(InputType) <= sizeof(uint16_t),
                   "InputType too large.");
+    static_assert(!std::is_signed<InputType>::value || sizeof(InputType) == 1,
+                  "Only 8-bit signed input is supported.");
 
 private:
     QSize size;
@@ -41,7 +45,6 @@ private:
     static const int cvMatType = OutputIsChar ? CV_8UC1 : CV_16UC1;
     static const bool typeIsSigned = std::is_signed<InputType>::value;
     static const uint zeroBits = 8*sizeof(OutputType) - bitsPerPixel;
-    static const uint signedShiftBits = bitsPerPixel - 1;
 
 public:
     MonoUnpackedDecoder(QSize size_) :
@@ -59,20 +62,17 @@ public:
     int cvType() override { return cvMatType; };
 
     void decode(QByteArray frame) override {
+        // M is continuous, so all lines can be converted in one go
+        const size_t pixels = std::min<size_t>(M.total(),
+                                               frame.size() / sizeof(InputType));
         const InputType* dta =
             reinterpret_cast<const InputType*>(frame.constData());
-        const int h = size.height(), w = size.width();
-        for (int i = 0; i < h; i++) {
-            auto line = M.ptr<OutputType>(i);
-            for (int j = 0; j < w; j++) {
-                OutputType tmp;
-                if (typeIsSigned)
-                    tmp = dta[i * w + j] + (1<<signedShiftBits);
-                else
-                    tmp = dta[i * w + j];
-                line[j] = tmp << (zeroBits);
-            }
-        }
+        if constexpr (typeIsSigned)
+            Unpack::signedToUnsigned8(dta, M.ptr<uint8_t>(0), pixels);
+        else if constexpr (zeroBits == 0)
+            std::memcpy(M.data, dta, pixels * sizeof(OutputType));
+        else
+            Unpack::shiftLeft16(dta, M.ptr<uint16_t>(0), pixels, zeroBits);
     }
 
     const cv::Mat getCvImage() override {
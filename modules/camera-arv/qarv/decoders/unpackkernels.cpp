@@ -0,0 +1,290 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "unpackkernels.h"
+
+#include <algorithm>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define UNPACK_HAVE_X86 1
+#include <immintrin.h>
+#endif
+
+namespace QArv::Unpack
+{
+
+Isa bestIsa()
+{
+    static const Isa isa = []() {
+        if (isaSupported(Isa::AVX2))
+            return Isa::AVX2;
+        if (isaSupported(Isa::SSSE3))
+            return Isa::SSSE3;
+        return Isa::SCALAR;
+    }();
+    return isa;
+}
+
+bool isaSupported(Isa isa)
+{
+    switch (isa) {
+    case Isa::SCALAR:
+        return true;
+#ifdef UNPACK_HAVE_X86
+    case Isa::SSSE3:
+        return __builtin_cpu_supports("ssse3");
+    case Isa::AVX2:
+        return __builtin_cpu_supports("avx2");
+#endif
+    default:
+        return false;
+    }
+}
+
+const char *isaName(Isa isa)
+{
+    switch (isa) {
+    case Isa::SCALAR:
+        return "scalar";
+    case Isa::SSSE3:
+        return "SSSE3";
+    case Isa::AVX2:
+        return "AVX2";
+    }
+    return "unknown";
+}
+
+/*
+ * Scalar reference implementations, which also handle the tails
+ * the vectorized kernels leave over.
+ */
+
+static void mono12PackedScalar(const uint8_t *src, uint16_t *dst, size_t begin, size_t end)
+{
+    // begin must be even, so it points at the start of a byte triplet
+    for (size_t i = begin; i < end; i += 2) {
+        const uint8_t *p = src + (i / 2) * 3;
+        dst[i] = static_cast<uint16_t>((p[0] << 8) | ((p[1] << 4) & 0xF0));
+        if (i + 1 < end)
+            dst[i + 1] = static_cast<uint16_t>((p[2] << 8) | (p[1] & 0xF0));
+    }
+}
+
+static void shiftLeft16Scalar(const uint16_t *src, uint16_t *dst, size_t begin, size_t end, unsigned int shift)
+{
+    for (size_t i = begin; i < end; i++)
+        dst[i] = static_cast<uint16_t>(src[i] << shift);
+}
+
+static void signedToUnsigned8Scalar(const int8_t *src, uint8_t *dst, size_t begin, size_t end)
+{
+    for (size_t i = begin; i < end; i++)
+        dst[i] = static_cast<uint8_t>(src[i]) ^ 0x80;
+}
+
+#ifdef UNPACK_HAVE_X86
+
+/*
+ * Mono12Packed: For each pixel, shuffle its high byte and the shared middle byte
+ * of its triplet into one 16-bit lane. Even pixels take the lower nibble of the
+ * middle byte, odd pixels the upper one.
+ */
+
+__attribute__((target("ssse3"))) static size_t mono12PackedSsse3(
+    const uint8_t *src,
+    size_t srcSize,
+    uint16_t *dst,
+    size_t pixels)
+{
+    const __m128i shuffle = _mm_setr_epi8(1, 0, 1, 2, 4, 3, 4, 5, 7, 6, 7, 8, 10, 9, 10, 11);
+    const __m128i hiMask = _mm_set1_epi16(static_cast<short>(0xFF00));
+    const __m128i evenLoMask = _mm_setr_epi16(0x00F0, 0, 0x00F0, 0, 0x00F0, 0, 0x00F0, 0);
+    const __m128i oddLoMask = _mm_setr_epi16(0, 0x00F0, 0, 0x00F0, 0, 0x00F0, 0, 0x00F0);
+
+    // 8 pixels from 12 bytes per iteration, but we load 16 bytes
+    size_t i = 0;
+    for (; i + 8 <= pixels && (i / 2) * 3 + 16 <= srcSize; i += 8) {
+        const auto in = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + (i / 2) * 3));
+        const auto w = _mm_shuffle_epi8(in, shuffle);
+        const auto even = _mm_and_si128(_mm_slli_epi16(w, 4), evenLoMask);
+        const auto odd = _mm_and_si128(w, oddLoMask);
+        const auto res = _mm_or_si128(_mm_and_si128(w, hiMask), _mm_or_si128(even, odd));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), res);
+    }
+
+    return i;
+}
+
+__attribute__((target("avx2"))) static size_t mono12PackedAvx2(
+    const uint8_t *src,
+    size_t srcSize,
+    uint16_t *dst,
+    size_t pixels)
+{
+    // vpshufb works within 128-bit lanes, so each lane gets its own 12 input bytes
+    const __m256i shuffle = _mm256_setr_epi8(
+        1, 0, 1, 2, 4, 3, 4, 5, 7, 6, 7, 8, 10, 9, 10, 11, 1, 0, 1, 2, 4, 3, 4, 5, 7, 6, 7, 8, 10, 9, 10, 11);
+    const __m256i hiMask = _mm256_set1_epi16(static_cast<short>(0xFF00));
+    const __m256i evenLoMask = _mm256_setr_epi16(
+        0x00F0, 0, 0x00F0, 0, 0x00F0, 0, 0x00F0, 0, 0x00F0, 0, 0x00F0, 0, 0x00F0, 0, 0x00F0, 0);
+    const __m256i oddLoMask = _mm256_setr_epi16(
+        0, 0x00F0, 0, 0x00F0, 0, 0x00F0, 0, 0x00F0, 0, 0x00F0, 0, 0x00F0, 0, 0x00F0, 0, 0x00F0);
+
+    // 16 pixels from 24 bytes per iteration, the upper lane loads bytes 12 to 28
+    size_t i = 0;
+    for (; i + 16 <= pixels && (i / 2) * 3 + 28 <= srcSize; i += 16) {
+        const uint8_t *p = src + (i / 2) * 3;
+        const auto in = _mm256_inserti128_si256(
+            _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p))),
+            _mm_loadu_si128(reinterpret_cast<const __m128i *>(p + 12)),
+            1);
+        const auto w = _mm256_shuffle_epi8(in, shuffle);
+        const auto even = _mm256_and_si256(_mm256_slli_epi16(w, 4), evenLoMask);
+        const auto odd = _mm256_and_si256(w, oddLoMask);
+        const auto res = _mm256_or_si256(_mm256_and_si256(w, hiMask), _mm256_or_si256(even, odd));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), res);
+    }
+
+    return i;
+}
+
+__attribute__((target("ssse3"))) static size_t shiftLeft16Ssse3(
+    const uint16_t *src,
+    uint16_t *dst,
+    size_t count,
+    unsigned int shift)
+{
+    const auto shiftCount = _mm_cvtsi32_si128(static_cast<int>(shift));
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_sll_epi16(v, shiftCount));
+    }
+
+    return i;
+}
+
+__attribute__((target("avx2"))) static size_t shiftLeft16Avx2(
+    const uint16_t *src,
+    uint16_t *dst,
+    size_t count,
+    unsigned int shift)
+{
+    const auto shiftCount = _mm_cvtsi32_si128(static_cast<int>(shift));
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_sll_epi16(v, shiftCount));
+    }
+
+    return i;
+}
+
+__attribute__((target("ssse3"))) static size_t signedToUnsigned8Ssse3(const int8_t *src, uint8_t *dst, size_t count)
+{
+    const auto signBit = _mm_set1_epi8(static_cast<char>(0x80));
+
+    size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        const auto v = _mm_loadu_si128(reinterpret_cast<const __m128i *>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(dst + i), _mm_xor_si128(v, signBit));
+    }
+
+    return i;
+}
+
+__attribute__((target("avx2"))) static size_t signedToUnsigned8Avx2(const int8_t *src, uint8_t *dst, size_t count)
+{
+    const auto signBit = _mm256_set1_epi8(static_cast<char>(0x80));
+
+    size_t i = 0;
+    for (; i + 32 <= count; i += 32) {
+        const auto v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst + i), _mm256_xor_si256(v, signBit));
+    }
+
+    return i;
+}
+
+#endif // UNPACK_HAVE_X86
+
+size_t mono12Packed(const uint8_t *src, size_t srcSize, uint16_t *dst, size_t maxPixels)
+{
+    return mono12Packed(src, srcSize, dst, maxPixels, bestIsa());
+}
+
+size_t mono12Packed(const uint8_t *src, size_t srcSize, uint16_t *dst, size_t maxPixels, Isa isa)
+{
+    const size_t pixels = std::min(maxPixels, (srcSize / 3) * 2);
+
+    size_t done = 0;
+#ifdef UNPACK_HAVE_X86
+    if (isa == Isa::AVX2)
+        done = mono12PackedAvx2(src, srcSize, dst, pixels);
+    else if (isa == Isa::SSSE3)
+        done = mono12PackedSsse3(src, srcSize, dst, pixels);
+#else
+    (void)isa;
+#endif
+    mono12PackedScalar(src, dst, done, pixels);
+
+    return pixels;
+}
+
+void shiftLeft16(const uint16_t *src, uint16_t *dst, size_t count, unsigned int shift)
+{
+    shiftLeft16(src, dst, count, shift, bestIsa());
+}
+
+void shiftLeft16(const uint16_t *src, uint16_t *dst, size_t count, unsigned int shift, Isa isa)
+{
+    size_t done = 0;
+#ifdef UNPACK_HAVE_X86
+    if (isa == Isa::AVX2)
+        done = shiftLeft16Avx2(src, dst, count, shift);
+    else if (isa == Isa::SSSE3)
+        done = shiftLeft16Ssse3(src, dst, count, shift);
+#else
+    (void)isa;
+#endif
+    shiftLeft16Scalar(src, dst, done, count, shift);
+}
+
+void signedToUnsigned8(const int8_t *src, uint8_t *dst, size_t count)
+{
+    signedToUnsigned8(src, dst, count, bestIsa());
+}
+
+void signedToUnsigned8(const int8_t *src, uint8_t *dst, size_t count, Isa isa)
+{
+    size_t done = 0;
+#ifdef UNPACK_HAVE_X86
+    if (isa == Isa::AVX2)
+        done = signedToUnsigned8Avx2(src, dst, count);
+    else if (isa == Isa::SSSE3)
+        done = signedToUnsigned8Ssse3(src, dst, count);
+#else
+    (void)isa;
+#endif
+    signedToUnsigned8Scalar(src, dst, done, count);
+}
+
+} // namespace QArv::Unpack
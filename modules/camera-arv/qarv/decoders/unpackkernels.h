@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Pixel unpacking kernels for the QArv decoders.
+ *
+ * Each kernel has a scalar implementation and vectorized variants, the best
+ * variant supported by the CPU we run on is selected at runtime. All variants
+ * produce exactly the same output.
+ */
+namespace QArv::Unpack
+{
+
+enum class Isa {
+    SCALAR,
+    SSSE3,
+    AVX2
+};
+
+//! Returns the best instruction set the kernels can use on this CPU.
+Isa bestIsa();
+
+//! Returns true if the kernels can use the given instruction set on this CPU.
+bool isaSupported(Isa isa);
+
+const char *isaName(Isa isa);
+
+/*!
+ * Unpacks GigE Vision Mono12Packed data (two pixels in three bytes) into
+ * 16-bit pixels, with the 12 significant bits in the most significant bits.
+ * Unpacks at most maxPixels pixels, and only complete byte triplets.
+ * Returns the number of pixels written.
+ */
+size_t mono12Packed(const uint8_t *src, size_t srcSize, uint16_t *dst, size_t maxPixels);
+size_t mono12Packed(const uint8_t *src, size_t srcSize, uint16_t *dst, size_t maxPixels, Isa isa);
+
+//! Shifts 16-bit pixels left by shift bits, to move their significant bits to the top.
+void shiftLeft16(const uint16_t *src, uint16_t *dst, size_t count, unsigned int shift);
+void shiftLeft16(const uint16_t *src, uint16_t *dst, size_t count, unsigned int shift, Isa isa);
+
+//! Converts signed 8-bit pixels to unsigned ones by offsetting them by 128.
+void signedToUnsigned8(const int8_t *src, uint8_t *dst, size_t count);
+void signedToUnsigned8(const int8_t *src, uint8_t *dst, size_t count, Isa isa);
+
+} // namespace QArv::Unpack
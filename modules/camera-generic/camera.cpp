@@ -314,6 +314,31 @@ void Camera::disconnect()
     d->connected = false;
 }
 
+bool Camera::isConnected() const
+{
+    return d->connected && !d->failed;
+}
+
+/**
+ * Discard frames the driver captured while nobody was reading from the camera,
+ * e.g. between two runs, as we would otherwise timestamp them with their read time.
+ */
+void Camera::dropQueuedFrames()
+{
+    if (!d->connected)
+        return;
+
+    // a queued frame is returned immediately, while we have to wait for a fresh one
+    const auto halfFrameInterval = microseconds_t(500 * 1000 / std::max(d->fps, 1));
+    for (uint i = 0; i < 32; i++) {
+        const auto grabStart = currentTimePoint();
+        if (!d->cam->grab())
+            break;
+        if (currentTimePoint() - grabStart > halfFrameInterval)
+            break;
+    }
+}
+
 QList<CameraPixelFormat> Camera::readPixelFormats()
 {
     QList<CameraPixelFormat> result;
@@ -350,6 +375,11 @@ void Camera::setPixelFormat(const CameraPixelFormat &pixFmt)
     d->captureFormat = pixFmt;
 }
 
+CameraPixelFormat Camera::pixelFormat() const
+{
+    return d->captureFormat;
+}
+
 bool Camera::recordFrame(Frame &frame, SecondaryClockSynchronizer *clockSync)
 {
     bool status = false;
@@ -372,6 +402,10 @@ bool Camera::recordFrame(Frame &frame, SecondaryClockSynchronizer *clockSync)
     try {
         cv::Mat mat;
         status = d->cam->retrieve(mat);
+
+        // the backend may hand us a buffer it will write the next frame into
+        if (cvMatIsShared(mat))
+            mat = mat.clone();
         frame.mat = cvMatToVips(mat);
     } catch (const cv::Exception &e) {
         status = false;
@@ -92,9 +92,12 @@ public:
 
     bool connect();
     void disconnect();
+    bool isConnected() const;
+    void dropQueuedFrames();
 
     QList<CameraPixelFormat> readPixelFormats();
     void setPixelFormat(const CameraPixelFormat &pixFmt);
+    CameraPixelFormat pixelFormat() const;
 
     bool recordFrame(Frame &frame, SecondaryClockSynchronizer *clockSync);
 
@@ -40,12 +40,18 @@ private:
 
     std::unique_ptr<SecondaryClockSynchronizer> m_clockSync;
 
+    // device & format the camera was connected with, the user may change them between runs
+    int m_connectedCamId;
+    unsigned int m_connectedFourcc;
+
 public:
     explicit GenericCameraModule(QObject *parent = nullptr)
         : AbstractModule(parent),
           m_camera(new Camera),
           m_camSettingsWindow(nullptr),
-          m_stopped(true)
+          m_stopped(true),
+          m_connectedCamId(-1),
+          m_connectedFourcc(0)
     {
         m_outStream = registerOutputPort<Frame>(QStringLiteral("video"), QStringLiteral("Video"));
 
@@ -74,7 +80,8 @@ public:
 
     ModuleFeatures features() const override
     {
-        return ModuleFeature::REALTIME | ModuleFeature::REQUEST_CPU_AFFINITY | ModuleFeature::SHOW_SETTINGS;
+        return ModuleFeature::REALTIME | ModuleFeature::REQUEST_CPU_AFFINITY | ModuleFeature::SHOW_SETTINGS
+               | ModuleFeature::PREPARE_CONCURRENT | ModuleFeature::KEEP_WARM;
     }
 
     bool prepare(const TestSubject &) override
@@ -84,15 +91,32 @@ public:
             return false;
         }
 
-        statusMessage("Connecting camera...");
-        m_camera->setResolution(m_camSettingsWindow->resolution());
-        if (!m_camera->connect()) {
-            raiseError(QStringLiteral("Unable to connect camera: %1").arg(m_camera->lastError()));
-            return false;
+        // we are prepared on a worker thread, so talk to the settings window in the main thread
+        cv::Size resolution;
+        runInMainThread([&]() {
+            resolution = m_camSettingsWindow->resolution();
+            m_fps = m_camSettingsWindow->framerate();
+            m_camSettingsWindow->setRunning(true);
+        });
+
+        const bool sameDevice = m_camera->camId() == m_connectedCamId
+                                && m_camera->pixelFormat().fourcc == m_connectedFourcc;
+        if (isWarmRun() && m_camera->isConnected() && sameDevice && m_camera->resolution() == resolution) {
+            // the camera stayed connected since the last run, we only need to get rid of old frames
+            statusMessage("Reusing connected camera...");
+            m_camera->dropQueuedFrames();
+        } else {
+            // opening the device can take a while, which is why we prepare concurrently
+            statusMessage("Connecting camera...");
+            m_camera->disconnect();
+            m_camera->setResolution(resolution);
+            if (!m_camera->connect()) {
+                raiseError(QStringLiteral("Unable to connect camera: %1").arg(m_camera->lastError()));
+                return false;
+            }
+            m_connectedCamId = m_camera->camId();
+            m_connectedFourcc = m_camera->pixelFormat().fourcc;
         }
-
-        m_camSettingsWindow->setRunning(true);
-        m_fps = m_camSettingsWindow->framerate();
         m_camera->setFramerate(m_fps);
 
         // set the required stream metadata for video capture
@@ -178,9 +202,21 @@ public:
         while (!m_stopped) {
         }
 
-        m_camera->disconnect();
         m_camSettingsWindow->setRunning(false);
         safeStopSynchronizer(m_clockSync);
+
+        // keep the device open if another run follows shortly
+        if (keepWarmAfterStop()) {
+            statusMessage("Camera kept connected for the next run.");
+            return;
+        }
+        m_camera->disconnect();
+        statusMessage("Camera disconnected.");
+    }
+
+    void coolDown() override
+    {
+        m_camera->disconnect();
         statusMessage("Camera disconnected.");
     }
 
@@ -19,10 +19,12 @@
 
 #include "tiscameramodule.h"
 
+#include "datactl/framebufferpool.h"
 #include "datactl/frametype.h"
 #include "utils/misc.h"
 #include <QDebug>
 #include <QMessageBox>
+#include <algorithm>
 #include <gst/app/gstappsink.h>
 #include <tcam-property-1.0.h>
 
@@ -52,6 +54,8 @@ private:
     double m_fps;
     QString m_imgFormat;
     std::atomic_bool m_deviceLost;
+    microseconds_t m_measuredPeriod{0};
+    microseconds_t m_measuredCycleTime{0};
 
 public:
     explicit TISCameraModule(QObject *parent = nullptr)
@@ -166,6 +170,27 @@ public:
         if (m_imgFormat.toUpper().startsWith("GRAY16"))
             m_outStream->setMetadataValue("depth", VIPS_FORMAT_USHORT);
 
+        // every frame is copied and timestamped once, which must be done well within a frame interval.
+        // We reserve the time 99% of all frames took in the previous run with the same frame rate
+        // with some headroom, or a quarter of the interval if we did not measure it yet. Threads may
+        // exceed the reservation if there is idle CPU time, so it only needs to cover what we absolutely
+        // have to get, and it never takes more than half of a CPU from other periodic threads.
+        if (m_fps > 0) {
+            const auto period = microseconds_t(static_cast<int64_t>(1000 * 1000 / m_fps));
+            if (period != m_measuredPeriod)
+                m_measuredCycleTime = microseconds_t(0);
+
+            auto runtime = period / 4;
+            if (m_measuredCycleTime.count() > 0)
+                runtime = std::clamp(m_measuredCycleTime * 3 / 2, microseconds_t(100), period / 2);
+            setPeriodicTiming({period, runtime, period});
+            m_measuredPeriod = period;
+        } else {
+            setPeriodicTiming(PeriodicThreadTiming());
+            m_measuredCycleTime = microseconds_t(0);
+            m_measuredPeriod = microseconds_t(0);
+        }
+
         // start the stream
         m_outStream->start();
         m_pipeline = m_ctlDialog->pipeline();
@@ -207,6 +232,14 @@ public:
             return;
         }
 
+        // copy frames into buffers of the shared frame pool, instead of allocating new memory for each one
+        const auto copyToPooledImage = [this](const void *data, int bands, VipsBandFormat format) {
+            const auto width = m_resolution.width();
+            const auto height = m_resolution.height();
+            const auto size = static_cast<size_t>(width) * height * bands * vips_format_sizeof(format);
+            return FrameBufferPool::shared(size)->copyImage(data, width, height, bands, format);
+        };
+
         while (m_running) {
             g_autoptr(GstSample) sample = nullptr;
             auto frameRecvTime = MTIMER_FUNC_TIMESTAMP(sample = gst_app_sink_pull_sample(m_appSink));
@@ -222,6 +255,7 @@ public:
                 continue;
             }
 
+            beginPeriodicCycle();
             const auto buffer = gst_sample_get_buffer(sample);
             GstMapInfo info;
 
@@ -234,13 +268,7 @@ public:
                 // create our frame and push it to subscribers
                 Frame frame;
                 if (g_strcmp0(format_str, "BGRx") == 0) {
-                    frame.mat = vips::VImage::new_from_memory_copy(
-                        info.data,
-                        m_resolution.width() * m_resolution.height() * 4,
-                        m_resolution.width(),
-                        m_resolution.height(),
-                        4,
-                        VIPS_FORMAT_UCHAR);
+                    frame.mat = copyToPooledImage(info.data, 4, VIPS_FORMAT_UCHAR);
 
                     // BGR to RGB
                     frame.mat = frame.mat.bandjoin({
@@ -249,21 +277,9 @@ public:
                         frame.mat[0]  // Blue channel
                     });
                 } else if (g_strcmp0(format_str, "GRAY8") == 0) {
-                    frame.mat = vips::VImage::new_from_memory_copy(
-                        info.data,
-                        m_resolution.width() * m_resolution.height(),
-                        m_resolution.width(),
-                        m_resolution.height(),
-                        1,
-                        VIPS_FORMAT_UCHAR);
+                    frame.mat = copyToPooledImage(info.data, 1, VIPS_FORMAT_UCHAR);
                 } else if (g_strcmp0(format_str, "GRAY16_LE") == 0) {
-                    frame.mat = vips::VImage::new_from_memory_copy(
-                        info.data,
-                        m_resolution.width() * m_resolution.height(),
-                        m_resolution.width(),
-                        m_resolution.height(),
-                        1,
-                        VIPS_FORMAT_USHORT);
+                    frame.mat = copyToPooledImage(info.data, 1, VIPS_FORMAT_USHORT);
                 } else {
                     qCDebug(logTISCam).noquote().nospace() << QString::fromStdString(m_device.str()) << ": "
                                                            << "Received buffer with unsupported format: " << format_str;
@@ -291,7 +307,9 @@ public:
 
             // unmap our buffer - all other resources are cleaned up automatically
             gst_buffer_unmap(buffer, &info);
+            endPeriodicCycle();
         }
+        m_measuredCycleTime = periodicThreadStats().p99CycleTime;
 
         if (!m_deviceLost) {
             gst_element_set_state(m_pipeline, GST_STATE_PAUSED);
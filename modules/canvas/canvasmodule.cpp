@@ -86,6 +86,8 @@ public:
         m_blackOutCount = 0;
         m_paused = false;
 
+        m_cvView->setOwnerName(name());
+
         return true;
     }
 
@@ -195,7 +197,7 @@ public:
 
         // get all timing info and show the image
         const auto frame = maybeFrame.value();
-        m_cvView->showImage(frame.mat.copy_memory());
+        m_cvView->showImage(frame.mat);
         const auto frameTime = frame.time.count();
 
         if (m_expectedFps == 0) {
@@ -256,6 +256,11 @@ void CanvasWindow::setStatusText(const QString &text)
     m_statusLabel->setText(text);
 }
 
+void CanvasWindow::setOwnerName(const QString &name)
+{
+    m_imgView->setOwnerName(name);
+}
+
 bool CanvasWindow::highlightSaturation() const
 {
     return m_imgView->highlightSaturation();
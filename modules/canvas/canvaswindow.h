@@ -37,6 +37,7 @@ public:
 
     void showImage(const vips::VImage &image);
     void setStatusText(const QString &text);
+    void setOwnerName(const QString &name);
 
     bool highlightSaturation() const;
     void setHighlightSaturation(bool enabled);
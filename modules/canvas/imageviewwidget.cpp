@@ -21,10 +21,18 @@
 
 #include <QDebug>
 #include <QMessageBox>
+#include <QOpenGLContext>
 #include <QOpenGLTexture>
 #include <QOpenGLShaderProgram>
 #include <QOpenGLBuffer>
 #include <QOpenGLVertexArrayObject>
+#include <atomic>
+#include <pthread.h>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "datactl/vipsbudget.h"
 
 #if defined(QT_OPENGL_ES)
 #define USE_GLES 1
@@ -81,16 +89,35 @@ static const char *fragmentShaderSource =
     "    }\n"
     "}\n";
 
+/**
+ * @brief A frame that was converted to 8-bit RGB and scaled for display
+ */
+struct PreparedFrame {
+    vips::VImage origImage;
+    vips::VImage rgbImage;
+};
+
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wpadded"
 class ImageViewWidget::Private
 {
 public:
-    Private() {}
+    Private()
+        : running(false),
+          hasPending(false),
+          hasPrepared(false),
+          viewWidth(0),
+          viewHeight(0),
+          texWidth(0),
+          texHeight(0),
+          pboIndex(0),
+          glInitialized(false),
+          canMapBuffers(false)
+    {
+    }
     ~Private() {}
 
     QVector4D bgColorVec;
-    vips::VImage rgbImage;
     vips::VImage origImage;
 
     bool highlightSaturation;
@@ -99,9 +126,63 @@ public:
     QOpenGLBuffer vbo;
     std::unique_ptr<QOpenGLTexture> matTex;
     QOpenGLShaderProgram shaderProgram;
+
+    // frame preparation worker
+    std::thread prepThread;
+    std::atomic_bool running;
+    std::mutex mutex;
+    std::condition_variable cond;
+    vips::VImage pendingImage;
+    bool hasPending;
+    QString ownerName;
+    PreparedFrame preparedFrame;
+    bool hasPrepared;
+
+    // size of the view in device pixels, frames are downscaled to this size
+    std::atomic_int viewWidth;
+    std::atomic_int viewHeight;
+
+    // persistent texture & pixel buffers for streaming uploads
+    int texWidth;
+    int texHeight;
+    QOpenGLBuffer pbos[2];
+    uint pboIndex;
+
+    bool glInitialized;
+    bool canMapBuffers;
 };
 #pragma GCC diagnostic pop
 
+/**
+ * @brief Convert an image into something we can directly upload as texture.
+ *
+ * This converts the image to 8-bit sRGB and downscales it to fit the given view
+ * size, if the image is larger. The result is fully evaluated into memory, so no
+ * more expensive work needs to happen on the GUI thread.
+ */
+static vips::VImage prepareImageForDisplay(const vips::VImage &image, int viewWidth, int viewHeight)
+{
+    auto rgbImage = image;
+    if (rgbImage.format() != VIPS_FORMAT_UCHAR)
+        rgbImage = rgbImage.cast(VIPS_FORMAT_UCHAR, vips::VImage::option()->set("shift", true));
+    const auto interpretation = rgbImage.interpretation();
+    rgbImage = (interpretation == VIPS_INTERPRETATION_sRGB || interpretation == VIPS_INTERPRETATION_RGB)
+                   ? rgbImage
+                   : rgbImage.colourspace(VIPS_INTERPRETATION_sRGB);
+    if (rgbImage.bands() != 3)
+        rgbImage = rgbImage.extract_band(0, vips::VImage::option()->set("n", 3));
+
+    // there is no point in uploading more pixels than we can show
+    if (viewWidth > 0 && viewHeight > 0) {
+        const double scale = std::min(
+            static_cast<double>(viewWidth) / rgbImage.width(), static_cast<double>(viewHeight) / rgbImage.height());
+        if (scale < 1.0)
+            rgbImage = rgbImage.resize(scale, vips::VImage::option()->set("kernel", VIPS_KERNEL_LINEAR));
+    }
+
+    return rgbImage.copy_memory();
+}
+
 ImageViewWidget::ImageViewWidget(QWidget *parent)
     : QOpenGLWidget(parent),
       d(new ImageViewWidget::Private)
@@ -111,12 +192,76 @@ ImageViewWidget::ImageViewWidget(QWidget *parent)
     setWindowTitle("Video");
 
     setMinimumSize(QSize(320, 256));
+
+    // thread to convert & scale frames for display, so the GUI thread only needs to upload them
+    d->running = true;
+    d->prepThread = std::thread([this]() {
+        pthread_setname_np(pthread_self(), "canvas_prep");
+
+        QString ownerName;
+        while (d->running) {
+            vips::VImage image;
+            {
+                std::unique_lock<std::mutex> lock(d->mutex);
+                d->cond.wait(lock, [&] {
+                    return d->hasPending || !d->running;
+                });
+                if (!d->running)
+                    break;
+                image = d->pendingImage;
+                d->pendingImage = vips::VImage();
+                d->hasPending = false;
+                ownerName = d->ownerName;
+            }
+
+            PreparedFrame frame;
+            try {
+                Syntalos::VipsEvalGuard vipsGuard(ownerName, Syntalos::VipsEvalPriority::DISPLAY);
+                frame.origImage = image.copy_memory();
+                frame.rgbImage = prepareImageForDisplay(frame.origImage, d->viewWidth, d->viewHeight);
+            } catch (const vips::VError &e) {
+                qWarning().noquote() << "Unable to prepare image for display:" << e.what();
+                continue;
+            }
+
+            {
+                std::lock_guard<std::mutex> lock(d->mutex);
+                // if the GUI didn't pick up the previous frame yet, it is simply replaced
+                d->preparedFrame = frame;
+                d->hasPrepared = true;
+            }
+
+            QMetaObject::invokeMethod(
+                this,
+                [this]() {
+                    update();
+                },
+                Qt::QueuedConnection);
+        }
+    });
 }
 
 ImageViewWidget::~ImageViewWidget()
 {
+    {
+        std::lock_guard<std::mutex> lock(d->mutex);
+        d->running = false;
+    }
+    d->cond.notify_all();
+    if (d->prepThread.joinable())
+        d->prepThread.join();
+
+    // nothing to clean up if we were never shown
+    if (!d->glInitialized)
+        return;
+
+    makeCurrent();
+    d->matTex.reset();
+    for (auto &pbo : d->pbos)
+        pbo.destroy();
     d->vao.destroy();
     d->vbo.destroy();
+    doneCurrent();
 }
 
 void ImageViewWidget::initializeGL()
@@ -174,6 +319,32 @@ void ImageViewWidget::initializeGL()
 
     d->vbo.release();
     d->vao.release();
+
+    // mapping buffer ranges needs OpenGL 3.0 / GLES 3.0, on older contexts we
+    // upload textures directly from client memory instead
+    const auto glVersion = context()->format().version();
+    d->canMapBuffers = glVersion >= qMakePair(3, 0);
+    if (d->canMapBuffers) {
+        // double-buffered pixel buffers, so we can write the next frame while the previous
+        // one may still be transferred to the texture
+        for (auto &pbo : d->pbos) {
+            pbo = QOpenGLBuffer(QOpenGLBuffer::PixelUnpackBuffer);
+            pbo.setUsagePattern(QOpenGLBuffer::StreamDraw);
+            pbo.create();
+        }
+    } else {
+        qDebug().noquote() << QStringLiteral("OpenGL %1.%2 can not map pixel buffers, uploading frames directly.")
+                                  .arg(glVersion.first)
+                                  .arg(glVersion.second);
+    }
+
+    d->glInitialized = true;
+}
+
+void ImageViewWidget::resizeGL(int w, int h)
+{
+    d->viewWidth = static_cast<int>(w * devicePixelRatioF());
+    d->viewHeight = static_cast<int>(h * devicePixelRatioF());
 }
 
 void ImageViewWidget::paintGL()
@@ -181,30 +352,78 @@ void ImageViewWidget::paintGL()
     renderImage();
 }
 
-void ImageViewWidget::renderImage()
+void ImageViewWidget::uploadPreparedFrame()
 {
-    if (d->rgbImage.is_null())
-        return;
+    PreparedFrame frame;
+    {
+        std::lock_guard<std::mutex> lock(d->mutex);
+        if (!d->hasPrepared)
+            return;
+        frame = d->preparedFrame;
+        d->preparedFrame = PreparedFrame();
+        d->hasPrepared = false;
+    }
+    d->origImage = frame.origImage;
 
     if (!d->matTex) {
         d->matTex.reset(new QOpenGLTexture(QOpenGLTexture::Target2D));
+        d->matTex->create();
+        d->matTex->bind();
         d->matTex->setWrapMode(QOpenGLTexture::ClampToEdge);
         d->matTex->setMinificationFilter(QOpenGLTexture::Linear);
         d->matTex->setMagnificationFilter(QOpenGLTexture::Linear);
+        d->texWidth = 0;
+        d->texHeight = 0;
     }
 
-    const auto imgWidth = d->rgbImage.width();
-    const auto imgHeight = d->rgbImage.height();
+    const auto imgWidth = frame.rgbImage.width();
+    const auto imgHeight = frame.rgbImage.height();
+    const auto dataSize = static_cast<int>(VIPS_IMAGE_SIZEOF_IMAGE(frame.rgbImage.get_image()));
 
     d->matTex->bind();
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, imgWidth, imgHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, d->rgbImage.data());
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+    // only (re)allocate texture storage if the frame dimensions have changed
+    if (imgWidth != d->texWidth || imgHeight != d->texHeight) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, imgWidth, imgHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+        d->texWidth = imgWidth;
+        d->texHeight = imgHeight;
+    }
+
+    auto &pbo = d->pbos[d->pboIndex];
+    d->pboIndex = (d->pboIndex + 1) % 2;
+    if (d->canMapBuffers && pbo.isCreated() && pbo.bind()) {
+        // orphan the previous buffer storage, so we never have to wait for a pending transfer
+        pbo.allocate(dataSize);
+        auto ptr = glMapBufferRange(
+            GL_PIXEL_UNPACK_BUFFER, 0, dataSize, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+        if (ptr != nullptr) {
+            memcpy(ptr, frame.rgbImage.data(), dataSize);
+            glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, imgWidth, imgHeight, GL_RGB, GL_UNSIGNED_BYTE, nullptr);
+            pbo.release();
+            return;
+        }
+        pbo.release();
+    }
+
+    // fall back to uploading directly from client memory
+    glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, imgWidth, imgHeight, GL_RGB, GL_UNSIGNED_BYTE, frame.rgbImage.data());
+}
+
+void ImageViewWidget::renderImage()
+{
+    uploadPreparedFrame();
+    if (!d->matTex || d->texWidth <= 0 || d->texHeight <= 0)
+        return;
 
     // Render the texture on the surface
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
 
-    const float imageAspectRatio = static_cast<float>(imgWidth) / imgHeight;
+    const float imageAspectRatio = static_cast<float>(d->texWidth) / d->texHeight;
     const float aspectRatio = static_cast<float>(width()) / height() / imageAspectRatio;
+    d->matTex->bind();
     d->shaderProgram.bind();
     d->shaderProgram.setUniformValue("bgColor", d->bgColorVec);
     d->shaderProgram.setUniformValue("aspectRatio", aspectRatio);
@@ -220,19 +439,16 @@ void ImageViewWidget::renderImage()
 
 bool ImageViewWidget::showImage(const vips::VImage &image)
 {
-    d->origImage = image;
-    d->rgbImage = image;
-
-    if (d->rgbImage.format() != VIPS_FORMAT_UCHAR)
-        d->rgbImage = d->rgbImage.cast(VIPS_FORMAT_UCHAR, vips::VImage::option()->set("shift", true));
-    const auto interpretation = d->rgbImage.interpretation();
-    d->rgbImage = (interpretation == VIPS_INTERPRETATION_sRGB || interpretation == VIPS_INTERPRETATION_RGB)
-                      ? d->rgbImage
-                      : d->rgbImage.colourspace(VIPS_INTERPRETATION_sRGB);
-    if (d->rgbImage.bands() != 3)
-        d->rgbImage = d->rgbImage.extract_band(0, vips::VImage::option()->set("n", 3));
-
-    update();
+    // conversion & scaling happens on the preparation thread, we only hand over
+    // the newest image here - if the worker is still busy, the previous pending
+    // image is dropped
+    {
+        std::lock_guard<std::mutex> lock(d->mutex);
+        d->pendingImage = image;
+        d->hasPending = true;
+    }
+    d->cond.notify_one();
+
     return true;
 }
 
@@ -256,3 +472,10 @@ bool ImageViewWidget::highlightSaturation() const
 {
     return d->highlightSaturation;
 }
+
+void ImageViewWidget::setOwnerName(const QString &name)
+{
+    // used to account image processing time to the right module
+    std::lock_guard<std::mutex> lock(d->mutex);
+    d->ownerName = name;
+}
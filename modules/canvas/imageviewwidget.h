@@ -20,10 +20,10 @@
 #pragma once
 
 #include <QOpenGLWidget>
-#include <QOpenGLFunctions>
+#include <QOpenGLExtraFunctions>
 #include "datactl/vips8-q.h"
 
-class ImageViewWidget : public QOpenGLWidget, protected QOpenGLFunctions
+class ImageViewWidget : public QOpenGLWidget, protected QOpenGLExtraFunctions
 {
     Q_OBJECT
 public:
@@ -38,11 +38,17 @@ public slots:
     void setHighlightSaturation(bool enabled);
     bool highlightSaturation() const;
 
+    void setOwnerName(const QString &name);
+
 protected:
     void initializeGL() override;
+    void resizeGL(int w, int h) override;
     void paintGL() override;
     void renderImage();
 
+private:
+    void uploadPreparedFrame();
+
 private:
     class Private;
     Q_DISABLE_COPY(ImageViewWidget)
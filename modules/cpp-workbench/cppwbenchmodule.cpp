@@ -29,6 +29,8 @@
 #include <qtermwidget5/qtermwidget.h>
 #include <QTabWidget>
 #include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDateTime>
 #include <QDesktopServices>
 #include <QDebug>
 #include <QFileInfo>
@@ -39,9 +41,13 @@
 #include <QTextBrowser>
 #include <QDir>
 #include <QFileSystemWatcher>
+#include <QProcess>
 #include <QProcessEnvironment>
 #include <QMessageBox>
 #include <QToolBar>
+#include <algorithm>
+#include <cstdio>
+#include <utime.h>
 
 #include "mlinkmodule.h"
 #include "porteditordialog.h"
@@ -56,6 +62,74 @@ namespace Syntalos
 Q_LOGGING_CATEGORY(logCppWB, "mod.cpp-workbench")
 }
 
+// amount of compiled binaries we keep around in the build cache
+static const int BUILD_CACHE_MAX_ENTRIES = 48;
+
+static QString readProcessOutput(const QString &program, const QStringList &args, const QProcessEnvironment &env)
+{
+    QProcess proc;
+    proc.setProcessEnvironment(env);
+    proc.start(program, args);
+    if (!proc.waitForFinished(10 * 1000) || proc.exitCode() != 0)
+        return QString();
+    return QString::fromUtf8(proc.readAllStandardOutput()).trimmed();
+}
+
+/**
+ * Describe everything besides the code itself that goes into a compiled workbench
+ * binary, so we never use a cached binary with a toolchain or Syntalos version
+ * it was not built with.
+ */
+static QString toolchainFingerprint(const QProcessEnvironment &env)
+{
+    static QHash<QString, QString> fingerprintCache;
+    const auto envKey = env.toStringList().join('\n');
+    if (fingerprintCache.contains(envKey))
+        return fingerprintCache.value(envKey);
+
+    QStringList parts;
+    parts.append(readProcessOutput(env.value("CXX", "c++"), {"--version"}, env));
+    parts.append(readProcessOutput("meson", {"--version"}, env));
+    parts.append(readProcessOutput("pkg-config", {"--modversion", "syntalos-mlink"}, env));
+
+    // the library may change without a version bump when running from the build directory
+    auto libDirs = env.value("LD_LIBRARY_PATH").split(':', Qt::SkipEmptyParts);
+    libDirs.append(readProcessOutput("pkg-config", {"--variable=libdir", "syntalos-mlink"}, env));
+    for (const auto &dir : libDirs) {
+        QFileInfo libInfo(QStringLiteral("%1/libsyntalos-mlink.so").arg(dir));
+        if (!libInfo.exists())
+            continue;
+        QFileInfo realLibInfo(libInfo.canonicalFilePath());
+        parts.append(QStringLiteral("%1 %2 %3")
+                         .arg(realLibInfo.filePath())
+                         .arg(realLibInfo.size())
+                         .arg(realLibInfo.lastModified().toMSecsSinceEpoch()));
+        break;
+    }
+
+    // we compile with -march=native, so binaries are only valid for this CPU
+    QFile cpuInfoFile(QStringLiteral("/proc/cpuinfo"));
+    if (cpuInfoFile.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        QTextStream in(&cpuInfoFile);
+        bool haveModel = false;
+        bool haveFlags = false;
+        while (!in.atEnd() && !(haveModel && haveFlags)) {
+            const auto line = in.readLine();
+            if (!haveModel && line.startsWith("model name")) {
+                parts.append(line);
+                haveModel = true;
+            } else if (!haveFlags && line.startsWith("flags")) {
+                parts.append(line);
+                haveFlags = true;
+            }
+        }
+    }
+
+    const auto fingerprint = parts.join('\n');
+    fingerprintCache.insert(envKey, fingerprint);
+    return fingerprint;
+}
+
 class CppWBenchModule : public MLinkModule
 {
     Q_OBJECT
@@ -87,6 +161,13 @@ public:
             qCCritical(logCppWB, "Failed to load Meson template");
         mesonDefTplRc.close();
 
+        QFile pchRc(QStringLiteral(":/code/mlink-pch.h"));
+        if (pchRc.open(QIODevice::ReadOnly))
+            m_pchHeader = pchRc.readAll();
+        else
+            qCCritical(logCppWB, "Failed to load precompiled header template");
+        pchRc.close();
+
         QFile autoBuildTplRc(QStringLiteral(":/code/autobuild.sh"));
         if (autoBuildTplRc.open(QIODevice::ReadOnly))
             m_autobuildScript = autoBuildTplRc.readAll();
@@ -179,6 +260,7 @@ public:
                 return;
             if (!performAutobuild(buildDir.absolutePath()))
                 return;
+            storeCachedBinary(buildArtifactKey(), buildDir.absoluteFilePath(exeName));
         });
 
         // add menu
@@ -241,6 +323,7 @@ public:
         if (!incPath.isEmpty())
             buildEnv.insert("CPLUS_INCLUDE_PATH", incPath);
 
+        m_buildEnv = buildEnv;
         m_termWidget->setEnvironment(buildEnv.toStringList());
         m_termWidget->startShellProgram();
 
@@ -354,16 +437,33 @@ public:
         codeFile.write(m_codeView->document()->text().toUtf8());
         codeFile.close();
 
-        // write Meson build definition to file
+        // write Meson build definition to file, touching it only if it changed to not trigger a reconfiguration
+        const auto mesonDef = QString(m_mesonDefTmpl).replace("@EXE_NAME@", exeName).toUtf8();
         QFile mesonDefFile(wsDir.absoluteFilePath("meson.build"));
-        if (!mesonDefFile.exists()) {
+        if (!mesonDefFile.open(QIODevice::ReadOnly) || mesonDefFile.readAll() != mesonDef) {
+            mesonDefFile.close();
             if (!mesonDefFile.open(QIODevice::WriteOnly)) {
                 raiseError(QStringLiteral("Failed to write Meson build definition to file"));
                 return false;
             }
-            mesonDefFile.write(m_mesonDefTmpl.replace("@EXE_NAME@", exeName).toUtf8());
-            mesonDefFile.close();
+            mesonDefFile.write(mesonDef);
         }
+        mesonDefFile.close();
+
+        // write precompiled header, so the Syntalos and Qt headers don't need to be parsed on every build.
+        // Like the Meson definition, it is only touched if it changed, to not trigger a full rebuild.
+        const auto pchData = m_pchHeader.toUtf8();
+        QDir pchDir(wsDir.absoluteFilePath("pch"));
+        QFile pchFile(pchDir.absoluteFilePath("mlink-pch.h"));
+        if (!pchFile.open(QIODevice::ReadOnly) || pchFile.readAll() != pchData) {
+            pchFile.close();
+            if (!pchDir.mkpath(QStringLiteral(".")) || !pchFile.open(QIODevice::WriteOnly)) {
+                raiseError(QStringLiteral("Failed to write precompiled header"));
+                return false;
+            }
+            pchFile.write(pchData);
+        }
+        pchFile.close();
 
         // write autobuild helper to file
         QFile autoBuildFile(wsDir.absoluteFilePath("autobuild.sh"));
@@ -453,6 +553,88 @@ public:
         }
     }
 
+    /**
+     * Hash of everything that determines the compiled binary.
+     */
+    QString buildArtifactKey() const
+    {
+        QCryptographicHash hash(QCryptographicHash::Sha256);
+        hash.addData(m_codeView->document()->text().toUtf8());
+        hash.addData(QByteArray(1, '\0'));
+        hash.addData(m_mesonDefTmpl.toUtf8());
+        hash.addData(QByteArray(1, '\0'));
+        hash.addData(m_autobuildScript.toUtf8());
+        hash.addData(QByteArray(1, '\0'));
+        hash.addData(m_pchHeader.toUtf8());
+        hash.addData(QByteArray(1, '\0'));
+        hash.addData(toolchainFingerprint(m_buildEnv).toUtf8());
+        return QString::fromLatin1(hash.result().toHex());
+    }
+
+    QString buildCacheDir() const
+    {
+        return QStringLiteral("%1/cpp-workbench-bin").arg(m_cacheRoot);
+    }
+
+    /**
+     * Path to the binary built for @p key, or an empty string if it was never built.
+     */
+    QString cachedBinary(const QString &key) const
+    {
+        const auto binPath = QStringLiteral("%1/%2/wbmodule").arg(buildCacheDir(), key);
+        if (!QFileInfo::exists(binPath))
+            return QString();
+
+        // mark as recently used, so pruning the cache keeps it
+        // (the binary may be running, so we can not open it for writing to do this)
+        utime(qPrintable(binPath), nullptr);
+        return binPath;
+    }
+
+    /**
+     * Copy a freshly built binary into the build cache.
+     * @return Path of the cached binary, or @p builtBinary if it could not be cached.
+     */
+    QString storeCachedBinary(const QString &key, const QString &builtBinary)
+    {
+        QDir entryDir(QStringLiteral("%1/%2").arg(buildCacheDir(), key));
+        const auto binPath = entryDir.absoluteFilePath("wbmodule");
+        const auto tmpPath = QStringLiteral("%1.%2.tmp").arg(binPath).arg(QCoreApplication::applicationPid());
+        if (!entryDir.mkpath(QStringLiteral(".")) || !QFile::copy(builtBinary, tmpPath)) {
+            qCWarning(logCppWB).noquote() << "Unable to store build of" << name() << "in cache";
+            return builtBinary;
+        }
+
+        // other Syntalos instances may use the cache as well, so replace the binary atomically
+        if (std::rename(qPrintable(tmpPath), qPrintable(binPath)) != 0) {
+            QFile::remove(tmpPath);
+            return builtBinary;
+        }
+
+        pruneBuildCache();
+        return binPath;
+    }
+
+    void pruneBuildCache()
+    {
+        QDir cacheDir(buildCacheDir());
+        const auto entries = cacheDir.entryInfoList(QDir::Dirs | QDir::NoDotAndDotDot);
+        if (entries.size() <= BUILD_CACHE_MAX_ENTRIES)
+            return;
+
+        // drop the least recently used binaries, their modification time is updated on every use
+        std::vector<std::pair<QDateTime, QString>> lastUsed;
+        for (const auto &entry : entries)
+            lastUsed.emplace_back(
+                QFileInfo(QDir(entry.absoluteFilePath()).absoluteFilePath("wbmodule")).lastModified(),
+                entry.absoluteFilePath());
+        std::sort(lastUsed.begin(), lastUsed.end(), [](const auto &a, const auto &b) {
+            return a.first > b.first;
+        });
+        for (size_t i = BUILD_CACHE_MAX_ENTRIES; i < lastUsed.size(); i++)
+            QDir(lastUsed[i].second).removeRecursively();
+    }
+
     bool prepare(const TestSubject &testSubject) override
     {
         m_portEditAction->setEnabled(false);
@@ -475,15 +657,25 @@ public:
         if (!prepareBuild(buildDir, exeName))
             return false;
 
-        setStatusMessage("Compiling...");
-        if (!performAutobuild(buildDir.absolutePath())) {
-            raiseError(QStringLiteral("Failed to compile C++ code. Check module console output for details."));
-            return false;
+        // identical code is never compiled twice, no matter which module or project it came from
+        const auto artifactKey = buildArtifactKey();
+        auto binaryPath = cachedBinary(artifactKey);
+        if (binaryPath.isEmpty()) {
+            setStatusMessage("Compiling...");
+            if (!performAutobuild(buildDir.absolutePath())) {
+                raiseError(QStringLiteral("Failed to compile C++ code. Check module console output for details."));
+                return false;
+            }
+            binaryPath = storeCachedBinary(artifactKey, buildDir.absoluteFilePath(exeName));
+        } else {
+            m_termWidget->clear();
+            m_termWidget->sendText(QStringLiteral("# Code is unchanged, using cached build %1\n").arg(artifactKey));
+            qCDebug(logCppWB).noquote() << "Using cached build" << artifactKey << "for" << name();
         }
 
         // use our newly built executable as communication target
         setStatusMessage("Validating...");
-        setModuleBinary(buildDir.absoluteFilePath(exeName));
+        setModuleBinary(binaryPath);
         if (!QFileInfo::exists(moduleBinary())) {
             raiseError(QStringLiteral("No valid executable found after build"));
             return false;
@@ -575,6 +767,8 @@ private:
 
     QString m_mesonDefTmpl;
     QString m_autobuildScript;
+    QString m_pchHeader;
+    QProcessEnvironment m_buildEnv;
     QString m_cacheRoot;
     QString m_wsDirPath;
     bool m_depsOkay;
@@ -0,0 +1,4 @@
+// Precompiled header for C++ Workbench modules
+
+#include <QCoreApplication>
+#include <syntalos-mlink>
@@ -20,14 +20,56 @@
 #include "datasourcemodule.h"
 #include "datactl/frametype.h"
 
+#include <cmath>
 #include <format>
-#include <QInputDialog>
+#include <time.h>
 #include "utils/misc.h"
 
+#include "datasourcesettingsdialog.h"
+
 SYNTALOS_MODULE(DevelDataSourceModule)
 
 using namespace vips;
 
+static inline int64_t monotonicTimeNsec()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+}
+
+/**
+ * Create a test image with a diagonal stripe pattern, shifted by @p seed,
+ * so consecutive frames of the pool are distinguishable.
+ */
+static vips::VImage createPatternImage(const QSize &size, LoadFrameFormat format, int seed)
+{
+    const int bands = format == LoadFrameFormat::RGB8 ? 3 : 1;
+    const size_t samples = static_cast<size_t>(size.width()) * size.height() * bands;
+
+    if (format == LoadFrameFormat::MONO16) {
+        std::vector<uint16_t> buffer(samples);
+        for (int y = 0; y < size.height(); y++) {
+            for (int x = 0; x < size.width(); x++)
+                buffer[static_cast<size_t>(y) * size.width() + x] = ((x + 2 * y + 8 * seed) & 0xFF) * 257;
+        }
+        return vips::VImage::new_from_memory_copy(
+            buffer.data(), samples * sizeof(uint16_t), size.width(), size.height(), bands, VIPS_FORMAT_USHORT);
+    }
+
+    std::vector<uint8_t> buffer(samples);
+    for (int y = 0; y < size.height(); y++) {
+        for (int x = 0; x < size.width(); x++) {
+            const auto value = static_cast<uint8_t>((x + 2 * y + 8 * seed) & 0xFF);
+            const auto pos = (static_cast<size_t>(y) * size.width() + x) * bands;
+            for (int b = 0; b < bands; b++)
+                buffer[pos + b] = value ^ (b * 0x55);
+        }
+    }
+    return vips::VImage::new_from_memory_copy(
+        buffer.data(), samples, size.width(), size.height(), bands, VIPS_FORMAT_UCHAR);
+}
+
 class DataSourceModule : public AbstractModule
 {
     Q_OBJECT
@@ -39,10 +81,22 @@ private:
     std::shared_ptr<DataStream<FloatSignalBlock>> m_floatOut;
     std::shared_ptr<DataStream<IntSignalBlock>> m_intOut;
 
-    int m_fps;
+    DataSourceSettingsDialog *m_settingsDlg;
+
+    double m_fps;
     QSize m_outFrameSize;
     bool m_colorVideo;
 
+    // load generator settings and precomputed data
+    bool m_loadGenerator;
+    int m_signalChannels;
+    int m_signalBlockSize;
+    double m_signalSampleRate;
+    int64_t m_spinTimeNsec;
+    std::vector<vips::VImage> m_framePool;
+    std::vector<FloatSignalBlock> m_floatBlockPool;
+    std::vector<IntSignalBlock> m_intBlockPool;
+
     time_t m_prevRowTime;
     time_t m_prevTimeSData;
     int m_prevIntValue;
@@ -52,8 +106,15 @@ public:
         : AbstractModule(parent),
           m_fps(200),
           m_outFrameSize(QSize(960, 600)),
-          m_colorVideo(true)
+          m_colorVideo(true),
+          m_loadGenerator(false)
     {
+        m_settingsDlg = new DataSourceSettingsDialog;
+        m_settingsDlg->setFrameRate(m_fps);
+        m_settingsDlg->setFrameSize(m_outFrameSize);
+        m_settingsDlg->setFrameFormat(LoadFrameFormat::RGB8);
+        addSettingsWindow(m_settingsDlg);
+
         m_frameOut = registerOutputPort<Frame>(QStringLiteral("frames-out"), QStringLiteral("Frames"));
         m_rowsOut = registerOutputPort<TableRow>(QStringLiteral("rows-out"), QStringLiteral("Table Rows"));
         m_fctlOut = registerOutputPort<FirmataControl>(QStringLiteral("fctl-out"), QStringLiteral("Firmata Control"));
@@ -70,27 +131,34 @@ public:
 
     ModuleFeatures features() const override
     {
-        return ModuleFeature::NONE | ModuleFeature::SHOW_SETTINGS;
+        ModuleFeatures flags = ModuleFeature::SHOW_SETTINGS;
+
+        if (m_settingsDlg->highPriorityThread())
+            flags |= ModuleFeature::REQUEST_CPU_AFFINITY | ModuleFeature::REALTIME;
+        return flags;
     }
 
     void showSettingsUi() override
     {
         if (m_running)
             return;
-
-        bool ok;
-        auto intVal = QInputDialog::getInt(
-            nullptr, "Configure Debug Data Source", "Video Framerate", m_fps, 2, 10000, 1, &ok);
-        if (ok)
-            m_fps = intVal;
+        AbstractModule::showSettingsUi();
     }
 
     bool prepare(const TestSubject &) override
     {
-        m_frameOut->setMetadataValue("framerate", (double)m_fps);
+        m_fps = m_settingsDlg->frameRate();
+        m_outFrameSize = m_settingsDlg->frameSize();
+        m_colorVideo = m_settingsDlg->frameFormat() == LoadFrameFormat::RGB8;
+        m_loadGenerator = m_settingsDlg->mode() == DataSourceMode::LOAD_GENERATOR;
+
+        m_frameOut->setMetadataValue("framerate", m_fps);
         m_frameOut->setMetadataValue("size", m_outFrameSize);
         m_frameOut->start();
 
+        if (m_loadGenerator)
+            return prepareLoadGenerator();
+
         m_rowsOut->setSuggestedDataName(QStringLiteral("table-%1/testvalues").arg(datasetNameSuggestion()));
         m_rowsOut->setMetadataValue(
             "table_header",
@@ -122,6 +190,11 @@ public:
     {
         startWaitCondition->wait(this);
 
+        if (m_loadGenerator) {
+            runLoadGenerator();
+            return;
+        }
+
         size_t dataIndex = 0;
         while (m_running) {
             m_frameOut->push(createFrame_sleep(dataIndex, m_fps));
@@ -176,8 +249,202 @@ public:
         }
     }
 
+    void serializeSettings(const QString &, QVariantHash &settings, QByteArray &) override
+    {
+        settings.insert("load_generator", m_settingsDlg->mode() == DataSourceMode::LOAD_GENERATOR);
+        settings.insert("high_priority", m_settingsDlg->highPriorityThread());
+        settings.insert("framerate", m_settingsDlg->frameRate());
+        settings.insert("frame_width", m_settingsDlg->frameSize().width());
+        settings.insert("frame_height", m_settingsDlg->frameSize().height());
+        settings.insert("frame_format", static_cast<int>(m_settingsDlg->frameFormat()));
+        settings.insert("frame_pool_size", m_settingsDlg->framePoolSize());
+        settings.insert("signal_channels", m_settingsDlg->signalChannelCount());
+        settings.insert("signal_block_size", m_settingsDlg->signalBlockSize());
+        settings.insert("signal_sample_rate", m_settingsDlg->signalSampleRate());
+        settings.insert("spin_time_us", m_settingsDlg->spinTimeUsec());
+    }
+
+    bool loadSettings(const QString &, const QVariantHash &settings, const QByteArray &) override
+    {
+        m_settingsDlg->setMode(
+            settings.value("load_generator", false).toBool() ? DataSourceMode::LOAD_GENERATOR : DataSourceMode::DEMO);
+        m_settingsDlg->setHighPriorityThread(settings.value("high_priority", false).toBool());
+        m_settingsDlg->setFrameRate(settings.value("framerate", 200).toDouble());
+        m_settingsDlg->setFrameSize(
+            QSize(settings.value("frame_width", 960).toInt(), settings.value("frame_height", 600).toInt()));
+        m_settingsDlg->setFrameFormat(static_cast<LoadFrameFormat>(
+            settings.value("frame_format", static_cast<int>(LoadFrameFormat::RGB8)).toInt()));
+        m_settingsDlg->setFramePoolSize(settings.value("frame_pool_size", 16).toInt());
+        m_settingsDlg->setSignalChannelCount(settings.value("signal_channels", 32).toInt());
+        m_settingsDlg->setSignalBlockSize(settings.value("signal_block_size", 256).toInt());
+        m_settingsDlg->setSignalSampleRate(settings.value("signal_sample_rate", 30000).toDouble());
+        m_settingsDlg->setSpinTimeUsec(settings.value("spin_time_us", 50).toInt());
+        return true;
+    }
+
 private:
-    Frame createFrame_sleep(size_t index, int fps)
+    bool prepareLoadGenerator()
+    {
+        const auto poolSize = m_settingsDlg->framePoolSize();
+        const auto format = m_settingsDlg->frameFormat();
+        const auto channels = m_settingsDlg->signalChannelCount();
+        const auto blockSize = m_settingsDlg->signalBlockSize();
+        m_signalChannels = channels;
+        m_signalBlockSize = blockSize;
+        m_signalSampleRate = m_settingsDlg->signalSampleRate();
+        m_spinTimeNsec = m_settingsDlg->spinTimeUsec() * 1000;
+
+        // render everything we send in advance, so generating data costs nothing during the run
+        setStatusMessage(QStringLiteral("Precomputing %1 frames...").arg(poolSize));
+        m_framePool.clear();
+        m_framePool.reserve(poolSize);
+        for (int i = 0; i < poolSize; i++)
+            m_framePool.push_back(createPatternImage(m_outFrameSize, format, i));
+
+        // a few different signal blocks, with a sine of a different frequency on each channel
+        const int blockPoolSize = 8;
+        m_floatBlockPool.assign(blockPoolSize, FloatSignalBlock(blockSize, channels));
+        m_intBlockPool.assign(blockPoolSize, IntSignalBlock(blockSize, channels));
+        for (int b = 0; b < blockPoolSize; b++) {
+            for (int i = 0; i < blockSize; i++) {
+                const double t = static_cast<double>(b * blockSize + i) / (blockPoolSize * blockSize);
+                for (int c = 0; c < channels; c++) {
+                    m_floatBlockPool[b].data(i, c) = std::sin(2 * M_PI * (c + 1) * t);
+                    m_intBlockPool[b].data(i, c) = (b * blockSize + i + c) % 1024;
+                }
+            }
+        }
+
+        QStringList signalNames;
+        for (int c = 0; c < channels; c++)
+            signalNames.append(QStringLiteral("Ch %1").arg(c + 1));
+        m_floatOut->setMetadataValue("signal_names", signalNames);
+        m_floatOut->setMetadataValue("time_unit", "index");
+        m_floatOut->setMetadataValue("data_unit", "au");
+        m_floatOut->setMetadataValue("sample_rate", m_signalSampleRate);
+        m_floatOut->setMetadataValue("block_size", blockSize);
+        m_floatOut->start();
+        m_intOut->setMetadataValue("signal_names", signalNames);
+        m_intOut->setMetadataValue("time_unit", "index");
+        m_intOut->setMetadataValue("data_unit", "au");
+        m_intOut->setMetadataValue("sample_rate", m_signalSampleRate);
+        m_intOut->setMetadataValue("block_size", blockSize);
+        m_intOut->start();
+
+        // we do not generate these, but downstream modules may expect them to be active
+        m_rowsOut->start();
+        m_fctlOut->start();
+
+        setStatusMessage(QString());
+        return true;
+    }
+
+    /**
+     * Sleep until the absolute monotonic time @p deadlineNs. The last @p spinNs before
+     * the deadline are spent busy-waiting, as waking up from a sleep is not precise enough
+     * for high rates.
+     */
+    void waitUntilDeadline(int64_t deadlineNs, int64_t spinNs)
+    {
+        // sleep in slices, so we still react to the run being stopped on very low rates
+        constexpr int64_t maxSleepNs = 100 * 1000 * 1000;
+        int64_t nowNs = monotonicTimeNsec();
+        while (m_running && (deadlineNs - spinNs) > nowNs) {
+            const auto wakeNs = std::min(deadlineNs - spinNs, nowNs + maxSleepNs);
+            const struct timespec ts = {
+                .tv_sec = static_cast<time_t>(wakeNs / 1000000000),
+                .tv_nsec = static_cast<long>(wakeNs % 1000000000)};
+            clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr);
+            nowNs = monotonicTimeNsec();
+        }
+
+        while (nowNs < deadlineNs)
+            nowNs = monotonicTimeNsec();
+    }
+
+    void runLoadGenerator()
+    {
+        const auto channels = m_signalChannels;
+        const auto blockSize = m_signalBlockSize;
+        const auto sampleRate = m_signalSampleRate;
+        const auto spinNs = m_spinTimeNsec;
+
+        // deadlines are computed from the start time, so errors never accumulate
+        const double framePeriodNs = 1000000000.0 / m_fps;
+        const double blockPeriodNs = 1000000000.0 * blockSize / sampleRate;
+
+        const auto startNs = monotonicTimeNsec();
+        uint64_t frameCount = 0;
+        uint64_t blockCount = 0;
+        uint64_t lateCount = 0;
+
+        auto lastReportNs = startNs;
+        uint64_t lastReportFrames = 0;
+        uint64_t lastReportBlocks = 0;
+
+        while (m_running) {
+            const auto frameDeadline = startNs + static_cast<int64_t>(frameCount * framePeriodNs);
+            const auto blockDeadline = startNs + static_cast<int64_t>(blockCount * blockPeriodNs);
+            const bool sendFrame = frameDeadline <= blockDeadline;
+            const auto deadline = sendFrame ? frameDeadline : blockDeadline;
+
+            waitUntilDeadline(deadline, spinNs);
+            if (!m_running)
+                break;
+
+            const auto nowNs = monotonicTimeNsec();
+            if (nowNs - deadline > (sendFrame ? framePeriodNs : blockPeriodNs))
+                lateCount++;
+
+            if (sendFrame) {
+                m_frameOut->push(Frame(
+                    m_framePool[frameCount % m_framePool.size()], frameCount, m_syTimer->timeSinceStartMsec()));
+                frameCount++;
+            } else {
+                // timestamps are the sample indices
+                const auto firstSample = static_cast<quint32>(blockCount * blockSize);
+                FloatSignalBlock fsb = m_floatBlockPool[blockCount % m_floatBlockPool.size()];
+                IntSignalBlock isb = m_intBlockPool[blockCount % m_intBlockPool.size()];
+                for (int i = 0; i < blockSize; i++)
+                    fsb.timestamps[i] = firstSample + i;
+                isb.timestamps = fsb.timestamps;
+                m_floatOut->push(fsb);
+                m_intOut->push(isb);
+                blockCount++;
+            }
+
+            // report achieved versus requested rates about once a second
+            const auto reportIntervalNs = nowNs - lastReportNs;
+            if (reportIntervalNs >= 1000000000) {
+                const double frameRate = (frameCount - lastReportFrames) * 1.0e9 / reportIntervalNs;
+                const double kSampleRate = (blockCount - lastReportBlocks) * blockSize * 1.0e6 / reportIntervalNs;
+                setStatusMessage(QStringLiteral("%1/%2 fps, %3/%4 kS/s × %5 ch, %6 late")
+                                     .arg(frameRate, 0, 'f', 1)
+                                     .arg(m_fps, 0, 'f', 1)
+                                     .arg(kSampleRate, 0, 'f', 1)
+                                     .arg(sampleRate / 1000.0, 0, 'f', 1)
+                                     .arg(channels)
+                                     .arg(lateCount));
+                lastReportNs = nowNs;
+                lastReportFrames = frameCount;
+                lastReportBlocks = blockCount;
+            }
+        }
+
+        const double runSec = (monotonicTimeNsec() - startNs) / 1.0e9;
+        if (runSec > 0)
+            qDebug().noquote().nospace()
+                << name() << ": Generated " << frameCount / runSec << " fps (requested " << m_fps << "), "
+                << blockCount * blockSize / runSec << " samples/s per channel (requested " << sampleRate << ") on "
+                << channels << " channels, " << lateCount << " items were late";
+
+        // don't keep the (possibly large) precomputed data around between runs
+        m_framePool.clear();
+        m_floatBlockPool.clear();
+        m_intBlockPool.clear();
+    }
+
+    Frame createFrame_sleep(size_t index, double fps)
     {
         const auto startTime = currentTimePoint();
 
@@ -235,8 +502,8 @@ private:
         // evaluate the new image immediately
         vips_image_wio_input(frame.mat.get_image());
 
-        std::this_thread::sleep_for(
-            std::chrono::microseconds((1000 / fps) * 1000) - timeDiffUsec(currentTimePoint(), startTime));
+        const auto frameInterval = std::chrono::microseconds(static_cast<int64_t>(1000000 / fps));
+        std::this_thread::sleep_for(frameInterval - timeDiffUsec(currentTimePoint(), startTime));
         return frame;
     }
 
@@ -269,7 +536,8 @@ QString DevelDataSourceModuleInfo::name() const
 
 QString DevelDataSourceModuleInfo::description() const
 {
-    return QStringLiteral("Developer module generating different artificial data.");
+    return QStringLiteral(
+        "Developer module generating different artificial data, or precisely paced synthetic load at high rates.");
 }
 
 QIcon DevelDataSourceModuleInfo::icon() const
@@ -0,0 +1,153 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "datasourcesettingsdialog.h"
+#include "ui_datasourcesettingsdialog.h"
+
+#include <QIcon>
+
+DataSourceSettingsDialog::DataSourceSettingsDialog(QWidget *parent)
+    : QDialog(parent),
+      ui(new Ui::DataSourceSettingsDialog)
+{
+    ui->setupUi(this);
+    setWindowIcon(QIcon(":/icons/generic-config"));
+
+    connect(ui->modeComboBox, qOverload<int>(&QComboBox::currentIndexChanged), this, [this](int) {
+        updateUiState();
+    });
+    updateUiState();
+}
+
+DataSourceSettingsDialog::~DataSourceSettingsDialog()
+{
+    delete ui;
+}
+
+DataSourceMode DataSourceSettingsDialog::mode() const
+{
+    return static_cast<DataSourceMode>(ui->modeComboBox->currentIndex());
+}
+
+void DataSourceSettingsDialog::setMode(DataSourceMode mode)
+{
+    ui->modeComboBox->setCurrentIndex(static_cast<int>(mode));
+}
+
+bool DataSourceSettingsDialog::highPriorityThread() const
+{
+    return ui->hpThreadCheckBox->isChecked();
+}
+
+void DataSourceSettingsDialog::setHighPriorityThread(bool enabled)
+{
+    ui->hpThreadCheckBox->setChecked(enabled);
+}
+
+double DataSourceSettingsDialog::frameRate() const
+{
+    return ui->frameRateSpinBox->value();
+}
+
+void DataSourceSettingsDialog::setFrameRate(double fps)
+{
+    ui->frameRateSpinBox->setValue(fps);
+}
+
+QSize DataSourceSettingsDialog::frameSize() const
+{
+    return QSize(ui->frameWidthSpinBox->value(), ui->frameHeightSpinBox->value());
+}
+
+void DataSourceSettingsDialog::setFrameSize(const QSize &size)
+{
+    ui->frameWidthSpinBox->setValue(size.width());
+    ui->frameHeightSpinBox->setValue(size.height());
+}
+
+LoadFrameFormat DataSourceSettingsDialog::frameFormat() const
+{
+    return static_cast<LoadFrameFormat>(ui->frameFormatComboBox->currentIndex());
+}
+
+void DataSourceSettingsDialog::setFrameFormat(LoadFrameFormat format)
+{
+    ui->frameFormatComboBox->setCurrentIndex(static_cast<int>(format));
+}
+
+int DataSourceSettingsDialog::framePoolSize() const
+{
+    return ui->framePoolSpinBox->value();
+}
+
+void DataSourceSettingsDialog::setFramePoolSize(int count)
+{
+    ui->framePoolSpinBox->setValue(count);
+}
+
+int DataSourceSettingsDialog::signalChannelCount() const
+{
+    return ui->signalChannelsSpinBox->value();
+}
+
+void DataSourceSettingsDialog::setSignalChannelCount(int count)
+{
+    ui->signalChannelsSpinBox->setValue(count);
+}
+
+int DataSourceSettingsDialog::signalBlockSize() const
+{
+    return ui->signalBlockSizeSpinBox->value();
+}
+
+void DataSourceSettingsDialog::setSignalBlockSize(int samples)
+{
+    ui->signalBlockSizeSpinBox->setValue(samples);
+}
+
+double DataSourceSettingsDialog::signalSampleRate() const
+{
+    return ui->signalRateSpinBox->value();
+}
+
+void DataSourceSettingsDialog::setSignalSampleRate(double rate)
+{
+    ui->signalRateSpinBox->setValue(rate);
+}
+
+int DataSourceSettingsDialog::spinTimeUsec() const
+{
+    return ui->spinTimeSpinBox->value();
+}
+
+void DataSourceSettingsDialog::setSpinTimeUsec(int usec)
+{
+    ui->spinTimeSpinBox->setValue(usec);
+}
+
+void DataSourceSettingsDialog::updateUiState()
+{
+    // the demo data only uses the frame rate, size and color
+    const bool loadGen = mode() == DataSourceMode::LOAD_GENERATOR;
+    ui->framePoolSpinBox->setEnabled(loadGen);
+    ui->signalChannelsSpinBox->setEnabled(loadGen);
+    ui->signalBlockSizeSpinBox->setEnabled(loadGen);
+    ui->signalRateSpinBox->setEnabled(loadGen);
+    ui->spinTimeSpinBox->setEnabled(loadGen);
+}
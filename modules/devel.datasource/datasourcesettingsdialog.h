@@ -0,0 +1,83 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QDialog>
+#include <QSize>
+
+namespace Ui
+{
+class DataSourceSettingsDialog;
+}
+
+enum class DataSourceMode {
+    DEMO,
+    LOAD_GENERATOR
+};
+
+enum class LoadFrameFormat {
+    MONO8,
+    MONO16,
+    RGB8
+};
+
+class DataSourceSettingsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+    explicit DataSourceSettingsDialog(QWidget *parent = nullptr);
+    ~DataSourceSettingsDialog();
+
+    DataSourceMode mode() const;
+    void setMode(DataSourceMode mode);
+
+    bool highPriorityThread() const;
+    void setHighPriorityThread(bool enabled);
+
+    double frameRate() const;
+    void setFrameRate(double fps);
+
+    QSize frameSize() const;
+    void setFrameSize(const QSize &size);
+
+    LoadFrameFormat frameFormat() const;
+    void setFrameFormat(LoadFrameFormat format);
+
+    int framePoolSize() const;
+    void setFramePoolSize(int count);
+
+    int signalChannelCount() const;
+    void setSignalChannelCount(int count);
+
+    int signalBlockSize() const;
+    void setSignalBlockSize(int samples);
+
+    double signalSampleRate() const;
+    void setSignalSampleRate(double rate);
+
+    int spinTimeUsec() const;
+    void setSpinTimeUsec(int usec);
+
+private:
+    void updateUiState();
+
+    Ui::DataSourceSettingsDialog *ui;
+};
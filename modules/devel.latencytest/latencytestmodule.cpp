@@ -29,6 +29,8 @@ class LatencyTestModule : public AbstractModule
 private:
     std::shared_ptr<StreamInputPort<FirmataData>> m_fmDataInPort;
     std::shared_ptr<StreamSubscription<FirmataData>> m_fmDataSub;
+    std::shared_ptr<StreamInputPort<FirmataData>> m_fmOutEventsInPort;
+    std::shared_ptr<StreamSubscription<FirmataData>> m_fmOutEventsSub;
 
     std::shared_ptr<DataStream<TableRow>> m_tabStream;
     std::shared_ptr<DataStream<FirmataControl>> m_fmCtlStream;
@@ -38,6 +40,8 @@ public:
         : AbstractModule(parent)
     {
         m_fmDataInPort = registerInputPort<FirmataData>(QStringLiteral("firmata-in"), QStringLiteral("Firmata Data"));
+        m_fmOutEventsInPort = registerInputPort<FirmataData>(
+            QStringLiteral("firmata-out-events"), QStringLiteral("Firmata Output Pin Events"));
         m_tabStream = registerOutputPort<TableRow>(QStringLiteral("table-out"), QStringLiteral("Table Rows"));
         m_fmCtlStream = registerOutputPort<FirmataControl>(
             QStringLiteral("firmata-out"), QStringLiteral("Firmata Control"));
@@ -61,16 +65,25 @@ public:
             "table_header",
             QStringList() << "RecTime"
                           << "State"
-                          << "ProcTime");
+                          << "ProcTime"
+                          << "Pin");
         m_tabStream->setMetadataValue("data_name_proposal", "events/table");
         m_tabStream->start();
 
         m_fmCtlStream->start();
 
-        if (m_fmDataInPort->hasSubscription())
+        m_fmOutEventsSub.reset();
+        if (m_fmOutEventsInPort->hasSubscription())
+            m_fmOutEventsSub = m_fmOutEventsInPort->subscription();
+
+        if (m_fmDataInPort->hasSubscription()) {
             m_fmDataSub = m_fmDataInPort->subscription();
-        else
+
+            // we measure reaction latency, so avoid being put to sleep between input events
+            m_fmDataSub->setWaitStrategy(SubscriptionWaitStrategy::SPIN_THEN_BLOCK);
+        } else {
             setStateDormant();
+        }
 
         return true;
     }
@@ -92,29 +105,63 @@ public:
     {
         startWaitCondition->wait(this);
 
-        uint16_t lastValue = 0;
+        uint16_t lastInValue = 0;
+        uint16_t lastOutValue = 0;
         while (m_running) {
             const auto data = m_fmDataSub->next();
+            processOutputEvents(lastOutValue);
             if (!data.has_value())
                 continue;
             if (!data->isDigital)
                 continue;
-            if (lastValue == data->value)
-                continue;
+
             if (data->pinName != QStringLiteral("testIn"))
                 continue;
+            if (lastInValue == data->value)
+                continue;
 
             if (data->value) {
                 auto ctl = FirmataControl(FirmataCommandKind::WRITE_DIGITAL_PULSE, "testOut");
                 m_fmCtlStream->push(ctl);
             }
 
-            m_tabStream->push(TableRow(
-                QStringList() << QString::number(data->time.count()) << QString::number(data->value)
-                              << QString::number(m_syTimer->timeSinceStartMsec().count())));
-            lastValue = data->value;
+            pushEventRow(data.value());
+            lastInValue = data->value;
+        }
+        processOutputEvents(lastOutValue);
+
+        const auto stats = m_fmDataSub->waitLatencyStats();
+        if (stats.count > 0)
+            qDebug().noquote().nospace()
+                << name() << ": Input wakeup latency p50=" << stats.p50Usec << "µs p99=" << stats.p99Usec
+                << "µs p99.9=" << stats.p999Usec << "µs max=" << stats.maxUsec << "µs (spin: " << stats.spinWakeups
+                << ", yield: " << stats.yieldWakeups << ", block: " << stats.blockWakeups << ")";
+    }
+
+    void processOutputEvents(uint16_t &lastOutValue)
+    {
+        if (!m_fmOutEventsSub)
+            return;
+
+        // the Firmata module reports when it actually switched our output pin,
+        // which gives us the full input-to-output latency and the pulse length
+        while (true) {
+            const auto data = m_fmOutEventsSub->peekNext();
+            if (!data.has_value())
+                break;
+            if (data->pinName != QStringLiteral("testOut") || lastOutValue == data->value)
+                continue;
+            pushEventRow(data.value());
+            lastOutValue = data->value;
         }
     }
+
+    void pushEventRow(const FirmataData &data)
+    {
+        m_tabStream->push(TableRow(
+            QStringList() << QString::number(data.time.count()) << QString::number(data.value)
+                          << QString::number(m_syTimer->timeSinceStartMsec().count()) << data.pinName));
+    }
 };
 
 QString DevelLatencyTestModuleInfo::id() const
@@ -39,33 +39,55 @@ public:
         // we use the generic Python OOP worker process for this
         setModuleBinary(findSyntalosPyWorkerBinary());
 
+        // pass-through benchmark, reporting the frame rate and latency of the Python bridge
         setScript(
-            "import syio as sy\n"
-            "import cv2 as cv\n"
+            "import syntalos_mlink as syl\n"
             "\n"
-            "iport = sy.get_input_port('nonexistent')\n"
-            "print('IPort (nonexistent): ' + str(iport))\n"
-            "iport = sy.get_input_port('video-in')\n"
-            "oport = sy.get_output_port('video-out')\n"
-            "print('IPort: ' + str(iport))\n"
-            "print('OPort: ' + str(oport))\n"
+            "# set to False to submit the received frames directly\n"
+            "USE_LOANED_FRAMES = True\n"
+            "REPORT_INTERVAL_MSEC = 2000\n"
+            "\n"
+            "iport = syl.get_input_port('video-in')\n"
+            "oport = syl.get_output_port('video-out')\n"
             "oport.set_metadata_value('framerate', 200)\n"
             "oport.set_metadata_value_size('size', [960, 600])\n"
             "\n"
+            "stats = {'count': 0, 'latency': 0.0, 'start': 0}\n"
+            "\n"
             "def prepare() -> bool:\n"
             "    iport.on_data = new_data_event\n"
             "    return True\n"
             "\n"
-            "def run() -> bool:\n"
-            "    while sy.is_running():\n"
-            "        sy.await_data()\n"
-            "    print('Quitting PyOOPTestModule Loop!')\n"
+            "def report(now) -> None:\n"
+            "    count = stats['count']\n"
+            "    if count > 0:\n"
+            "        fps = count * 1000.0 / (now - stats['start'])\n"
+            "        latency = stats['latency'] / count\n"
+            "        print('Pass-through: {:.1f} fps, mean latency {:.2f} msec'.format(fps, latency))\n"
+            "    stats.update(count=0, latency=0.0, start=now)\n"
+            "\n"
+            "def run() -> None:\n"
+            "    stats['start'] = syl.time_since_start_msec()\n"
+            "    while syl.is_running():\n"
+            "        syl.await_data(100 * 1000)\n"
+            "        now = syl.time_since_start_msec()\n"
+            "        if now - stats['start'] >= REPORT_INTERVAL_MSEC:\n"
+            "            report(now)\n"
             "\n"
             "def new_data_event(frame) -> None:\n"
-            "    blur = cv.blur(frame.mat, (5,5))\n"
-            "    frame.mat = blur\n"
-            "    oport.submit(frame)\n"
-            "\n");
+            "    if USE_LOANED_FRAMES:\n"
+            "        src = frame.array\n"
+            "        channels = 1 if src.ndim == 2 else src.shape[2]\n"
+            "        out = oport.loan_frame(src.shape[1], src.shape[0], channels, src.dtype)\n"
+            "        out.array[...] = src\n"
+            "        out.index = frame.index\n"
+            "        out.time_msec = frame.time_msec\n"
+            "        oport.submit(out)\n"
+            "    else:\n"
+            "        oport.submit(frame)\n"
+            "\n"
+            "    stats['count'] += 1\n"
+            "    stats['latency'] += syl.time_since_start_msec() - frame.time_msec.total_seconds() * 1000\n");
 
         registerInputPort<FirmataData>("firmata-in", "Pin Data");
         registerOutputPort<FirmataControl>("firmata-out", "Pin Control");
@@ -106,7 +128,7 @@ QString PyOOPTestModuleInfo::name() const
 
 QString PyOOPTestModuleInfo::description() const
 {
-    return QStringLiteral("Test module to test out-of-process and Python capabilities.");
+    return QStringLiteral("Test module to benchmark out-of-process and Python frame pass-through.");
 }
 
 QIcon PyOOPTestModuleInfo::icon() const
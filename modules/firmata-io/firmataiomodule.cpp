@@ -21,10 +21,12 @@
 
 #include "firmata/serialport.h"
 #include "firmatasettingsdialog.h"
+#include "pulsescheduler.h"
 #include <QDebug>
 #include <QThread>
 #include <QTimer>
 #include <QEventLoop>
+#include <thread>
 
 #include "streams/subscriptionnotifier.h"
 #include "utils/misc.h"
@@ -61,13 +63,21 @@ private:
 
     std::shared_ptr<StreamInputPort<FirmataControl>> m_inFmCtl;
     std::shared_ptr<DataStream<FirmataData>> m_fmStream;
+    std::shared_ptr<DataStream<FirmataData>> m_fmOutStream;
     std::shared_ptr<StreamSubscription<FirmataControl>> m_fmCtlSub;
 
+    PulseScheduler m_pulseScheduler;
+    std::unique_ptr<QTimer> m_pulseTimer;
+    uint64_t m_pinTransitionCount;
+    microseconds_t m_maxPulseLateness;
+
 public:
     explicit FirmataIOModule(QObject *parent = nullptr)
         : AbstractModule(parent),
           m_settingsDialog(nullptr),
-          m_stopped(true)
+          m_stopped(true),
+          m_pinTransitionCount(0),
+          m_maxPulseLateness(0)
     {
         m_settingsDialog = new FirmataSettingsDialog;
         addSettingsWindow(m_settingsDialog);
@@ -75,6 +85,7 @@ public:
 
         m_inFmCtl = registerInputPort<FirmataControl>(QStringLiteral("fmctl"), QStringLiteral("Firmata Control"));
         m_fmStream = registerOutputPort<FirmataData>(QStringLiteral("fmdata"), QStringLiteral("Firmata Data"));
+        m_fmOutStream = registerOutputPort<FirmataData>(QStringLiteral("fmout"), QStringLiteral("Output Pin Events"));
     }
 
     ~FirmataIOModule() override {}
@@ -102,8 +113,9 @@ public:
         m_namePinMap.clear();
         m_pinNameMap.clear();
 
-        // start event stream and see if we should listen to control commands
+        // start event streams and see if we should listen to control commands
         m_fmStream->start();
+        m_fmOutStream->start();
         m_fmCtlSub.reset();
         if (m_inFmCtl->hasSubscription())
             m_fmCtlSub = m_inFmCtl->subscription();
@@ -166,6 +178,18 @@ public:
             &FirmataIOModule::recvDigitalPinRead,
             Qt::DirectConnection);
 
+        // pulses are not waited for, instead we schedule the end of every pulse and
+        // have this timer fire when the next pin transition is due
+        m_pulseScheduler = PulseScheduler();
+        m_pinTransitionCount = 0;
+        m_maxPulseLateness = microseconds_t(0);
+        m_pulseTimer = std::make_unique<QTimer>();
+        m_pulseTimer->setSingleShot(true);
+        m_pulseTimer->setTimerType(Qt::PreciseTimer);
+        connect(m_pulseTimer.get(), &QTimer::timeout, [&firmata, this]() {
+            runDuePinTransitions(firmata.get());
+        });
+
         // trigger if we have new input data
         std::unique_ptr<SubscriptionNotifier> notifier;
         if (m_fmCtlSub) {
@@ -199,6 +223,13 @@ public:
         // run our internal event loop
         loop.exec();
 
+        // finish all pulses that are still in flight, so no pin is left active
+        for (const auto &tr : m_pulseScheduler.takeAll())
+            applyPinTransition(firmata.get(), tr);
+        m_pulseTimer.reset();
+        qCDebug(logFmMod).noquote() << "Executed" << m_pinTransitionCount << "scheduled pin transitions, max. lateness:"
+                                    << m_maxPulseLateness.count() << "µs";
+
         m_fmCtlSub->disableNotify();
         m_stopped = true;
     }
@@ -282,9 +313,30 @@ public:
         return pin;
     }
 
+    void pushOutputTransition(uint8_t pinId, bool value, const microseconds_t &time)
+    {
+        // report the time at which the pin state was actually written, on a separate
+        // stream so consumers of input events do not see our own writes
+        const auto pinName = m_pinNameMap.value(pinId);
+        if (pinName.isEmpty() || !m_namePinMap.value(pinName).output)
+            return;
+
+        FirmataData fdata;
+        fdata.time = std::chrono::duration_cast<milliseconds_t>(time);
+        fdata.isDigital = true;
+        fdata.pinId = pinId;
+        fdata.pinName = pinName;
+        fdata.value = value;
+        m_fmOutStream->push(fdata);
+    }
+
     void pinSetValue(SerialFirmata *firmata, int pinId, bool value)
     {
-        firmata->writeDigitalPin(pinId, value);
+        // an explicit write overrides the end of a running pulse
+        const auto id = static_cast<uint8_t>(pinId);
+        m_pulseScheduler.cancel(id);
+        firmata->writeDigitalPin(id, value);
+        pushOutputTransition(id, value, m_syTimer->timeSinceStartUsec());
     }
 
     void pinSetValue(SerialFirmata *firmata, const QString &pinName, bool value)
@@ -295,15 +347,65 @@ public:
         pinSetValue(firmata, pin.id, value);
     }
 
+    void applyPinTransition(SerialFirmata *firmata, const PulseScheduler::Transition &tr)
+    {
+        firmata->writeDigitalPin(tr.pinId, tr.value);
+        const auto time = m_syTimer->timeSinceStartUsec();
+
+        m_pinTransitionCount++;
+        if (time - tr.deadline > m_maxPulseLateness)
+            m_maxPulseLateness = time - tr.deadline;
+        pushOutputTransition(tr.pinId, tr.value, time);
+    }
+
+    void armPulseTimer()
+    {
+        const auto next = m_pulseScheduler.nextDeadline();
+        if (!next.has_value()) {
+            m_pulseTimer->stop();
+            return;
+        }
+
+        // QTimer has millisecond resolution, so we wake up early rather than late
+        const auto wait = next.value() - m_syTimer->timeSinceStartUsec();
+        m_pulseTimer->start(std::max<int>(0, static_cast<int>(wait.count() / 1000)));
+    }
+
+    void runDuePinTransitions(SerialFirmata *firmata)
+    {
+        auto now = m_syTimer->timeSinceStartUsec();
+
+        // wait out the sub-millisecond remainder the timer could not handle for us
+        const auto next = m_pulseScheduler.nextDeadline();
+        if (next.has_value() && next.value() > now && next.value() - now < microseconds_t(1000)) {
+            std::this_thread::sleep_for(next.value() - now);
+            now = m_syTimer->timeSinceStartUsec();
+        }
+
+        for (const auto &tr : m_pulseScheduler.takeDue(now))
+            applyPinTransition(firmata, tr);
+        armPulseTimer();
+    }
+
     void pinSignalPulse(SerialFirmata *firmata, int pinId, int pulseDuration = 0)
     {
         if (pulseDuration <= 0)
             pulseDuration = 50; // 50 msec is our default pulse length
         else if (pulseDuration > 4000)
             pulseDuration = 4000; // clamp pulse length at 4 sec max
-        pinSetValue(firmata, pinId, true);
-        delay(pulseDuration);
-        pinSetValue(firmata, pinId, false);
+
+        // raise the pin right away, unless it is still active from an earlier pulse,
+        // in which case that pulse is simply extended
+        const auto id = static_cast<uint8_t>(pinId);
+        auto now = m_syTimer->timeSinceStartUsec();
+        if (!m_pulseScheduler.isPending(id)) {
+            firmata->writeDigitalPin(id, true);
+            now = m_syTimer->timeSinceStartUsec();
+            pushOutputTransition(id, true, now);
+        }
+
+        m_pulseScheduler.schedulePulseEnd(id, false, now + milliseconds_t(pulseDuration));
+        armPulseTimer();
     }
 
     void pinSignalPulse(SerialFirmata *firmata, const QString &pinName, int pulseDuration = 0)
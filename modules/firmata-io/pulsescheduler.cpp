@@ -0,0 +1,148 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pulsescheduler.h"
+
+#include <algorithm>
+
+PulseScheduler::PulseScheduler(microseconds_t tickLength, size_t wheelSize)
+    : m_tickLength(tickLength),
+      m_wheel(std::max<size_t>(wheelSize, 1)),
+      m_lastTick(0),
+      m_seq(0)
+{
+}
+
+int64_t PulseScheduler::tickOf(microseconds_t time) const
+{
+    return time.count() / m_tickLength.count();
+}
+
+size_t PulseScheduler::slotOf(int64_t tick) const
+{
+    // timestamps may be negative before the run has started
+    const auto size = static_cast<int64_t>(m_wheel.size());
+    return static_cast<size_t>(((tick % size) + size) % size);
+}
+
+bool PulseScheduler::isCurrent(const Entry &entry) const
+{
+    // entries of cancelled or replaced transitions are removed lazily
+    const auto it = m_pending.find(entry.tr.pinId);
+    return it != m_pending.end() && it->second.seq == entry.seq;
+}
+
+void PulseScheduler::schedulePulseEnd(uint8_t pinId, bool value, microseconds_t deadline)
+{
+    auto it = m_pending.find(pinId);
+    if (it != m_pending.end() && it->second.tr.deadline >= deadline) {
+        it->second.tr.value = value;
+        return;
+    }
+
+    const Entry entry{
+        {pinId, value, deadline},
+        ++m_seq
+    };
+    m_pending[pinId] = entry;
+
+    // transitions which are already overdue go into the slot we check next
+    m_wheel[slotOf(std::max(tickOf(deadline), m_lastTick))].push_back(entry);
+}
+
+bool PulseScheduler::cancel(uint8_t pinId)
+{
+    return m_pending.erase(pinId) > 0;
+}
+
+bool PulseScheduler::isPending(uint8_t pinId) const
+{
+    return m_pending.find(pinId) != m_pending.end();
+}
+
+static void sortByDeadline(std::vector<PulseScheduler::Transition> &transitions)
+{
+    std::stable_sort(transitions.begin(), transitions.end(), [](const auto &a, const auto &b) {
+        return a.deadline < b.deadline;
+    });
+}
+
+std::vector<PulseScheduler::Transition> PulseScheduler::takeDue(microseconds_t now)
+{
+    std::vector<Transition> due;
+    const auto nowTick = tickOf(now);
+
+    // visit every slot we passed since the last call, but each one at most once
+    const auto firstTick = std::max(m_lastTick, nowTick - static_cast<int64_t>(m_wheel.size()) + 1);
+    for (auto tick = firstTick; tick <= nowTick && !m_pending.empty(); tick++) {
+        auto &slot = m_wheel[slotOf(tick)];
+        for (size_t i = 0; i < slot.size();) {
+            const auto &entry = slot[i];
+            if (isCurrent(entry) && entry.tr.deadline > now) {
+                // a later revolution of the wheel
+                i++;
+                continue;
+            }
+
+            if (isCurrent(entry)) {
+                const auto pinId = entry.tr.pinId;
+                due.push_back(m_pending[pinId].tr);
+                m_pending.erase(pinId);
+            }
+            slot[i] = slot.back();
+            slot.pop_back();
+        }
+    }
+    m_lastTick = std::max(m_lastTick, nowTick);
+
+    sortByDeadline(due);
+    return due;
+}
+
+std::vector<PulseScheduler::Transition> PulseScheduler::takeAll()
+{
+    std::vector<Transition> all;
+    all.reserve(m_pending.size());
+    for (const auto &pending : m_pending)
+        all.push_back(pending.second.tr);
+
+    m_pending.clear();
+    for (auto &slot : m_wheel)
+        slot.clear();
+
+    sortByDeadline(all);
+    return all;
+}
+
+std::optional<microseconds_t> PulseScheduler::nextDeadline() const
+{
+    // there is at most one transition per pin, so this is cheap
+    std::optional<microseconds_t> next;
+    for (const auto &pending : m_pending) {
+        if (!next.has_value() || pending.second.tr.deadline < next.value())
+            next = pending.second.tr.deadline;
+    }
+
+    return next;
+}
+
+size_t PulseScheduler::pendingCount() const
+{
+    return m_pending.size();
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+#include "datactl/syclock.h"
+
+using Syntalos::microseconds_t;
+
+/**
+ * @brief Schedules digital pin transitions without blocking
+ *
+ * Pending transitions are kept in a hashed timer wheel, so queueing and expiring
+ * them is cheap no matter how many pulses are in flight. Each pin can have at most
+ * one pending transition, scheduling a new one replaces the old one.
+ */
+class PulseScheduler
+{
+public:
+    struct Transition {
+        uint8_t pinId;
+        bool value;
+        microseconds_t deadline;
+    };
+
+    explicit PulseScheduler(microseconds_t tickLength = microseconds_t(500), size_t wheelSize = 1024);
+
+    /**
+     * Schedule the end of a pulse on a pin, setting it to @p value at @p deadline.
+     * If the pin already has a pending pulse end, the later of the two deadlines wins,
+     * so overlapping pulses on the same pin merge into one.
+     */
+    void schedulePulseEnd(uint8_t pinId, bool value, microseconds_t deadline);
+
+    /**
+     * Drop a pending transition of the pin, e.g. because it was set explicitly.
+     * @return True if a transition was pending.
+     */
+    bool cancel(uint8_t pinId);
+
+    //! True if the pin has a pending transition
+    bool isPending(uint8_t pinId) const;
+
+    /**
+     * Remove all transitions which are due at @p now from the wheel.
+     * @return The due transitions, ordered by their deadline.
+     */
+    std::vector<Transition> takeDue(microseconds_t now);
+
+    //! Remove all pending transitions, regardless of their deadline.
+    std::vector<Transition> takeAll();
+
+    //! Deadline of the earliest pending transition, if there is any.
+    std::optional<microseconds_t> nextDeadline() const;
+
+    size_t pendingCount() const;
+
+private:
+    struct Entry {
+        Transition tr;
+        uint64_t seq;
+    };
+
+    int64_t tickOf(microseconds_t time) const;
+    size_t slotOf(int64_t tick) const;
+    bool isCurrent(const Entry &entry) const;
+
+    microseconds_t m_tickLength;
+    std::vector<std::vector<Entry>> m_wheel;
+    int64_t m_lastTick;
+    uint64_t m_seq;
+
+    // pin ID -> sequence number and deadline of its current entry
+    std::unordered_map<uint8_t, Entry> m_pending;
+};
@@ -273,7 +273,9 @@ public:
         if (mat.empty())
             return;
 
-        self->m_rawOut->push(Frame(cvMatToVips(mat), self->m_recFrameCount++, frameTime));
+        // the frame buffer belongs to the Miniscope library, which may capture the next
+        // frame into it while the VIPS image still shares it, so we need our own copy
+        self->m_rawOut->push(Frame(cvMatToVips(mat.clone()), self->m_recFrameCount++, frameTime));
 
         if (orientation[4] < 0.05) {
             if (self->m_lastOrientationVec == orientation)
@@ -306,7 +308,7 @@ public:
         const auto self = static_cast<MiniscopeModule *>(udata);
         if (!self->m_acceptFrames)
             return;
-        self->m_dispOut->push(Frame(cvMatToVips(mat), time));
+        self->m_dispOut->push(Frame(cvMatToVips(mat.clone()), time));
     }
 
     static void on_controlValueChanged(const QString &id, double dispValue, double devValue, void *udata)
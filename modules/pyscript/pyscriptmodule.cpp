@@ -171,7 +171,12 @@ public:
             return false;
         }
 
+        GlobalConfig gconf;
+        setKeepProcessWarm(gconf.warmPythonWorkers());
+
         setInitialized();
+        if (keepProcessWarm())
+            warmUpProcess();
         return true;
     }
 
@@ -187,7 +192,10 @@ public:
     void stop() override
     {
         MLinkModule::stop();
-        terminateProcess();
+
+        // a warm worker resets itself when it receives the script for the next run
+        if (!keepProcessWarm())
+            terminateProcess();
         m_portEditAction->setEnabled(true);
     }
 
@@ -90,6 +90,12 @@ public:
         m_paStream->start();
         m_tempStream->start();
 
+        // the device sends one sample per period, which takes us very little CPU time to process
+        if (m_settingsDlg->samplingRate() > 0) {
+            const auto period = microseconds_t(1000 * 1000 / m_settingsDlg->samplingRate());
+            setPeriodicTiming({period, std::max(period / 20, microseconds_t(50)), period});
+        }
+
         // set up clock synchronizer
         m_clockSync = initClockSynchronizer(m_settingsDlg->samplingRate());
         m_clockSync->setStrategies(TimeSyncStrategy::SHIFT_TIMESTAMPS_FWD | TimeSyncStrategy::SHIFT_TIMESTAMPS_BWD);
@@ -194,6 +200,7 @@ public:
                 continue;
             }
 
+            beginPeriodicCycle();
             QByteArray sensorDataRaw;
             auto dataRecvTime = FUNC_DONE_TIMESTAMP(
                 m_syTimer->startTime(), sensorDataRaw = serial.readLine().trimmed());
@@ -231,6 +238,7 @@ public:
                 m_paStream->push(paBlock);
                 m_tempStream->push(cBlock);
             }
+            endPeriodicCycle();
         }
 
         // stop measuring
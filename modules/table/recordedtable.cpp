@@ -20,16 +20,22 @@
 #include "recordedtable.h"
 
 #include <QDebug>
-#include <QFile>
 #include <QHeaderView>
 #include <QMessageBox>
-#include <QTableWidget>
+#include <QTableView>
 #include <QVBoxLayout>
 #include <QLabel>
 
+#include "tablecsvwriter.h"
+#include "tablerowmodel.h"
+
+// interval in which new rows are added to the table display, ~30 Hz is plenty for humans to read along
+static constexpr int TABLE_DISPLAY_UPDATE_INTERVAL_MSEC = 33;
+
 RecordedTable::RecordedTable(QObject *parent, const QIcon &winIcon)
     : QObject(parent),
       m_name(QString()),
+      m_pendingSkippedRows(0),
       m_saveData(true),
       m_displayData(true)
 {
@@ -42,28 +48,41 @@ RecordedTable::RecordedTable(QObject *parent, const QIcon &winIcon)
     else
         m_tableBox->setWindowIcon(winIcon);
 
-    m_tableWidget = new QTableWidget(m_tableBox);
-    m_tableWidget->horizontalHeader()->hide();
+    m_model = new TableRowModel(this);
+    m_model->setMaxRows(TABLE_MAX_DISPLAY_ROWS);
+    m_tableView = new QTableView(m_tableBox);
+    m_tableView->setModel(m_model);
+    m_tableView->horizontalHeader()->hide();
+
+    // all rows have the same height, so Qt doesn't need to measure every row's contents
+    m_tableView->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    m_tableView->verticalHeader()->setDefaultSectionSize(m_tableView->fontMetrics().height() + 6);
+    m_tableView->horizontalHeader()->setSectionResizeMode(QHeaderView::Interactive);
 
     auto layout = new QVBoxLayout(m_tableBox);
     layout->setMargin(2);
     m_tableBox->setLayout(layout);
-    layout->addWidget(m_tableWidget);
+    layout->addWidget(m_tableView);
 
     m_infoLabel = new QLabel("Ready", m_tableBox);
     m_infoLabel->setAlignment(Qt::AlignLeft | Qt::AlignVCenter);
     m_infoLabel->setFixedHeight(20);
     layout->addWidget(m_infoLabel);
 
-    m_eventFile = new QFile;
+    m_csvWriter = std::make_unique<TableCsvWriter>();
     m_haveEvents = false;
     m_infoLabel->setVisible(false);
+
+    // we add new rows to the display in batches, instead of touching the view for every single row
+    m_displayTimer = new QTimer(this);
+    m_displayTimer->setInterval(TABLE_DISPLAY_UPDATE_INTERVAL_MSEC);
+    connect(m_displayTimer, &QTimer::timeout, this, &RecordedTable::flushPendingRows);
 }
 
 RecordedTable::~RecordedTable()
 {
+    m_csvWriter->close();
     delete m_tableBox;
-    delete m_eventFile;
 }
 
 QString RecordedTable::name() const
@@ -101,16 +120,26 @@ void RecordedTable::setDisplayData(bool display)
 
 bool RecordedTable::open(const QString &fileName)
 {
-    m_eventFileName = fileName;
-    close();
-    m_eventFile->setFileName(m_eventFileName);
-    return m_eventFile->open(QFile::WriteOnly | QFile::Truncate);
+    return m_csvWriter->open(fileName);
 }
 
 void RecordedTable::close()
 {
-    if (m_eventFile->isOpen())
-        m_eventFile->close();
+    m_csvWriter->close();
+
+    // display whatever we still have pending
+    m_displayTimer->stop();
+    flushPendingRows();
+}
+
+bool RecordedTable::hasWriteError() const
+{
+    return m_csvWriter->hasError();
+}
+
+QString RecordedTable::lastWriteError() const
+{
+    return m_csvWriter->lastError();
 }
 
 void RecordedTable::show()
@@ -125,7 +154,9 @@ void RecordedTable::hide()
 
 void RecordedTable::reset()
 {
-    m_tableWidget->setRowCount(0);
+    m_pendingRows.clear();
+    m_pendingSkippedRows = 0;
+    m_model->clear();
     m_haveEvents = false;
 }
 
@@ -139,61 +170,52 @@ void RecordedTable::setHeader(const QStringList &headers)
         return;
     }
 
-    m_tableWidget->horizontalHeader()->show();
-    m_tableWidget->setColumnCount(headers.count());
-    m_tableWidget->setHorizontalHeaderLabels(headers);
+    m_tableView->horizontalHeader()->show();
+    m_model->setHeader(headers);
 
     // write headers
-    if (!m_eventFile->isOpen())
-        return;
-    QTextStream tsout(m_eventFile);
-    auto csvHdr = headers;
-    tsout << csvHdr.replaceInStrings(QStringLiteral(";"), QStringLiteral("；")).join(";") << "\n";
+    if (m_csvWriter->isOpen())
+        m_csvWriter->enqueueRow(headers);
 }
 
 void RecordedTable::addRows(const QStringList &data)
 {
     m_haveEvents = true;
 
-    if (m_saveData) {
-        // write to file if file is opened
-        if (!m_eventFile->isOpen())
-            return;
-        QTextStream tsout(m_eventFile);
-
-        // since our tables are semicolon-separated, we replace the "regular" semicolon
-        // with a unicode fullwith semicolon (U+FF1B). That way, users of the table module
-        // can use pretty much any character they want and a machine-readable CSV table will be generated.
-        auto csvRows = data;
-        tsout << csvRows.replaceInStrings(QStringLiteral(";"), QStringLiteral("；")).join(";") << "\n";
-    }
+    // write to file if file is opened
+    if (m_saveData && m_csvWriter->isOpen())
+        m_csvWriter->enqueueRow(data);
 
     // exit if we shouldn't display data
     if (!m_displayData)
         return;
 
-    auto columnCount = m_tableWidget->columnCount();
-    if (columnCount < data.count()) {
-        // create necessary amount of columns
-        if (columnCount == 0) {
-            m_tableWidget->setColumnCount(data.count());
-        } else {
-            for (auto i = columnCount; i < data.count(); i++)
-                m_tableWidget->insertColumn(i);
-        }
+    // queue row for the next display update - if we are queueing more than we could display,
+    // we can drop the oldest pending rows right away (the model still needs to count them)
+    if (m_pendingRows.size() >= static_cast<size_t>(m_model->maxRows())) {
+        const auto dropCount = m_pendingRows.size() / 2;
+        m_pendingRows.erase(m_pendingRows.begin(), m_pendingRows.begin() + dropCount);
+        m_pendingSkippedRows += static_cast<qint64>(dropCount);
     }
+    m_pendingRows.push_back(data);
 
-    auto lastRowId = m_tableWidget->rowCount();
-    m_tableWidget->setRowCount(lastRowId + 1);
+    if (!m_displayTimer->isActive())
+        m_displayTimer->start();
+}
 
-    for (auto i = 0; i < data.count(); i++) {
-        auto item = new QTableWidgetItem(data.at(i));
-        item->setFlags(item->flags() ^ Qt::ItemIsEditable);
-        m_tableWidget->setItem(lastRowId, i, item);
+void RecordedTable::flushPendingRows()
+{
+    if (m_pendingRows.empty()) {
+        m_displayTimer->stop();
+        return;
     }
 
+    m_model->appendRows(m_pendingRows, m_pendingSkippedRows);
+    m_pendingRows.clear();
+    m_pendingSkippedRows = 0;
+
     // scroll to the last item
-    m_tableWidget->scrollToBottom();
+    m_tableView->scrollToBottom();
 }
 
 const QRect &RecordedTable::geometry() const
@@ -22,9 +22,13 @@
 #include <QIcon>
 #include <QObject>
 #include <QLabel>
+#include <QTimer>
+#include <memory>
+#include <vector>
 
-class QTableWidget;
-class QFile;
+class QTableView;
+class TableRowModel;
+class TableCsvWriter;
 
 class RecordedTable : public QObject
 {
@@ -44,6 +48,8 @@ public:
 
     bool open(const QString &fileName);
     void close();
+    bool hasWriteError() const;
+    QString lastWriteError() const;
 
     void show();
     void hide();
@@ -57,17 +63,24 @@ public:
 
     QWidget *widget() const;
 
+private slots:
+    void flushPendingRows();
+
 private:
     void updateInfoLabel();
 
 private:
     QWidget *m_tableBox;
     QLabel *m_infoLabel;
-    QTableWidget *m_tableWidget;
-    QFile *m_eventFile;
-    QString m_eventFileName;
+    QTableView *m_tableView;
+    TableRowModel *m_model;
+    std::unique_ptr<TableCsvWriter> m_csvWriter;
     QString m_name;
 
+    std::vector<QStringList> m_pendingRows;
+    qint64 m_pendingSkippedRows;
+    QTimer *m_displayTimer;
+
     bool m_haveEvents;
     bool m_saveData;
     bool m_displayData;
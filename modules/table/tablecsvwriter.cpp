@@ -0,0 +1,174 @@
+/*
+ * Copyright (C) 2019-2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tablecsvwriter.h"
+
+#include <QDebug>
+#include <pthread.h>
+
+// write to disk once we have accumulated this many bytes
+static constexpr int CSV_WRITE_CHUNK_SIZE = 256 * 1024;
+
+TableCsvWriter::TableCsvWriter()
+    : m_running(false),
+      m_failed(false)
+{
+    m_buffer.reserve(CSV_WRITE_CHUNK_SIZE + 4096);
+}
+
+TableCsvWriter::~TableCsvWriter()
+{
+    close();
+}
+
+bool TableCsvWriter::open(const QString &fileName)
+{
+    close();
+
+    m_failed = false;
+    m_lastError.clear();
+    m_queue.clear();
+    m_buffer.clear();
+
+    m_file.setFileName(fileName);
+    if (!m_file.open(QFile::WriteOnly | QFile::Truncate)) {
+        m_lastError = m_file.errorString();
+        m_failed = true;
+        return false;
+    }
+
+    m_running = true;
+    m_thread = std::thread(&TableCsvWriter::writerThread, this);
+    pthread_setname_np(m_thread.native_handle(), "table_csvwrite");
+
+    return true;
+}
+
+void TableCsvWriter::close()
+{
+    if (m_thread.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_running = false;
+        }
+        m_cond.notify_one();
+        m_thread.join();
+    }
+
+    if (m_file.isOpen())
+        m_file.close();
+}
+
+bool TableCsvWriter::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+void TableCsvWriter::enqueueRow(const QStringList &row)
+{
+    if (!m_running || m_failed)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_queue.push_back(row);
+    }
+    m_cond.notify_one();
+}
+
+bool TableCsvWriter::hasError() const
+{
+    return m_failed;
+}
+
+QString TableCsvWriter::lastError() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_lastError;
+}
+
+void TableCsvWriter::formatRow(const QStringList &row)
+{
+    // since our tables are semicolon-separated, we replace the "regular" semicolon
+    // with a unicode fullwith semicolon (U+FF1B). That way, users of the table module
+    // can use pretty much any character they want and a machine-readable CSV table will be generated.
+    for (int i = 0; i < row.size(); i++) {
+        if (i > 0)
+            m_buffer.append(';');
+
+        const auto &cell = row[i];
+        if (cell.contains(QLatin1Char(';')))
+            m_buffer.append(QString(cell).replace(QStringLiteral(";"), QStringLiteral("；")).toUtf8());
+        else
+            m_buffer.append(cell.toUtf8());
+    }
+    m_buffer.append('\n');
+}
+
+bool TableCsvWriter::flushBuffer()
+{
+    if (m_buffer.isEmpty())
+        return true;
+
+    const auto written = m_file.write(m_buffer);
+    m_buffer.clear();
+    if (written < 0) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_lastError = m_file.errorString();
+        m_failed = true;
+        return false;
+    }
+
+    return true;
+}
+
+void TableCsvWriter::writerThread()
+{
+    std::vector<QStringList> rows;
+
+    while (true) {
+        bool running;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait_for(lock, std::chrono::milliseconds(500), [&] {
+                return !m_queue.empty() || !m_running;
+            });
+            rows.swap(m_queue);
+            running = m_running;
+        }
+
+        for (const auto &row : rows)
+            formatRow(row);
+
+        // write in big chunks while data is streaming in, and also write everything we have
+        // in case nothing new arrived for a while, so data hits the disk in a timely manner
+        if (m_buffer.size() >= CSV_WRITE_CHUNK_SIZE || rows.empty() || !running) {
+            if (!flushBuffer()) {
+                qWarning().noquote() << "Unable to write table data:" << lastError();
+                break;
+            }
+        }
+        rows.clear();
+
+        if (!running)
+            break;
+    }
+
+    m_file.flush();
+}
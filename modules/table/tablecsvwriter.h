@@ -0,0 +1,72 @@
+/*
+ * Copyright (C) 2019-2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QFile>
+#include <QStringList>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Writes semicolon-separated table rows from a background thread
+ *
+ * Rows are queued by the caller without blocking on disk I/O. The writer
+ * thread formats them into a large buffer and only writes to the file
+ * once a sizeable chunk has accumulated, or when no new data arrived for
+ * a little while.
+ */
+class TableCsvWriter
+{
+public:
+    explicit TableCsvWriter();
+    ~TableCsvWriter();
+
+    bool open(const QString &fileName);
+    void close();
+    bool isOpen() const;
+
+    void enqueueRow(const QStringList &row);
+
+    bool hasError() const;
+    QString lastError() const;
+
+private:
+    Q_DISABLE_COPY(TableCsvWriter)
+
+    void writerThread();
+    void formatRow(const QStringList &row);
+    bool flushBuffer();
+
+    QFile m_file;
+    std::thread m_thread;
+    std::atomic_bool m_running;
+    std::atomic_bool m_failed;
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+    std::vector<QStringList> m_queue;
+    QString m_lastError;
+
+    // only ever touched by the writer thread
+    QByteArray m_buffer;
+};
@@ -144,12 +144,19 @@ public:
         if (!m_rowSub)
             return;
 
-        auto maybeRow = m_rowSub->peekNext();
-        if (!maybeRow.has_value())
-            return;
+        // fetch everything that is pending (within limits, to not starve the UI),
+        // the table will only update its display at a sensible rate anyway
+        for (uint i = 0; i < 4096; i++) {
+            auto maybeRow = m_rowSub->peekNext();
+            if (!maybeRow.has_value())
+                break;
+            m_recTable->addRows(maybeRow->data);
+        }
 
-        const auto row = maybeRow.value();
-        m_recTable->addRows(row.data);
+        if (m_recTable->hasWriteError()) {
+            raiseError(QStringLiteral("Unable to write table data: %1").arg(m_recTable->lastWriteError()));
+            m_rowSub.reset();
+        }
     }
 
     void stop() override
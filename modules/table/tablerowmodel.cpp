@@ -0,0 +1,169 @@
+/*
+ * Copyright (C) 2019-2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tablerowmodel.h"
+
+TableRowModel::TableRowModel(QObject *parent)
+    : QAbstractTableModel(parent),
+      m_columnCount(0),
+      m_maxRows(TABLE_MAX_DISPLAY_ROWS),
+      m_firstRowIndex(0)
+{
+}
+
+int TableRowModel::rowCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+    return static_cast<int>(m_rows.size());
+}
+
+int TableRowModel::columnCount(const QModelIndex &parent) const
+{
+    if (parent.isValid())
+        return 0;
+    return m_columnCount;
+}
+
+QVariant TableRowModel::data(const QModelIndex &index, int role) const
+{
+    if (!index.isValid() || role != Qt::DisplayRole)
+        return QVariant();
+    if (index.row() >= static_cast<int>(m_rows.size()))
+        return QVariant();
+
+    const auto &row = m_rows[index.row()];
+    if (index.column() >= row.size())
+        return QVariant();
+    return row.at(index.column());
+}
+
+QVariant TableRowModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (role != Qt::DisplayRole)
+        return QVariant();
+
+    if (orientation == Qt::Vertical) {
+        // show the absolute row number, even if older rows were already dropped
+        return m_firstRowIndex + section + 1;
+    }
+
+    if (section < m_header.size())
+        return m_header.at(section);
+    return section + 1;
+}
+
+Qt::ItemFlags TableRowModel::flags(const QModelIndex &index) const
+{
+    if (!index.isValid())
+        return Qt::NoItemFlags;
+    return Qt::ItemIsEnabled | Qt::ItemIsSelectable;
+}
+
+int TableRowModel::maxRows() const
+{
+    return m_maxRows;
+}
+
+void TableRowModel::setMaxRows(int maxRows)
+{
+    m_maxRows = maxRows > 0 ? maxRows : 1;
+}
+
+void TableRowModel::setHeader(const QStringList &headers)
+{
+    beginResetModel();
+    m_header = headers;
+    m_columnCount = std::max(m_columnCount, static_cast<int>(headers.size()));
+    endResetModel();
+}
+
+bool TableRowModel::hasHeader() const
+{
+    return !m_header.isEmpty();
+}
+
+/**
+ * Add @p rows to the end of the table. @p skippedRows were received before them,
+ * but were dropped without ever being added, and only count towards the row numbers.
+ */
+void TableRowModel::appendRows(const std::vector<QStringList> &rows, qint64 skippedRows)
+{
+    if (skippedRows > 0) {
+        // we only ever show consecutive rows, so nothing we have can be shown next to the new ones
+        if (!m_rows.empty()) {
+            beginRemoveRows(QModelIndex(), 0, static_cast<int>(m_rows.size()) - 1);
+            m_firstRowIndex += static_cast<qint64>(m_rows.size());
+            m_rows.clear();
+            endRemoveRows();
+        }
+        m_firstRowIndex += skippedRows;
+    }
+    if (rows.empty())
+        return;
+
+    // if we got more rows than we can display at all, only look at the most recent ones
+    const auto newCount = std::min(rows.size(), static_cast<size_t>(m_maxRows));
+    const auto firstNew = rows.size() - newCount;
+
+    // drop old rows in chunks (10% of the window), so we don't emit a removal for every single new row
+    // once the window is full
+    const auto currentCount = m_rows.size();
+    if (currentCount + newCount > static_cast<size_t>(m_maxRows)) {
+        auto dropCount = currentCount + newCount - m_maxRows;
+        dropCount = std::min(currentCount, dropCount + static_cast<size_t>(m_maxRows / 10));
+        if (dropCount > 0) {
+            beginRemoveRows(QModelIndex(), 0, static_cast<int>(dropCount) - 1);
+            m_rows.erase(m_rows.begin(), m_rows.begin() + dropCount);
+            m_firstRowIndex += dropCount;
+            endRemoveRows();
+        }
+    }
+    m_firstRowIndex += firstNew;
+
+    // create necessary amount of columns
+    int maxColumns = m_columnCount;
+    for (size_t i = firstNew; i < rows.size(); i++)
+        maxColumns = std::max(maxColumns, static_cast<int>(rows[i].size()));
+    if (maxColumns > m_columnCount) {
+        beginInsertColumns(QModelIndex(), m_columnCount, maxColumns - 1);
+        m_columnCount = maxColumns;
+        endInsertColumns();
+    }
+
+    const auto firstRow = static_cast<int>(m_rows.size());
+    beginInsertRows(QModelIndex(), firstRow, firstRow + static_cast<int>(newCount) - 1);
+    m_rows.insert(m_rows.end(), rows.begin() + firstNew, rows.end());
+    endInsertRows();
+}
+
+void TableRowModel::clear()
+{
+    beginResetModel();
+    m_rows.clear();
+    m_header.clear();
+    m_columnCount = 0;
+    m_firstRowIndex = 0;
+    endResetModel();
+}
+
+qint64 TableRowModel::totalRowCount() const
+{
+    return m_firstRowIndex + static_cast<qint64>(m_rows.size());
+}
@@ -0,0 +1,69 @@
+/*
+ * Copyright (C) 2019-2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QAbstractTableModel>
+#include <QStringList>
+#include <deque>
+#include <vector>
+
+// maximum number of most recent rows kept for display
+static constexpr int TABLE_MAX_DISPLAY_ROWS = 20000;
+
+/**
+ * @brief Append-only table model with a capped row window
+ *
+ * Rows are stored as the (implicitly shared) string lists we receive from
+ * the stream, so appending a row never copies cell data. Only the last
+ * maxRows() rows are kept, older rows are dropped in chunks to keep the
+ * amount of model change notifications low.
+ */
+class TableRowModel : public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    explicit TableRowModel(QObject *parent = nullptr);
+
+    int rowCount(const QModelIndex &parent = QModelIndex()) const override;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const override;
+
+    QVariant data(const QModelIndex &index, int role = Qt::DisplayRole) const override;
+    QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+    Qt::ItemFlags flags(const QModelIndex &index) const override;
+
+    int maxRows() const;
+    void setMaxRows(int maxRows);
+
+    void setHeader(const QStringList &headers);
+    bool hasHeader() const;
+
+    void appendRows(const std::vector<QStringList> &rows, qint64 skippedRows = 0);
+    void clear();
+
+    qint64 totalRowCount() const;
+
+private:
+    QStringList m_header;
+    std::deque<QStringList> m_rows;
+    int m_columnCount;
+    int m_maxRows;
+    qint64 m_firstRowIndex;
+};
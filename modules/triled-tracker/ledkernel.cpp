@@ -0,0 +1,300 @@
+/**
+ * Copyright (C) 2016-2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ledkernel.h"
+
+#include <algorithm>
+#include <cstring>
+#include <opencv2/core/utility.hpp>
+
+// the closing kernel is 6x6 with OpenCV's default anchor (3, 3), so it covers
+// the offsets -3 ... +2 around each pixel in both directions
+static constexpr int MORPH_OFFSET_LOW = 3;
+static constexpr int MORPH_OFFSET_HIGH = 2;
+
+static inline uchar bgrToGray(int c0, int c1, int c2)
+{
+    // same fixed-point weights cv::cvtColor() uses for COLOR_BGR2GRAY
+    return static_cast<uchar>((c0 * 1868 + c1 * 9617 + c2 * 4899 + (1 << 13)) >> 14);
+}
+
+template<int CN>
+static void grayRow(const uchar *src, uchar *gray, int count)
+{
+    for (int x = 0; x < count; x++) {
+        const uchar *px = src + x * CN;
+        gray[x] = bgrToGray(px[0], px[1], px[2]);
+    }
+}
+
+template<int CN>
+static void grayLabelRow(
+    const uchar *src,
+    uchar *gray,
+    uchar *labels,
+    int count,
+    const std::array<LedDetector::ColorRange, 3> &ranges)
+{
+    // copy thresholds to locals, so the compiler can keep them in registers and vectorize the loop
+    uchar lo[3][3], hi[3][3];
+    for (int i = 0; i < 3; i++) {
+        for (int c = 0; c < 3; c++) {
+            lo[i][c] = ranges[i].min[c];
+            hi[i][c] = ranges[i].max[c];
+        }
+    }
+
+    for (int x = 0; x < count; x++) {
+        const uchar *px = src + x * CN;
+        const uchar c0 = px[0];
+        const uchar c1 = px[1];
+        const uchar c2 = px[2];
+
+        gray[x] = bgrToGray(c0, c1, c2);
+
+        uchar label = 0;
+        for (int i = 0; i < 3; i++) {
+            const uchar inRange = (c0 >= lo[i][0]) & (c0 <= hi[i][0]) & (c1 >= lo[i][1]) & (c1 <= hi[i][1])
+                                  & (c2 >= lo[i][2]) & (c2 <= hi[i][2]);
+            label |= static_cast<uchar>(inRange << i);
+        }
+        labels[x] = label;
+    }
+}
+
+template<int CN>
+static void classifyRange(
+    const cv::Mat &image,
+    cv::Mat &gray,
+    cv::Mat &labels,
+    const cv::Rect &roi,
+    bool computeGray,
+    const std::array<LedDetector::ColorRange, 3> &ranges,
+    const cv::Range &rows)
+{
+    const auto roiEnd = roi.x + roi.width;
+    for (int y = rows.start; y < rows.end; y++) {
+        const auto src = image.ptr<uchar>(y);
+        const auto grayRowPtr = gray.ptr<uchar>(y);
+
+        if (y < roi.y || y >= roi.y + roi.height) {
+            if (computeGray)
+                grayRow<CN>(src, grayRowPtr, image.cols);
+            continue;
+        }
+
+        if (computeGray)
+            grayRow<CN>(src, grayRowPtr, roi.x);
+        grayLabelRow<CN>(src + roi.x * CN, grayRowPtr + roi.x, labels.ptr<uchar>(y) + roi.x, roi.width, ranges);
+        if (computeGray)
+            grayRow<CN>(src + roiEnd * CN, grayRowPtr + roiEnd, image.cols - roiEnd);
+    }
+}
+
+/**
+ * One horizontal pass of a binary dilation (bitwise OR) or erosion (bitwise AND).
+ * Since every bit of a label is one independent mask, this processes all three
+ * color masks at once. Pixels outside of the image are ignored, like OpenCV does
+ * with its default morphology border value.
+ */
+template<bool DILATE>
+static void morphRowPass(const uchar *src, uchar *dst, int width)
+{
+    const auto combineClamped = [&](int x) {
+        uchar v = DILATE ? 0x00 : 0xFF;
+        const auto kEnd = std::min(width - 1, x + MORPH_OFFSET_HIGH);
+        for (int k = std::max(0, x - MORPH_OFFSET_LOW); k <= kEnd; k++)
+            v = DILATE ? (v | src[k]) : (v & src[k]);
+        return v;
+    };
+
+    int x = 0;
+    for (; x < std::min(MORPH_OFFSET_LOW, width); x++)
+        dst[x] = combineClamped(x);
+    for (; x < width - MORPH_OFFSET_HIGH; x++) {
+        if (DILATE)
+            dst[x] = src[x - 3] | src[x - 2] | src[x - 1] | src[x] | src[x + 1] | src[x + 2];
+        else
+            dst[x] = src[x - 3] & src[x - 2] & src[x - 1] & src[x] & src[x + 1] & src[x + 2];
+    }
+    for (; x < width; x++)
+        dst[x] = combineClamped(x);
+}
+
+template<bool DILATE>
+static void morphColumnPass(const cv::Mat &src, cv::Mat &dst)
+{
+    const auto width = src.cols;
+    const auto height = src.rows;
+    for (int y = 0; y < height; y++) {
+        const auto yStart = std::max(0, y - MORPH_OFFSET_LOW);
+        const auto yEnd = std::min(height - 1, y + MORPH_OFFSET_HIGH);
+
+        auto d = dst.ptr<uchar>(y);
+        std::memcpy(d, src.ptr<uchar>(yStart), width);
+        for (int yy = yStart + 1; yy <= yEnd; yy++) {
+            const auto s = src.ptr<uchar>(yy);
+            for (int x = 0; x < width; x++)
+                d[x] = DILATE ? (d[x] | s[x]) : (d[x] & s[x]);
+        }
+    }
+}
+
+LedDetector::LedDetector()
+    : m_searchRadius(0)
+{
+    // default thresholds for the LEDs on our tracking headstage, in the channel order of the frame
+    setColorRange(LedRed, cv::Vec3b(0, 0, 180), cv::Vec3b(80, 80, 255));
+    setColorRange(LedGreen, cv::Vec3b(0, 220, 0), cv::Vec3b(110, 255, 180));
+    setColorRange(LedBlue, cv::Vec3b(210, 0, 0), cv::Vec3b(255, 240, 70));
+
+    reset();
+}
+
+void LedDetector::setColorRange(LedColor color, const cv::Vec3b &min, const cv::Vec3b &max)
+{
+    m_ranges[color].min = min;
+    m_ranges[color].max = max;
+}
+
+int LedDetector::searchRadius() const
+{
+    return m_searchRadius;
+}
+
+void LedDetector::setSearchRadius(int radius)
+{
+    m_searchRadius = radius > 0 ? radius : 0;
+}
+
+const cv::Mat &LedDetector::grayFrame() const
+{
+    return m_gray;
+}
+
+void LedDetector::reset()
+{
+    m_lastPositions.fill(cv::Point(-1, -1));
+}
+
+void LedDetector::classify(const cv::Mat &image, const cv::Rect &roi, bool computeGray)
+{
+    const auto cn = image.channels();
+    cv::parallel_for_(cv::Range(0, image.rows), [&](const cv::Range &rows) {
+        if (cn == 4)
+            classifyRange<4>(image, m_gray, m_labels, roi, computeGray, m_ranges, rows);
+        else
+            classifyRange<3>(image, m_gray, m_labels, roi, computeGray, m_ranges, rows);
+    });
+}
+
+void LedDetector::closeLabels(const cv::Rect &roi)
+{
+    cv::Mat labels(m_labels, roi);
+    cv::Mat tmp(m_labelsTmp, roi);
+
+    // dilate
+    for (int y = 0; y < labels.rows; y++)
+        morphRowPass<true>(labels.ptr<uchar>(y), tmp.ptr<uchar>(y), labels.cols);
+    morphColumnPass<true>(tmp, labels);
+
+    // erode
+    for (int y = 0; y < labels.rows; y++)
+        morphRowPass<false>(labels.ptr<uchar>(y), tmp.ptr<uchar>(y), labels.cols);
+    morphColumnPass<false>(tmp, labels);
+}
+
+void LedDetector::findMaxima(const cv::Rect &roi, std::array<cv::Point, 3> &positions)
+{
+    // a maximum of zero counts as "not found", just like with cv::minMaxLoc() on a masked image
+    std::array<uchar, 3> maxVal = {0, 0, 0};
+    positions.fill(cv::Point(-1, -1));
+
+    for (int y = roi.y; y < roi.y + roi.height; y++) {
+        const auto labels = m_labels.ptr<uchar>(y);
+        const auto gray = m_gray.ptr<uchar>(y);
+        for (int x = roi.x; x < roi.x + roi.width; x++) {
+            const auto label = labels[x];
+            if (label == 0)
+                continue;
+
+            // strictly greater, so the first maximum in raster order wins
+            const auto value = gray[x];
+            for (int i = 0; i < 3; i++) {
+                if ((label & (1 << i)) && value > maxVal[i]) {
+                    maxVal[i] = value;
+                    positions[i] = cv::Point(x, y);
+                }
+            }
+        }
+    }
+}
+
+void LedDetector::detect(const cv::Mat &image, std::array<cv::Point, 3> &positions)
+{
+    CV_Assert(image.depth() == CV_8U && (image.channels() == 3 || image.channels() == 4));
+
+    // these are no-ops unless the frame size changed
+    m_gray.create(image.size(), CV_8UC1);
+    m_labels.create(image.size(), CV_8UC1);
+    m_labelsTmp.create(image.size(), CV_8UC1);
+
+    const cv::Rect fullRect(0, 0, image.cols, image.rows);
+    auto roi = fullRect;
+
+    bool haveLastPositions = m_searchRadius > 0;
+    for (const auto &pos : m_lastPositions)
+        haveLastPositions = haveLastPositions && pos.x >= 0 && pos.y >= 0;
+    if (haveLastPositions) {
+        int xMin = image.cols, yMin = image.rows, xMax = 0, yMax = 0;
+        for (const auto &pos : m_lastPositions) {
+            xMin = std::min(xMin, pos.x);
+            yMin = std::min(yMin, pos.y);
+            xMax = std::max(xMax, pos.x);
+            yMax = std::max(yMax, pos.y);
+        }
+        roi = cv::Rect(
+                  xMin - m_searchRadius,
+                  yMin - m_searchRadius,
+                  xMax - xMin + 2 * m_searchRadius + 1,
+                  yMax - yMin + 2 * m_searchRadius + 1)
+              & fullRect;
+        if (roi.empty())
+            roi = fullRect;
+    }
+
+    classify(image, roi, true);
+    closeLabels(roi);
+    findMaxima(roi, positions);
+
+    if (roi != fullRect) {
+        bool allFound = true;
+        for (const auto &pos : positions)
+            allFound = allFound && pos.x >= 0;
+
+        if (!allFound) {
+            // we lost at least one LED, look at the whole frame again
+            classify(image, fullRect, false);
+            closeLabels(fullRect);
+            findMaxima(fullRect, positions);
+        }
+    }
+
+    m_lastPositions = positions;
+}
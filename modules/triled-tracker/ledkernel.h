@@ -0,0 +1,83 @@
+/**
+ * Copyright (C) 2016-2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <array>
+#include <opencv2/core.hpp>
+
+/**
+ * @brief Finds the brightest red, green and blue LED spot in a frame
+ *
+ * Produces the same result as thresholding the frame once per color with cv::inRange(),
+ * closing the resulting mask with a 6x6 kernel and taking the brightest grayscale pixel
+ * under each mask - but does so with one fused pass over the frame that computes the
+ * grayscale image and a combined three-bit color label plane at the same time.
+ * All intermediate buffers are kept between frames.
+ *
+ * If a search radius is set, only the area around the last known LED positions is
+ * classified, and we fall back to the full frame in case one of the LEDs was lost.
+ */
+class LedDetector
+{
+public:
+    enum LedColor {
+        LedRed = 0,
+        LedGreen = 1,
+        LedBlue = 2
+    };
+
+    struct ColorRange {
+        cv::Vec3b min;
+        cv::Vec3b max;
+    };
+
+    explicit LedDetector();
+
+    void setColorRange(LedColor color, const cv::Vec3b &min, const cv::Vec3b &max);
+
+    int searchRadius() const;
+    void setSearchRadius(int radius);
+
+    /**
+     * Run detection on an 8-bit, 3-channel frame. Positions of LEDs that were not
+     * found are set to (-1, -1).
+     */
+    void detect(const cv::Mat &image, std::array<cv::Point, 3> &positions);
+
+    /**
+     * Grayscale version of the last frame passed to detect(), always for the full frame.
+     */
+    const cv::Mat &grayFrame() const;
+
+    void reset();
+
+private:
+    void classify(const cv::Mat &image, const cv::Rect &roi, bool computeGray);
+    void closeLabels(const cv::Rect &roi);
+    void findMaxima(const cv::Rect &roi, std::array<cv::Point, 3> &positions);
+
+    std::array<ColorRange, 3> m_ranges;
+    int m_searchRadius;
+    std::array<cv::Point, 3> m_lastPositions;
+
+    cv::Mat m_gray;
+    cv::Mat m_labels;
+    cv::Mat m_labelsTmp;
+};
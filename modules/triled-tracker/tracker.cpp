@@ -28,6 +28,8 @@
 #include <opencv2/highgui/highgui.hpp>
 #include <opencv2/imgproc/imgproc.hpp>
 
+#include "datactl/vipsutils.h"
+
 Tracker::Tracker(std::shared_ptr<DataStream<TableRow>> dataStream, const QString &subjectId)
     : QObject(nullptr),
       m_initialized(false),
@@ -81,11 +83,19 @@ bool Tracker::initialize()
     m_mazeRect = std::vector<cv::Point2f>();
     m_mazeFindTrialCount = 0;
 
+    // forget about previous LED positions
+    m_ledDetector.reset();
+
     m_firstFrame = true;
     m_initialized = true;
     return true;
 }
 
+void Tracker::setLedSearchRadius(int radius)
+{
+    m_ledDetector.setSearchRadius(radius);
+}
+
 void Tracker::analyzeFrame(const cv::Mat &frame, const milliseconds_t time, cv::Mat *trackingFrame, cv::Mat *infoFrame)
 {
     // do the tracking on the source frame
@@ -218,40 +228,6 @@ static std::vector<cv::Point2f> findCornerBlobs(const cv::Mat &grayMat)
     return mazeRect;
 }
 
-static cv::Point findMaxColorBrightness(
-    const cv::Mat &image,
-    const cv::Mat &imageGray,
-    cv::Scalar minColors,
-    cv::Scalar maxColors)
-{
-    double maxVal;
-    cv::Point maxLoc;
-    cv::Mat colorMaskMat(image.size(), image.type());
-    cv::Mat colorMat(image.size(), image.type());
-
-    // create matrix with pixels in range
-    cv::inRange(image, minColors, maxColors, colorMaskMat);
-    // remove noise
-    cv::morphologyEx(colorMaskMat, colorMaskMat, cv::MORPH_CLOSE, cv::Mat::ones(6, 6, colorMaskMat.type()));
-
-    // find maximum
-    imageGray.copyTo(colorMat, colorMaskMat);
-    cv::minMaxLoc(
-        colorMat,
-        nullptr, // minimum value
-        &maxVal,
-        nullptr, // minimum location (Point),
-        &maxLoc,
-        cv::Mat());
-    if (((maxLoc.x == 0) && (maxLoc.y == 0)) && (maxVal == 0)) {
-        // we didn't find a maximum, our tracking dot vanished. Set an invalid point.
-        maxLoc.x = -1;
-        maxLoc.y = -1;
-    }
-
-    return maxLoc;
-}
-
 static double calculateTriangleGamma(Tracker::LEDTriangle &tri)
 {
     // sanity checks
@@ -347,34 +323,39 @@ static bool cvRectFuzzyEqual(
 
 Tracker::LEDTriangle Tracker::trackPoints(const cv::Mat &image, cv::Mat *infoFrame, cv::Mat *trackingFrame)
 {
-    cv::Point maxLoc;
     LEDTriangle res;
+    std::array<cv::Point, 3> leds;
 
-    cv::Mat trackMat(image.size(), image.type());
-    cv::Mat grayMat(image.size(), image.type());
+    // find all LEDs in one go, this also gives us the grayscale image
+    m_ledDetector.detect(image, leds);
+    const auto &grayMat = m_ledDetector.grayFrame();
+    auto &trackMat = m_trackMat;
+
+    // the output buffers of the previous frame may still be in use by VIPS images,
+    // only write to them again if nobody else is holding on to them
+    if (cvMatIsShared(trackMat))
+        trackMat.release();
+    if (cvMatIsShared(m_infoMat))
+        m_infoMat.release();
 
-    cv::cvtColor(image, grayMat, cv::COLOR_RGB2GRAY);
     cv::cvtColor(grayMat, trackMat, cv::COLOR_GRAY2RGBA);
 
     // colors are in BGR
 
     // red maximum
-    maxLoc = findMaxColorBrightness(image, grayMat, cv::Scalar(0, 0, 180), cv::Scalar(80, 80, 255));
-    if (maxLoc.x > 0)
-        cv::circle(trackMat, maxLoc, 6, cv::Scalar(0, 0, 255), -1); // BGR colors
-    res.red = maxLoc;
+    res.red = leds[LedDetector::LedRed];
+    if (res.red.x > 0)
+        cv::circle(trackMat, res.red, 6, cv::Scalar(0, 0, 255), -1); // BGR colors
 
     // green maximum
-    maxLoc = findMaxColorBrightness(image, grayMat, cv::Scalar(0, 220, 0), cv::Scalar(110, 255, 180));
-    if (maxLoc.x > 0)
-        cv::circle(trackMat, maxLoc, 6, cv::Scalar(0, 255, 0), -1); // BGR colors
-    res.green = maxLoc;
+    res.green = leds[LedDetector::LedGreen];
+    if (res.green.x > 0)
+        cv::circle(trackMat, res.green, 6, cv::Scalar(0, 255, 0), -1); // BGR colors
 
     // blue maximum
-    maxLoc = findMaxColorBrightness(image, grayMat, cv::Scalar(210, 0, 0), cv::Scalar(255, 240, 70));
-    if (maxLoc.x > 0)
-        cv::circle(trackMat, maxLoc, 6, cv::Scalar(255, 0, 0), -1); // BGR colors
-    res.blue = maxLoc;
+    res.blue = leds[LedDetector::LedBlue];
+    if (res.blue.x > 0)
+        cv::circle(trackMat, res.blue, 6, cv::Scalar(255, 0, 0), -1); // BGR colors
 
     // calculate gamma angle
     res.gamma = calculateTriangleGamma(res);
@@ -418,7 +399,8 @@ Tracker::LEDTriangle Tracker::trackPoints(const cv::Mat &image, cv::Mat *infoFra
     auto angle = calculateTriangleTurnAngle(res);
     res.turnAngle = angle;
 
-    cv::Mat infoMat(m_mouseGraphicMat.size(), m_mouseGraphicMat.type());
+    auto &infoMat = m_infoMat;
+    infoMat.create(m_mouseGraphicMat.size(), m_mouseGraphicMat.type());
 
     // rotate mouse image if we have a valid angle
     if (res.turnAngle > 0) {
@@ -426,6 +408,9 @@ Tracker::LEDTriangle Tracker::trackPoints(const cv::Mat &image, cv::Mat *infoFra
         auto rotMat = cv::getRotationMatrix2D(matCenter, angle, 1.0);
 
         cv::warpAffine(m_mouseGraphicMat, infoMat, rotMat, m_mouseGraphicMat.size());
+    } else {
+        // the buffer is reused, don't show stale data from a previous frame
+        infoMat.setTo(cv::Scalar(0, 0, 0));
     }
 
     // display position in infographic
@@ -25,6 +25,7 @@
 
 #include "streams/stream.h"
 #include "datactl/frametype.h"
+#include "ledkernel.h"
 
 class Tracker : public QObject
 {
@@ -47,6 +48,7 @@ public:
     QString lastError() const;
 
     bool initialize();
+    void setLedSearchRadius(int radius);
     void analyzeFrame(const cv::Mat &frame, const milliseconds_t time, cv::Mat *trackingFrame, cv::Mat *infoFrame);
     QVariantHash finalize();
 
@@ -65,6 +67,10 @@ private:
     std::vector<cv::Point2f> m_mazeRect;
     uint m_mazeFindTrialCount;
     cv::Mat m_mouseGraphicMat;
+
+    LedDetector m_ledDetector;
+    cv::Mat m_trackMat;
+    cv::Mat m_infoMat;
 };
 
 #endif // TRACKER_H
@@ -27,6 +27,9 @@
 
 SYNTALOS_MODULE(TriLedTrackerModule)
 
+// search radius around the last known LED positions, in pixels
+static const int LED_SEARCH_RADIUS = 96;
+
 class TriLedTrackerModule : public AbstractModule
 {
     Q_OBJECT
@@ -100,6 +103,10 @@ public:
             return;
         }
 
+        // only look for the LEDs close to where we saw them last, the detector will
+        // fall back to searching the whole frame if it loses track of them
+        tracker->setLedSearchRadius(LED_SEARCH_RADIUS);
+
         // wait until we actually start
         startWaitCondition->wait(this);
 
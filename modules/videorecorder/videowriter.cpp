@@ -39,6 +39,7 @@ extern "C" {
 }
 
 #include "datactl/tsyncfile.h"
+#include "datactl/vipsbudget.h"
 
 namespace Syntalos
 {
@@ -1167,11 +1168,14 @@ inline bool VideoWriter::prepareFrame(const vips::VImage &inImage)
     // Ensure all VIPS operations are applied and we have our own immutable copy
     // of the data at this point
     int pixSize = 1;
-    if (d->inputPixFormat == AV_PIX_FMT_GRAY16LE) {
-        image = image.cast(VIPS_FORMAT_USHORT, vips::VImage::option()->set("shift", true)).copy_memory();
-        pixSize = 2;
-    } else {
-        image = image.cast(VIPS_FORMAT_UCHAR, vips::VImage::option()->set("shift", true)).copy_memory();
+    {
+        Syntalos::VipsEvalGuard vipsGuard(d->modName);
+        if (d->inputPixFormat == AV_PIX_FMT_GRAY16LE) {
+            image = image.cast(VIPS_FORMAT_USHORT, vips::VImage::option()->set("shift", true)).copy_memory();
+            pixSize = 2;
+        } else {
+            image = image.cast(VIPS_FORMAT_UCHAR, vips::VImage::option()->set("shift", true)).copy_memory();
+        }
     }
 
     auto data = (const uint8_t *)image.data();
@@ -0,0 +1,263 @@
+/*
+ * Copyright (C) 2020-2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "transformpipeline.h"
+
+#include <QDebug>
+#include <QThread>
+#include <chrono>
+#include <pthread.h>
+
+#include "datactl/vipsbudget.h"
+
+TransformPipeline::TransformPipeline(
+    const QString &ownerName,
+    const QList<std::shared_ptr<VideoTransform>> &vtfList,
+    const EmitFunc &emitFn)
+    : m_ownerName(ownerName),
+      m_vtfList(vtfList),
+      m_emitFn(emitFn),
+      m_maxInFlight(1),
+      m_running(false),
+      m_nextSubmitSeq(0),
+      m_nextEmitSeq(0),
+      m_droppedCount(0)
+{
+    // one entry per transformation, plus one for the final rendering step
+    m_stats.resize(m_vtfList.size() + 1, TimingAccu{0, 0, 0});
+}
+
+TransformPipeline::~TransformPipeline()
+{
+    finish();
+}
+
+void TransformPipeline::start(int maxInFlight)
+{
+    finish();
+
+    m_maxInFlight = std::max(1, maxInFlight);
+    m_nextSubmitSeq = 0;
+    m_nextEmitSeq = 0;
+    m_droppedCount = 0;
+    m_pending.clear();
+    m_slots.assign(m_maxInFlight, Slot{Frame(), false, false});
+    {
+        std::lock_guard<std::mutex> lock(m_statsMutex);
+        std::fill(m_stats.begin(), m_stats.end(), TimingAccu{0, 0, 0});
+    }
+
+    // process everything inline if we don't want any parallelism
+    if (m_maxInFlight == 1)
+        return;
+
+    m_running = true;
+    const auto workerCount = std::min(m_maxInFlight, std::max(2, QThread::idealThreadCount()));
+    for (int i = 0; i < workerCount; i++) {
+        m_workers.emplace_back(&TransformPipeline::workerThread, this);
+        pthread_setname_np(m_workers.back().native_handle(), "vtf_worker");
+    }
+}
+
+/**
+ * Transform @p frame and emit it.
+ * @return false if the frame was dropped because the pipeline is full.
+ */
+bool TransformPipeline::submit(const Frame &frame)
+{
+    if (m_workers.empty()) {
+        std::vector<uint64_t> stepNsec;
+        auto result = frame;
+        processFrame(result, stepNsec);
+        recordTimings(stepNsec);
+        m_emitFn(result);
+        return true;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        // we must not block here, as other modules may share our event thread
+        if (m_nextSubmitSeq - m_nextEmitSeq >= static_cast<uint64_t>(m_maxInFlight)) {
+            m_droppedCount++;
+            return false;
+        }
+        m_pending.emplace_back(m_nextSubmitSeq++, frame);
+    }
+    m_workCond.notify_one();
+    return true;
+}
+
+void TransformPipeline::finish()
+{
+    if (m_workers.empty())
+        return;
+
+    {
+        // wait for all frames to be processed and emitted
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_slotCond.wait(lock, [&] {
+            return m_nextEmitSeq == m_nextSubmitSeq;
+        });
+        m_running = false;
+    }
+    m_workCond.notify_all();
+
+    for (auto &worker : m_workers)
+        worker.join();
+    m_workers.clear();
+}
+
+int TransformPipeline::maxInFlight() const
+{
+    return m_maxInFlight;
+}
+
+uint64_t TransformPipeline::droppedCount() const
+{
+    return m_droppedCount;
+}
+
+void TransformPipeline::processFrame(Frame &frame, std::vector<uint64_t> &stepNsec)
+{
+    stepNsec.resize(m_stats.size());
+
+    auto lastTime = std::chrono::steady_clock::now();
+    for (int i = 0; i < m_vtfList.size(); i++) {
+        m_vtfList[i]->process(frame);
+
+        const auto now = std::chrono::steady_clock::now();
+        stepNsec[i] = std::chrono::duration_cast<std::chrono::nanoseconds>(now - lastTime).count();
+        lastTime = now;
+    }
+
+    // apply all pending operations
+    {
+        Syntalos::VipsEvalGuard vipsGuard(m_ownerName);
+        frame.mat = frame.mat.copy_memory();
+    }
+    stepNsec.back() = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - lastTime)
+                          .count();
+}
+
+void TransformPipeline::recordTimings(const std::vector<uint64_t> &stepNsec)
+{
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    for (size_t i = 0; i < m_stats.size(); i++) {
+        auto &accu = m_stats[i];
+        accu.count++;
+        accu.totalNsec += stepNsec[i];
+        if (stepNsec[i] > accu.maxNsec)
+            accu.maxNsec = stepNsec[i];
+    }
+}
+
+void TransformPipeline::workerThread()
+{
+    std::vector<uint64_t> stepNsec;
+
+    while (true) {
+        uint64_t seq;
+        Frame frame;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_workCond.wait(lock, [&] {
+                return !m_pending.empty() || !m_running;
+            });
+            if (m_pending.empty())
+                break;
+
+            seq = m_pending.front().first;
+            frame = std::move(m_pending.front().second);
+            m_pending.pop_front();
+        }
+
+        bool failed = false;
+        try {
+            processFrame(frame, stepNsec);
+            recordTimings(stepNsec);
+        } catch (const vips::VError &e) {
+            // we must not stall the pipeline, so we just drop this frame
+            qWarning().noquote() << "Failed to transform frame" << frame.index << ":" << e.what();
+            failed = true;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            auto &slot = m_slots[seq % m_slots.size()];
+            slot.frame = std::move(frame);
+            slot.ready = true;
+            slot.failed = failed;
+        }
+
+        // emit all frames that are complete, in order. Only one thread at a time collects and
+        // pushes frames, so they stay in order, but pushing does not hold up the other workers.
+        std::lock_guard<std::mutex> emitLock(m_emitMutex);
+        std::vector<Frame> readyFrames;
+        bool advanced = false;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            while (true) {
+                auto &head = m_slots[m_nextEmitSeq % m_slots.size()];
+                if (!head.ready)
+                    break;
+                if (!head.failed)
+                    readyFrames.push_back(std::move(head.frame));
+                head.frame = Frame();
+                head.ready = false;
+                m_nextEmitSeq++;
+                advanced = true;
+            }
+        }
+
+        for (const auto &readyFrame : readyFrames)
+            m_emitFn(readyFrame);
+        if (advanced)
+            m_slotCond.notify_all();
+    }
+}
+
+QList<TransformTiming> TransformPipeline::timings() const
+{
+    QList<TransformTiming> result;
+
+    std::lock_guard<std::mutex> lock(m_statsMutex);
+    for (size_t i = 0; i < m_stats.size(); i++) {
+        const auto &accu = m_stats[i];
+        TransformTiming timing;
+        timing.name = (i < static_cast<size_t>(m_vtfList.size())) ? m_vtfList[i]->name()
+                                                                   : QStringLiteral("Render");
+        timing.count = accu.count;
+        timing.meanUsec = accu.count > 0 ? (accu.totalNsec / static_cast<double>(accu.count)) / 1000.0 : 0;
+        timing.maxUsec = accu.maxNsec / 1000.0;
+        result.append(timing);
+    }
+
+    return result;
+}
+
+QString TransformPipeline::timingSummary() const
+{
+    QStringList lines;
+    for (const auto &timing : timings())
+        lines.append(QStringLiteral("%1: %2 µs mean, %3 µs max")
+                         .arg(timing.name)
+                         .arg(timing.meanUsec, 0, 'f', 1)
+                         .arg(timing.maxUsec, 0, 'f', 1));
+    return lines.join(QLatin1Char('\n'));
+}
@@ -0,0 +1,120 @@
+/*
+ * Copyright (C) 2020-2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QList>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "datactl/frametype.h"
+#include "videotransform.h"
+
+/**
+ * @brief Timing statistics for a single step of the transformation chain
+ */
+struct TransformTiming {
+    QString name;
+    uint64_t count;
+    double meanUsec;
+    double maxUsec;
+};
+
+/**
+ * @brief Applies a chain of video transformations to frames
+ *
+ * With an in-flight depth of 1, frames are processed directly on the thread
+ * that submits them. With a larger depth, up to that many frames are processed
+ * concurrently on a pool of worker threads, and are emitted strictly in the order
+ * they were submitted in. Submitting never blocks: if the pipeline is full, the frame
+ * is dropped and counted, as the thread submitting frames may be shared with other modules.
+ *
+ * As libvips evaluates lazily, the time spent in each transformation only covers
+ * building its part of the pipeline (plus anything vips has to compute eagerly,
+ * like histograms), while the actual pixel work is accounted to the final
+ * rendering step.
+ */
+class TransformPipeline
+{
+public:
+    using EmitFunc = std::function<void(const Frame &frame)>;
+
+    explicit TransformPipeline(
+        const QString &ownerName,
+        const QList<std::shared_ptr<VideoTransform>> &vtfList,
+        const EmitFunc &emitFn);
+    ~TransformPipeline();
+
+    void start(int maxInFlight);
+    bool submit(const Frame &frame);
+    void finish();
+
+    int maxInFlight() const;
+    uint64_t droppedCount() const;
+
+    QList<TransformTiming> timings() const;
+    QString timingSummary() const;
+
+private:
+    Q_DISABLE_COPY(TransformPipeline)
+
+    struct Slot {
+        Frame frame;
+        bool ready;
+        bool failed;
+    };
+
+    struct TimingAccu {
+        uint64_t count;
+        uint64_t totalNsec;
+        uint64_t maxNsec;
+    };
+
+    void workerThread();
+    void processFrame(Frame &frame, std::vector<uint64_t> &stepNsec);
+    void recordTimings(const std::vector<uint64_t> &stepNsec);
+
+    QString m_ownerName;
+    QList<std::shared_ptr<VideoTransform>> m_vtfList;
+    EmitFunc m_emitFn;
+    int m_maxInFlight;
+
+    std::vector<std::thread> m_workers;
+    std::mutex m_mutex;
+    std::mutex m_emitMutex;
+    std::condition_variable m_workCond;
+    std::condition_variable m_slotCond;
+    bool m_running;
+
+    // frames waiting for a worker, and frames being processed / waiting to be emitted
+    std::deque<std::pair<uint64_t, Frame>> m_pending;
+    std::vector<Slot> m_slots;
+    uint64_t m_nextSubmitSeq;
+    uint64_t m_nextEmitSeq;
+    std::atomic<uint64_t> m_droppedCount;
+
+    mutable std::mutex m_statsMutex;
+    std::vector<TimingAccu> m_stats;
+};
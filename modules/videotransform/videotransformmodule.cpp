@@ -19,7 +19,10 @@
 
 #include "videotransformmodule.h"
 
+#include <QDebug>
+
 #include "datactl/frametype.h"
+#include "transformpipeline.h"
 #include "vtransformctldialog.h"
 
 SYNTALOS_MODULE(VideoTransformModule)
@@ -35,6 +38,7 @@ private:
 
     VTransformCtlDialog *m_settingsDlg;
     QList<std::shared_ptr<VideoTransform>> m_activeVTFList;
+    std::unique_ptr<TransformPipeline> m_pipeline;
 
 public:
     explicit VideoTransformModule(QObject *parent = nullptr)
@@ -93,6 +97,13 @@ public:
         // set new dimensions of output data (we may have changed that)
         m_framesOut->setMetadataValue("size", tfISize);
 
+        // set up the pipeline that runs the transformations, possibly on multiple frames in parallel
+        m_pipeline = std::make_unique<TransformPipeline>(name(), m_activeVTFList, [this](const Frame &frame) {
+            m_framesOut->push(frame);
+        });
+        m_pipeline->start(m_settingsDlg->parallelFrames());
+        m_settingsDlg->setTimingInfo(QString());
+
         // update UI with the new limits
         m_settingsDlg->updateUi();
 
@@ -114,23 +125,29 @@ public:
         if (!maybeFrame.has_value())
             return;
 
-        // get the frame
-        auto frame = maybeFrame.value();
-
-        // apply transformations
-        for (const auto &vtf : m_activeVTFList) {
-            vtf->process(frame);
-        }
-
-        // apply all pending operations
-        frame.mat = frame.mat.copy_memory();
-
-        // forward the frame
-        m_framesOut->push(frame);
+        // transform and forward the frame
+        m_pipeline->submit(maybeFrame.value());
     }
 
     void stop() override
     {
+        if (m_pipeline) {
+            // wait for all frames that are still in flight
+            m_pipeline->finish();
+
+            if (m_pipeline->droppedCount() > 0)
+                qWarning().noquote().nospace()
+                    << name() << ": Dropped " << m_pipeline->droppedCount()
+                    << " frames, as all parallel transformation slots were busy.";
+
+            const auto timingInfo = m_pipeline->timingSummary();
+            if (!timingInfo.isEmpty()) {
+                qDebug().noquote() << "Transformation timings for" << name() << "\n" << timingInfo;
+                m_settingsDlg->setTimingInfo(timingInfo);
+            }
+            m_pipeline.reset();
+        }
+
         for (const auto &vtf : m_activeVTFList)
             vtf->stop();
         m_activeVTFList.clear();
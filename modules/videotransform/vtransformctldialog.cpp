@@ -54,6 +54,7 @@ void VTransformCtlDialog::setRunning(bool running)
         updateUi();
     m_running = running;
     ui->modButtonsWidget->setEnabled(!m_running);
+    ui->parallelWidget->setEnabled(!m_running);
 }
 
 void VTransformCtlDialog::updateUi()
@@ -79,14 +80,27 @@ QList<std::shared_ptr<VideoTransform>> VTransformCtlDialog::transformList()
     return m_vtfListModel->toList();
 }
 
+int VTransformCtlDialog::parallelFrames() const
+{
+    return ui->sbParallelFrames->value();
+}
+
+void VTransformCtlDialog::setTimingInfo(const QString &text)
+{
+    ui->labelTimingInfo->setText(text);
+}
+
 QVariantHash VTransformCtlDialog::serializeSettings() const
 {
-    return m_vtfListModel->toVariantHash();
+    auto settings = m_vtfListModel->toVariantHash();
+    settings.insert("parallel_frames", ui->sbParallelFrames->value());
+    return settings;
 }
 
 void VTransformCtlDialog::loadSettings(const QVariantHash &settings)
 {
     m_vtfListModel->fromVariantHash(settings);
+    ui->sbParallelFrames->setValue(settings.value("parallel_frames", 1).toInt());
     updateUi();
 }
 
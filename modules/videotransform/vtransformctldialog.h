@@ -40,6 +40,9 @@ public:
     void resetSettingsPanel();
 
     QList<std::shared_ptr<VideoTransform>> transformList();
+    int parallelFrames() const;
+    void setTimingInfo(const QString &text);
+
     QVariantHash serializeSettings() const;
     void loadSettings(const QVariantHash &settings);
 
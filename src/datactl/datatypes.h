@@ -22,6 +22,7 @@
 #include <QDataStream>
 #include <QMetaType>
 #include <QMetaEnum>
+#include <cstring>
 #include <memory>
 
 #include "syclock.h"
@@ -468,6 +469,72 @@ enum class SignalDataType {
     BoardDigOut
 };
 
+/**
+ * Signal blocks are transferred as the number of timestamps, rows and columns (as 64-bit integers),
+ * followed by the raw timestamps and the data matrix in Eigen's column-major order.
+ * Sender and receiver always run on the same machine, so the native byte order is used.
+ */
+template<typename TSVector, typename DataMatrix>
+ssize_t signalBlockMemorySize(const TSVector &timestamps, const DataMatrix &data)
+{
+    return static_cast<ssize_t>(
+        sizeof(quint64) * 3 + sizeof(typename TSVector::Scalar) * timestamps.size()
+        + sizeof(typename DataMatrix::Scalar) * data.size());
+}
+
+template<typename TSVector, typename DataMatrix>
+bool signalBlockToMemory(void *memory, ssize_t size, const TSVector &timestamps, const DataMatrix &data)
+{
+    if (size >= 0 && size < signalBlockMemorySize(timestamps, data))
+        return false;
+
+    const quint64 header[3] = {
+        static_cast<quint64>(timestamps.size()),
+        static_cast<quint64>(data.rows()),
+        static_cast<quint64>(data.cols())};
+    const auto tsBytes = sizeof(typename TSVector::Scalar) * timestamps.size();
+    const auto dataBytes = sizeof(typename DataMatrix::Scalar) * data.size();
+
+    auto dst = static_cast<unsigned char *>(memory);
+    std::memcpy(dst, header, sizeof(header));
+    if (tsBytes > 0)
+        std::memcpy(dst + sizeof(header), timestamps.data(), tsBytes);
+    if (dataBytes > 0)
+        std::memcpy(dst + sizeof(header) + tsBytes, data.data(), dataBytes);
+
+    return true;
+}
+
+template<typename TSVector, typename DataMatrix>
+bool signalBlockFromMemory(const void *memory, size_t size, TSVector &timestamps, DataMatrix &data)
+{
+    quint64 header[3];
+    if (size < sizeof(header)) {
+        timestamps.resize(0);
+        data.resize(0, 0);
+        return false;
+    }
+
+    auto src = static_cast<const unsigned char *>(memory);
+    std::memcpy(header, src, sizeof(header));
+    const auto tsBytes = sizeof(typename TSVector::Scalar) * header[0];
+    const auto dataBytes = sizeof(typename DataMatrix::Scalar) * header[1] * header[2];
+    if (size < sizeof(header) + tsBytes + dataBytes) {
+        timestamps.resize(0);
+        data.resize(0, 0);
+        return false;
+    }
+
+    timestamps.resize(static_cast<Eigen::Index>(header[0]));
+    data.resize(static_cast<Eigen::Index>(header[1]), static_cast<Eigen::Index>(header[2]));
+    if (tsBytes > 0)
+        std::memcpy(timestamps.data(), src + sizeof(header), tsBytes);
+    if (dataBytes > 0)
+        std::memcpy(data.data(), src + sizeof(header) + tsBytes, dataBytes);
+
+    return true;
+}
+
 /**
  * @brief A block of integer signal data from a data source
  *
@@ -501,26 +568,27 @@ struct IntSignalBlock : BaseDataType {
     VectorXu timestamps;
     MatrixXi data;
 
-    QByteArray toBytes() const override
+    ssize_t memorySize() const override
     {
-        QByteArray bytes;
-        QDataStream stream(&bytes, QIODevice::WriteOnly);
+        return signalBlockMemorySize(timestamps, data);
+    }
 
-        serializeEigen(stream, timestamps);
-        serializeEigen(stream, data);
+    bool writeToMemory(void *memory, ssize_t size = -1) const override
+    {
+        return signalBlockToMemory(memory, size, timestamps, data);
+    }
 
+    QByteArray toBytes() const override
+    {
+        QByteArray bytes(memorySize(), Qt::Uninitialized);
+        writeToMemory(bytes.data(), bytes.size());
         return bytes;
     }
 
     static IntSignalBlock fromMemory(const void *memory, size_t size)
     {
         IntSignalBlock obj;
-        QByteArray block(reinterpret_cast<const char *>(memory), size);
-        QDataStream stream(block);
-
-        obj.timestamps = deserializeEigen<VectorXu>(stream);
-        obj.data = deserializeEigen<MatrixXi>(stream);
-
+        signalBlockFromMemory(memory, size, obj.timestamps, obj.data);
         return obj;
     }
 };
@@ -566,26 +634,27 @@ struct FloatSignalBlock : BaseDataType {
     VectorXu timestamps;
     MatrixXd data;
 
-    QByteArray toBytes() const override
+    ssize_t memorySize() const override
     {
-        QByteArray bytes;
-        QDataStream stream(&bytes, QIODevice::WriteOnly);
+        return signalBlockMemorySize(timestamps, data);
+    }
 
-        serializeEigen(stream, timestamps);
-        serializeEigen(stream, data);
+    bool writeToMemory(void *memory, ssize_t size = -1) const override
+    {
+        return signalBlockToMemory(memory, size, timestamps, data);
+    }
 
+    QByteArray toBytes() const override
+    {
+        QByteArray bytes(memorySize(), Qt::Uninitialized);
+        writeToMemory(bytes.data(), bytes.size());
         return bytes;
     }
 
     static FloatSignalBlock fromMemory(const void *memory, size_t size)
     {
         FloatSignalBlock obj;
-        QByteArray block(reinterpret_cast<const char *>(memory), size);
-        QDataStream stream(block);
-
-        obj.timestamps = deserializeEigen<VectorXu>(stream);
-        obj.data = deserializeEigen<MatrixXd>(stream);
-
+        signalBlockFromMemory(memory, size, obj.timestamps, obj.data);
         return obj;
     }
 };
@@ -0,0 +1,348 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "framebufferpool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace Syntalos
+{
+
+// align buffers to cache lines, so vector code can work on them efficiently
+static constexpr size_t FRAME_BUFFER_ALIGNMENT = 64;
+
+// size of a transparent huge page on x86_64 and (most) aarch64 systems
+static constexpr size_t HUGE_PAGE_SIZE = 2 * 1024 * 1024;
+
+// idle memory each process-wide pool may keep around, and the number of buffers it keeps at least
+static constexpr size_t SHARED_POOL_CACHE_BYTES = 256 * 1024 * 1024;
+static constexpr size_t SHARED_POOL_MIN_CACHED = 4;
+
+// idle memory all process-wide pools together may keep around
+static constexpr size_t SHARED_POOLS_TOTAL_CACHE_BYTES = 512 * 1024 * 1024;
+
+// share of a buffer we are willing to waste by rounding it up to whole huge pages
+static constexpr double HUGE_PAGE_MAX_WASTE = 0.1;
+
+namespace
+{
+struct PooledBufferRef {
+    std::shared_ptr<FrameBufferPool> pool;
+    void *buffer;
+};
+} // namespace
+
+static void pooledImagePostClose(VipsImage *, gpointer userData)
+{
+    auto ref = static_cast<PooledBufferRef *>(userData);
+    ref->pool->release(ref->buffer);
+    delete ref;
+}
+
+static std::mutex &sharedPoolsMutex()
+{
+    static std::mutex mutex;
+    return mutex;
+}
+
+static std::map<size_t, std::shared_ptr<FrameBufferPool>> &sharedPools()
+{
+    static std::map<size_t, std::shared_ptr<FrameBufferPool>> pools;
+    return pools;
+}
+
+// idle memory currently cached by all process-wide pools
+static std::atomic<size_t> g_sharedCachedBytes{0};
+
+/**
+ * Huge pages are only worth it if rounding the buffer up to whole pages
+ * does not waste much memory.
+ */
+static bool hugePagesWorthwhile(size_t bufferSize)
+{
+    if (bufferSize < HUGE_PAGE_SIZE)
+        return false;
+
+    const auto allocSize = (bufferSize + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+    return static_cast<double>(allocSize - bufferSize) < bufferSize * HUGE_PAGE_MAX_WASTE;
+}
+
+/**
+ * Write to every page of a buffer, so the kernel maps all of it right away
+ * instead of faulting pages in one by one while a frame is written.
+ */
+static void prefaultBuffer(void *buffer, size_t size)
+{
+    static const size_t pageSize = sysconf(_SC_PAGESIZE);
+
+    auto bytes = static_cast<volatile unsigned char *>(buffer);
+    for (size_t i = 0; i < size; i += pageSize)
+        bytes[i] = 0;
+}
+
+FrameBufferPool::FrameBufferPool(size_t bufferSize, size_t maxCached, bool hugePages)
+    : m_bufferSize(bufferSize),
+      m_maxCached(maxCached),
+      m_hugePages(hugePages),
+      m_sharedCache(false)
+{
+    // aligned_alloc requires the size to be a multiple of the alignment, and huge pages
+    // are only ever used for whole 2 MiB blocks
+    const size_t alignment = m_hugePages ? HUGE_PAGE_SIZE : FRAME_BUFFER_ALIGNMENT;
+    m_allocSize = (m_bufferSize + alignment - 1) & ~(alignment - 1);
+
+    m_stats.bufferSize = m_bufferSize;
+    m_stats.hugePages = m_hugePages;
+}
+
+FrameBufferPool::~FrameBufferPool()
+{
+    trim();
+}
+
+std::shared_ptr<FrameBufferPool> FrameBufferPool::shared(size_t bufferSize)
+{
+    std::lock_guard<std::mutex> lock(sharedPoolsMutex());
+    auto &pool = sharedPools()[bufferSize];
+    if (!pool) {
+        const auto maxCached = std::max(
+            SHARED_POOL_MIN_CACHED, SHARED_POOL_CACHE_BYTES / std::max<size_t>(bufferSize, 1));
+        pool = std::make_shared<FrameBufferPool>(bufferSize, maxCached, hugePagesWorthwhile(bufferSize));
+        pool->m_sharedCache = true;
+    }
+
+    return pool;
+}
+
+std::vector<FrameBufferPoolStats> FrameBufferPool::sharedStats()
+{
+    std::vector<FrameBufferPoolStats> result;
+    std::lock_guard<std::mutex> lock(sharedPoolsMutex());
+    for (const auto &it : sharedPools())
+        result.push_back(it.second->stats());
+
+    return result;
+}
+
+void FrameBufferPool::trimShared()
+{
+    std::lock_guard<std::mutex> lock(sharedPoolsMutex());
+    auto &pools = sharedPools();
+    for (auto it = pools.begin(); it != pools.end();) {
+        it->second->trim();
+
+        // forget pools nobody uses anymore, so frame sizes of past runs do not pile up
+        if (it->second.use_count() == 1)
+            it = pools.erase(it);
+        else
+            ++it;
+    }
+}
+
+size_t FrameBufferPool::bufferSize() const
+{
+    return m_bufferSize;
+}
+
+bool FrameBufferPool::hugePages() const
+{
+    return m_hugePages;
+}
+
+FrameBufferPoolStats FrameBufferPool::stats()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto stats = m_stats;
+    stats.cached = m_free.size();
+    return stats;
+}
+
+void *FrameBufferPool::allocateBuffer()
+{
+    void *buffer;
+    if (m_hugePages) {
+        // over-allocate, so we can cut out a region that starts at a huge page boundary
+        const auto mapSize = m_allocSize + HUGE_PAGE_SIZE;
+        auto map = mmap(nullptr, mapSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (map == MAP_FAILED)
+            throw std::bad_alloc();
+
+        const auto start = reinterpret_cast<uintptr_t>(map);
+        const auto aligned = (start + HUGE_PAGE_SIZE - 1) & ~(HUGE_PAGE_SIZE - 1);
+        if (aligned > start)
+            munmap(map, aligned - start);
+        const auto tailSize = (start + mapSize) - (aligned + m_allocSize);
+        if (tailSize > 0)
+            munmap(reinterpret_cast<void *>(aligned + m_allocSize), tailSize);
+        buffer = reinterpret_cast<void *>(aligned);
+
+#ifdef MADV_HUGEPAGE
+        // this is only a hint, we still get regular pages if THP are disabled on this system
+        madvise(buffer, m_allocSize, MADV_HUGEPAGE);
+#endif
+    } else {
+        buffer = std::aligned_alloc(FRAME_BUFFER_ALIGNMENT, m_allocSize);
+        if (buffer == nullptr)
+            throw std::bad_alloc();
+    }
+
+    prefaultBuffer(buffer, m_allocSize);
+    return buffer;
+}
+
+/**
+ * Account for one more idle buffer of a shared pool, unless all shared pools
+ * together already cache as much memory as they may.
+ */
+bool FrameBufferPool::reserveCacheBytes()
+{
+    if (!m_sharedCache)
+        return true;
+
+    auto current = g_sharedCachedBytes.load();
+    do {
+        if (current + m_allocSize > SHARED_POOLS_TOTAL_CACHE_BYTES)
+            return false;
+    } while (!g_sharedCachedBytes.compare_exchange_weak(current, current + m_allocSize));
+
+    return true;
+}
+
+void FrameBufferPool::freeBuffer(void *buffer)
+{
+    if (m_hugePages)
+        munmap(buffer, m_allocSize);
+    else
+        std::free(buffer);
+}
+
+void *FrameBufferPool::acquire()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_free.empty()) {
+            auto buffer = m_free.back();
+            m_free.pop_back();
+            if (m_sharedCache)
+                g_sharedCachedBytes -= m_allocSize;
+
+            m_stats.acquired++;
+            m_stats.reused++;
+            m_stats.inUse++;
+            m_stats.peakInUse = std::max(m_stats.peakInUse, m_stats.inUse);
+            return buffer;
+        }
+    }
+
+    auto buffer = allocateBuffer();
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stats.acquired++;
+    m_stats.allocated++;
+    m_stats.inUse++;
+    m_stats.peakInUse = std::max(m_stats.peakInUse, m_stats.inUse);
+    return buffer;
+}
+
+void FrameBufferPool::release(void *buffer)
+{
+    if (buffer == nullptr)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.inUse--;
+        if (m_free.size() < m_maxCached && reserveCacheBytes()) {
+            m_free.push_back(buffer);
+            return;
+        }
+    }
+
+    freeBuffer(buffer);
+}
+
+void FrameBufferPool::reserve(size_t count)
+{
+    count = std::min(count, m_maxCached);
+    while (true) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            if (m_free.size() >= count)
+                return;
+        }
+
+        auto buffer = allocateBuffer();
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stats.allocated++;
+        if (!reserveCacheBytes()) {
+            freeBuffer(buffer);
+            return;
+        }
+        m_free.push_back(buffer);
+    }
+}
+
+void FrameBufferPool::trim()
+{
+    std::vector<void *> buffers;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        buffers.swap(m_free);
+    }
+    if (m_sharedCache)
+        g_sharedCachedBytes -= buffers.size() * m_allocSize;
+
+    for (auto buffer : buffers)
+        freeBuffer(buffer);
+}
+
+vips::VImage FrameBufferPool::wrapImage(void *buffer, int width, int height, int bands, VipsBandFormat format)
+{
+    VipsImage *image = vips_image_new_from_memory(buffer, m_bufferSize, width, height, bands, format);
+    if (image == nullptr) {
+        release(buffer);
+        throw vips::VError();
+    }
+
+    // hand the buffer back to us once vips is done with the image
+    auto ref = new PooledBufferRef{shared_from_this(), buffer};
+    g_signal_connect(image, "postclose", G_CALLBACK(pooledImagePostClose), ref);
+
+    return vips::VImage(image);
+}
+
+vips::VImage FrameBufferPool::copyImage(const void *data, int width, int height, int bands, VipsBandFormat format)
+{
+    const auto dataSize = static_cast<size_t>(width) * height * bands * vips_format_sizeof(format);
+    if (dataSize > m_bufferSize)
+        throw vips::VError("Image does not fit into frame buffer");
+
+    auto buffer = acquire();
+    std::memcpy(buffer, data, dataSize);
+    return wrapImage(buffer, width, height, bands, format);
+}
+
+} // namespace Syntalos
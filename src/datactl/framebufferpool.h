@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QtGlobal>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "vips8-q.h"
+
+namespace Syntalos
+{
+
+/**
+ * @brief Usage counters of a frame buffer pool
+ */
+struct FrameBufferPoolStats {
+    size_t bufferSize{0};
+    bool hugePages{false};  /// Buffers are backed by transparent huge pages
+    uint64_t acquired{0};   /// Total number of buffers handed out
+    uint64_t reused{0};     /// Buffers handed out from the idle cache, without allocating
+    uint64_t allocated{0};  /// Buffers that had to be freshly allocated
+    size_t inUse{0};        /// Buffers currently held by images or producers
+    size_t peakInUse{0};    /// Largest number of buffers in use at the same time
+    size_t cached{0};       /// Idle buffers waiting to be reused
+};
+
+/**
+ * @brief Pool of recyclable, equally sized frame buffers
+ *
+ * Producers that create a new image for every frame can fetch memory from this
+ * pool instead of allocating a fresh buffer each time. Images created with wrapImage()
+ * reference the pool buffer directly, and return it to the pool once libvips
+ * drops the last reference to the image.
+ *
+ * The pool never blocks: If all buffers are in use, a new one is allocated.
+ * At most maxCached idle buffers are kept around for reuse.
+ * Freshly allocated buffers are pre-faulted, so the kernel does not have to map
+ * their pages one by one while a frame is written. For large frames, buffers can be
+ * backed by 2 MiB huge pages to reduce TLB misses when reading and writing them.
+ * The idle buffers of all process-wide pools together are limited to a fixed amount of memory.
+ *
+ * Pools must be created with std::make_shared, as images keep their pool alive.
+ * Modules in the same process should usually share the pools returned by shared().
+ */
+class FrameBufferPool : public std::enable_shared_from_this<FrameBufferPool>
+{
+public:
+    explicit FrameBufferPool(size_t bufferSize, size_t maxCached = 8, bool hugePages = false);
+    ~FrameBufferPool();
+
+    /**
+     * Get the process-wide pool for buffers of @p bufferSize bytes.
+     * Pools for large buffers use huge pages if that wastes little memory, and all
+     * pools are kept alive until the process exits or trimShared() drops them.
+     */
+    static std::shared_ptr<FrameBufferPool> shared(size_t bufferSize);
+
+    /**
+     * Get usage statistics of all process-wide pools.
+     */
+    static std::vector<FrameBufferPoolStats> sharedStats();
+
+    /**
+     * Free all idle buffers of the process-wide pools, e.g. once a run has finished,
+     * and drop the pools which are not in use anymore.
+     */
+    static void trimShared();
+
+    size_t bufferSize() const;
+    bool hugePages() const;
+    FrameBufferPoolStats stats();
+
+    /**
+     * Get a buffer of bufferSize() bytes, which must either be given back
+     * with release() or be turned into an image with wrapImage().
+     */
+    void *acquire();
+    void release(void *buffer);
+
+    /**
+     * Allocate idle buffers ahead of time, until at least @p count are cached.
+     */
+    void reserve(size_t count);
+
+    /**
+     * Drop all idle buffers.
+     */
+    void trim();
+
+    /**
+     * Create an image that uses a buffer of this pool as its pixel memory.
+     * The buffer must not be modified anymore after the image was created.
+     */
+    vips::VImage wrapImage(void *buffer, int width, int height, int bands, VipsBandFormat format);
+
+    /**
+     * Create an image with a copy of the tightly packed pixels in @p data,
+     * which must not be larger than bufferSize().
+     */
+    vips::VImage copyImage(const void *data, int width, int height, int bands, VipsBandFormat format);
+
+private:
+    Q_DISABLE_COPY(FrameBufferPool)
+
+    void *allocateBuffer();
+    void freeBuffer(void *buffer);
+    bool reserveCacheBytes();
+
+    size_t m_bufferSize;
+    size_t m_allocSize;
+    size_t m_maxCached;
+    bool m_hugePages;
+    bool m_sharedCache;
+
+    std::mutex m_mutex;
+    std::vector<void *> m_free;
+    FrameBufferPoolStats m_stats;
+};
+
+} // namespace Syntalos
@@ -19,6 +19,7 @@
 
 #pragma once
 #include "datatypes.h"
+#include "framebufferpool.h"
 #include "vips8-q.h"
 
 /**
@@ -64,34 +65,38 @@ struct Frame : BaseDataType {
             vips_image_wio_input(mat.get_image());
     }
 
+    /**
+     * Size of the header preceding the pixel data in serialized frames:
+     * 1x uint64 + 1x int64 for index and timestamp, 4x int for image metadata.
+     */
+    static constexpr size_t HeaderSize = sizeof(uint64_t) + sizeof(int64_t) + (sizeof(int) * 4);
+
     ssize_t memorySize() const override
     {
+        // frames without an image only carry their header
+        if (mat.get_image() == nullptr)
+            return static_cast<ssize_t>(HeaderSize);
+
         // Calculate data size based on the format
         size_t dataSize = VIPS_IMAGE_SIZEOF_ELEMENT(mat.get_image()) * mat.width() * mat.height() * mat.bands();
 
-        // Calculate total buffer size:
-        // 1x uint64 + 1x int64 for index and timestamp
-        // 4x int for image metadata
-        // + size of image data itself
-        return static_cast<ssize_t>(sizeof(uint64_t) + sizeof(int64_t) + (sizeof(int) * 4) + dataSize);
+        // Calculate total buffer size: header + size of image data itself
+        return static_cast<ssize_t>(HeaderSize + dataSize);
     }
 
-    bool writeToMemory(void *buffer, ssize_t size = -1) const override
+    /**
+     * Write a frame header to @p buffer, which must be at least HeaderSize bytes large.
+     * The pixel data, if written by other means, follows the header directly.
+     */
+    static void writeHeader(
+        void *buffer,
+        uint64_t index,
+        const milliseconds_t &time,
+        int width,
+        int height,
+        int channels,
+        VipsBandFormat format)
     {
-        // fetch metadata
-        int width = mat.width();
-        int height = mat.height();
-        int channels = mat.bands();
-        auto format = mat.format();
-
-        // Calculate data size based on the format
-        size_t dataSize = VIPS_IMAGE_SIZEOF_ELEMENT(mat.get_image()) * width * height * channels;
-
-        // calculate our memory segment size, if it wasn't passed
-        if (size < 0)
-            size = memorySize();
-
-        // copy metadata to buffer
         size_t offset = 0;
 
         // copy index and timestamp
@@ -110,11 +115,28 @@ struct Frame : BaseDataType {
         std::memcpy(static_cast<unsigned char *>(buffer) + offset, &channels, sizeof(channels));
         offset += sizeof(channels);
         std::memcpy(static_cast<unsigned char *>(buffer) + offset, &format, sizeof(format));
-        offset += sizeof(format);
+    }
 
-        // copy image data
-        const void *imageData = mat.data();
-        std::memcpy(static_cast<unsigned char *>(buffer) + offset, imageData, dataSize);
+    bool writeToMemory(void *buffer, ssize_t size = -1) const override
+    {
+        // fetch metadata
+        int width = mat.width();
+        int height = mat.height();
+        int channels = mat.bands();
+
+        // Calculate data size based on the format
+        size_t dataSize = VIPS_IMAGE_SIZEOF_ELEMENT(mat.get_image()) * width * height * channels;
+
+        // calculate our memory segment size, if it wasn't passed
+        if (size < 0)
+            size = memorySize();
+
+        writeHeader(buffer, index, time, width, height, channels, mat.format());
+
+        // copy image data - the image may be a lazy view (e.g. with swapped channels),
+        // so evaluate it into a new image instead of modifying a possibly shared one
+        const auto memImage = mat.copy_memory();
+        std::memcpy(static_cast<unsigned char *>(buffer) + HeaderSize, memImage.data(), dataSize);
 
         return true;
     };
@@ -130,6 +152,22 @@ struct Frame : BaseDataType {
     }
 
     static Frame fromMemory(const void *buffer, size_t size)
+    {
+        return fromMemoryInternal(buffer, size, true);
+    }
+
+    /**
+     * Create a frame whose image refers to the pixel data in @p buffer, without copying it.
+     * The caller must keep the buffer alive and unchanged for as long as the image
+     * (or anything derived from it) is in use.
+     */
+    static Frame viewFromMemory(const void *buffer, size_t size)
+    {
+        return fromMemoryInternal(buffer, size, false);
+    }
+
+private:
+    static Frame fromMemoryInternal(const void *buffer, size_t size, bool copy)
     {
         Frame frame;
 
@@ -158,8 +196,11 @@ struct Frame : BaseDataType {
         size_t sizeOfElement = vips_format_sizeof_unsafe(format);
         size_t dataSize = sizeOfElement * width * height * channels;
 
-        frame.mat = vips::VImage::new_from_memory_copy(
-            (void *)(static_cast<const unsigned char *>(buffer) + offset), dataSize, width, height, channels, format);
+        auto pixels = (void *)(static_cast<const unsigned char *>(buffer) + offset);
+        if (copy)
+            frame.mat = FrameBufferPool::shared(dataSize)->copyImage(pixels, width, height, channels, format);
+        else
+            frame.mat = vips::VImage::new_from_memory(pixels, dataSize, width, height, channels, format);
 
         return frame;
     }
@@ -38,7 +38,11 @@ using namespace Syntalos;
 #define TSYNC_FILE_MAGIC 0xF223434E5953548A
 
 #define TSYNC_FILE_VERSION_MAJOR 1
-#define TSYNC_FILE_VERSION_MINOR 2
+#define TSYNC_FILE_VERSION_MINOR 3
+
+// oldest format version we can still read, also used when writing raw
+// files so older readers can still load them
+#define TSYNC_FILE_VERSION_MINOR_RAW 2
 
 #define TSYNC_FILE_BLOCK_TERM 0x1126000000000000
 
@@ -90,6 +94,54 @@ QString Syntalos::tsyncFileModeToString(const TSyncFileMode &mode)
     }
 }
 
+QString Syntalos::tsyncFileEncodingToString(const TSyncFileEncoding &encoding)
+{
+    switch (encoding) {
+    case TSyncFileEncoding::RAW:
+        return QStringLiteral("raw");
+    case TSyncFileEncoding::DELTA:
+        return QStringLiteral("delta");
+    default:
+        return QStringLiteral("INVALID");
+    }
+}
+
+/**
+ * Cast a time value to the given data type, so encoded values
+ * wrap around exactly like raw ones would.
+ */
+template<class T>
+static inline long long tsyncCastTime(const T &value, TSyncFileDataType dtype)
+{
+    switch (dtype) {
+    case TSyncFileDataType::INT16:
+        return static_cast<qint16>(value);
+    case TSyncFileDataType::INT32:
+        return static_cast<qint32>(value);
+    case TSyncFileDataType::INT64:
+        return static_cast<qint64>(value);
+    case TSyncFileDataType::UINT16:
+        return static_cast<quint16>(value);
+    case TSyncFileDataType::UINT32:
+        return static_cast<quint32>(value);
+    case TSyncFileDataType::UINT64:
+        return static_cast<long long>(static_cast<quint64>(value));
+    default:
+        qFatal("Tried to convert time to unknown timesync datatype: %i", (int)dtype);
+        return 0;
+    }
+}
+
+static inline quint64 zigzagEncode(qint64 value)
+{
+    return (static_cast<quint64>(value) << 1) ^ static_cast<quint64>(value >> 63);
+}
+
+static inline qint64 zigzagDecode(quint64 value)
+{
+    return static_cast<qint64>((value >> 1) ^ (~(value & 1) + 1));
+}
+
 // ------------------
 // TimeSyncFileWriter
 // ------------------
@@ -105,6 +157,7 @@ TimeSyncFileWriter::TimeSyncFileWriter()
     m_time1DType = TSyncFileDataType::UINT32;
     m_time2DType = TSyncFileDataType::UINT32;
     m_tsMode = TSyncFileMode::CONTINUOUS;
+    m_encoding = TSyncFileEncoding::RAW;
     m_blockSize = 2800;
 
     m_stream.setVersion(QDataStream::Qt_5_12);
@@ -167,6 +220,16 @@ void TimeSyncFileWriter::setChunkSize(int size)
     m_blockSize = size;
 }
 
+/**
+ * Select how time values are stored. Files are written with the RAW encoding
+ * by default, as DELTA-encoded files can not be read by tools that only support
+ * format version 1.2.
+ */
+void TimeSyncFileWriter::setEncoding(TSyncFileEncoding encoding)
+{
+    m_encoding = encoding;
+}
+
 void TimeSyncFileWriter::setCreationTimeOverride(const QDateTime &dt)
 {
     m_creationTimeOverride = dt;
@@ -189,6 +252,47 @@ void TimeSyncFileWriter::csWriteValue<QByteArray>(const QByteArray &data)
     XXH3_64bits_update(m_xxh3State, (const uint8_t *)data.constData(), sizeof(char) * data.size());
 }
 
+void TimeSyncFileWriter::csWriteVarint(quint64 value)
+{
+    uint8_t buf[10];
+    int len = 0;
+    while (value >= 0x80) {
+        buf[len++] = static_cast<uint8_t>(value) | 0x80;
+        value >>= 7;
+    }
+    buf[len++] = static_cast<uint8_t>(value);
+
+    m_stream.writeRawData((const char *)buf, len);
+    XXH3_64bits_update(m_xxh3State, buf, len);
+}
+
+void TimeSyncFileWriter::csWriteTime(long long value, TSyncFileDataType dtype)
+{
+    switch (dtype) {
+    case TSyncFileDataType::INT16:
+        csWriteValue<qint16>(value);
+        break;
+    case TSyncFileDataType::INT32:
+        csWriteValue<qint32>(value);
+        break;
+    case TSyncFileDataType::INT64:
+        csWriteValue<qint64>(value);
+        break;
+    case TSyncFileDataType::UINT16:
+        csWriteValue<quint16>(value);
+        break;
+    case TSyncFileDataType::UINT32:
+        csWriteValue<quint32>(value);
+        break;
+    case TSyncFileDataType::UINT64:
+        csWriteValue<quint64>(value);
+        break;
+    default:
+        qFatal("Tried to write unknown datatype to timesync file: %i", (int)dtype);
+        break;
+    }
+}
+
 bool TimeSyncFileWriter::open(const QString &modName, const QUuid &collectionId, const QVariantHash &userData)
 {
     if (m_file->isOpen())
@@ -219,8 +323,11 @@ bool TimeSyncFileWriter::open(const QString &modName, const QUuid &collectionId,
 
     m_stream << (quint64)TSYNC_FILE_MAGIC;
 
+    // raw files are written in the old format version, so older readers can still load them
+    const quint16 formatVMinor = m_encoding == TSyncFileEncoding::RAW ? TSYNC_FILE_VERSION_MINOR_RAW
+                                                                       : TSYNC_FILE_VERSION_MINOR;
     csWriteValue<quint16>(TSYNC_FILE_VERSION_MAJOR);
-    csWriteValue<quint16>(TSYNC_FILE_VERSION_MINOR);
+    csWriteValue<quint16>(formatVMinor);
 
     csWriteValue<qint64>(currentTime.toTime_t());
 
@@ -239,6 +346,9 @@ bool TimeSyncFileWriter::open(const QString &modName, const QUuid &collectionId,
     csWriteValue<quint16>((quint16)m_timeUnits.second);
     csWriteValue<quint16>((quint16)m_time2DType);
 
+    if (formatVMinor >= 3)
+        csWriteValue<quint16>((quint16)m_encoding);
+
     m_file->flush();
     const auto headerBytes = m_file->size();
     if (headerBytes <= 0)
@@ -319,52 +429,24 @@ void TimeSyncFileWriter::writeTimeEntry(const T1 &time1, const T2 &time2)
     static_assert(std::is_arithmetic<T1>::value, "T1 must be an arithmetic type.");
     static_assert(std::is_arithmetic<T2>::value, "T2 must be an arithmetic type.");
 
-    switch (m_time1DType) {
-    case TSyncFileDataType::INT16:
-        csWriteValue<qint16>(time1);
-        break;
-    case TSyncFileDataType::INT32:
-        csWriteValue<qint32>(time1);
-        break;
-    case TSyncFileDataType::INT64:
-        csWriteValue<qint64>(time1);
-        break;
-    case TSyncFileDataType::UINT16:
-        csWriteValue<quint16>(time1);
-        break;
-    case TSyncFileDataType::UINT32:
-        csWriteValue<quint32>(time1);
-        break;
-    case TSyncFileDataType::UINT64:
-        csWriteValue<quint64>(time1);
-        break;
-    default:
-        qFatal("Tried to write unknown datatype to timesync file for time1: %i", (int)m_time1DType);
-        break;
-    }
-
-    switch (m_time2DType) {
-    case TSyncFileDataType::INT16:
-        csWriteValue<qint16>(time2);
-        break;
-    case TSyncFileDataType::INT32:
-        csWriteValue<qint32>(time2);
-        break;
-    case TSyncFileDataType::INT64:
-        csWriteValue<qint64>(time2);
-        break;
-    case TSyncFileDataType::UINT16:
-        csWriteValue<quint16>(time2);
-        break;
-    case TSyncFileDataType::UINT32:
-        csWriteValue<quint32>(time2);
-        break;
-    case TSyncFileDataType::UINT64:
-        csWriteValue<quint64>(time2);
-        break;
-    default:
-        qFatal("Tried to write unknown datatype to timesync file for time2: %i", (int)m_time1DType);
-        break;
+    const long long times[2] = {tsyncCastTime(time1, m_time1DType), tsyncCastTime(time2, m_time2DType)};
+    if (m_encoding == TSyncFileEncoding::RAW || m_bIndex == 0) {
+        // every block starts with full values, so blocks can be decoded on their own
+        csWriteTime(times[0], m_time1DType);
+        csWriteTime(times[1], m_time2DType);
+        for (int i = 0; i < 2; i++) {
+            m_prevTimes[i] = static_cast<quint64>(times[i]);
+            m_prevDeltas[i] = 0;
+        }
+    } else {
+        // timestamps mostly advance in constant steps, so we only store how much the
+        // increment changed. We compute in unsigned arithmetic so values may wrap around.
+        for (int i = 0; i < 2; i++) {
+            const auto delta = static_cast<quint64>(times[i]) - m_prevTimes[i];
+            csWriteVarint(zigzagEncode(static_cast<qint64>(delta - m_prevDeltas[i])));
+            m_prevTimes[i] = static_cast<quint64>(times[i]);
+            m_prevDeltas[i] = delta;
+        }
     }
 
     m_bIndex++;
@@ -373,7 +455,8 @@ void TimeSyncFileWriter::writeTimeEntry(const T1 &time1, const T2 &time2)
 }
 
 TimeSyncFileReader::TimeSyncFileReader()
-    : m_lastError(QString())
+    : m_lastError(QString()),
+      m_encoding(TSyncFileEncoding::RAW)
 {
 }
 
@@ -397,6 +480,70 @@ inline QByteArray csReadValue(QDataStream &in, XXH3_state_t *state)
     return value;
 }
 
+static long long csReadTime(QDataStream &in, XXH3_state_t *state, TSyncFileDataType dtype)
+{
+    switch (dtype) {
+    case TSyncFileDataType::INT16:
+        return csReadValue<qint16>(in, state);
+    case TSyncFileDataType::INT32:
+        return csReadValue<qint32>(in, state);
+    case TSyncFileDataType::INT64:
+        return csReadValue<qint64>(in, state);
+    case TSyncFileDataType::UINT16:
+        return csReadValue<quint16>(in, state);
+    case TSyncFileDataType::UINT32:
+        return csReadValue<quint32>(in, state);
+    case TSyncFileDataType::UINT64:
+        return csReadValue<quint64>(in, state);
+    default:
+        qFatal("Tried to read unknown datatype from timesync file: %i", (int)dtype);
+        return 0;
+    }
+}
+
+static bool csReadVarint(QDataStream &in, XXH3_state_t *state, quint64 *value)
+{
+    uint8_t buf[10];
+    *value = 0;
+    for (int i = 0; i < 10; i++) {
+        in >> buf[i];
+        if (in.status() != QDataStream::Ok)
+            return false;
+
+        *value |= static_cast<quint64>(buf[i] & 0x7F) << (7 * i);
+        if ((buf[i] & 0x80) == 0) {
+            XXH3_64bits_update(state, buf, i + 1);
+            return true;
+        }
+    }
+
+    // varints of 64-bit values are never longer than 10 bytes
+    return false;
+}
+
+/**
+ * Advance @p in to just behind the next block terminator and its checksum,
+ * so reading can continue with the following block after a damaged one.
+ */
+static bool skipToNextBlock(QDataStream &in)
+{
+    quint64 window = 0;
+    quint8 byte;
+
+    in.resetStatus();
+    while (!in.atEnd()) {
+        in >> byte;
+        window = (window >> 8) | (static_cast<quint64>(byte) << 56);
+        if (window == TSYNC_FILE_BLOCK_TERM) {
+            quint64 checksum;
+            in >> checksum;
+            return in.status() == QDataStream::Ok;
+        }
+    }
+
+    return false;
+}
+
 bool TimeSyncFileReader::open(const QString &fname)
 {
     QFile file(fname);
@@ -421,7 +568,8 @@ bool TimeSyncFileReader::open(const QString &fname)
 
     const auto formatVMajor = csReadValue<quint16>(in, csState);
     const auto formatVMinor = csReadValue<quint16>(in, csState);
-    if ((formatVMajor != TSYNC_FILE_VERSION_MAJOR) || (formatVMinor < TSYNC_FILE_VERSION_MINOR)) {
+    if ((formatVMajor != TSYNC_FILE_VERSION_MAJOR) || (formatVMinor < TSYNC_FILE_VERSION_MINOR_RAW)
+        || (formatVMinor > TSYNC_FILE_VERSION_MINOR)) {
         m_lastError = QStringLiteral(
                           "Unable to read data: This file is using an incompatible (probably newer) version of the "
                           "format which we can not read (%1.%2 vs %3.%4).")
@@ -472,6 +620,16 @@ bool TimeSyncFileReader::open(const QString &fname)
     const auto timeDType2 = static_cast<TSyncFileDataType>(timeDType2_i);
     m_timeDTypes = qMakePair(timeDType1, timeDType2);
 
+    // block encoding, files before version 1.3 only store raw values
+    m_encoding = TSyncFileEncoding::RAW;
+    if (formatVMinor >= 3)
+        m_encoding = static_cast<TSyncFileEncoding>(csReadValue<quint16>(in, csState));
+    if (m_encoding != TSyncFileEncoding::RAW && m_encoding != TSyncFileEncoding::DELTA) {
+        m_lastError = QStringLiteral("Unable to read data: Unknown time block encoding %1.").arg((int)m_encoding);
+        XXH3_freeState(csState);
+        return false;
+    }
+
     // skip potential alignment bytes
     const int padding = (file.pos() * -1) & (8 - 1); // files use 8-byte alignment
     for (int i = 0; i < padding; i++)
@@ -497,8 +655,21 @@ bool TimeSyncFileReader::open(const QString &fname)
     // read the time data
     m_times.clear();
     int bIndex = 0;
+    size_t blockStart = 0;
+    quint64 prevDeltas[2] = {0, 0};
     XXH3_64bits_reset(csState);
     const auto data_sec_end = file.size() - 16;
+
+    // drop the entries of a damaged block and continue with the next one
+    const auto resyncBlock = [&]() {
+        m_times.resize(blockStart);
+        if (!skipToNextBlock(in))
+            return false;
+        XXH3_64bits_reset(csState);
+        bIndex = 0;
+        return true;
+    };
+
     while (!in.atEnd()) {
         if (file.pos() == data_sec_end) {
             // read last 16 bytes, which *must* be the block terminator of the final block, otherwise
@@ -521,71 +692,59 @@ bool TimeSyncFileReader::open(const QString &fname)
         long long timeVal1;
         long long timeVal2;
 
-        switch (timeDType1) {
-        case TSyncFileDataType::INT16:
-            timeVal1 = csReadValue<qint16>(in, csState);
-            break;
-        case TSyncFileDataType::INT32:
-            timeVal1 = csReadValue<qint32>(in, csState);
-            break;
-        case TSyncFileDataType::INT64:
-            timeVal1 = csReadValue<qint64>(in, csState);
-            break;
-        case TSyncFileDataType::UINT16:
-            timeVal1 = csReadValue<quint16>(in, csState);
-            break;
-        case TSyncFileDataType::UINT32:
-            timeVal1 = csReadValue<quint32>(in, csState);
-            break;
-        case TSyncFileDataType::UINT64:
-            timeVal1 = csReadValue<quint64>(in, csState);
-            break;
-        default:
-            qFatal("Tried to read unknown datatype from timesync file for time1: %i", (int)timeDType1);
-            break;
-        }
+        if (m_encoding == TSyncFileEncoding::RAW || bIndex == 0) {
+            timeVal1 = csReadTime(in, csState, timeDType1);
+            timeVal2 = csReadTime(in, csState, timeDType2);
+            prevDeltas[0] = prevDeltas[1] = 0;
+        } else {
+            const auto entryPos = file.pos();
+            quint64 dd1, dd2;
+            if (!csReadVarint(in, csState, &dd1) || !csReadVarint(in, csState, &dd2)) {
+                qCWarning(logTSyncFile).noquote()
+                    << "Invalid encoded time value in tsync data block: Skipping damaged block.";
+                file.seek(entryPos);
+                if (!resyncBlock()) {
+                    m_lastError = QStringLiteral(
+                        "Unable to read all tsync data: Encoded time value was invalid or the file was truncated.");
+                    XXH3_freeState(csState);
+                    return false;
+                }
+                continue;
+            }
 
-        switch (timeDType2) {
-        case TSyncFileDataType::INT16:
-            timeVal2 = csReadValue<qint16>(in, csState);
-            break;
-        case TSyncFileDataType::INT32:
-            timeVal2 = csReadValue<qint32>(in, csState);
-            break;
-        case TSyncFileDataType::INT64:
-            timeVal2 = csReadValue<qint64>(in, csState);
-            break;
-        case TSyncFileDataType::UINT16:
-            timeVal2 = csReadValue<quint16>(in, csState);
-            break;
-        case TSyncFileDataType::UINT32:
-            timeVal2 = csReadValue<quint32>(in, csState);
-            break;
-        case TSyncFileDataType::UINT64:
-            timeVal2 = csReadValue<quint64>(in, csState);
-            break;
-        default:
-            qFatal("Tried to read unknown datatype from timesync file for time2: %i", (int)timeDType2);
-            break;
+            prevDeltas[0] += static_cast<quint64>(zigzagDecode(dd1));
+            prevDeltas[1] += static_cast<quint64>(zigzagDecode(dd2));
+            timeVal1 = static_cast<long long>(static_cast<quint64>(m_times.back().first) + prevDeltas[0]);
+            timeVal2 = static_cast<long long>(static_cast<quint64>(m_times.back().second) + prevDeltas[1]);
         }
 
         m_times.push_back(std::make_pair(timeVal1, timeVal2));
 
         bIndex++;
         if (bIndex == m_blockSize) {
+            const auto termPos = file.pos();
             quint64 expectedCRC;
             in >> blockTerm >> expectedCRC;
 
             if (blockTerm != TSYNC_FILE_BLOCK_TERM) {
-                m_lastError = QStringLiteral("Unable to read all tsync data: Block separator was invalid.");
-                XXH3_freeState(csState);
-                return false;
+                // the terminator may be anywhere if variable-length values were damaged,
+                // so we search for it starting where we expected it
+                qCWarning(logTSyncFile).noquote()
+                    << "Block separator of tsync data block was invalid: Skipping damaged block.";
+                file.seek(termPos);
+                if (!resyncBlock()) {
+                    m_lastError = QStringLiteral("Unable to read all tsync data: Block separator was invalid.");
+                    XXH3_freeState(csState);
+                    return false;
+                }
+                continue;
             }
             if (expectedCRC != XXH3_64bits_digest(csState))
                 qCWarning(logTSyncFile).noquote() << "CRC check failed for tsync data block: Data is likely corrupted.";
 
             XXH3_64bits_reset(csState);
             bIndex = 0;
+            blockStart = m_times.size();
         }
     }
 
@@ -618,6 +777,11 @@ TSyncFileMode TimeSyncFileReader::syncMode() const
     return m_tsMode;
 }
 
+TSyncFileEncoding TimeSyncFileReader::encoding() const
+{
+    return m_encoding;
+}
+
 QVariantHash TimeSyncFileReader::userData() const
 {
     return m_userData;
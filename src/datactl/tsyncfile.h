@@ -68,9 +68,18 @@ enum class TSyncFileDataType {
     UINT64 = 8
 };
 
+/**
+ * @brief How time values are stored in the blocks of a TSync file.
+ */
+enum class TSyncFileEncoding {
+    RAW = 0,  /// Every value is stored with the full width of its data type (format 1.2)
+    DELTA = 1 /// First value of a block stored as-is, then zig-zag varints of the change in increment (format 1.3)
+};
+
 QString tsyncFileTimeUnitToString(const TSyncFileTimeUnit &tsftunit);
 QString tsyncFileDataTypeToString(const TSyncFileDataType &dtype);
 QString tsyncFileModeToString(const TSyncFileMode &mode);
+QString tsyncFileEncodingToString(const TSyncFileEncoding &encoding);
 
 /**
  * @brief Write a timestamp synchronization file
@@ -98,6 +107,7 @@ public:
 
     void setSyncMode(TSyncFileMode mode);
     void setChunkSize(int size);
+    void setEncoding(TSyncFileEncoding encoding);
 
     void setCreationTimeOverride(const QDateTime &dt);
 
@@ -119,6 +129,7 @@ private:
     QFile *m_file;
     QDataStream m_stream;
     TSyncFileMode m_tsMode;
+    TSyncFileEncoding m_encoding;
     int m_blockSize;
     int m_bIndex;
     XXH3_state_t *m_xxh3State;
@@ -130,9 +141,15 @@ private:
     TSyncFileDataType m_time1DType;
     TSyncFileDataType m_time2DType;
 
+    // last values and increments of the current block, for delta encoding
+    quint64 m_prevTimes[2];
+    quint64 m_prevDeltas[2];
+
     void writeBlockTerminator(bool check = true);
     template<class T>
     void csWriteValue(const T &data);
+    void csWriteVarint(quint64 value);
+    void csWriteTime(long long value, TSyncFileDataType dtype);
     template<class T1, class T2>
     void writeTimeEntry(const T1 &time1, const T2 &time2);
 };
@@ -156,6 +173,7 @@ public:
     QUuid collectionId() const;
     time_t creationTime() const;
     TSyncFileMode syncMode() const;
+    TSyncFileEncoding encoding() const;
 
     QVariantHash userData() const;
     microseconds_t tolerance() const;
@@ -174,6 +192,7 @@ private:
     QVariantHash m_userData;
 
     TSyncFileMode m_tsMode;
+    TSyncFileEncoding m_encoding;
     int m_blockSize;
 
     microseconds_t m_tolerance;
@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "vipsbudget.h"
+
+#include <QStringList>
+#include <algorithm>
+#include <thread>
+
+#include "vips8-q.h"
+
+namespace Syntalos
+{
+Q_LOGGING_CATEGORY(logVipsBudget, "vips.budget")
+
+// We stream new images all the time, so cached operations are almost never reused
+// and would only pin frame buffers in memory. Keep the operation cache small.
+static constexpr int VIPS_CACHE_MAX_OPS = 24;
+static constexpr size_t VIPS_CACHE_MAX_MEM = 32 * 1024 * 1024;
+static constexpr int VIPS_CACHE_MAX_FILES = 16;
+
+// upper limit for threads per evaluation, more rarely helps with our frame sizes
+static constexpr int VIPS_MAX_EVAL_THREADS = 4;
+
+VipsBudget *VipsBudget::instance()
+{
+    static VipsBudget budget;
+    return &budget;
+}
+
+VipsBudget::VipsBudget()
+    : m_threadBudget(0),
+      m_evalThreads(1),
+      m_totalSlots(0),
+      m_activeSlots(0),
+      m_activeDisplaySlots(0),
+      m_waitingNormal(0)
+{
+}
+
+void VipsBudget::configure(int threadBudget, int evalThreads)
+{
+    const auto cpuCount = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+    if (threadBudget <= 0)
+        threadBudget = std::max(2, cpuCount / 2);
+    if (evalThreads <= 0)
+        evalThreads = std::clamp(threadBudget / 2, 1, VIPS_MAX_EVAL_THREADS);
+    evalThreads = std::min(evalThreads, threadBudget);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_threadBudget = threadBudget;
+        m_evalThreads = evalThreads;
+        m_totalSlots = std::max(1, threadBudget / evalThreads);
+
+        for (auto &entry : m_modules) {
+            if (entry.second.maxSlots > 0)
+                entry.second.maxSlots = std::min(entry.second.maxSlots, m_totalSlots);
+        }
+    }
+    m_cond.notify_all();
+
+    vips_concurrency_set(evalThreads);
+    vips_cache_set_max(VIPS_CACHE_MAX_OPS);
+    vips_cache_set_max_mem(VIPS_CACHE_MAX_MEM);
+    vips_cache_set_max_files(VIPS_CACHE_MAX_FILES);
+
+    qCDebug(logVipsBudget).noquote().nospace()
+        << "Using a budget of " << threadBudget << " vips threads, " << evalThreads << " per evaluation";
+}
+
+int VipsBudget::threadBudget() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_threadBudget;
+}
+
+int VipsBudget::evalThreads() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_evalThreads;
+}
+
+VipsBudget::ModuleState &VipsBudget::moduleStateUnlocked(const QString &moduleName)
+{
+    auto it = m_modules.find(moduleName);
+    if (it == m_modules.end()) {
+        ModuleState state;
+        state.activeSlots = 0;
+        state.maxSlots = 0;
+        state.usage = VipsModuleUsage{moduleName, 0, 0, 0, 0};
+        it = m_modules.emplace(moduleName, state).first;
+    }
+
+    return it->second;
+}
+
+void VipsBudget::setModuleThreadLimit(const QString &moduleName, int maxThreads)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto &state = moduleStateUnlocked(moduleName);
+        if (maxThreads <= 0)
+            state.maxSlots = 0;
+        else
+            state.maxSlots = std::max(1, maxThreads / std::max(1, m_evalThreads));
+    }
+    m_cond.notify_all();
+}
+
+void VipsBudget::clearModuleThreadLimits()
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        for (auto &entry : m_modules)
+            entry.second.maxSlots = 0;
+    }
+    m_cond.notify_all();
+}
+
+std::chrono::nanoseconds VipsBudget::acquire(const QString &moduleName, VipsEvalPriority priority)
+{
+    const auto waitStart = std::chrono::steady_clock::now();
+
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto &state = moduleStateUnlocked(moduleName);
+
+    const auto slotAvailable = [&] {
+        // we never block if the budget was not configured
+        if (m_totalSlots <= 0)
+            return true;
+        if (state.maxSlots > 0 && state.activeSlots >= state.maxSlots)
+            return false;
+        if (m_activeSlots >= m_totalSlots)
+            return false;
+        if (priority == VipsEvalPriority::DISPLAY) {
+            // display evaluations yield to everyone else and keep one slot free for them
+            if (m_waitingNormal > 0)
+                return false;
+            if (m_totalSlots > 1 && m_activeDisplaySlots >= m_totalSlots - 1)
+                return false;
+        }
+        return true;
+    };
+
+    if (!slotAvailable()) {
+        if (priority == VipsEvalPriority::NORMAL)
+            m_waitingNormal++;
+        m_cond.wait(lock, slotAvailable);
+        if (priority == VipsEvalPriority::NORMAL)
+            m_waitingNormal--;
+    }
+
+    state.activeSlots++;
+    m_activeSlots++;
+    if (priority == VipsEvalPriority::DISPLAY)
+        m_activeDisplaySlots++;
+
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - waitStart);
+}
+
+void VipsBudget::release(
+    const QString &moduleName,
+    VipsEvalPriority priority,
+    const std::chrono::nanoseconds &evalTime,
+    const std::chrono::nanoseconds &waitTime)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto &state = moduleStateUnlocked(moduleName);
+        state.activeSlots--;
+        m_activeSlots--;
+        if (priority == VipsEvalPriority::DISPLAY)
+            m_activeDisplaySlots--;
+
+        const auto evalMsec = evalTime.count() / 1000000.0;
+        state.usage.evalCount++;
+        state.usage.wallMsec += evalMsec;
+        state.usage.estimatedWorkerMsec += evalMsec * m_evalThreads;
+        state.usage.waitMsec += waitTime.count() / 1000000.0;
+    }
+    m_cond.notify_all();
+}
+
+void VipsBudget::resetUsage()
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (auto &entry : m_modules)
+        entry.second.usage = VipsModuleUsage{entry.first, 0, 0, 0, 0};
+}
+
+QList<VipsModuleUsage> VipsBudget::usage() const
+{
+    QList<VipsModuleUsage> result;
+
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto &entry : m_modules) {
+        if (entry.second.usage.evalCount > 0)
+            result.append(entry.second.usage);
+    }
+
+    return result;
+}
+
+QString VipsBudget::usageSummary() const
+{
+    QStringList lines;
+    for (const auto &usage : this->usage())
+        lines.append(
+            QStringLiteral(
+                "%1: %2 evaluations, %3 ms evaluating (est. max. %4 ms vips worker time), %5 ms waiting for budget")
+                .arg(usage.moduleName)
+                .arg(usage.evalCount)
+                .arg(usage.wallMsec, 0, 'f', 1)
+                .arg(usage.estimatedWorkerMsec, 0, 'f', 1)
+                .arg(usage.waitMsec, 0, 'f', 1));
+    return lines.join(QLatin1Char('\n'));
+}
+
+VipsEvalGuard::VipsEvalGuard(const QString &moduleName, VipsEvalPriority priority)
+    : m_moduleName(moduleName),
+      m_priority(priority)
+{
+    m_waitTime = VipsBudget::instance()->acquire(m_moduleName, m_priority);
+    m_startTime = std::chrono::steady_clock::now();
+}
+
+VipsEvalGuard::~VipsEvalGuard()
+{
+    const auto evalTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - m_startTime);
+    VipsBudget::instance()->release(m_moduleName, m_priority, evalTime, m_waitTime);
+}
+
+} // namespace Syntalos
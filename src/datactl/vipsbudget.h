@@ -0,0 +1,147 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QList>
+#include <QLoggingCategory>
+#include <QString>
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+
+namespace Syntalos
+{
+
+Q_DECLARE_LOGGING_CATEGORY(logVipsBudget)
+
+/**
+ * @brief libvips usage of a single module
+ */
+struct VipsModuleUsage {
+    QString moduleName;
+    uint64_t evalCount;
+    double wallMsec;            // total time spent in pixel evaluation
+    double estimatedWorkerMsec; // upper estimate of vips worker time: wall time times threads per evaluation,
+                                // not measured CPU time, as vips worker threads are shared by all modules
+    double waitMsec;            // time spent waiting for the budget to allow an evaluation
+};
+
+/**
+ * @brief Priority of a libvips evaluation
+ */
+enum class VipsEvalPriority {
+    NORMAL, /// processing or recording data, must keep up with the stream
+    DISPLAY /// preparing images for display, may be delayed or skip frames
+};
+
+/**
+ * @brief Process-wide libvips thread budget
+ *
+ * libvips runs every pixel evaluation (copy_memory(), write_to_memory(), ...) on
+ * a threadpool that uses vips_concurrency_get() threads. If many modules evaluate
+ * images at the same time, this multiplies and competes with the threads we carefully
+ * placed on CPU cores.
+ *
+ * This class sets the threads per evaluation and a streaming-friendly operation cache
+ * policy, and hands out evaluation slots so the total number of vips worker threads
+ * stays within a global budget. Modules wrap their evaluations in a VipsEvalGuard,
+ * which may additionally be limited per module, and which records vips time per module.
+ */
+class VipsBudget
+{
+public:
+    static VipsBudget *instance();
+
+    /**
+     * Apply a thread budget. A budget of 0 selects a default based on the CPU count,
+     * evalThreads of 0 picks a sensible amount of threads per evaluation.
+     * Must be called after libvips was initialized.
+     */
+    void configure(int threadBudget, int evalThreads = 0);
+
+    int threadBudget() const;
+    int evalThreads() const;
+
+    /**
+     * Limit the amount of vips threads a module may occupy at the same time.
+     * A value <= 0 removes the limit.
+     */
+    void setModuleThreadLimit(const QString &moduleName, int maxThreads);
+    void clearModuleThreadLimits();
+
+    void resetUsage();
+    QList<VipsModuleUsage> usage() const;
+    QString usageSummary() const;
+
+private:
+    friend class VipsEvalGuard;
+    explicit VipsBudget();
+
+    struct ModuleState {
+        int activeSlots;
+        int maxSlots;
+        VipsModuleUsage usage;
+    };
+
+    ModuleState &moduleStateUnlocked(const QString &moduleName);
+    std::chrono::nanoseconds acquire(const QString &moduleName, VipsEvalPriority priority);
+    void release(
+        const QString &moduleName,
+        VipsEvalPriority priority,
+        const std::chrono::nanoseconds &evalTime,
+        const std::chrono::nanoseconds &waitTime);
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond;
+    int m_threadBudget;
+    int m_evalThreads;
+    int m_totalSlots;
+    int m_activeSlots;
+    int m_activeDisplaySlots;
+    int m_waitingNormal;
+    std::map<QString, ModuleState> m_modules;
+};
+
+/**
+ * @brief Scope guard for a libvips evaluation done on behalf of a module
+ *
+ * Blocks until the global and per-module budget allow another evaluation,
+ * and accounts the time spent until the guard is destroyed to the module.
+ * Display evaluations never take the last free slot and yield to waiting
+ * normal evaluations, so a busy display can not stall recording or processing.
+ * Guards must not be nested, as that could deadlock once the budget is exhausted.
+ */
+class VipsEvalGuard
+{
+public:
+    explicit VipsEvalGuard(const QString &moduleName, VipsEvalPriority priority = VipsEvalPriority::NORMAL);
+    ~VipsEvalGuard();
+
+private:
+    Q_DISABLE_COPY(VipsEvalGuard)
+
+    QString m_moduleName;
+    VipsEvalPriority m_priority;
+    std::chrono::nanoseconds m_waitTime;
+    std::chrono::steady_clock::time_point m_startTime;
+};
+
+} // namespace Syntalos
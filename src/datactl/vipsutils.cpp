@@ -21,6 +21,97 @@
 
 #include <opencv2/opencv.hpp>
 
+/**
+ * Quark for the cv::Mat a VIPS image created by cvMatToVips() was made from.
+ * In contrast to VIPS metadata, GObject qdata is not propagated to images derived
+ * from ours, so it is only ever found on an image with exactly the Mat's pixels.
+ */
+static GQuark cvMatQuark()
+{
+    static const GQuark quark = g_quark_from_static_string("syntalos-cv-mat");
+    return quark;
+}
+
+static void heldMatPostClose(VipsImage *, gpointer userData)
+{
+    delete static_cast<cv::Mat *>(userData);
+}
+
+static void heldMatDestroy(gpointer userData)
+{
+    delete static_cast<cv::Mat *>(userData);
+}
+
+namespace
+{
+
+/**
+ * Allocator for cv::Mats wrapping the pixel buffer of a VIPS image,
+ * which holds a reference on the image until the last Mat using it is gone.
+ */
+class VipsMatAllocator : public cv::MatAllocator
+{
+public:
+    cv::UMatData *allocate(
+        int dims,
+        const int *sizes,
+        int type,
+        void *data,
+        size_t *step,
+        cv::AccessFlag flags,
+        cv::UMatUsageFlags usageFlags) const override
+    {
+        // new allocations (e.g. for Mats reallocated by OpenCV functions) are not ours
+        return cv::Mat::getStdAllocator()->allocate(dims, sizes, type, data, step, flags, usageFlags);
+    }
+
+    bool allocate(cv::UMatData *u, cv::AccessFlag accessFlags, cv::UMatUsageFlags usageFlags) const override
+    {
+        return cv::Mat::getStdAllocator()->allocate(u, accessFlags, usageFlags);
+    }
+
+    void deallocate(cv::UMatData *u) const override
+    {
+        if (u == nullptr)
+            return;
+        CV_Assert(u->urefcount >= 0);
+        CV_Assert(u->refcount >= 0);
+        if (u->refcount == 0) {
+            g_object_unref(static_cast<VipsImage *>(u->userdata));
+            delete u;
+        }
+    }
+
+    void wrap(cv::Mat &mat, VipsImage *image) const
+    {
+        auto u = new cv::UMatData(this);
+        u->data = u->origdata = mat.data;
+        u->size = mat.total() * mat.elemSize();
+        u->userdata = g_object_ref(image);
+
+        mat.u = u;
+        mat.allocator = this;
+        mat.addref();
+    }
+};
+
+} // namespace
+
+static VipsMatAllocator g_vipsMatAllocator;
+
+/**
+ * Reorder the first three bands of an image, to convert between RGB(A) and BGR(A).
+ * This only creates a lazy view, no pixels are touched until the image is evaluated.
+ */
+static vips::VImage swapRedBlue(const vips::VImage &image)
+{
+    std::vector<vips::VImage> bands = {image.extract_band(2), image.extract_band(1), image.extract_band(0)};
+    if (image.bands() == 4)
+        bands.push_back(image.extract_band(3));
+
+    return vips::VImage::bandjoin(bands);
+}
+
 vips::VImage cvMatToVips(const cv::Mat &mat)
 {
     const auto channels = mat.channels();
@@ -40,30 +131,51 @@ vips::VImage cvMatToVips(const cv::Mat &mat)
         throw vips::VError("Unsupported cv::Mat depth for VIPS conversion");
     }
 
-    // make continuous Mat, if we don't have one already
-    auto contMat = mat.isContinuous() ? mat : mat.clone();
+    // We can only share refcounted, continuous buffers - Mats wrapping foreign memory
+    // could have their data freed under our feet, so those are copied into a pooled buffer.
+    if (!mat.isContinuous() || mat.u == nullptr) {
+        auto pool = Syntalos::FrameBufferPool::shared(mat.total() * mat.elemSize());
+        auto buffer = pool->acquire();
+        auto vimg = pool->wrapImage(buffer, mat.cols, mat.rows, channels, format);
+        mat.copyTo(cv::Mat(mat.rows, mat.cols, mat.type(), buffer));
+
+        // OpenCV uses BGR(A) while VIPS expects RGB(A), swap channels lazily
+        if (channels == 3 || channels == 4)
+            vimg = swapRedBlue(vimg).copy(vips::VImage::option()->set("interpretation", VIPS_INTERPRETATION_RGB));
+        return vimg;
+    }
+
+    auto heldMat = new cv::Mat(mat);
 
-    // perform color conversion
-    if (channels == 3)
-        cv::cvtColor(contMat, contMat, cv::COLOR_BGR2RGB);
-    else if (channels == 4)
-        cv::cvtColor(contMat, contMat, cv::COLOR_BGRA2RGBA);
+    const size_t dataSize = heldMat->total() * heldMat->elemSize();
+    VipsImage *image = vips_image_new_from_memory(
+        heldMat->data, dataSize, heldMat->cols, heldMat->rows, channels, format);
+    if (image == nullptr) {
+        delete heldMat;
+        throw vips::VError();
+    }
 
-    // unfortunately we need to copy here, as OpenCV does not relinquish control over its memory
-    // easily and cleanly
-    const size_t dataSize = contMat.total() * contMat.elemSize();
-    vips::VImage vimg = vips::VImage::new_from_memory_copy(
-        contMat.data, dataSize, mat.cols, mat.rows, channels, format);
+    // the image holds a reference on the Mat's buffer until VIPS is done with it
+    g_signal_connect(image, "postclose", G_CALLBACK(heldMatPostClose), heldMat);
+    vips::VImage vimg(image);
 
-    // update interpretation
+    // OpenCV uses BGR(A) while VIPS expects RGB(A), swap channels lazily
     if (channels == 3 || channels == 4)
-        vimg.set("interpretation", VIPS_INTERPRETATION_RGB);
+        vimg = swapRedBlue(vimg).copy(vips::VImage::option()->set("interpretation", VIPS_INTERPRETATION_RGB));
+
+    // remember where we came from, so vipsToCvMat() can hand out the original Mat
+    g_object_set_qdata_full(G_OBJECT(vimg.get_image()), cvMatQuark(), new cv::Mat(*heldMat), heldMatDestroy);
 
     return vimg;
 }
 
 cv::Mat vipsToCvMat(vips::VImage vimg)
 {
+    // images we created ourselves still know the Mat they were made from
+    const auto srcMat = static_cast<cv::Mat *>(g_object_get_qdata(G_OBJECT(vimg.get_image()), cvMatQuark()));
+    if (srcMat != nullptr)
+        return *srcMat;
+
     const auto channels = vimg.bands();
 
     // convert some common formats
@@ -137,10 +249,24 @@ cv::Mat vipsToCvMat(vips::VImage vimg)
     default:
         throw vips::VError("Unsupported number of channels or pixel format for cv::Mat conversion");
     }
+    if (cvType < 0)
+        throw vips::VError("Unsupported number of channels or pixel format for cv::Mat conversion");
 
-    // wrap the data in a cv::Mat
-    cv::Mat mat(cv::Size(vimg.height(), vimg.width()), cvType, (void *)vimg.data());
+    // OpenCV expects BGR(A) order
+    if (channels == 3 || channels == 4)
+        vimg = swapRedBlue(vimg);
 
-    // create a copy so the resulting cv::Mat takes ownership of the data
-    return mat.clone();
+    // evaluate the image, this is a no-op for images which are already in memory
+    auto memImage = vimg.copy_memory();
+
+    // wrap the data in a cv::Mat, which keeps the image alive
+    cv::Mat mat(memImage.height(), memImage.width(), cvType, const_cast<void *>(memImage.data()));
+    g_vipsMatAllocator.wrap(mat, memImage.get_image());
+
+    return mat;
+}
+
+bool cvMatIsShared(const cv::Mat &mat)
+{
+    return mat.u != nullptr && mat.u->refcount > 1;
 }
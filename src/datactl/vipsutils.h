@@ -20,24 +20,52 @@
 #pragma once
 
 #include "vips8-q.h"
+#include "framebufferpool.h"
 #include "opencv2/core.hpp"
 
 /**
  * @brief Transform a cv::Mat to a vips::VImage
+ *
+ * The returned image shares the pixel buffer of the Mat and keeps it alive for as long
+ * as it exists, so the Mat must not be modified afterwards. Mats which do not own their
+ * data or are not continuous are copied.
+ * Color images are returned as lazy RGB(A) view of the BGR(A) data, the channels are only
+ * swapped once a consumer actually reads the pixels.
+ *
  * @param mat The image matrix to transform
- * @return A copy of the image as VIPS image.
+ * @return The image as VIPS image.
  */
 vips::VImage cvMatToVips(const cv::Mat &mat);
 
 /**
  * @brief Transform a VipsImage into a cv::Mat
+ *
+ * Images created by cvMatToVips() yield their original Mat again, other images are
+ * evaluated into memory (if they are not there already) and wrapped without a copy.
+ * The returned Mat shares its data with the image, clone it before modifying it.
+ *
  * @param vimg The image to transform
- * @return A copy of the image as cv::Mat
+ * @return The image as cv::Mat, with color images in BGR(A) order
  */
 cv::Mat vipsToCvMat(vips::VImage vimg);
 
+/**
+ * @brief Check whether the pixel buffer of a cv::Mat is referenced by anything else
+ *
+ * Producers that reuse their output buffers have to detach from them (or clone them)
+ * before passing them to cvMatToVips(), if they are still shared.
+ *
+ * @param mat The image matrix to check
+ * @return True if another Mat or VIPS image holds a reference to the buffer
+ */
+bool cvMatIsShared(const cv::Mat &mat);
+
 /**
  * @brief Create a new VIPS image with the given dimensions and format
+ *
+ * The image is backed by a recycled buffer of the process-wide frame buffer pool,
+ * its pixels are uninitialized.
+ *
  * @tparam format The VIPS format to use
  * @param width The width of the image
  * @param height The height of the image
@@ -47,16 +75,8 @@ cv::Mat vipsToCvMat(vips::VImage vimg);
 template<VipsBandFormat format>
 vips::VImage newVipsImage(int width, int height, int bands = 1)
 {
-    size_t buffer_size = 0;
-    switch (format) {
-    case VIPS_FORMAT_USHORT:
-        buffer_size = width * height * sizeof(uint16_t);
-        break;
-    default:
-        static_assert(false, "Unknown VIPS format");
-    }
-
-    auto buffer = vips_malloc(nullptr, buffer_size);
+    const auto bufferSize = static_cast<size_t>(width) * height * bands * vips_format_sizeof(format);
+    auto pool = Syntalos::FrameBufferPool::shared(bufferSize);
 
-    return vips::VImage::new_from_memory_steal(buffer, buffer_size, width, height, bands, format);
+    return pool->wrapImage(pool->acquire(), width, height, bands, format);
 }
@@ -26,15 +26,20 @@
 #include <QDBusUnixFileDescriptor>
 #include <QDateTime>
 #include <QDebug>
+#include <QLocale>
 #include <QMessageBox>
 #include <QStandardPaths>
 #include <QStorageInfo>
 #include <QTemporaryDir>
 #include <QThread>
+#include <QThreadPool>
 #include <QTimer>
 #include <QVector>
+#include <condition_variable>
 #include <filesystem>
 #include <libusb.h>
+#include <mutex>
+#include <poll.h>
 #include <pthread.h>
 #include <sched.h>
 #include <linux/sched.h>
@@ -45,6 +50,7 @@
 
 #include "cpuaffinity.h"
 #include "globalconfig.h"
+#include "ioxmempool.h"
 #include "meminfo.h"
 #include "moduleeventthread.h"
 #include "modulelibrary.h"
@@ -53,8 +59,11 @@
 #include "sysinfo.h"
 #include "datactl/syclock.h"
 #include "datactl/edlstorage.h"
+#include "datactl/framebufferpool.h"
+#include "datactl/vipsbudget.h"
 #include "utils/misc.h"
 #include "utils/tomlutils.h"
+#include "mlink/ipc-types-private.h"
 
 namespace Syntalos
 {
@@ -67,6 +76,12 @@ static_assert(
 
 using namespace Syntalos;
 
+// time module threads get between being woken up and their synchronized start
+static constexpr microseconds_t START_BARRIER_LEAD_TIME = std::chrono::milliseconds(2);
+
+// time a daemon we launch with a non-default configuration gets to fail on it
+static constexpr int PROCESS_STARTUP_CHECK_MSEC = 750;
+
 static int engineUsbHotplugDispatchCB(
     struct libusb_context *ctx,
     struct libusb_device *dev,
@@ -87,6 +102,7 @@ public:
     int niceness;
     int allowedRTPriority;
     std::vector<uint> cpuAffinity;
+    PeriodicThreadTiming timing;
 };
 
 /**
@@ -111,7 +127,8 @@ public:
           m_joined(false),
           m_td(details),
           m_mod(module),
-          m_waitCond(waitCondition)
+          m_waitCond(waitCondition),
+          m_schedPolicy(ThreadSchedPolicy::OTHER)
     {
         if (threadBackend == BackendQThread) {
             m_threadBackend = BackendQThread;
@@ -152,6 +169,14 @@ public:
         m_joined = true;
     }
 
+    /**
+     * @brief Scheduling class the thread ended up running with
+     */
+    ThreadSchedPolicy schedPolicy() const
+    {
+        return m_schedPolicy;
+    }
+
     bool joinTimeout(uint seconds)
     {
         if (m_threadBackend == BackendQThread) {
@@ -185,6 +210,7 @@ private:
     ThreadDetails m_td;
     AbstractModule *m_mod;
     OptionalWaitCondition *m_waitCond;
+    std::atomic<ThreadSchedPolicy> m_schedPolicy;
 
     /**
      * @brief Main entry point for engine-managed module threads.
@@ -194,18 +220,39 @@ private:
         auto self = static_cast<SyThread *>(udata);
         pthread_setname_np(pthread_self(), qPrintable(self->m_td.name.mid(0, 15)));
 
-        // set higher niceness for this thread
-        if (self->m_td.niceness != 0)
-            setCurrentThreadNiceness(self->m_td.niceness);
-
-        // set CPU affinity
-        if (!self->m_td.cpuAffinity.empty())
-            thread_set_affinity_from_vec(pthread_self(), self->m_td.cpuAffinity);
-
-        if (self->m_mod->features().testFlag(ModuleFeature::REALTIME)) {
-            if (setCurrentThreadRealtime(self->m_td.allowedRTPriority))
+        // periodic threads get their CPU time reserved, if we are permitted to do that
+        // (deadline threads must be able to run on any CPU, so they do not get an affinity)
+        const auto &timing = self->m_td.timing;
+        if (timing.isValid()) {
+            using namespace std::chrono;
+            if (setCurrentThreadDeadline(
+                    duration_cast<nanoseconds>(timing.runtime).count(),
+                    duration_cast<nanoseconds>(timing.effectiveDeadline()).count(),
+                    duration_cast<nanoseconds>(timing.period).count())) {
+                self->m_schedPolicy = ThreadSchedPolicy::DEADLINE;
                 qCDebug(logEngine).noquote().nospace()
-                    << "Module thread for '" << self->m_mod->name() << "' set to realtime mode.";
+                    << "Module thread for '" << self->m_mod->name() << "' set to deadline scheduling ("
+                    << timing.runtime.count() << "µs every " << timing.period.count() << "µs).";
+            }
+        }
+
+        if (self->m_schedPolicy != ThreadSchedPolicy::DEADLINE) {
+            // set higher niceness for this thread
+            if (self->m_td.niceness != 0)
+                setCurrentThreadNiceness(self->m_td.niceness);
+
+            // set CPU affinity
+            if (!self->m_td.cpuAffinity.empty())
+                thread_set_affinity_from_vec(pthread_self(), self->m_td.cpuAffinity);
+
+            // periodic threads fall back to fixed realtime priorities
+            if (self->m_mod->features().testFlag(ModuleFeature::REALTIME) || timing.isValid()) {
+                if (setCurrentThreadRealtime(self->m_td.allowedRTPriority)) {
+                    self->m_schedPolicy = ThreadSchedPolicy::REALTIME;
+                    qCDebug(logEngine).noquote().nospace()
+                        << "Module thread for '" << self->m_mod->name() << "' set to realtime mode.";
+                }
+            }
         }
 
         self->m_mod->runThread(self->m_waitCond);
@@ -226,9 +273,17 @@ public:
         VariantStreamSubscription *sub;
         VarStreamInputPort *port;
         ConnectionHeatLevel heat;
+
+        // for estimating how fast the module processes this input
+        uint64_t lastDeliveredCount;
+        size_t lastPendingCount;
+        double processedPerSec;
+        bool memoryThrottled;
     };
 
     std::vector<SubscriptionBufferWatchData> monitoredSubscriptions;
+    QList<AbstractModule *> modules;
+    symaster_timepoint lastMemCheckTime;
     QString exportDirPath;
 
     bool diskSpaceWarningEmitted;
@@ -262,6 +317,7 @@ public:
     std::shared_ptr<SyncTimer> timer;
     std::vector<uint> mainThreadCoreAffinity;
     int roudiPidFd;
+    std::vector<IoxMemPool> roudiMemPools;
 
     QString exportBaseDir;
     QString exportDir;
@@ -282,6 +338,14 @@ public:
 
     QString lastRunExportDir;
     QString nextRunComment;
+    milliseconds_t lastRunDuration;
+    milliseconds_t lastRunSetupTime;
+    microseconds_t lastRunStartOffset;
+    QHash<AbstractModule *, ModuleRunTimings> lastRunTimings;
+    QHash<AbstractModule *, ModuleMemoryUsage> lastRunMemory;
+
+    bool keepModulesWarm;
+    QSet<AbstractModule *> warmModules;
 
     QList<QPair<AbstractModule *, QString>> pendingErrors;
 
@@ -315,6 +379,10 @@ Engine::Engine(QWidget *parentWidget)
     d->runIsEphemeral = false;
     d->mainThreadCoreAffinity.clear();
     d->runCount = 0;
+    d->lastRunDuration = milliseconds_t(0);
+    d->lastRunSetupTime = milliseconds_t(0);
+    d->lastRunStartOffset = microseconds_t(0);
+    d->keepModulesWarm = false;
     d->runCountPadding = 1;
     d->monitoring->emergencyOOMStop = d->gconf->emergencyOOMStop();
 
@@ -376,10 +444,11 @@ Engine::~Engine()
  * This function is used to launch a new program in a new process, and return the PID as pidfd.
  *
  * @param exePath The path to the executable to launch.
+ * @param args Arguments to pass to the new process.
  * @param pidfd_out A pointer to an integer, which will be set to the PID of the new process.
  * @return true if the program was successfully launched, false otherwise.
  */
-static bool launchProgram(const QString &exePath, int *pidfd_out)
+static bool launchProgram(const QString &exePath, const QStringList &args, int *pidfd_out)
 {
     struct clone_args cl_args = {0};
     int pidfd;
@@ -390,14 +459,22 @@ static bool launchProgram(const QString &exePath, int *pidfd_out)
     cl_args.flags = CLONE_PIDFD | CLONE_PARENT_SETTID;
     cl_args.exit_signal = SIGCHLD;
 
-    char *const argv[] = {const_cast<char *>(qPrintable(exePath)), nullptr};
+    // prepare the argument vector before cloning, so the child doesn't have to allocate
+    std::vector<QByteArray> argData;
+    argData.push_back(exePath.toLocal8Bit());
+    for (const auto &arg : args)
+        argData.push_back(arg.toLocal8Bit());
+    std::vector<char *> argv;
+    for (auto &arg : argData)
+        argv.push_back(arg.data());
+    argv.push_back(nullptr);
 
     const auto pid = (pid_t)syscall(SYS_clone3, &cl_args, sizeof(cl_args));
     if (pid < 0)
         return false;
 
     if (pid == 0) { // Child process
-        execvp(qPrintable(exePath), argv);
+        execvp(argv[0], argv.data());
         perror("execvp"); // execvp only returns on error
         exit(EXIT_FAILURE);
     }
@@ -408,6 +485,25 @@ static bool launchProgram(const QString &exePath, int *pidfd_out)
     return true;
 }
 
+/**
+ * @brief Check whether a freshly launched process terminated during its startup.
+ *
+ * Waits for up to PROCESS_STARTUP_CHECK_MSEC and reaps the process if it exited.
+ *
+ * @param pidfd The PIDFD of the process to check.
+ * @return true if the process has exited.
+ */
+static bool processExitedDuringStartup(int pidfd)
+{
+    struct pollfd pfd = {pidfd, POLLIN, 0};
+    if (poll(&pfd, 1, PROCESS_STARTUP_CHECK_MSEC) <= 0)
+        return false;
+
+    siginfo_t si;
+    waitid(P_PIDFD, pidfd, &si, WEXITED | WNOHANG);
+    return true;
+}
+
 /**
  * @brief Check if a process is still running using a pidfd.
  *
@@ -687,6 +783,10 @@ bool Engine::removeModule(AbstractModule *mod)
         // Update module info
         auto modInfo = d->modLibrary->moduleInfo(id);
         modInfo->setCount(modInfo->count() - 1);
+        d->lastRunTimings.remove(mod);
+        d->lastRunMemory.remove(mod);
+        if (d->warmModules.remove(mod))
+            mod->coolDown();
 
         emit modulePreRemove(mod);
         delete mod;
@@ -743,6 +843,40 @@ QString Engine::lastRunExportDir() const
     return d->lastRunExportDir;
 }
 
+/**
+ * @brief Time the last run was in its running state, zero if it never got there
+ */
+milliseconds_t Engine::lastRunDuration() const
+{
+    return d->lastRunDuration;
+}
+
+/**
+ * @brief Time from the start of the last run until all modules were running
+ *
+ * For runs following a run with modules kept warm, this is the time it took to re-arm them.
+ */
+milliseconds_t Engine::lastRunSetupTime() const
+{
+    return d->lastRunSetupTime;
+}
+
+/**
+ * @brief Time the given module needed to prepare and to stop in the last run
+ */
+ModuleRunTimings Engine::lastRunModuleTimings(AbstractModule *mod) const
+{
+    return d->lastRunTimings.value(mod);
+}
+
+/**
+ * @brief Memory the given module held on to in the last (or current) run
+ */
+ModuleMemoryUsage Engine::lastRunModuleMemory(AbstractModule *mod) const
+{
+    return d->lastRunMemory.value(mod);
+}
+
 QString Engine::readRunComment(const QString &runExportDir) const
 {
     if (runExportDir.isEmpty())
@@ -798,6 +932,36 @@ void Engine::setSaveInternalDiagnostics(bool save)
     d->saveInternal = save;
 }
 
+bool Engine::keepModulesWarm() const
+{
+    return d->keepModulesWarm;
+}
+
+/**
+ * @brief Keep modules warm for another run
+ *
+ * If enabled, modules with the KEEP_WARM feature keep their devices, threads and other
+ * expensive resources alive when the current or next run stops, so a run directly following it
+ * only has to rotate output data and timers.
+ * Disabling this again while no run is active releases all resources modules have kept.
+ */
+void Engine::setKeepModulesWarm(bool keepWarm)
+{
+    d->keepModulesWarm = keepWarm;
+    if (!keepWarm && !d->active)
+        coolDownModules();
+}
+
+void Engine::coolDownModules()
+{
+    for (auto &mod : d->warmModules) {
+        qCDebug(logEngine).noquote() << "Releasing resources module" << mod->name() << "kept for a warm run";
+        mod->coolDown();
+        mod->setWarmRun(false);
+    }
+    d->warmModules.clear();
+}
+
 int Engine::obtainSleepShutdownIdleInhibitor()
 {
     QDBusInterface iface(
@@ -886,8 +1050,39 @@ bool Syntalos::Engine::ensureRoudi()
         close(d->roudiPidFd);
     }
 
+    // use the mempool layout previous runs found to be necessary (it always extends our default),
+    // unless it does not fit into the shared memory this system has available
+    auto memPools = ioxMemPoolLayoutFromString(d->gconf->ioxMemPoolLayout());
+    if (!memPools.empty() && ioxMemPoolLayoutTotalSize(memPools) > ioxMemPoolMaxTotalSize()) {
+        qCWarning(logEngine).noquote().nospace()
+            << "Stored IPC mempool layout needs more shared memory than available ("
+            << QLocale().formattedDataSize(ioxMemPoolLayoutTotalSize(memPools)) << "), using the default layout.";
+        memPools.clear();
+    }
+    const bool customLayout = !memPools.empty();
+    if (!customLayout)
+        memPools = defaultIoxMemPoolLayout();
+
     qCDebug(logEngine).noquote() << "RouDi is not running, trying to restart it...";
-    if (!launchProgram(roudiBinary, &d->roudiPidFd)) {
+    qCDebug(logEngine).noquote() << "Using IPC mempool layout:" << ioxMemPoolLayoutToString(memPools);
+    QStringList roudiArgs = {QStringLiteral("--mempools"), ioxMemPoolLayoutToString(memPools)};
+    bool roudiLaunched = launchProgram(roudiBinary, roudiArgs, &d->roudiPidFd);
+
+    // RouDi exits right away if it can not set up a layout, in which case we forget
+    // about the custom layout and fall back to the default one that is known to work
+    if (roudiLaunched && customLayout && processExitedDuringStartup(d->roudiPidFd)) {
+        qCWarning(logEngine).noquote() << "RouDi failed to start with the stored IPC mempool layout, "
+                                          "retrying with the default layout.";
+        close(d->roudiPidFd);
+        d->roudiPidFd = -1;
+        d->gconf->setIoxMemPoolLayout(QString());
+
+        memPools = defaultIoxMemPoolLayout();
+        roudiArgs = QStringList({QStringLiteral("--mempools"), ioxMemPoolLayoutToString(memPools)});
+        roudiLaunched = launchProgram(roudiBinary, roudiArgs, &d->roudiPidFd);
+    }
+
+    if (!roudiLaunched) {
         QMessageBox::critical(
             d->parentWidget,
             QStringLiteral("System Error"),
@@ -896,6 +1091,7 @@ bool Syntalos::Engine::ensureRoudi()
                 .arg(std::strerror(errno)));
         return false;
     }
+    d->roudiMemPools = memPools;
 
     bool fatalError = false;
     auto temporaryErrorHandler = iox::ErrorHandler::setTemporaryErrorHandler(
@@ -915,6 +1111,133 @@ bool Syntalos::Engine::ensureRoudi()
     return true;
 }
 
+/**
+ * @brief Determine the shared-memory chunks needed for streams exchanged with out-of-process modules
+ *
+ * For every stream that crosses a process boundary, this estimates the element size from
+ * the stream metadata and the worst-case number of chunks held at the same time: the
+ * publisher's history and pending loan, plus each subscriber's queue, the chunk it is
+ * currently processing and the ones it may retain.
+ */
+static std::vector<IoxChunkRequirement> collectIpcChunkRequirements(const QList<AbstractModule *> &modules)
+{
+    std::vector<StreamOutputPort *> publishers;
+    QHash<StreamOutputPort *, uint64_t> chunksByPublisher;
+
+    const auto addChunks = [&](StreamOutputPort *oport, uint64_t chunks) {
+        if (!chunksByPublisher.contains(oport)) {
+            const bool external = qobject_cast<MLinkModule *>(oport->owner()) != nullptr;
+            publishers.push_back(oport);
+            chunksByPublisher[oport] = (external ? SY_IOX_HISTORY_SIZE : SY_IOX_EXPORT_HISTORY_SIZE) + 1;
+        }
+        chunksByPublisher[oport] += chunks;
+    };
+
+    for (const auto &mod : modules) {
+        if (qobject_cast<MLinkModule *>(mod) == nullptr)
+            continue;
+
+        // data forwarded from the module process to the master
+        for (const auto &oport : mod->outPorts()) {
+            if (oport->streamVar()->hasSubscribers())
+                addChunks(oport.get(), SY_IOX_QUEUE_CAPACITY + 1);
+        }
+
+        // data received by the module process, which may retain a few chunks
+        // (the engine can not know whether a port opts into batch delivery, so we assume it doesn't)
+        for (const auto &iport : mod->inPorts()) {
+            if (iport->hasSubscription())
+                addChunks(iport->outPort(), SY_IOX_QUEUE_CAPACITY + SY_IOX_RETAINED_CHUNKS_MAX + 1);
+        }
+    }
+
+    std::vector<IoxChunkRequirement> requirements;
+    for (const auto &oport : publishers) {
+        const auto elementSize = estimateStreamElementMemorySize(oport->dataTypeId(), oport->streamVar()->metadata());
+        if (elementSize == 0)
+            continue;
+
+        requirements.push_back(
+            {QStringLiteral("%1/%2").arg(oport->owner()->name(), oport->title()),
+             elementSize,
+             static_cast<uint32_t>(chunksByPublisher[oport])});
+    }
+
+    return requirements;
+}
+
+bool Engine::checkIpcMemPoolLayout(const QList<AbstractModule *> &modules)
+{
+    const auto requirements = collectIpcChunkRequirements(modules);
+    if (requirements.empty())
+        return true;
+
+    QString problem;
+    if (ioxMemPoolLayoutSatisfies(d->roudiMemPools, requirements, &problem))
+        return true;
+
+    // RouDi can not be reconfigured while we are connected to it, so we remember
+    // the layout this project needs and use it the next time we launch the daemon,
+    // as long as it fits into the shared memory this system has
+    qCWarning(logEngine).noquote() << "IPC mempool layout is insufficient:" << problem;
+    const auto maxTotalSize = ioxMemPoolMaxTotalSize();
+    const auto newLayout = ioxMemPoolLayoutClamped(ioxMemPoolLayoutFor(requirements, d->roudiMemPools), maxTotalSize);
+
+    QString message;
+    if (!newLayout.empty() && ioxMemPoolLayoutSatisfies(newLayout, requirements)) {
+        d->gconf->setIoxMemPoolLayout(ioxMemPoolLayoutToString(newLayout));
+        qCDebug(logEngine).noquote() << "Stored new IPC mempool layout:" << ioxMemPoolLayoutToString(newLayout);
+
+        message = QStringLiteral(
+                      "The shared memory reserved for communicating with external modules is too small for "
+                      "the data streams of this project.\n%1\n\n"
+                      "A larger configuration (%2 total) has been saved and will be used once Syntalos is "
+                      "restarted.")
+                      .arg(problem, QLocale().formattedDataSize(ioxMemPoolLayoutTotalSize(newLayout)));
+    } else {
+        message = QStringLiteral(
+                      "The shared memory reserved for communicating with external modules is too small for "
+                      "the data streams of this project.\n%1\n\n"
+                      "This system can provide at most %2 of shared memory to Syntalos, which is not enough. "
+                      "Reduce the frame size or the number of streams exchanged with external modules, "
+                      "or enlarge /dev/shm.")
+                      .arg(problem, QLocale().formattedDataSize(maxTotalSize));
+    }
+    d->runFailedReason = QStringLiteral("engine: %1").arg(problem);
+    d->failed = true;
+    d->pendingErrors.append(qMakePair(static_cast<AbstractModule *>(nullptr), message));
+    emitStatusMessage(QStringLiteral("Shared memory for IPC is insufficient."));
+
+    return false;
+}
+
+bool Engine::checkPeriodicThreadBandwidth(const QList<AbstractModule *> &threadedModules)
+{
+    std::vector<PeriodicThreadRequest> requests;
+    for (const auto &mod : threadedModules) {
+        const auto timing = mod->periodicTiming();
+        if (timing.period.count() > 0)
+            requests.push_back({mod->name(), timing});
+    }
+    if (requests.empty())
+        return true;
+
+    QString problem;
+    if (periodicThreadsFit(requests, availableRealtimeBandwidth(), &problem))
+        return true;
+
+    qCWarning(logEngine).noquote() << "Periodic module threads can not be scheduled:" << problem;
+    d->runFailedReason = QStringLiteral("engine: %1").arg(problem);
+    d->failed = true;
+    d->pendingErrors.append(qMakePair(
+        static_cast<AbstractModule *>(nullptr),
+        QStringLiteral("Not enough CPU time is available to run all modules with fixed timing requirements.\n%1")
+            .arg(problem)));
+    emitStatusMessage(QStringLiteral("Not enough CPU time for periodic threads."));
+
+    return false;
+}
+
 /**
  * @brief Return a list of active modules that have been sorted in the order they
  * should be prepared, run and overall be handled in (but not stopped in!).
@@ -1280,20 +1603,172 @@ void Engine::onDiskspaceMonitorEvent()
     }
 }
 
+/**
+ * Find the module which holds on to the most memory, or nullptr if no module uses any.
+ */
+static AbstractModule *largestMemoryUser(const QHash<AbstractModule *, ModuleMemoryUsage> &memUsage)
+{
+    AbstractModule *largestMod = nullptr;
+    qint64 largestBytes = 0;
+    for (auto it = memUsage.constBegin(); it != memUsage.constEnd(); ++it) {
+        if (it.value().totalBytes() <= largestBytes)
+            continue;
+        largestMod = it.key();
+        largestBytes = it.value().totalBytes();
+    }
+
+    return largestMod;
+}
+
+/**
+ * Describe the module which holds on to the most memory, for the user to know where to look.
+ */
+static QString largestMemoryUserMessage(const QHash<AbstractModule *, ModuleMemoryUsage> &memUsage)
+{
+    const auto largestMod = largestMemoryUser(memUsage);
+    if (largestMod == nullptr)
+        return QString();
+    const auto largest = memUsage.value(largestMod);
+
+    QStringList parts;
+    if (largest.queuedBytes > 0)
+        parts.append(QStringLiteral("%1 of unprocessed input").arg(QLocale().formattedDataSize(largest.queuedBytes)));
+    if (largest.residentBytes > 0)
+        parts.append(
+            QStringLiteral("%1 in its worker process").arg(QLocale().formattedDataSize(largest.residentBytes)));
+    return QStringLiteral("Module \"%1\" uses the most memory (%2).")
+        .arg(largestMod->name(), parts.join(QStringLiteral(", ")));
+}
+
+void Engine::updateModuleMemoryUsage()
+{
+    const auto now = symaster_clock::now();
+    const auto elapsedSec = std::chrono::duration<double>(now - d->monitoring->lastMemCheckTime).count();
+    d->monitoring->lastMemCheckTime = now;
+
+    QHash<AbstractModule *, qint64> queuedBytes;
+    QHash<AbstractModule *, qint64> peakInputBytes;
+    for (auto &msd : d->monitoring->monitoredSubscriptions) {
+        const auto mod = msd.port->owner();
+        queuedBytes[mod] += msd.sub->approxPendingBytes();
+        peakInputBytes[mod] = std::max<qint64>(peakInputBytes.value(mod, 0), msd.sub->peakPendingBytes());
+
+        // whatever was delivered and is not pending anymore was processed by the module
+        const auto delivered = msd.sub->deliveredCount();
+        const auto pending = msd.sub->approxPendingCount();
+        const auto processed = static_cast<double>(delivered - msd.lastDeliveredCount)
+                               - (static_cast<double>(pending) - static_cast<double>(msd.lastPendingCount));
+        if (elapsedSec > 0)
+            msd.processedPerSec = std::max(processed, 0.0) / elapsedSec;
+        msd.lastDeliveredCount = delivered;
+        msd.lastPendingCount = pending;
+    }
+
+    for (auto &mod : d->monitoring->modules) {
+        auto &usage = d->lastRunMemory[mod];
+        usage.queuedBytes = queuedBytes.value(mod, 0);
+        usage.peakQueuedBytes = std::max({usage.peakQueuedBytes, usage.queuedBytes, peakInputBytes.value(mod, 0)});
+
+        // out-of-process modules keep most of their data in their worker process
+        const auto mlinkMod = qobject_cast<MLinkModule *>(mod);
+        if (mlinkMod == nullptr)
+            continue;
+        const auto pid = mlinkMod->processId();
+        const auto rssKiB = pid > 0 ? read_process_rss_kib(pid) : -1;
+        if (rssKiB < 0)
+            continue;
+        usage.residentBytes = rssKiB * 1024;
+        usage.peakResidentBytes = std::max(usage.peakResidentBytes, usage.residentBytes);
+    }
+}
+
+/**
+ * Throttle the input which holds on to the most queued data, if that accounts for
+ * a noticeable share of the system's memory.
+ * @return true if an input was throttled.
+ */
+bool Engine::throttleLargestMemoryConsumer(qint64 memTotalBytes)
+{
+    EngineResourceMonitorData::SubscriptionBufferWatchData *largest = nullptr;
+    qint64 largestBytes = 0;
+    for (auto &msd : d->monitoring->monitoredSubscriptions) {
+        const auto pendingBytes = msd.sub->approxPendingBytes();
+        if (msd.memoryThrottled || pendingBytes <= largestBytes)
+            continue;
+        largest = &msd;
+        largestBytes = pendingBytes;
+    }
+
+    // we only intervene if throttling actually makes a difference
+    if (largest == nullptr || largestBytes < memTotalBytes / 50)
+        return false;
+
+    // only let through a bit less data than the module managed to process recently,
+    // so it can catch up with what is queued already
+    const auto itemsPerSec = static_cast<uint>(std::max(largest->processedPerSec * 0.9, 1.0));
+    largest->sub->restrictItemsPerSec(itemsPerSec);
+    largest->memoryThrottled = true;
+
+    const auto mod = largest->port->owner();
+    d->lastRunMemory[mod].throttledInputs++;
+
+    const auto message = QStringLiteral(
+                             "System memory is low: Module \"%1\" can not keep up with its input \"%2\" (%3 queued). "
+                             "The input was throttled to %4 items/sec.")
+                             .arg(mod->name(), largest->port->title())
+                             .arg(QLocale().formattedDataSize(largestBytes))
+                             .arg(itemsPerSec);
+    qCWarning(logEngine).noquote() << message;
+    Q_EMIT resourceWarningUpdate(Memory, false, message);
+    d->monitoring->memoryWarningEmitted = true;
+
+    return true;
+}
+
+/**
+ * Remove the throttles set by throttleLargestMemoryConsumer(), once memory
+ * is not scarce anymore.
+ */
+void Engine::liftMemoryThrottles()
+{
+    for (auto &msd : d->monitoring->monitoredSubscriptions) {
+        if (!msd.memoryThrottled)
+            continue;
+        msd.sub->clearItemsPerSecRestriction();
+        msd.memoryThrottled = false;
+        qCInfo(logEngine).noquote()
+            << QStringLiteral("System memory recovered, lifted throttle of input \"%1\" of module \"%2\".")
+                   .arg(msd.port->title(), msd.port->owner()->name());
+    }
+}
+
 void Engine::onMemoryMonitorEvent()
 {
     const auto memInfo = read_meminfo();
+    updateModuleMemoryUsage();
 
     if (memInfo.memAvailablePercent < d->monitoring->prevMemAvailablePercent && memInfo.memAvailablePercent < 1.6
         && d->monitoring->emergencyOOMStop) {
+        // try to get rid of the offender first, before we abort the whole run
+        if (throttleLargestMemoryConsumer(memInfo.memTotalKiB * 1024)) {
+            d->monitoring->prevMemAvailablePercent = memInfo.memAvailablePercent;
+            return;
+        }
+
         qCInfo(logEngine).noquote()
             << "Less than 2% of system memory available and shrinking, commencing emergency stop.";
-        receiveModuleError(QStringLiteral(
-            "Emergency stop: We are low on system memory, and it is continuing to shrink rapidly.\n"
-            "To prevent Syntalos from being killed by the system and loosing data, this run has been stopped.\n"
-            "Please check your module setup to ensure modules are able to process incoming data fast enough.\n"
-            "Slow connections are currently highlighted in red. Depending on the setup complexity, upgrading the "
-            "system may also be a viable solution"));
+
+        // attribute the failure to the module which holds on to the most memory
+        failRun(
+            largestMemoryUser(d->lastRunMemory),
+            QStringLiteral(
+                "Emergency stop: We are low on system memory, and it is continuing to shrink rapidly.\n"
+                "To prevent Syntalos from being killed by the system and loosing data, this run has been stopped.\n"
+                "%1\n"
+                "Please check your module setup to ensure modules are able to process incoming data fast enough.\n"
+                "Slow connections are currently highlighted in red. Depending on the setup complexity, upgrading the "
+                "system may also be a viable solution")
+                .arg(largestMemoryUserMessage(d->lastRunMemory)));
         d->runFailedReason = QStringLiteral("engine: Emergency stop due to low system memory.");
     } else if (memInfo.memAvailablePercent < 5) {
         // when we have less than 5% memory remaining, there usually still is (slower) swap space available,
@@ -1302,9 +1777,14 @@ void Engine::onMemoryMonitorEvent()
         Q_EMIT resourceWarningUpdate(
             Memory,
             false,
-            QStringLiteral("System memory is low. Only %1% remaining.").arg(memInfo.memAvailablePercent, 0, 'f', 1));
+            QStringLiteral("System memory is low. Only %1% remaining. %2")
+                .arg(memInfo.memAvailablePercent, 0, 'f', 1)
+                .arg(largestMemoryUserMessage(d->lastRunMemory)));
         d->monitoring->memoryWarningEmitted = true;
     } else {
+        // throttled inputs would otherwise drop data for the rest of the run
+        liftMemoryThrottles();
+
         if (d->monitoring->memoryWarningEmitted) {
             Q_EMIT resourceWarningUpdate(
                 Memory,
@@ -1352,7 +1832,8 @@ void Engine::onBufferMonitorEvent()
             qCDebug(logEngine).noquote().nospace()
                 << "Connection heat changed to \"" << connectionHeatToHumanString(msd.heat) << "\" for "
                 << QString("%1:%2[<%3]").arg(msd.port->owner()->name(), msd.port->title(), msd.port->dataTypeName())
-                << " (level: " << approxPendingCount << ")";
+                << " (level: " << approxPendingCount << ", "
+                << QLocale().formattedDataSize(msd.sub->approxPendingBytes()) << ")";
         }
 
         if (heat > ConnectionHeatLevel::LOW) {
@@ -1388,6 +1869,8 @@ void Engine::startResourceMonitoring(QList<AbstractModule *> activeModules, cons
     d->monitoring->prevMemAvailablePercent = 100;
     d->monitoring->emergencyOOMStop = d->gconf->emergencyOOMStop();
     d->monitoring->memoryWarningEmitted = false;
+    d->monitoring->modules = activeModules;
+    d->monitoring->lastMemCheckTime = symaster_clock::now();
     d->monitoring->memCheckTimer.setInterval(10 * 1000); // check every 10sec
     connect(&d->monitoring->memCheckTimer, &QTimer::timeout, this, &Engine::onMemoryMonitorEvent);
 
@@ -1401,6 +1884,10 @@ void Engine::startResourceMonitoring(QList<AbstractModule *> activeModules, cons
             data.sub = port->subscriptionVar().get();
             data.port = port.get();
             data.heat = ConnectionHeatLevel::NONE;
+            data.lastDeliveredCount = 0;
+            data.lastPendingCount = 0;
+            data.processedPerSec = 0;
+            data.memoryThrottled = false;
             d->monitoring->monitoredSubscriptions.push_back(data);
 
             // reset all connection heat levels
@@ -1430,7 +1917,23 @@ void Engine::stopResourceMonitoring()
     d->monitoring->subBufferCheckTimer.stop();
     d->monitoring->subBufferCheckTimer.disconnect(this);
 
+    // take a last look at where memory went, for the run diagnostics
+    updateModuleMemoryUsage();
+    for (auto it = d->lastRunMemory.constBegin(); it != d->lastRunMemory.constEnd(); ++it) {
+        const auto &usage = it.value();
+        if (usage.peakQueuedBytes == 0 && usage.peakResidentBytes < 0)
+            continue;
+        QString residentInfo;
+        if (usage.peakResidentBytes >= 0)
+            residentInfo = QStringLiteral(", %1 in its worker process")
+                               .arg(QLocale().formattedDataSize(usage.peakResidentBytes));
+        qCDebug(logEngine).noquote().nospace()
+            << "Module '" << it.key()->name() << "' held at most "
+            << QLocale().formattedDataSize(usage.peakQueuedBytes) << " of queued input" << residentInfo;
+    }
+
     d->monitoring->monitoredSubscriptions.clear();
+    d->monitoring->modules.clear();
     d->monitoring->exportDirPath = QString();
 
     qCDebug(logEngine).noquote().nospace() << "Stopped monitoring system resources.";
@@ -1485,9 +1988,30 @@ bool Engine::finalizeExperimentMetadata(
         QVariantHash info;
         info.insert(QStringLiteral("id"), mod->id());
         info.insert(QStringLiteral("name"), mod->name());
+        const auto timings = d->lastRunTimings.value(mod);
+        if (timings.hasStartSkew)
+            info.insert(QStringLiteral("start_skew_usec"), static_cast<qint64>(timings.startSkew.count()));
+        if (timings.hasThread)
+            info.insert(QStringLiteral("sched_policy"), threadSchedPolicyToString(timings.schedPolicy));
+        if (timings.periodic.cycles > 0) {
+            info.insert(QStringLiteral("periodic_cycles"), static_cast<qint64>(timings.periodic.cycles));
+            info.insert(QStringLiteral("missed_deadlines"), static_cast<qint64>(timings.periodic.missedDeadlines));
+            info.insert(QStringLiteral("max_cycle_usec"), static_cast<qint64>(timings.periodic.maxCycleTime.count()));
+            info.insert(QStringLiteral("p99_cycle_usec"), static_cast<qint64>(timings.periodic.p99CycleTime.count()));
+        }
+        const auto memUsage = d->lastRunMemory.value(mod);
+        info.insert(QStringLiteral("peak_queued_bytes"), memUsage.peakQueuedBytes);
+        if (memUsage.peakResidentBytes >= 0)
+            info.insert(QStringLiteral("peak_resident_bytes"), memUsage.peakResidentBytes);
+        if (memUsage.throttledInputs > 0)
+            info.insert(QStringLiteral("memory_throttled_inputs"), memUsage.throttledInputs);
         attrModList.append(info);
     }
     extraData.insert("modules", attrModList);
+
+    // time threaded modules were released at, relative to the start of the master clock
+    if (d->lastRunStartOffset.count() > 0)
+        extraData.insert("thread_start_offset_usec", static_cast<qint64>(d->lastRunStartOffset.count()));
     storageCollection->setAttributes(extraData);
 
     qCDebug(logEngine) << "Saving experiment metadata in:" << storageCollection->path();
@@ -1504,6 +2028,249 @@ bool Engine::finalizeExperimentMetadata(
     return true;
 }
 
+namespace
+{
+/**
+ * Runs the prepare() step of a module on a thread pool thread.
+ */
+class ModulePrepareTask : public QRunnable
+{
+public:
+    explicit ModulePrepareTask(AbstractModule *mod, const TestSubject &subject, std::function<void(bool)> doneFn)
+        : m_mod(mod),
+          m_subject(subject),
+          m_doneFn(std::move(doneFn))
+    {
+    }
+
+    void run() override
+    {
+        m_doneFn(m_mod->prepare(m_subject));
+    }
+
+private:
+    AbstractModule *m_mod;
+    TestSubject m_subject;
+    std::function<void(bool)> m_doneFn;
+};
+} // namespace
+
+/**
+ * @brief Prepare all modules for a run
+ * @return true if all modules were prepared successfully
+ *
+ * A module may need the metadata its upstream modules set on their output streams
+ * when it prepares, so it has to wait for those, but not for any other module.
+ * Modules which support it are prepared on a thread pool, while all others are
+ * prepared on the main thread in exec order, at the same time.
+ */
+bool Engine::prepareModules(
+    const QList<AbstractModule *> &orderedModules,
+    const std::shared_ptr<EDLCollection> &storageCollection)
+{
+    struct PrepareJob {
+        AbstractModule *mod;
+        QSet<AbstractModule *> upstream;
+        bool concurrent;
+        bool started;
+        bool finished;
+        milliseconds_t startTime;
+        milliseconds_t endTime;
+    };
+
+    std::vector<PrepareJob> jobs;
+    jobs.reserve(orderedModules.size());
+    for (auto &mod : orderedModules) {
+        // At this point the module should have a timer, the location where
+        // data is saved and be in the PREPARING state.
+        const auto modInfo = d->modLibrary->moduleInfo(mod->id());
+
+        mod->setStatusMessage(QString());
+        mod->setTimer(d->timer);
+        mod->setState(ModuleState::PREPARING);
+        mod->setEphemeralRun(d->runIsEphemeral);
+        mod->setWarmRun(d->warmModules.contains(mod));
+        d->lastRunTimings[mod].warm = d->warmModules.contains(mod);
+
+        mod->setSimpleStorageNames(d->simpleStorageNames);
+        if ((modInfo != nullptr) && (!modInfo->storageGroupName().isEmpty())) {
+            auto storageGroup = storageCollection->groupByName(modInfo->storageGroupName(), true);
+            if (storageGroup == nullptr) {
+                qCCritical(logEngine) << "Unable to create data storage group with name" << modInfo->storageGroupName();
+                mod->setStorageGroup(storageCollection);
+            } else {
+                mod->setStorageGroup(storageGroup);
+            }
+        } else {
+            mod->setStorageGroup(storageCollection);
+        }
+
+        PrepareJob job;
+        job.mod = mod;
+        job.concurrent = mod->features().testFlag(ModuleFeature::PREPARE_CONCURRENT);
+        job.started = false;
+        job.finished = false;
+        job.startTime = milliseconds_t(0);
+        job.endTime = milliseconds_t(0);
+        for (auto &iport : mod->inPorts()) {
+            if (!iport->hasSubscription())
+                continue;
+            const auto upstreamMod = iport->outPort()->owner();
+            if (upstreamMod != mod && orderedModules.contains(upstreamMod))
+                job.upstream.insert(upstreamMod);
+        }
+        jobs.push_back(job);
+    }
+
+    QThreadPool pool;
+    pool.setMaxThreadCount(std::max(1, QThread::idealThreadCount()));
+    std::mutex resultsMutex;
+    std::condition_variable resultsCond;
+    QHash<AbstractModule *, bool> poolResults;
+
+    QSet<AbstractModule *> preparedMods;
+    const auto phaseStartTime = currentTimePoint();
+    size_t finishedCount = 0;
+    int runningInPool = 0;
+    bool success = true;
+
+    const auto finishJob = [&](PrepareJob &job, bool ok) {
+        auto mod = job.mod;
+        job.finished = true;
+        job.endTime = timeDiffToNowMsec(phaseStartTime);
+        d->lastRunTimings[mod].prepare = job.endTime - job.startTime;
+        finishedCount++;
+
+        if (!ok) {
+            // only report the first failure, others are likely caused by it
+            if (success) {
+                d->runFailedReason = QStringLiteral("Prepare step failed for: %1(%2)").arg(mod->id(), mod->name());
+                emitStatusMessage(QStringLiteral("Module '%1' failed to prepare.").arg(mod->name()));
+            }
+            success = false;
+            d->failed = true;
+            return;
+        }
+
+        // If the module hasn't set itself to ready yet and is idle or preparing,
+        // assume it is actually ready. Otherwise flag it as dormant.
+        if (mod->state() == ModuleState::IDLE || mod->state() == ModuleState::PREPARING)
+            mod->setState(ModuleState::READY);
+        else if (mod->state() != ModuleState::READY)
+            mod->setState(ModuleState::DORMANT);
+        preparedMods.insert(mod);
+    };
+
+    const auto startJob = [&](PrepareJob &job) {
+        auto mod = job.mod;
+        job.started = true;
+        job.startTime = timeDiffToNowMsec(phaseStartTime);
+        emitStatusMessage(QStringLiteral("Preparing '%1'...").arg(mod->name()));
+
+        if (!job.concurrent) {
+            finishJob(job, mod->prepare(d->testSubject));
+            return;
+        }
+
+        runningInPool++;
+        pool.start(new ModulePrepareTask(mod, d->testSubject, [&, mod](bool ok) {
+            {
+                std::lock_guard<std::mutex> lock(resultsMutex);
+                poolResults.insert(mod, ok);
+            }
+            resultsCond.notify_one();
+        }));
+    };
+
+    while (finishedCount < jobs.size()) {
+        // collect the modules the pool has finished preparing
+        QHash<AbstractModule *, bool> results;
+        {
+            std::lock_guard<std::mutex> lock(resultsMutex);
+            results.swap(poolResults);
+        }
+        for (auto &job : jobs) {
+            if (!results.contains(job.mod))
+                continue;
+            runningInPool--;
+            finishJob(job, results.value(job.mod));
+        }
+
+        // don't start anything new once a module has failed, but let the pool finish
+        if (!success) {
+            if (runningInPool == 0)
+                break;
+        } else {
+            // hand every module whose upstream modules are done to the pool, and prepare
+            // the first one that has to run on the main thread
+            PrepareJob *mainThreadJob = nullptr;
+            bool anyStarted = false;
+            for (auto &job : jobs) {
+                if (job.started)
+                    continue;
+                if (!preparedMods.contains(job.upstream))
+                    continue;
+                if (job.concurrent) {
+                    startJob(job);
+                    anyStarted = true;
+                } else if (mainThreadJob == nullptr) {
+                    mainThreadJob = &job;
+                }
+            }
+
+            if (mainThreadJob != nullptr) {
+                startJob(*mainThreadJob);
+                continue;
+            }
+
+            if (!anyStarted && runningInPool == 0) {
+                // the remaining modules depend on each other, so just go by exec order
+                for (auto &job : jobs) {
+                    if (job.started)
+                        continue;
+                    qCDebug(logEngine).noquote() << "Module dependency cycle, preparing" << job.mod->name()
+                                                 << "before its upstream modules";
+                    startJob(job);
+                    break;
+                }
+                continue;
+            }
+        }
+
+        // wait for the pool, while keeping the UI responsive
+        QCoreApplication::processEvents();
+        std::unique_lock<std::mutex> lock(resultsMutex);
+        resultsCond.wait_for(lock, std::chrono::milliseconds(10), [&]() {
+            return !poolResults.isEmpty();
+        });
+    }
+    pool.waitForDone();
+
+    // write out when each module was prepared, so slow and blocking modules are easy to spot
+    milliseconds_t sequentialTime(0);
+    for (const auto &job : jobs) {
+        if (job.started)
+            sequentialTime += job.endTime - job.startTime;
+    }
+    QString timeline = QStringLiteral("Module preparation timeline (%1 msec in total, %2 msec if sequential):")
+                           .arg(timeDiffToNowMsec(phaseStartTime).count())
+                           .arg(sequentialTime.count());
+    for (const auto &job : jobs) {
+        if (!job.started) {
+            timeline.append(QStringLiteral("\n  %1 not prepared").arg(job.mod->name()));
+            continue;
+        }
+        timeline.append(QStringLiteral("\n  %1 → %2 msec: %3 (%4)")
+                            .arg(job.startTime.count(), 6)
+                            .arg(job.endTime.count(), 6)
+                            .arg(job.mod->name())
+                            .arg(job.concurrent ? QStringLiteral("worker thread") : QStringLiteral("main thread")));
+    }
+    qCDebug(logEngine).noquote() << timeline;
+
+    return success;
+}
+
 /**
  * @brief Actually run an experiment module board
  * @return true on succees
@@ -1514,6 +2281,7 @@ bool Engine::finalizeExperimentMetadata(
  */
 bool Engine::runInternal(const QString &exportDirPath)
 {
+    const auto setupStartTime = currentTimePoint();
     QDir edlDir(exportDirPath);
     if (edlDir.exists()) {
         QMessageBox::critical(
@@ -1535,6 +2303,13 @@ bool Engine::runInternal(const QString &exportDirPath)
     // ensure error queue is clean
     d->pendingErrors.clear();
 
+    // forget timings of the previous run
+    d->lastRunTimings.clear();
+    d->lastRunMemory.clear();
+    d->lastRunDuration = milliseconds_t(0);
+    d->lastRunSetupTime = milliseconds_t(0);
+    d->lastRunStartOffset = microseconds_t(0);
+
     // the engine is actively doing stuff with modules now
     d->active = true;
     d->usbEventsTimer->stop();
@@ -1638,6 +2413,7 @@ bool Engine::runInternal(const QString &exportDirPath)
     // filter out dedicated-thread modules, those get special treatment
     for (auto &mod : orderedActiveModules) {
         mod->setDefaultRTPriority(defaultRTPriority);
+        mod->resetPeriodicThreadStats();
         if (mod->driver() == ModuleDriverKind::THREAD_DEDICATED)
             threadedModules.append(mod);
     }
@@ -1652,52 +2428,35 @@ bool Engine::runInternal(const QString &exportDirPath)
     for (auto &mod : orderedActiveModules)
         mod->setPotentialNoaffinityCPUCount(potentialNoaffinityCPUCount);
 
-    QCoreApplication::processEvents();
-
-    // prepare modules
+    // account image processing time to modules of this run only, and keep display modules
+    // from occupying more than one evaluation's worth of vips threads
+    auto vipsBudget = VipsBudget::instance();
+    vipsBudget->resetUsage();
+    vipsBudget->clearModuleThreadLimits();
     for (auto &mod : orderedActiveModules) {
-        // Prepare module. At this point it should have a timer,
-        // the location where data is saved and be in the PREPARING state.
-        emitStatusMessage(QStringLiteral("Preparing '%1'...").arg(mod->name()));
-        lastPhaseTimepoint = currentTimePoint();
-
         const auto modInfo = d->modLibrary->moduleInfo(mod->id());
+        if (modInfo != nullptr && modInfo->categories().testFlag(ModuleCategory::DISPLAY))
+            vipsBudget->setModuleThreadLimit(mod->name(), vipsBudget->evalThreads());
+    }
 
-        mod->setStatusMessage(QString());
-        mod->setTimer(d->timer);
-        mod->setState(ModuleState::PREPARING);
-        mod->setEphemeralRun(d->runIsEphemeral);
+    QCoreApplication::processEvents();
 
-        mod->setSimpleStorageNames(d->simpleStorageNames);
-        if ((modInfo != nullptr) && (!modInfo->storageGroupName().isEmpty())) {
-            auto storageGroup = storageCollection->groupByName(modInfo->storageGroupName(), true);
-            if (storageGroup == nullptr) {
-                qCCritical(logEngine) << "Unable to create data storage group with name" << modInfo->storageGroupName();
-                mod->setStorageGroup(storageCollection);
-            } else {
-                mod->setStorageGroup(storageGroup);
-            }
-        } else {
-            mod->setStorageGroup(storageCollection);
-        }
+    // prepare modules, independent ones at the same time
+    const auto warmModulesCount = d->warmModules.size();
+    if (!prepareModules(orderedActiveModules, storageCollection))
+        initSuccessful = false;
 
-        if (!mod->prepare(d->testSubject)) {
-            initSuccessful = false;
-            d->failed = true;
-            d->runFailedReason = QStringLiteral("Prepare step failed for: %1(%2)").arg(mod->id(), mod->name());
-            emitStatusMessage(QStringLiteral("Module '%1' failed to prepare.").arg(mod->name()));
-            break;
-        }
-        // If the module hasn't set itself to ready yet and is idle or preparing,
-        // assume it is actually ready. Otherwise flag it as dormant.
-        if (mod->state() == ModuleState::IDLE || mod->state() == ModuleState::PREPARING)
-            mod->setState(ModuleState::READY);
-        else if (mod->state() != ModuleState::READY)
-            mod->setState(ModuleState::DORMANT);
+    // the modules are in use again now, they will tell us on stop whether they stay warm
+    d->warmModules.clear();
 
-        qCDebug(logEngine).noquote().nospace()
-            << "Module '" << mod->name() << "' prepared in " << timeDiffToNowMsec(lastPhaseTimepoint).count() << "msec";
-    }
+    // ensure RouDi can hold all data exchanged with external modules, so we fail
+    // here instead of being unable to transmit data during the run
+    if (initSuccessful && !checkIpcMemPoolLayout(orderedActiveModules))
+        initSuccessful = false;
+
+    // modules declare their periodic timing in prepare(), ensure the CPU can keep up with all of them
+    if (initSuccessful && !checkPeriodicThreadBandwidth(threadedModules))
+        initSuccessful = false;
 
     // exporter for streams so out-of-process mlink modules can access them
     emitStatusMessage(QStringLiteral("Exporting streams for external modules..."));
@@ -1745,6 +2504,16 @@ bool Engine::runInternal(const QString &exportDirPath)
             td.niceness = defaultThreadNice;
             td.allowedRTPriority = defaultRTPriority;
 
+            // if periodic threads can not use deadline scheduling, the ones with the shortest
+            // periods get the highest realtime priority (rate-monotonic scheduling)
+            td.timing = mod->periodicTiming();
+            if (td.timing.isValid()) {
+                for (const auto &other : threadedModules) {
+                    if (other->periodicTiming().isValid() && other->periodicTiming().period > td.timing.period)
+                        td.allowedRTPriority++;
+                }
+            }
+
             if (modCPUMap.contains(mod)) {
                 td.cpuAffinity = modCPUMap[mod];
                 std::ostringstream oss;
@@ -1881,6 +2650,12 @@ bool Engine::runInternal(const QString &exportDirPath)
         d->timer->start();
         d->running = true;
 
+        d->lastRunSetupTime = timeDiffToNowMsec(setupStartTime);
+        if (warmModulesCount > 0)
+            qCDebug(logEngine).noquote().nospace()
+                << "Re-armed run with " << warmModulesCount << " warm module(s) in "
+                << d->lastRunSetupTime.count() << "msec";
+
         // first, launch all threaded and evented modules
         for (auto &mod : orderedActiveModules) {
             if ((mod->driver() != ModuleDriverKind::THREAD_DEDICATED)
@@ -1903,11 +2678,12 @@ bool Engine::runInternal(const QString &exportDirPath)
         // make stream exporter resume its work
         streamExporter->run(startWaitCondition.get());
 
-        // wake that thundering herd and hope all threaded modules awoken by the
-        // start signal behave properly
+        // wake that thundering herd, releasing all threads at the same point in time
         // (Threads *must* only be unlocked after we've sent start() to the modules, as they
         // may prepare stuff in start() that the threads need, like timestamp syncs)
-        startWaitCondition->wakeAll();
+        // All threads get a little time to be scheduled again and then sleep until shortly
+        // before the start time, to spin for the remainder.
+        startWaitCondition->wakeAllAt(symaster_clock::now() + START_BARRIER_LEAD_TIME);
 
         qCDebug(logEngine).noquote().nospace()
             << "Threaded/evented module startup completed, took " << d->timer->timeSinceStartMsec().count() << "msec";
@@ -1966,11 +2742,28 @@ bool Engine::runInternal(const QString &exportDirPath)
         // stop exporting streams to external modules
         streamExporter->stop();
 
+        // record how well the module threads were synchronized on start
+        microseconds_t maxStartSkew(0);
+        const auto startSkews = startWaitCondition->startSkews();
+        for (auto it = startSkews.constBegin(); it != startSkews.constEnd(); ++it) {
+            auto &timings = d->lastRunTimings[it.key()];
+            timings.hasStartSkew = true;
+            timings.startSkew = std::chrono::duration_cast<microseconds_t>(it.value());
+            maxStartSkew = std::max(maxStartSkew, timings.startSkew);
+        }
+        d->lastRunStartOffset = std::chrono::duration_cast<microseconds_t>(
+            startWaitCondition->startTime() - d->timer->startTime());
+        qCDebug(logEngine).noquote().nospace()
+            << "Released " << startSkews.size() << " module threads with a maximum start skew of "
+            << maxStartSkew.count() << "µs";
+
         // stop resource watcher timers
         stopResourceMonitoring();
     }
 
     auto finishTimestamp = static_cast<long long>(d->timer->timeSinceStartMsec().count());
+    if (initSuccessful)
+        d->lastRunDuration = milliseconds_t(finishTimestamp);
     emitStatusMessage(QStringLiteral("Run stopped, finalizing..."));
 
     // clear any thread affinity of the main process, so anything the stop() actions
@@ -2037,8 +2830,14 @@ bool Engine::runInternal(const QString &exportDirPath)
             iport->subscriptionVar()->clearPending();
         }
 
-        // send the stop command
+        // send the stop command, and let modules which can keep their resources for the next run do so
+        const bool keepWarm = d->keepModulesWarm && !d->failed && initSuccessful
+                              && mod->features().testFlag(ModuleFeature::KEEP_WARM);
+        mod->setKeepWarmAfterStop(keepWarm);
         mod->stop();
+        mod->setKeepWarmAfterStop(false);
+        if (keepWarm && mod->state() != ModuleState::ERROR)
+            d->warmModules.insert(mod);
         QCoreApplication::processEvents();
 
         // safeguard against bad modules which don't stop running their
@@ -2054,8 +2853,9 @@ bool Engine::runInternal(const QString &exportDirPath)
         if (mod->state() != ModuleState::IDLE && mod->state() != ModuleState::ERROR)
             mod->setState(ModuleState::IDLE);
 
+        d->lastRunTimings[mod].stop = timeDiffToNowMsec(lastPhaseTimepoint);
         qCDebug(logEngine).noquote().nospace()
-            << "Module '" << mod->name() << "' stopped in " << timeDiffToNowMsec(lastPhaseTimepoint).count() << "msec";
+            << "Module '" << mod->name() << "' stopped in " << d->lastRunTimings[mod].stop.count() << "msec";
     }
 
     lastPhaseTimepoint = d->timer->currentTimePoint();
@@ -2132,8 +2932,27 @@ bool Engine::runInternal(const QString &exportDirPath)
 
     qCDebug(logEngine).noquote().nospace()
         << "All (non-event) engine threads joined in " << timeDiffToNowMsec(lastPhaseTimepoint).count() << "msec";
+
+    // record how the module threads were scheduled and whether periodic ones kept up
+    for (size_t i = 0; i < dThreads.size(); i++) {
+        auto mod = threadedModules[i];
+        auto &timings = d->lastRunTimings[mod];
+        timings.hasThread = true;
+        timings.schedPolicy = dThreads[i]->schedPolicy();
+        timings.periodic = mod->periodicThreadStats();
+        if (timings.periodic.missedDeadlines > 0)
+            qCWarning(logEngine).noquote().nospace()
+                << "Module '" << mod->name() << "' missed " << timings.periodic.missedDeadlines << " of "
+                << timings.periodic.cycles << " deadlines (longest cycle: " << timings.periodic.maxCycleTime.count()
+                << "µs)";
+    }
+
     lastPhaseTimepoint = d->timer->currentTimePoint();
 
+    const auto vipsUsage = VipsBudget::instance()->usageSummary();
+    if (!vipsUsage.isEmpty())
+        qCDebug(logEngine).noquote() << "Image processing (libvips) usage by module:\n" << vipsUsage;
+
     // All module data must be written by this point, so we "steal" its storage group,
     // so the module will trigger an error message if is still tries to access the final
     // data. We mast do this in a separate loop, as some modules may share an EDL group
@@ -2182,6 +3001,14 @@ bool Engine::runInternal(const QString &exportDirPath)
     // we have stopped doing things with modules
     d->active = false;
 
+    // a failed run, or one that was the last one, does not get a warm successor
+    if (d->failed || !d->keepModulesWarm) {
+        coolDownModules();
+
+        // nobody needs the idle frame buffers until the next run starts
+        FrameBufferPool::trimShared();
+    }
+
     // notify modules about any deferred USB events again
     d->usbEventsTimer->start();
 
@@ -2199,12 +3026,20 @@ void Engine::stop()
 
 void Engine::receiveModuleError(const QString &message)
 {
-    auto mod = qobject_cast<AbstractModule *>(sender());
-    mod->setState(ModuleState::ERROR);
-    if (mod != nullptr)
+    failRun(qobject_cast<AbstractModule *>(sender()), message);
+}
+
+/**
+ * Stop the current run because of an error, which can be attributed to @p mod if it is not null.
+ */
+void Engine::failRun(AbstractModule *mod, const QString &message)
+{
+    if (mod != nullptr) {
+        mod->setState(ModuleState::ERROR);
         d->runFailedReason = QStringLiteral("%1(%2): %3").arg(mod->id(), mod->name(), message);
-    else
+    } else {
         d->runFailedReason = QStringLiteral("?(?): %1").arg(message);
+    }
 
     const bool wasRunning = d->running;
     d->failed = true;
@@ -21,6 +21,7 @@
 
 #include <QLoggingCategory>
 #include <QObject>
+#include <algorithm>
 #include <memory>
 
 #include "moduleapi.h"
@@ -34,6 +35,40 @@ namespace Syntalos
 
 Q_DECLARE_LOGGING_CATEGORY(logEngine)
 
+/**
+ * @brief Time a module spent in the setup and teardown phases of a run, and how its thread was scheduled
+ */
+struct ModuleRunTimings {
+    milliseconds_t prepare{0};
+    milliseconds_t stop{0};
+
+    bool hasStartSkew{false};    /// Whether the module's thread waited for the synchronized start
+    microseconds_t startSkew{0}; /// Delay between the synchronized start time and the thread resuming
+
+    bool warm{false}; /// Whether the module reused resources it kept alive since the previous run
+
+    bool hasThread{false};                                   /// Whether the module ran in a dedicated engine thread
+    ThreadSchedPolicy schedPolicy{ThreadSchedPolicy::OTHER}; /// Scheduling class of the module's thread
+
+    PeriodicThreadStats periodic; /// Deadline statistics, if the module declared its periodic timing
+};
+
+/**
+ * @brief Memory attributed to a module during a run
+ */
+struct ModuleMemoryUsage {
+    qint64 queuedBytes{0};     /// Data waiting in the module's input queues
+    qint64 peakQueuedBytes{0}; /// Most data seen waiting in the module's input queues
+    qint64 residentBytes{-1};  /// Resident memory of the module's worker process, -1 if it has none
+    qint64 peakResidentBytes{-1};
+    uint throttledInputs{0}; /// Inputs the engine throttled because the module fell behind while memory was low
+
+    qint64 totalBytes() const
+    {
+        return queuedBytes + std::max<qint64>(residentBytes, 0);
+    }
+};
+
 class Engine : public QObject
 {
     Q_OBJECT
@@ -92,6 +127,10 @@ public:
     AbstractModule *moduleByName(const QString &name) const;
 
     QString lastRunExportDir() const;
+    milliseconds_t lastRunDuration() const;
+    milliseconds_t lastRunSetupTime() const;
+    ModuleRunTimings lastRunModuleTimings(AbstractModule *mod) const;
+    ModuleMemoryUsage lastRunModuleMemory(AbstractModule *mod) const;
     QString readRunComment(const QString &runExportDir = nullptr) const;
     /**
      * @brief Set comment for the next or a last experiment run
@@ -103,6 +142,9 @@ public:
     bool saveInternalDiagnostics() const;
     void setSaveInternalDiagnostics(bool save);
 
+    bool keepModulesWarm() const;
+    void setKeepModulesWarm(bool keepWarm);
+
     void notifyUsbHotplugEvent(UsbHotplugEventKind kind);
 
 public slots:
@@ -154,16 +196,26 @@ private:
     int obtainSleepShutdownIdleInhibitor();
     bool makeDirectory(const QString &dir);
     bool ensureRoudi();
+    bool checkIpcMemPoolLayout(const QList<AbstractModule *> &modules);
+    bool checkPeriodicThreadBandwidth(const QList<AbstractModule *> &threadedModules);
 
     QHash<AbstractModule *, std::vector<uint>> setupCoreAffinityConfig(const QList<AbstractModule *> &threadedModules);
     void startResourceMonitoring(QList<AbstractModule *> activeModules, const QString &exportDirPath);
     void stopResourceMonitoring();
+    void updateModuleMemoryUsage();
+    bool throttleLargestMemoryConsumer(qint64 memTotalBytes);
+    void liftMemoryThrottles();
+    void failRun(AbstractModule *mod, const QString &message);
 
     bool finalizeExperimentMetadata(
         std::shared_ptr<EDLCollection> storageCollection,
         qint64 finishTimestamp,
         const QList<AbstractModule *> &activeModules);
+    bool prepareModules(
+        const QList<AbstractModule *> &orderedModules,
+        const std::shared_ptr<EDLCollection> &storageCollection);
     bool runInternal(const QString &exportDirPath);
+    void coolDownModules();
     void makeFinalExperimentId();
     void refreshExportDirPath();
     void emitStatusMessage(const QString &message);
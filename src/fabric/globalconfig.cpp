@@ -147,6 +147,16 @@ void GlobalConfig::setExplicitCoreAffinities(bool enabled)
     m_s->setValue("engine/explicit_core_affinities", enabled);
 }
 
+int GlobalConfig::vipsThreadBudget() const
+{
+    return m_s->value("engine/vips_thread_budget", 0).toInt();
+}
+
+void GlobalConfig::setVipsThreadBudget(int threads)
+{
+    m_s->setValue("engine/vips_thread_budget", threads < 0 ? 0 : threads);
+}
+
 bool GlobalConfig::showDevelModules() const
 {
     return m_s->value("devel/show_devel_modules", false).toBool();
@@ -212,6 +222,26 @@ void GlobalConfig::setEmergencyOOMStop(bool enabled)
     m_s->setValue("engine/emergency_oom_stop", enabled);
 }
 
+bool GlobalConfig::warmPythonWorkers() const
+{
+    return m_s->value("engine/warm_python_workers", false).toBool();
+}
+
+void GlobalConfig::setWarmPythonWorkers(bool enabled)
+{
+    m_s->setValue("engine/warm_python_workers", enabled);
+}
+
+QString GlobalConfig::ioxMemPoolLayout() const
+{
+    return m_s->value("engine/iox_mempool_layout", QString()).toString();
+}
+
+void GlobalConfig::setIoxMemPoolLayout(const QString &layout)
+{
+    m_s->setValue("engine/iox_mempool_layout", layout);
+}
+
 QString Syntalos::colorModeToString(ColorMode mode)
 {
     switch (mode) {
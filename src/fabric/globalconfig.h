@@ -69,6 +69,9 @@ public:
     bool explicitCoreAffinities() const;
     void setExplicitCoreAffinities(bool enabled);
 
+    int vipsThreadBudget() const;
+    void setVipsThreadBudget(int threads);
+
     bool showDevelModules() const;
     void setShowDevelModules(bool enabled);
 
@@ -88,6 +91,12 @@ public:
     bool emergencyOOMStop() const;
     void setEmergencyOOMStop(bool enabled);
 
+    bool warmPythonWorkers() const;
+    void setWarmPythonWorkers(bool enabled);
+
+    QString ioxMemPoolLayout() const;
+    void setIoxMemPoolLayout(const QString &layout);
+
 private:
     QSettings *m_s;
     QString m_userHome;
@@ -0,0 +1,269 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "ioxmempool.h"
+
+#include <QLocale>
+#include <QSize>
+#include <QStringList>
+#include <algorithm>
+#include <sys/statvfs.h>
+
+#include "datactl/frametype.h"
+
+using namespace Syntalos;
+
+static constexpr uint64_t ONE_KILOBYTE = 1024U;
+static constexpr uint64_t ONE_MEGABYTE = 1024U * 1024;
+
+// samples per signal block we assume if a stream does not tell us its block size
+static constexpr uint64_t SIGNAL_BLOCK_DEFAULT_SAMPLES = 1024U;
+
+// RouDi can only manage a limited number of mempools per segment
+static constexpr size_t IOX_MAX_MEMPOOLS = 32U;
+
+// never let RouDi reserve more shared memory than this, no matter what a project requests
+static constexpr uint64_t IOX_MEMPOOL_MAX_TOTAL_SIZE = ONE_MEGABYTE * 8192;
+
+// share of the free space in /dev/shm a layout may claim, other programs need shared memory too
+static constexpr double IOX_SHM_USABLE_FRACTION = 0.75;
+
+std::vector<IoxMemPool> Syntalos::defaultIoxMemPoolLayout()
+{
+    return {
+        {ONE_KILOBYTE,       50},
+        {ONE_KILOBYTE * 512, 50},
+        {ONE_MEGABYTE,       20},
+        {ONE_MEGABYTE * 6,   20},
+        {ONE_MEGABYTE * 24,  10},
+    };
+}
+
+QString Syntalos::ioxMemPoolLayoutToString(const std::vector<IoxMemPool> &layout)
+{
+    QStringList parts;
+    for (const auto &pool : layout)
+        parts.append(QStringLiteral("%1:%2").arg(pool.chunkSize).arg(pool.chunkCount));
+    return parts.join(QLatin1Char(','));
+}
+
+std::vector<IoxMemPool> Syntalos::ioxMemPoolLayoutFromString(const QString &str)
+{
+    std::vector<IoxMemPool> layout;
+    for (const auto &part : str.split(QLatin1Char(','), Qt::SkipEmptyParts)) {
+        const auto values = part.trimmed().split(QLatin1Char(':'));
+        if (values.size() != 2)
+            return {};
+
+        bool sizeOk = false;
+        bool countOk = false;
+        const auto chunkSize = values[0].toULongLong(&sizeOk);
+        const auto chunkCount = values[1].toUInt(&countOk);
+        if (!sizeOk || !countOk || chunkSize == 0 || chunkCount == 0)
+            return {};
+        layout.push_back({chunkSize, chunkCount});
+    }
+
+    if (layout.size() > IOX_MAX_MEMPOOLS)
+        return {};
+
+    std::sort(layout.begin(), layout.end(), [](const auto &a, const auto &b) {
+        return a.chunkSize < b.chunkSize;
+    });
+    return layout;
+}
+
+uint64_t Syntalos::ioxMemPoolLayoutTotalSize(const std::vector<IoxMemPool> &layout)
+{
+    uint64_t total = 0;
+    for (const auto &pool : layout)
+        total += pool.chunkSize * pool.chunkCount;
+    return total;
+}
+
+uint64_t Syntalos::ioxMemPoolMaxTotalSize()
+{
+    struct statvfs shmStat;
+    if (statvfs("/dev/shm", &shmStat) != 0)
+        return IOX_MEMPOOL_MAX_TOTAL_SIZE;
+
+    const auto shmAvailable = static_cast<uint64_t>(shmStat.f_bavail) * shmStat.f_frsize;
+    return std::min(IOX_MEMPOOL_MAX_TOTAL_SIZE, static_cast<uint64_t>(shmAvailable * IOX_SHM_USABLE_FRACTION));
+}
+
+std::vector<IoxMemPool> Syntalos::ioxMemPoolLayoutClamped(const std::vector<IoxMemPool> &layout, uint64_t maxBytes)
+{
+    const auto totalSize = ioxMemPoolLayoutTotalSize(layout);
+    if (totalSize <= maxBytes)
+        return layout;
+
+    const auto factor = static_cast<double>(maxBytes) / totalSize;
+    auto clamped = layout;
+    for (auto &pool : clamped)
+        pool.chunkCount = std::max<uint32_t>(1, static_cast<uint32_t>(pool.chunkCount * factor));
+
+    if (ioxMemPoolLayoutTotalSize(clamped) > maxBytes)
+        return {};
+    return clamped;
+}
+
+uint64_t Syntalos::estimateStreamElementMemorySize(int dataTypeId, const QHash<QString, QVariant> &metadata)
+{
+    if (dataTypeId == syDataTypeId<Frame>()) {
+        const auto size = metadata.value(QStringLiteral("size"), QSize()).toSize();
+        if (!size.isValid())
+            return 0;
+
+        // assume a color image unless we are told otherwise, we rather overestimate here
+        const uint64_t bands = metadata.value(QStringLiteral("has_color"), true).toBool() ? 3 : 1;
+        const auto depth = static_cast<VipsBandFormat>(
+            metadata.value(QStringLiteral("depth"), VIPS_FORMAT_UCHAR).toInt());
+        const uint64_t elementSize = std::max<uint64_t>(vips_format_sizeof(depth), 1);
+
+        return Frame::HeaderSize + (uint64_t)size.width() * size.height() * bands * elementSize;
+    }
+
+    if (dataTypeId == syDataTypeId<FloatSignalBlock>() || dataTypeId == syDataTypeId<IntSignalBlock>()) {
+        const auto channels = std::max<uint64_t>(
+            metadata.value(QStringLiteral("signal_names")).toStringList().size(), 1);
+        auto samples = metadata.value(QStringLiteral("block_size"), 0).toULongLong();
+        if (samples == 0)
+            samples = SIGNAL_BLOCK_DEFAULT_SAMPLES;
+
+        const uint64_t valueSize = dataTypeId == syDataTypeId<FloatSignalBlock>() ? sizeof(MatrixXd::Scalar)
+                                                                                   : sizeof(MatrixXi::Scalar);
+        return sizeof(quint64) * 3 + samples * sizeof(VectorXu::Scalar) + samples * channels * valueSize;
+    }
+
+    return 0;
+}
+
+/**
+ * Sum up the chunks each pool of @p layout has to provide. Requirements
+ * which don't fit into any pool are added to @p unfit.
+ */
+static std::vector<int64_t> assignRequirementsToPools(
+    const std::vector<IoxMemPool> &layout,
+    const std::vector<IoxChunkRequirement> &requirements,
+    std::vector<const IoxChunkRequirement *> *unfit = nullptr)
+{
+    std::vector<int64_t> demand(layout.size(), 0);
+    for (const auto &req : requirements) {
+        bool placed = false;
+        for (size_t i = 0; i < layout.size(); i++) {
+            if (layout[i].chunkSize < req.chunkSize)
+                continue;
+            demand[i] += req.chunkCount;
+            placed = true;
+            break;
+        }
+
+        if (!placed && unfit != nullptr)
+            unfit->push_back(&req);
+    }
+
+    return demand;
+}
+
+bool Syntalos::ioxMemPoolLayoutSatisfies(
+    const std::vector<IoxMemPool> &layout,
+    const std::vector<IoxChunkRequirement> &requirements,
+    QString *errorMessage)
+{
+    std::vector<const IoxChunkRequirement *> unfit;
+    const auto demand = assignRequirementsToPools(layout, requirements, &unfit);
+
+    if (!unfit.empty()) {
+        if (errorMessage != nullptr) {
+            const auto req = unfit.front();
+            *errorMessage = QStringLiteral(
+                                "Elements of stream \"%1\" need %2 of shared memory each, but the largest "
+                                "shared-memory chunk available is only %3 large.")
+                                .arg(req->streamName)
+                                .arg(QLocale().formattedDataSize(req->chunkSize))
+                                .arg(QLocale().formattedDataSize(layout.empty() ? 0 : layout.back().chunkSize));
+        }
+        return false;
+    }
+
+    for (size_t i = 0; i < layout.size(); i++) {
+        if (demand[i] <= layout[i].chunkCount)
+            continue;
+
+        if (errorMessage != nullptr) {
+            QStringList streams;
+            for (const auto &req : requirements) {
+                const auto it = std::find_if(layout.cbegin(), layout.cend(), [&](const auto &pool) {
+                    return pool.chunkSize >= req.chunkSize;
+                });
+                if (it - layout.cbegin() == static_cast<ssize_t>(i))
+                    streams.append(QStringLiteral("\"%1\"").arg(req.streamName));
+            }
+
+            *errorMessage = QStringLiteral(
+                                "Streams %1 need up to %2 shared-memory chunks of %3 at the same time, "
+                                "but only %4 are available.")
+                                .arg(streams.join(QStringLiteral(", ")))
+                                .arg(demand[i])
+                                .arg(QLocale().formattedDataSize(layout[i].chunkSize))
+                                .arg(layout[i].chunkCount);
+        }
+        return false;
+    }
+
+    return true;
+}
+
+std::vector<IoxMemPool> Syntalos::ioxMemPoolLayoutFor(
+    const std::vector<IoxChunkRequirement> &requirements,
+    const std::vector<IoxMemPool> &base)
+{
+    auto layout = base;
+
+    // add pools for elements which are larger than anything we have so far,
+    // rounded up so streams of similar size share one pool
+    while (true) {
+        std::vector<const IoxChunkRequirement *> unfit;
+        assignRequirementsToPools(layout, requirements, &unfit);
+        if (unfit.empty())
+            break;
+
+        const auto chunkSize = ((unfit.front()->chunkSize + ONE_MEGABYTE - 1) / ONE_MEGABYTE) * ONE_MEGABYTE;
+        if (layout.size() >= IOX_MAX_MEMPOOLS) {
+            layout.back().chunkSize = chunkSize;
+            continue;
+        }
+
+        layout.push_back({chunkSize, 0});
+        std::sort(layout.begin(), layout.end(), [](const auto &a, const auto &b) {
+            return a.chunkSize < b.chunkSize;
+        });
+    }
+
+    // grow pools which are too small, leaving some headroom for control messages
+    // and elements that are a bit larger than announced
+    const auto demand = assignRequirementsToPools(layout, requirements);
+    for (size_t i = 0; i < layout.size(); i++) {
+        const auto wanted = static_cast<uint32_t>(demand[i] + (demand[i] / 4));
+        if (wanted > layout[i].chunkCount)
+            layout[i].chunkCount = wanted;
+    }
+
+    return layout;
+}
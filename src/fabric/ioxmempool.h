@@ -0,0 +1,114 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QString>
+#include <QVariant>
+#include <vector>
+
+namespace Syntalos
+{
+
+/**
+ * @brief A pool of equally sized shared-memory chunks managed by RouDi
+ */
+struct IoxMemPool {
+    uint64_t chunkSize;
+    uint32_t chunkCount;
+
+    bool operator==(const IoxMemPool &other) const
+    {
+        return chunkSize == other.chunkSize && chunkCount == other.chunkCount;
+    }
+};
+
+/**
+ * @brief Shared-memory chunks a single stream needs to be transferred between processes
+ */
+struct IoxChunkRequirement {
+    QString streamName;  /// Human-readable name of the stream, for error reporting
+    uint64_t chunkSize;  /// Size of the largest element expected on the stream
+    uint32_t chunkCount; /// Number of chunks that may be in use at the same time
+};
+
+/**
+ * Mempool layout used if no larger one was requested.
+ */
+std::vector<IoxMemPool> defaultIoxMemPoolLayout();
+
+/**
+ * Serialize a mempool layout to the "SIZE:COUNT,SIZE:COUNT,..." notation
+ * understood by syntalos-roudi.
+ */
+QString ioxMemPoolLayoutToString(const std::vector<IoxMemPool> &layout);
+
+/**
+ * Parse a mempool layout in "SIZE:COUNT,..." notation.
+ * @return The layout sorted by chunk size, or an empty layout if the string was invalid.
+ */
+std::vector<IoxMemPool> ioxMemPoolLayoutFromString(const QString &str);
+
+/**
+ * Total amount of shared memory a layout occupies, in bytes (excluding management overhead).
+ */
+uint64_t ioxMemPoolLayoutTotalSize(const std::vector<IoxMemPool> &layout);
+
+/**
+ * Largest amount of shared memory a mempool layout may occupy, in bytes.
+ * This is a fixed upper limit, further reduced to a share of the space available in /dev/shm.
+ */
+uint64_t ioxMemPoolMaxTotalSize();
+
+/**
+ * Reduce the chunk counts of @p layout proportionally, so it occupies at most @p maxBytes.
+ * @return The clamped layout, or an empty layout if even a single chunk per pool exceeds the limit.
+ */
+std::vector<IoxMemPool> ioxMemPoolLayoutClamped(const std::vector<IoxMemPool> &layout, uint64_t maxBytes);
+
+/**
+ * Estimate the size of a single stream element in shared memory from its data type and
+ * stream metadata (e.g. frame size, color and depth, signal channel count and block size).
+ * @return Estimated size in bytes, or 0 if the type has no meaningful size estimate.
+ */
+uint64_t estimateStreamElementMemorySize(int dataTypeId, const QHash<QString, QVariant> &metadata);
+
+/**
+ * Check whether the given layout can hold all chunks required at the same time.
+ *
+ * Every chunk is taken from the smallest pool it fits into, just like RouDi does.
+ * @param layout The mempool layout to check.
+ * @param requirements Chunks the streams of a run need.
+ * @param errorMessage Set to a human-readable description of the first problem found.
+ * @return true if the layout is sufficient.
+ */
+bool ioxMemPoolLayoutSatisfies(
+    const std::vector<IoxMemPool> &layout,
+    const std::vector<IoxChunkRequirement> &requirements,
+    QString *errorMessage = nullptr);
+
+/**
+ * Create a layout which is at least as large as @p base and satisfies all @p requirements.
+ */
+std::vector<IoxMemPool> ioxMemPoolLayoutFor(
+    const std::vector<IoxChunkRequirement> &requirements,
+    const std::vector<IoxMemPool> &base);
+
+} // namespace Syntalos
@@ -22,6 +22,7 @@
 #include "config.h"
 #include <QProcess>
 #include <QElapsedTimer>
+#include <QTimer>
 #include <QCoreApplication>
 #include <iceoryx_hoofs/posix_wrapper/signal_watcher.hpp>
 #include <iceoryx_posh/popo/subscriber.hpp>
@@ -41,6 +42,12 @@ namespace Syntalos
 Q_LOGGING_CATEGORY(logMLinkMod, "mlink-master")
 }
 
+static iox::capro::IdString_t makeClientId(const QString &modId, int index)
+{
+    return iox::capro::IdString_t(
+        iox::cxx::TruncateToCapacity, QStringLiteral("%1_%2").arg(modId).arg(index).toStdString());
+}
+
 class MLinkModule::Private
 {
 public:
@@ -51,6 +58,12 @@ public:
     QProcess *proc;
     bool outputCaptured;
     QString pyVenvDir;
+    QStringList pyPreloadModules;
+
+    bool keepProcessWarm;
+    bool workerReady;
+    bool procWarmedUp;
+    iox::capro::IdString_t procClientId;
     QString scriptWDir;
     QString scriptContent;
     QHash<QString, QVariantHash> sentMetadata;
@@ -232,6 +245,9 @@ MLinkModule::MLinkModule(QObject *parent)
 {
     d->proc = new QProcess(this);
     d->portChangesAllowed = true;
+    d->keepProcessWarm = false;
+    d->workerReady = false;
+    d->procWarmedUp = false;
     resetConnection();
 
     // merge stdout/stderr of external process with ours by default
@@ -246,6 +262,7 @@ MLinkModule::MLinkModule(QObject *parent)
         static_cast<void (QProcess::*)(int, QProcess::ExitStatus)>(&QProcess::finished),
         this,
         [this](int exitCode, QProcess::ExitStatus exitStatus) {
+            d->workerReady = false;
             if (exitStatus == QProcess::CrashExit) {
                 raiseError(QStringLiteral("Module process crashed with exit code %1! Check the log for details.")
                                .arg(exitCode));
@@ -362,8 +379,7 @@ void MLinkModule::onPortChangedCb(iox::popo::UntypedSubscriber *subscriber, MLin
 
 void MLinkModule::resetConnection()
 {
-    d->clientId = iox::capro::IdString_t(
-        iox::cxx::TruncateToCapacity, QStringLiteral("%1_%2").arg(id()).arg(index()).toStdString());
+    d->clientId = makeClientId(id(), index());
 
     // detach all events from the listener
     if (d->subError != nullptr)
@@ -457,6 +473,15 @@ void MLinkModule::setPythonVirtualEnv(const QString &venvDir)
     d->pyVenvDir = venvDir;
 }
 
+/**
+ * Python modules which the worker imports right after it was launched by
+ * warmUpProcess(), so their import time is not spent when preparing a run.
+ */
+void MLinkModule::setPythonPreloadModules(const QStringList &modules)
+{
+    d->pyPreloadModules = modules;
+}
+
 void MLinkModule::setScript(const QString &script, const QString &wdir)
 {
     d->scriptWDir = wdir;
@@ -513,11 +538,23 @@ void MLinkModule::terminateProcess()
     }
 }
 
-bool MLinkModule::runProcess()
+bool MLinkModule::keepProcessWarm() const
 {
-    // ensure any existing process does not exist
-    terminateProcess();
+    return d->keepProcessWarm;
+}
 
+/**
+ * If enabled, the module process is kept alive between runs and is relaunched in
+ * the background once a run has ended, in case it quit. Workers are expected to
+ * reset their state when a new script is loaded.
+ */
+void MLinkModule::setKeepProcessWarm(bool warm)
+{
+    d->keepProcessWarm = warm;
+}
+
+bool MLinkModule::startProcess(bool warmUp)
+{
     d->subError->releaseQueuedData();
     d->subInPortChange->releaseQueuedData();
     d->subOutPortChange->releaseQueuedData();
@@ -539,11 +576,21 @@ bool MLinkModule::runProcess()
         penv.insert("PATH", QStringLiteral("%1/bin/:%2").arg(d->pyVenvDir, penv.value("PATH", "")));
     }
 
+    // only preload modules if nobody is waiting for the worker yet, as it won't respond while importing
+    penv.remove("SYNTALOS_PY_PRELOAD");
+    if (warmUp && !d->pyPreloadModules.isEmpty())
+        penv.insert("SYNTALOS_PY_PRELOAD", d->pyPreloadModules.join(','));
+
+    d->workerReady = false;
+    d->procWarmedUp = warmUp;
+    d->procClientId = d->clientId;
     d->proc->setProcessEnvironment(penv);
     d->proc->start(d->proc->program(), QStringList());
-    if (!d->proc->waitForStarted())
-        return false;
+    return d->proc->waitForStarted();
+}
 
+bool MLinkModule::waitForWorkerService()
+{
     // wait for the service to show up
     bool workerFound = false;
     iox::runtime::ServiceDiscovery sd;
@@ -563,7 +610,7 @@ bool MLinkModule::runProcess()
 
     QElapsedTimer timer;
     timer.start();
-    do {
+    while (!workerFound) {
         auto notificationVector = waitset.timedWait(iox::units::Duration::fromSeconds(5));
         for (auto &notification : notificationVector) {
             if (notification->doesOriginateFrom(&sd))
@@ -572,7 +619,7 @@ bool MLinkModule::runProcess()
 
         if (timer.elapsed() > 5000)
             break;
-    } while (!workerFound);
+    }
 
     if (!workerFound) {
         raiseError(
@@ -582,14 +629,48 @@ bool MLinkModule::runProcess()
         return false;
     }
 
+    d->workerReady = true;
     return true;
 }
 
+bool MLinkModule::runProcess()
+{
+    // ensure any existing process does not exist
+    terminateProcess();
+
+    if (!startProcess(false))
+        return false;
+
+    return waitForWorkerService();
+}
+
+/**
+ * Launch the module process ahead of time without waiting for it, so it can load
+ * everything it needs while the user is still setting up the experiment.
+ * Does nothing if a process for this module is already running.
+ */
+void MLinkModule::warmUpProcess()
+{
+    if (isProcessRunning() && d->procClientId == makeClientId(id(), index()))
+        return;
+
+    terminateProcess();
+    if (!startProcess(true))
+        qCWarning(logMLinkMod).noquote() << "Unable to launch worker process for" << name() << "ahead of time";
+}
+
 bool MLinkModule::isProcessRunning() const
 {
     return d->proc->state() == QProcess::Running;
 }
 
+qint64 MLinkModule::processId() const
+{
+    if (!isProcessRunning())
+        return 0;
+    return d->proc->processId();
+}
+
 QString MLinkModule::readProcessOutput()
 {
     if (!d->outputCaptured)
@@ -679,12 +760,20 @@ bool MLinkModule::prepare(const TestSubject &subject)
     GlobalConfig gconf;
     bool ret;
 
-    // at this point, ensure the module process is actually running
-    if (!isProcessRunning()) {
+    // at this point, ensure the module process is actually running and reachable,
+    // a worker that was launched before our ID changed is of no use to us
+    if (!isProcessRunning() || d->procClientId != makeClientId(id(), index())) {
         if (!runProcess())
             return false;
+    } else if (!d->workerReady) {
+        if (!waitForWorkerService())
+            return false;
     }
 
+    // a freshly warmed-up worker may still be busy importing modules, so give it more time
+    const int firstCallTimeoutSec = d->procWarmedUp ? 60 : 8;
+    d->procWarmedUp = false;
+
     auto callSetNiceness = makeClient<iox::popo::Client<SetNicenessRequest, DoneResponse>>(
         SET_NICENESS_CALL_ID.c_str());
     auto callSetMaxRealtimePriority = makeClient<iox::popo::Client<SetMaxRealtimePriority, DoneResponse>>(
@@ -695,9 +784,12 @@ bool MLinkModule::prepare(const TestSubject &subject)
     auto callPrepare = makeClient<iox::popo::Client<PrepareStartRequest, DoneResponse>>(PREPARE_START_CALL_ID.c_str());
 
     // set module process niceness
-    ret = callClientSimple(callSetNiceness, [&](auto &request) {
-        request->nice = gconf.defaultThreadNice();
-    });
+    ret = callClientSimple(
+        callSetNiceness,
+        [&](auto &request) {
+            request->nice = gconf.defaultThreadNice();
+        },
+        firstCallTimeoutSec);
     if (!ret)
         return false;
 
@@ -820,4 +912,12 @@ void MLinkModule::stop()
     d->sentMetadata.clear();
     d->portChangesAllowed = true;
     AbstractModule::stop();
+
+    // have a new worker ready for the next run, in case this one quit
+    if (d->keepProcessWarm) {
+        QTimer::singleShot(0, this, [this]() {
+            if (!isProcessRunning())
+                warmUpProcess();
+        });
+    }
 }
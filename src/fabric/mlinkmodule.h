@@ -72,16 +72,22 @@ public:
     void setOutputCaptured(bool capture);
 
     void setPythonVirtualEnv(const QString &venvDir);
+    void setPythonPreloadModules(const QStringList &modules);
     void setScript(const QString &script, const QString &wdir = QString());
     bool setScriptFromFile(const QString &fname, const QString &wdir = QString());
 
     QByteArray settingsData() const;
     void setSettingsData(const QByteArray &data);
 
+    bool keepProcessWarm() const;
+    void setKeepProcessWarm(bool warm);
+
     void terminateProcess();
     bool runProcess();
+    void warmUpProcess();
 
     bool isProcessRunning() const;
+    qint64 processId() const;
 
     QString readProcessOutput();
 
@@ -109,6 +115,8 @@ private:
     bool callClientSimple(const Client &client, Func func, int timeoutSec = 8);
 
     void resetConnection();
+    bool startProcess(bool warmUp);
+    bool waitForWorkerService();
     static void onErrorReceivedCb(
         iox::popo::Subscriber<ErrorEvent, iox::mepoo::NoUserHeader> *subscriber,
         MLinkModule *self);
@@ -27,12 +27,23 @@
 #include <QMessageBox>
 #include <QStandardPaths>
 #include <QCursor>
+#include <QThread>
+#include <array>
+#include <cmath>
+#include <mutex>
 
 #include "datactl/frametype.h"
 #include "utils/misc.h"
 
 using namespace Syntalos;
 
+// modules may be prepared concurrently, and create their storage groups and datasets
+// in the same storage tree at the same time
+static std::mutex g_storageTreeMutex;
+
+// number of buckets for the cycle times of periodic threads, the last one holds all cycles above ~70min
+static constexpr size_t PERIODIC_CYCLE_HIST_BUCKETS = 128;
+
 class ModuleInfo::Private
 {
 public:
@@ -483,6 +494,15 @@ public:
 
     bool initialized;
     bool runIsEmphemeral;
+    bool runIsWarm;
+    bool keepWarmAfterStop;
+
+    PeriodicThreadTiming periodicTiming;
+    symaster_timepoint cycleStartTime;
+    std::atomic<uint64_t> periodicCycles;
+    std::atomic<uint64_t> missedDeadlines;
+    std::atomic<int64_t> maxCycleTimeUsec;
+    std::array<std::atomic<uint64_t>, PERIODIC_CYCLE_HIST_BUCKETS> cycleTimeHist;
 };
 
 // instantiate static field
@@ -497,6 +517,9 @@ AbstractModule::AbstractModule(QObject *parent)
     d->name = QStringLiteral("Unknown Module");
     d->s_eventsMaxModulesPerThread = -1;
     d->runIsEmphemeral = false;
+    d->runIsWarm = false;
+    d->keepWarmAfterStop = false;
+    resetPeriodicThreadStats();
 }
 
 AbstractModule::AbstractModule(const QString &id, QObject *parent)
@@ -605,6 +628,11 @@ void AbstractModule::finalize()
     /* do nothing */
 }
 
+void AbstractModule::coolDown()
+{
+    /* do nothing */
+}
+
 void AbstractModule::showDisplayUi()
 {
     const bool onlyOne = d->displayWindows.size() == 1;
@@ -900,6 +928,7 @@ std::shared_ptr<EDLDataset> AbstractModule::createDatasetInGroup(
     const QVariantHash &subMetadata)
 {
     const auto datasetName = datasetNameFromParameters(preferredName, subMetadata);
+    std::lock_guard<std::mutex> lock(g_storageTreeMutex);
 
     // check if the dataset already exists
     auto dset = group->datasetByName(datasetName);
@@ -937,6 +966,7 @@ std::shared_ptr<EDLGroup> AbstractModule::createStorageGroup(const QString &grou
         return nullptr;
     }
 
+    std::lock_guard<std::mutex> lock(g_storageTreeMutex);
     return d->rootDataGroup->groupByName(groupName, true);
 }
 
@@ -995,6 +1025,17 @@ std::unique_ptr<SecondaryClockSynchronizer> AbstractModule::initClockSynchronize
     return synchronizer;
 }
 
+void AbstractModule::runInMainThread(const std::function<void()> &func)
+{
+    auto app = QCoreApplication::instance();
+    if (QThread::currentThread() == app->thread()) {
+        func();
+        return;
+    }
+
+    QMetaObject::invokeMethod(app, func, Qt::BlockingQueuedConnection);
+}
+
 uint AbstractModule::potentialNoaffinityCPUCount() const
 {
     return d->potentialNoaffinityCPUCount;
@@ -1005,11 +1046,91 @@ int AbstractModule::defaultRealtimePriority() const
     return d->defaultRealtimePriority;
 }
 
+void AbstractModule::setPeriodicTiming(const PeriodicThreadTiming &timing)
+{
+    d->periodicTiming = timing;
+}
+
+PeriodicThreadTiming AbstractModule::periodicTiming() const
+{
+    return d->periodicTiming;
+}
+
+/**
+ * Cycle times are counted in logarithmic buckets with four buckets per power of two,
+ * so percentiles are precise to about 20% no matter how long a cycle takes.
+ */
+static size_t cycleTimeHistBucket(int64_t usec)
+{
+    const auto bucket = static_cast<size_t>(4 * std::log2(static_cast<double>(std::max<int64_t>(usec, 0)) + 1));
+    return std::min(bucket, PERIODIC_CYCLE_HIST_BUCKETS - 1);
+}
+
+static int64_t cycleTimeHistBucketLimit(size_t bucket)
+{
+    return static_cast<int64_t>(std::ceil(std::exp2((bucket + 1) / 4.0) - 1));
+}
+
+void AbstractModule::beginPeriodicCycle()
+{
+    d->cycleStartTime = symaster_clock::now();
+}
+
+void AbstractModule::endPeriodicCycle()
+{
+    if (d->cycleStartTime == symaster_timepoint())
+        return;
+
+    const auto cycleTime = timeDiffUsec(symaster_clock::now(), d->cycleStartTime);
+    d->cycleStartTime = symaster_timepoint();
+
+    d->periodicCycles.fetch_add(1, std::memory_order_relaxed);
+    if (d->periodicTiming.isValid() && cycleTime > d->periodicTiming.effectiveDeadline())
+        d->missedDeadlines.fetch_add(1, std::memory_order_relaxed);
+    if (cycleTime.count() > d->maxCycleTimeUsec.load(std::memory_order_relaxed))
+        d->maxCycleTimeUsec.store(cycleTime.count(), std::memory_order_relaxed);
+    d->cycleTimeHist[cycleTimeHistBucket(cycleTime.count())].fetch_add(1, std::memory_order_relaxed);
+}
+
+PeriodicThreadStats AbstractModule::periodicThreadStats() const
+{
+    PeriodicThreadStats stats;
+    stats.cycles = d->periodicCycles.load(std::memory_order_relaxed);
+    stats.missedDeadlines = d->missedDeadlines.load(std::memory_order_relaxed);
+    stats.maxCycleTime = microseconds_t(d->maxCycleTimeUsec.load(std::memory_order_relaxed));
+
+    // find the bucket the 99th percentile falls into, no bucket limit is larger than the longest cycle
+    uint64_t histCount = 0;
+    for (const auto &bucket : d->cycleTimeHist)
+        histCount += bucket.load(std::memory_order_relaxed);
+    const auto rank = static_cast<uint64_t>(std::ceil(histCount * 0.99));
+    uint64_t seen = 0;
+    for (size_t i = 0; i < d->cycleTimeHist.size() && histCount > 0; i++) {
+        seen += d->cycleTimeHist[i].load(std::memory_order_relaxed);
+        if (seen >= rank) {
+            stats.p99CycleTime = std::min(microseconds_t(cycleTimeHistBucketLimit(i)), stats.maxCycleTime);
+            break;
+        }
+    }
+
+    return stats;
+}
+
 bool AbstractModule::isEphemeralRun() const
 {
     return d->runIsEmphemeral;
 }
 
+bool AbstractModule::isWarmRun() const
+{
+    return d->runIsWarm;
+}
+
+bool AbstractModule::keepWarmAfterStop() const
+{
+    return d->keepWarmAfterStop;
+}
+
 void AbstractModule::usbHotplugEvent(UsbHotplugEventKind kind)
 {
     /* do nothing */
@@ -1137,6 +1258,26 @@ void AbstractModule::setEphemeralRun(bool isEphemeral)
     d->runIsEmphemeral = isEphemeral;
 }
 
+void AbstractModule::setWarmRun(bool isWarm)
+{
+    d->runIsWarm = isWarm;
+}
+
+void AbstractModule::resetPeriodicThreadStats()
+{
+    d->cycleStartTime = symaster_timepoint();
+    d->periodicCycles = 0;
+    d->missedDeadlines = 0;
+    d->maxCycleTimeUsec = 0;
+    for (auto &bucket : d->cycleTimeHist)
+        bucket = 0;
+}
+
+void AbstractModule::setKeepWarmAfterStop(bool keepWarm)
+{
+    d->keepWarmAfterStop = keepWarm;
+}
+
 void AbstractModule::setStatusMessage(const QString &message)
 {
     emit statusMessage(message);
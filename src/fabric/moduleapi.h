@@ -30,6 +30,7 @@
 #include "modconfig.h"
 #include "optionalwaitcondition.h"
 #include "streams/stream.h"
+#include "threadsched.h"
 #include "datactl/datatypes.h"
 #include "datactl/edlstorage.h"
 #include "datactl/syclock.h"
@@ -57,6 +58,9 @@ enum class ModuleFeature {
     PROHIBIT_CPU_AFFINITY =
         1 << 5,              /// Never set a core affinity for the thread of this module, even if the user wanted it
     CALL_UI_EVENTS = 1 << 6, /// Call direct UI events processing method
+    PREPARE_CONCURRENT =
+        1 << 7, /// prepare() is thread-safe and may run on a worker thread, in parallel to other modules
+    KEEP_WARM = 1 << 8, /// Module can keep devices and other expensive resources alive between consecutive runs
 };
 Q_DECLARE_FLAGS(ModuleFeatures, ModuleFeature)
 Q_DECLARE_OPERATORS_FOR_FLAGS(ModuleFeatures)
@@ -576,7 +580,10 @@ public:
      * @brief Prepare for an experiment run
      *
      * Prepare this module to run. This method is called once
-     * prior to every experiment run.
+     * prior to every experiment run, after all modules this module
+     * receives data from have been prepared.
+     * Modules with the PREPARE_CONCURRENT feature are prepared on a worker thread
+     * and must not touch any widgets directly from this method.
      * @return true if success
      */
     virtual bool prepare(const TestSubject &testSubject) = 0;
@@ -626,6 +633,15 @@ public:
      */
     virtual void finalize();
 
+    /**
+     * @brief Release resources that were kept alive for a following run.
+     *
+     * Called for modules with the KEEP_WARM feature that kept their resources
+     * alive in stop() (see keepWarmAfterStop()), once the engine knows that no
+     * warm run will follow, e.g. because an interval run has ended or was aborted.
+     */
+    virtual void coolDown();
+
     /**
      * @brief Show the display widgets of this module
      */
@@ -957,6 +973,14 @@ protected:
      */
     std::unique_ptr<SecondaryClockSynchronizer> initClockSynchronizer(double expectedFrequencyHz = 0);
 
+    /**
+     * @brief Run a function in the main (GUI) thread and wait for it to complete
+     *
+     * Modules which are prepared concurrently can use this to access their widgets
+     * from prepare(). If we already are in the main thread, the function is just called.
+     */
+    void runInMainThread(const std::function<void()> &func);
+
     /**
      * @brief Potential amount of CPUs not used by other syntalos tasks.
      *
@@ -980,6 +1004,30 @@ protected:
      */
     int defaultRealtimePriority() const;
 
+    /**
+     * @brief Declare the timing of this module's periodic work
+     *
+     * Modules with a dedicated thread that acquires or processes data at a fixed rate can
+     * declare how often new work arrives, how much CPU time it needs at most and by when
+     * it has to be done, usually in prepare(). The engine then runs the thread with
+     * SCHED_DEADLINE if it is permitted to (and with realtime priority otherwise), and
+     * checks that there is enough CPU time for all periodic threads before a run starts.
+     * Set a default-constructed timing to remove the declaration again.
+     */
+    void setPeriodicTiming(const PeriodicThreadTiming &timing);
+    PeriodicThreadTiming periodicTiming() const;
+
+    /**
+     * @brief Mark the start and the end of the work of one period
+     *
+     * Call beginPeriodicCycle() from the module's thread when new work has arrived (e.g. when
+     * a blocking device read returned), and endPeriodicCycle() once it is done. Cycles which
+     * took longer than the declared deadline are counted as missed deadlines.
+     */
+    void beginPeriodicCycle();
+    void endPeriodicCycle();
+    PeriodicThreadStats periodicThreadStats() const;
+
     /**
      * @brief Returns true if the currently ongoing or last run is/was ephemeral
      *
@@ -991,6 +1039,25 @@ protected:
      */
     bool isEphemeralRun() const;
 
+    /**
+     * @brief Returns true if the module kept its resources alive since the previous run
+     *
+     * Only ever true for modules with the KEEP_WARM feature, in case the previous run
+     * was stopped with keepWarmAfterStop() set. The module may then reuse devices,
+     * threads or encoder contexts in prepare() instead of setting them up again, but
+     * it still needs to start new output streams and use the new run's timer.
+     */
+    bool isWarmRun() const;
+
+    /**
+     * @brief Returns true if the module should keep its resources alive when stopping
+     *
+     * Valid in stop(). If set, another run will follow shortly and the module should only
+     * finish its current output data, but keep devices connected for a warm start.
+     * The engine will call coolDown() if that run does not happen after all.
+     */
+    bool keepWarmAfterStop() const;
+
     /**
      * @brief Handle USB hotplug events
      *
@@ -1030,6 +1097,9 @@ private:
     void setPotentialNoaffinityCPUCount(uint coreN);
     void setDefaultRTPriority(int prio);
     void setEphemeralRun(bool isEphemeral);
+    void setWarmRun(bool isWarm);
+    void resetPeriodicThreadStats();
+    void setKeepWarmAfterStop(bool keepWarm);
 };
 
 } // namespace Syntalos
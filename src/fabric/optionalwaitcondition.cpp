@@ -19,12 +19,19 @@
 
 #include <QMutex>
 #include <QWaitCondition>
+#include <cerrno>
+#include <time.h>
 
 #include "moduleapi.h"
 #include "optionalwaitcondition.h"
+#include "streams/spinwait.h"
 
 using namespace Syntalos;
 
+// time before the start timepoint at which we stop sleeping and busy-wait instead,
+// to not depend on the timer slack and wakeup latency of the kernel
+static constexpr nanoseconds_t START_SPIN_TIME = std::chrono::microseconds(200);
+
 class OptionalWaitCondition::OWCData
 {
 public:
@@ -35,6 +42,9 @@ public:
     QMutex mutex;
     QWaitCondition condition;
 
+    symaster_timepoint startTime;
+    QHash<AbstractModule *, nanoseconds_t> startSkews;
+
 private:
     Q_DISABLE_COPY(OWCData)
 };
@@ -43,22 +53,76 @@ OptionalWaitCondition::OptionalWaitCondition()
     : d(new OptionalWaitCondition::OWCData())
 {
     d->ready = false;
+    d->count = 0;
 }
 
-void OptionalWaitCondition::wait()
+/**
+ * Sleep until shortly before @p startTime, then spin until it is reached.
+ */
+static void sleepUntilStart(const symaster_timepoint &startTime)
+{
+    // the master clock may run on CLOCK_MONOTONIC_RAW, which can not be used with
+    // clock_nanosleep, so we translate our deadline into a relative one first
+    const auto sleepTime = (startTime - START_SPIN_TIME) - symaster_clock::now();
+    if (sleepTime.count() > 0) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        const auto wakeNs = static_cast<int64_t>(ts.tv_sec) * 1000000000 + ts.tv_nsec + sleepTime.count();
+        ts.tv_sec = static_cast<time_t>(wakeNs / 1000000000);
+        ts.tv_nsec = static_cast<long>(wakeNs % 1000000000);
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {
+        }
+    }
+
+    while (symaster_clock::now() < startTime)
+        spinPause();
+}
+
+nanoseconds_t OptionalWaitCondition::waitForStart()
 {
-    if (d->ready)
-        return;
     d->mutex.lock();
-    d->count++;
-    d->condition.wait(&d->mutex);
+    if (!d->ready) {
+        d->count++;
+        while (!d->ready)
+            d->condition.wait(&d->mutex);
+    }
+    const auto startTime = d->startTime;
     d->mutex.unlock();
+
+    // we were released immediately, there is nothing to synchronize to
+    if (startTime == symaster_timepoint())
+        return nanoseconds_t(0);
+
+    sleepUntilStart(startTime);
+    return symaster_clock::now() - startTime;
+}
+
+void OptionalWaitCondition::wait()
+{
+    if (d->ready && d->startTime == symaster_timepoint())
+        return;
+    waitForStart();
 }
 
 void OptionalWaitCondition::wait(AbstractModule *mod)
 {
     mod->setStateReady();
-    wait();
+    wait(QList<AbstractModule *>() << mod);
+}
+
+/**
+ * Wait on behalf of all @p mods sharing the calling thread, and record their start skew.
+ * Unlike wait(AbstractModule*), this does not change the state of the modules.
+ */
+void OptionalWaitCondition::wait(const QList<AbstractModule *> &mods)
+{
+    const auto skew = waitForStart();
+
+    QMutexLocker locker(&d->mutex);
+    if (d->startTime == symaster_timepoint())
+        return;
+    for (const auto mod : mods)
+        d->startSkews.insert(mod, skew);
 }
 
 uint OptionalWaitCondition::waitingCount() const
@@ -66,14 +130,44 @@ uint OptionalWaitCondition::waitingCount() const
     return d->count;
 }
 
+symaster_timepoint OptionalWaitCondition::startTime() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->startTime;
+}
+
+QHash<AbstractModule *, nanoseconds_t> OptionalWaitCondition::startSkews() const
+{
+    QMutexLocker locker(&d->mutex);
+    return d->startSkews;
+}
+
 void OptionalWaitCondition::wakeAll()
 {
+    QMutexLocker locker(&d->mutex);
+    d->ready = true;
     d->condition.wakeAll();
+}
+
+/**
+ * Release all waiting threads (and any thread which waits later) at @p startTime.
+ * The start time should be far enough in the future for all threads to be
+ * scheduled again before it is reached.
+ */
+void OptionalWaitCondition::wakeAllAt(const symaster_timepoint &startTime)
+{
+    QMutexLocker locker(&d->mutex);
+    if (!d->ready)
+        d->startTime = startTime;
     d->ready = true;
+    d->condition.wakeAll();
 }
 
 void OptionalWaitCondition::reset()
 {
+    QMutexLocker locker(&d->mutex);
     d->ready = false;
     d->count = 0;
+    d->startTime = symaster_timepoint();
+    d->startSkews.clear();
 }
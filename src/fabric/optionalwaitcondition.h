@@ -19,8 +19,12 @@
 
 #pragma once
 
+#include <QHash>
+#include <QList>
 #include <QSharedPointer>
 
+#include "datactl/syclock.h"
+
 namespace Syntalos
 {
 
@@ -33,6 +37,11 @@ class AbstractModule;
  *
  * Create a thread barrier to synchronize a
  * set of threads to run at once.
+ *
+ * If the threads are released with a start timepoint, every waiting thread
+ * sleeps until shortly before it and busy-waits for the remaining time, so all
+ * threads resume within microseconds of each other instead of whenever the
+ * scheduler gets to them.
  */
 class OptionalWaitCondition
 {
@@ -43,16 +52,32 @@ public:
 
     void wait();
     void wait(AbstractModule *mod);
+    void wait(const QList<AbstractModule *> &mods);
 
     uint waitingCount() const;
 
+    /**
+     * Time all waiting threads were released at, or a zero timepoint if they
+     * were released immediately.
+     */
+    symaster_timepoint startTime() const;
+
+    /**
+     * Delay between the start timepoint and the time each module's thread actually resumed.
+     * Only modules that waited via wait(AbstractModule*) or wait(QList) are recorded.
+     */
+    QHash<AbstractModule *, nanoseconds_t> startSkews() const;
+
 private:
     class OWCData;
     QSharedPointer<OWCData> d;
     Q_DISABLE_COPY(OptionalWaitCondition)
 
     void wakeAll();
+    void wakeAllAt(const symaster_timepoint &startTime);
     void reset();
+
+    nanoseconds_t waitForStart();
 };
 
 } // namespace Syntalos
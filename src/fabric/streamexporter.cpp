@@ -27,6 +27,7 @@
 #include "streams/stream.h"
 #include "utils/misc.h"
 #include "mlinkmodule.h"
+#include "mlink/ipc-types-private.h"
 
 using namespace Syntalos;
 
@@ -110,8 +111,8 @@ static std::unique_ptr<iox::popo::UntypedPublisher> makeIoxPublisher(
 {
     iox::popo::PublisherOptions publisherOptn;
 
-    // store the last 2 samples in queue
-    publisherOptn.historyCapacity = 2U;
+    // store the last few samples in queue
+    publisherOptn.historyCapacity = SY_IOX_EXPORT_HISTORY_SIZE;
 
     if (waitForConsumer) {
         // allow the subscriber to block us, to ensure we don't lose data
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "spinwait.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+using namespace Syntalos;
+
+// shortest time we busy-poll for, also used while we have no arrival estimate yet
+static constexpr int64_t MIN_SPIN_WINDOW_NS = 5000;
+
+// time we yield the CPU for after busy-polling, before finally blocking
+static constexpr int64_t YIELD_WINDOW_NS = 50000;
+
+// latency histogram: 100ns buckets up to 100µs, 10µs buckets up to 10ms, and one overflow bucket
+static constexpr int64_t HIST_FINE_STEP_NS = 100;
+static constexpr int64_t HIST_FINE_BUCKETS = 1000;
+static constexpr int64_t HIST_COARSE_STEP_NS = 10000;
+static constexpr int64_t HIST_COARSE_BUCKETS = 990;
+static constexpr int64_t HIST_SIZE = HIST_FINE_BUCKETS + HIST_COARSE_BUCKETS + 1;
+
+static int64_t histogramBucket(int64_t latencyNs)
+{
+    if (latencyNs < HIST_FINE_BUCKETS * HIST_FINE_STEP_NS)
+        return latencyNs / HIST_FINE_STEP_NS;
+    const auto coarse = (latencyNs - HIST_FINE_BUCKETS * HIST_FINE_STEP_NS) / HIST_COARSE_STEP_NS;
+    return std::min(HIST_FINE_BUCKETS + coarse, HIST_SIZE - 1);
+}
+
+static double histogramBucketUpperUsec(int64_t bucket)
+{
+    if (bucket < HIST_FINE_BUCKETS)
+        return ((bucket + 1) * HIST_FINE_STEP_NS) / 1000.0;
+    return (HIST_FINE_BUCKETS * HIST_FINE_STEP_NS + (bucket - HIST_FINE_BUCKETS + 1) * HIST_COARSE_STEP_NS) / 1000.0;
+}
+
+AdaptiveSpinWaiter::AdaptiveSpinWaiter(nanoseconds_t maxSpinWindow)
+    : m_maxSpinWindow(std::max(maxSpinWindow, nanoseconds_t(MIN_SPIN_WINDOW_NS))),
+      m_histogram(new std::atomic_uint32_t[HIST_SIZE])
+{
+    reset();
+}
+
+AdaptiveSpinWaiter::~AdaptiveSpinWaiter() {}
+
+nanoseconds_t AdaptiveSpinWaiter::spinWindow() const
+{
+    // like a TCP retransmission timer, cover a few mean deviations around the expected arrival
+    const auto window = 4 * m_jitterNs.load(std::memory_order_relaxed) + MIN_SPIN_WINDOW_NS;
+    return std::min(nanoseconds_t(window), m_maxSpinWindow);
+}
+
+AdaptiveSpinWaiter::WaitPlan AdaptiveSpinWaiter::planWait(symaster_timepoint now) const
+{
+    WaitPlan plan;
+    plan.blockTime = nanoseconds_t(0);
+    plan.yieldTime = nanoseconds_t(YIELD_WINDOW_NS);
+
+    // without an estimate of the arrival rate, only spin briefly in case data follows in quick succession
+    const auto intervalNs = m_intervalNs.load(std::memory_order_relaxed);
+    if (intervalNs <= 0) {
+        plan.spinDeadline = now + nanoseconds_t(MIN_SPIN_WINDOW_NS);
+        return plan;
+    }
+
+    // sleep until shortly before the next element is due, then poll until a bit after it
+    const auto window = spinWindow();
+    const auto expected = m_lastPushTime + nanoseconds_t(intervalNs);
+    if (now < expected - window)
+        plan.blockTime = (expected - window) - now;
+    plan.spinDeadline = std::max(expected + window, now + nanoseconds_t(MIN_SPIN_WINDOW_NS));
+
+    return plan;
+}
+
+void AdaptiveSpinWaiter::recordArrival(symaster_timepoint pushTime, uint64_t pushCount)
+{
+    // pushes we did not wait for still tell us about the arrival rate
+    if (m_lastPushCount > 0 && pushCount > m_lastPushCount && pushTime > m_lastPushTime) {
+        const auto pushes = static_cast<int64_t>(pushCount - m_lastPushCount);
+        const int64_t interval = (pushTime - m_lastPushTime).count() / pushes;
+        auto intervalNs = m_intervalNs.load(std::memory_order_relaxed);
+        auto jitterNs = m_jitterNs.load(std::memory_order_relaxed);
+        if (intervalNs <= 0) {
+            intervalNs = interval;
+            jitterNs = interval / 2;
+        } else {
+            const auto err = interval - intervalNs;
+            intervalNs += err / 8;
+            jitterNs += (std::abs(err) - jitterNs) / 4;
+        }
+        m_intervalNs.store(intervalNs, std::memory_order_relaxed);
+        m_jitterNs.store(jitterNs, std::memory_order_relaxed);
+    }
+
+    m_lastPushTime = pushTime;
+    m_lastPushCount = pushCount;
+}
+
+void AdaptiveSpinWaiter::recordWakeup(
+    Phase phase,
+    symaster_timepoint pushTime,
+    uint64_t pushCount,
+    symaster_timepoint wakeTime)
+{
+    recordArrival(pushTime, pushCount);
+
+    // if another element was pushed in the meantime, the time may be slightly later than
+    // the one of the element that woke us
+    const auto latencyNs = std::max<int64_t>((wakeTime - pushTime).count(), 0);
+
+    auto &bucket = m_histogram[histogramBucket(latencyNs)];
+    bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (static_cast<uint64_t>(latencyNs) > m_maxLatencyNs.load(std::memory_order_relaxed))
+        m_maxLatencyNs.store(latencyNs, std::memory_order_relaxed);
+
+    auto &phaseCount = m_phaseCounts[static_cast<int>(phase)];
+    phaseCount.store(phaseCount.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+WaitLatencyStats AdaptiveSpinWaiter::stats() const
+{
+    WaitLatencyStats stats;
+    stats.spinWakeups = m_phaseCounts[static_cast<int>(Phase::SPIN)].load(std::memory_order_relaxed);
+    stats.yieldWakeups = m_phaseCounts[static_cast<int>(Phase::YIELD)].load(std::memory_order_relaxed);
+    stats.blockWakeups = m_phaseCounts[static_cast<int>(Phase::BLOCK)].load(std::memory_order_relaxed);
+    stats.maxUsec = m_maxLatencyNs.load(std::memory_order_relaxed) / 1000.0;
+    stats.intervalUsec = m_intervalNs.load(std::memory_order_relaxed) / 1000.0;
+    stats.spinWindowUsec = spinWindow().count() / 1000.0;
+
+    std::vector<uint32_t> hist(HIST_SIZE);
+    for (int64_t i = 0; i < HIST_SIZE; i++) {
+        hist[i] = m_histogram[i].load(std::memory_order_relaxed);
+        stats.count += hist[i];
+    }
+    if (stats.count == 0)
+        return stats;
+
+    const auto percentile = [&](double p) {
+        const auto rank = static_cast<uint64_t>(std::ceil(p * stats.count));
+        uint64_t seen = 0;
+        for (int64_t i = 0; i < HIST_SIZE; i++) {
+            seen += hist[i];
+            if (seen >= rank)
+                return std::min(histogramBucketUpperUsec(i), stats.maxUsec);
+        }
+        return stats.maxUsec;
+    };
+    stats.p50Usec = percentile(0.50);
+    stats.p99Usec = percentile(0.99);
+    stats.p999Usec = percentile(0.999);
+
+    return stats;
+}
+
+void AdaptiveSpinWaiter::reset()
+{
+    m_intervalNs = 0;
+    m_jitterNs = 0;
+    m_lastPushTime = symaster_timepoint();
+    m_lastPushCount = 0;
+    m_maxLatencyNs = 0;
+    for (auto &count : m_phaseCounts)
+        count = 0;
+    for (int64_t i = 0; i < HIST_SIZE; i++)
+        m_histogram[i] = 0;
+}
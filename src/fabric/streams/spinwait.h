@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This software is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this software.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <thread>
+
+#include "datactl/syclock.h"
+
+namespace Syntalos
+{
+
+/**
+ * @brief How a stream subscription waits for new data
+ */
+enum class SubscriptionWaitStrategy {
+    BLOCK,           /// Sleep until new data arrives (default, cheapest on CPU)
+    SPIN_THEN_BLOCK, /// Busy-poll around the expected arrival time, then yield, then sleep
+};
+
+/**
+ * @brief Latency between elements being pushed and a waiting subscriber receiving them
+ */
+struct WaitLatencyStats {
+    uint64_t count{0};
+    double p50Usec{0};
+    double p99Usec{0};
+    double p999Usec{0};
+    double maxUsec{0};
+
+    uint64_t spinWakeups{0};  /// Elements received while busy-polling
+    uint64_t yieldWakeups{0}; /// Elements received while yielding the CPU
+    uint64_t blockWakeups{0}; /// Elements received after sleeping in the kernel
+
+    double intervalUsec{0};   /// Estimated interval between elements
+    double spinWindowUsec{0}; /// Current time spent busy-polling around the expected arrival
+};
+
+/**
+ * Hint to the CPU that we are in a busy-wait loop.
+ */
+inline void spinPause() noexcept
+{
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+/**
+ * @brief Wait for data with busy-polling timed to the expected arrival of new elements
+ *
+ * Sleeping in the kernel and being woken up again costs tens of microseconds, which
+ * dominates the latency of closed-loop setups. This waiter estimates the interval and
+ * jitter of incoming elements and only sleeps until shortly before the next element
+ * is due, then busy-polls for a window scaled by the observed jitter, yields for a
+ * little while and only then falls back to blocking indefinitely.
+ *
+ * All functions except for stats() must be called from the consuming thread,
+ * stats() may be called from any thread at any time.
+ */
+class AdaptiveSpinWaiter
+{
+public:
+    enum class Phase {
+        SPIN,
+        YIELD,
+        BLOCK
+    };
+
+    explicit AdaptiveSpinWaiter(nanoseconds_t maxSpinWindow = std::chrono::microseconds(250));
+    ~AdaptiveSpinWaiter();
+
+    /**
+     * Wait until @p isReady returns true.
+     *
+     * @param isReady Check whether new data is available, must be cheap.
+     * @param blockFor Sleep until new data is available, or at most for the given
+     *        time (indefinitely if it is negative). Returns true if data is available.
+     * @return The phase in which new data was found.
+     */
+    template<typename ReadyFn, typename BlockFn>
+    Phase wait(ReadyFn isReady, BlockFn blockFor)
+    {
+        const auto plan = planWait(symaster_clock::now());
+        if (plan.blockTime.count() > 0 && blockFor(plan.blockTime))
+            return Phase::BLOCK;
+
+        while (symaster_clock::now() < plan.spinDeadline) {
+            for (int i = 0; i < 64; i++) {
+                if (isReady())
+                    return Phase::SPIN;
+                spinPause();
+            }
+        }
+
+        const auto yieldDeadline = symaster_clock::now() + plan.yieldTime;
+        while (symaster_clock::now() < yieldDeadline) {
+            if (isReady())
+                return Phase::YIELD;
+            std::this_thread::yield();
+        }
+
+        blockFor(nanoseconds_t(-1));
+        return Phase::BLOCK;
+    }
+
+    /**
+     * Record that a new element was taken without waiting for it.
+     * @param pushTime Time of the most recent push to the stream.
+     * @param pushCount Total number of elements pushed so far.
+     */
+    void recordArrival(symaster_timepoint pushTime, uint64_t pushCount);
+
+    /**
+     * Record that the consumer woke up for new data after waiting for it.
+     */
+    void recordWakeup(Phase phase, symaster_timepoint pushTime, uint64_t pushCount, symaster_timepoint wakeTime);
+
+    WaitLatencyStats stats() const;
+    void reset();
+
+private:
+    struct WaitPlan {
+        nanoseconds_t blockTime;
+        symaster_timepoint spinDeadline;
+        nanoseconds_t yieldTime;
+    };
+
+    WaitPlan planWait(symaster_timepoint now) const;
+    nanoseconds_t spinWindow() const;
+
+    nanoseconds_t m_maxSpinWindow;
+    std::atomic_int64_t m_intervalNs;
+    std::atomic_int64_t m_jitterNs;
+    symaster_timepoint m_lastPushTime;
+    uint64_t m_lastPushCount;
+
+    std::atomic_uint64_t m_maxLatencyNs;
+    std::atomic_uint64_t m_phaseCounts[3];
+    std::unique_ptr<std::atomic_uint32_t[]> m_histogram;
+};
+
+} // namespace Syntalos
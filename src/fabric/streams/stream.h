@@ -33,6 +33,7 @@
 
 #include "datactl/datatypes.h"
 #include "readerwriterqueue.h"
+#include "spinwait.h"
 #include "datactl/syclock.h"
 
 using namespace moodycamel;
@@ -79,9 +80,19 @@ public:
     virtual bool active() const = 0;
     virtual bool hasPending() const = 0;
     virtual size_t approxPendingCount() const = 0;
+    virtual int64_t approxPendingBytes() const = 0;
+    virtual int64_t peakPendingBytes() const = 0;
+    virtual uint64_t deliveredCount() const = 0;
+    virtual uint64_t droppedCount() const = 0;
     virtual int enableNotify() = 0;
     virtual void disableNotify() = 0;
     virtual void setThrottleItemsPerSec(uint itemsPerSec, bool allowMore = true) = 0;
+    virtual void restrictItemsPerSec(uint itemsPerSec) = 0;
+    virtual void clearItemsPerSecRestriction() = 0;
+    virtual void setWaitStrategy(SubscriptionWaitStrategy strategy) = 0;
+    virtual SubscriptionWaitStrategy waitStrategy() const = 0;
+    virtual WaitLatencyStats waitLatencyStats() const = 0;
+    virtual symaster_timepoint lastPushTime(uint64_t *pushCount = nullptr) const = 0;
 
     virtual void suspend() = 0;
     virtual void resume() = 0;
@@ -130,7 +141,15 @@ public:
           m_active(true),
           m_suspended(false),
           m_throttle(0),
-          m_skippedElements(0)
+          m_restriction(0),
+          m_skippedElements(0),
+          m_deliveredCount(0),
+          m_droppedCount(0),
+          m_pendingBytes(0),
+          m_peakPendingBytes(0),
+          m_spinWait(false),
+          m_pushSeq(0),
+          m_lastPushNs(0)
     {
         m_lastItemTime = currentTimePoint();
         m_eventfd = eventfd(0, EFD_NONBLOCK);
@@ -156,8 +175,12 @@ public:
     {
         if (!m_active && m_queue.peek() == nullptr)
             return std::nullopt;
+        if (m_spinWait)
+            return nextAdaptive();
+
         std::optional<T> data;
         m_queue.wait_dequeue(data);
+        takePending(data);
         return data;
     }
 
@@ -174,6 +197,7 @@ public:
 
         if (!m_queue.try_dequeue(data))
             return std::nullopt;
+        takePending(data);
 
         return data;
     }
@@ -266,8 +290,7 @@ public:
         m_suspended = true;
 
         // drop currently pending data
-        while (m_queue.pop()) {
-        }
+        dropPending();
     }
 
     /**
@@ -284,8 +307,7 @@ public:
     void clearPending() override
     {
         m_suspended = true;
-        while (m_queue.pop()) {
-        }
+        dropPending();
         m_suspended = false;
     }
 
@@ -299,9 +321,44 @@ public:
         return m_queue.size_approx() > 0;
     }
 
+    /**
+     * @brief Approximate amount of memory held by the elements waiting in this subscription's queue
+     * Elements shared with other subscriptions (e.g. frames) are accounted for in every queue
+     * that keeps them alive. Elements which can not tell their size count with their type's size.
+     */
+    int64_t approxPendingBytes() const override
+    {
+        return std::max<int64_t>(m_pendingBytes.load(std::memory_order_relaxed), 0);
+    }
+
+    /**
+     * @brief Highest amount of memory held by this subscription's queue since the stream was started
+     */
+    int64_t peakPendingBytes() const override
+    {
+        return m_peakPendingBytes.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Number of elements the stream has enqueued for this subscription since it was started
+     */
+    uint64_t deliveredCount() const override
+    {
+        return m_deliveredCount.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Number of elements which were not enqueued for this subscription since the stream was started
+     * These are the elements skipped because of a throttle or because the subscription was suspended.
+     */
+    uint64_t droppedCount() const override
+    {
+        return m_droppedCount.load(std::memory_order_relaxed);
+    }
+
     uint throttleValue() const
     {
-        return m_throttle;
+        return std::max(m_throttle.load(), m_restriction.load());
     }
 
     uint retrieveApproxSkippedElements()
@@ -343,6 +400,83 @@ public:
         m_skippedElements = 0;
     }
 
+    /**
+     * @brief Limit the output frequency of this subscription to at most the given value
+     * Unlike setThrottleItemsPerSec(), this never makes an existing throttle less strict and
+     * keeps elements that are already queued, so it is safe to call from any thread, e.g. by
+     * the engine to keep a subscriber which falls behind from using up all memory.
+     * The restriction is kept separate from the throttle the subscriber selected, and can be
+     * removed again with clearItemsPerSecRestriction().
+     */
+    void restrictItemsPerSec(uint itemsPerSec) override
+    {
+        const uint newRestriction = std::ceil((1000.0 / std::max(itemsPerSec, 1U)) * 1000);
+        uint restriction = m_restriction;
+        while (restriction < newRestriction && !m_restriction.compare_exchange_weak(restriction, newRestriction)) {
+        }
+    }
+
+    /**
+     * @brief Remove a limit set by restrictItemsPerSec()
+     * The throttle selected by the subscriber itself stays in effect.
+     */
+    void clearItemsPerSecRestriction() override
+    {
+        m_restriction = 0;
+    }
+
+    /**
+     * @brief Select how next() waits for new elements
+     *
+     * With SubscriptionWaitStrategy::SPIN_THEN_BLOCK, next() learns the interval at which
+     * elements arrive and busy-polls around their expected arrival instead of sleeping,
+     * which avoids the kernel wakeup latency at the expense of CPU time.
+     * This must be set before the stream is started, e.g. in a module's prepare() step.
+     */
+    void setWaitStrategy(SubscriptionWaitStrategy strategy) override
+    {
+        if (strategy == SubscriptionWaitStrategy::SPIN_THEN_BLOCK && !m_spinWaiter)
+            m_spinWaiter = std::make_unique<AdaptiveSpinWaiter>();
+        m_spinWait = strategy == SubscriptionWaitStrategy::SPIN_THEN_BLOCK;
+    }
+
+    SubscriptionWaitStrategy waitStrategy() const override
+    {
+        return m_spinWait ? SubscriptionWaitStrategy::SPIN_THEN_BLOCK : SubscriptionWaitStrategy::BLOCK;
+    }
+
+    /**
+     * @brief Latency next() achieved between an element being pushed and it being received
+     * Only elements next() actually had to wait for are accounted, and only if the
+     * subscription uses the SPIN_THEN_BLOCK wait strategy.
+     */
+    WaitLatencyStats waitLatencyStats() const override
+    {
+        if (!m_spinWaiter)
+            return WaitLatencyStats();
+        return m_spinWaiter->stats();
+    }
+
+    /**
+     * @brief Time of the most recent push to this subscription
+     * This is only tracked if the subscription uses the SPIN_THEN_BLOCK wait strategy.
+     * @param pushCount Set to the number of elements pushed since the stream was started.
+     */
+    symaster_timepoint lastPushTime(uint64_t *pushCount = nullptr) const override
+    {
+        uint64_t seq;
+        int64_t timeNs;
+        do {
+            seq = m_pushSeq.load(std::memory_order_acquire);
+            timeNs = m_lastPushNs.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+        } while ((seq & 1) != 0 || seq != m_pushSeq.load(std::memory_order_relaxed));
+
+        if (pushCount != nullptr)
+            *pushCount = seq / 2;
+        return symaster_timepoint(nanoseconds_t(timeNs));
+    }
+
     void forcePushNullopt() override
     {
         std::optional<T> v;
@@ -357,7 +491,20 @@ private:
     std::atomic_bool m_active;
     std::atomic_bool m_suspended;
     std::atomic_uint m_throttle;
+    std::atomic_uint m_restriction;
     std::atomic_uint m_skippedElements;
+    std::atomic_uint64_t m_deliveredCount;
+    std::atomic_uint64_t m_droppedCount;
+    std::atomic_int64_t m_pendingBytes;
+    std::atomic_int64_t m_peakPendingBytes;
+
+    std::unique_ptr<AdaptiveSpinWaiter> m_spinWaiter;
+    std::atomic_bool m_spinWait;
+
+    // push time of the latest element, guarded by a sequence counter so readers get
+    // a consistent pair of time and number of pushes
+    std::atomic_uint64_t m_pushSeq;
+    std::atomic_int64_t m_lastPushNs;
 
     // NOTE: These two variables are intentionally *not* threadsafe and are
     // only ever manipulated by the stream (in case of the time) or only
@@ -370,25 +517,97 @@ private:
         m_metadata = metadata;
     }
 
-    void push(const T &data)
+    static int64_t elementMemorySize(const T &data)
+    {
+        const auto size = data.memorySize();
+        return size > 0 ? size : static_cast<int64_t>(sizeof(T));
+    }
+
+    void takePending(const std::optional<T> &data)
+    {
+        if (data.has_value())
+            m_pendingBytes.fetch_sub(elementMemorySize(data.value()), std::memory_order_relaxed);
+    }
+
+    void dropPending()
+    {
+        std::optional<T> data;
+        while (m_queue.try_dequeue(data))
+            takePending(data);
+    }
+
+    std::optional<T> nextAdaptive()
+    {
+        std::optional<T> data;
+        uint64_t pushCount;
+        if (m_queue.try_dequeue(data)) {
+            takePending(data);
+            m_spinWaiter->recordArrival(lastPushTime(&pushCount), pushCount);
+            return data;
+        }
+
+        bool dequeued = false;
+        const auto phase = m_spinWaiter->wait(
+            [this]() {
+                return m_queue.size_approx() > 0;
+            },
+            [this, &data, &dequeued](nanoseconds_t timeout) {
+                if (timeout.count() < 0)
+                    m_queue.wait_dequeue(data);
+                else if (!m_queue.wait_dequeue_timed(data, std::chrono::duration_cast<microseconds_t>(timeout)))
+                    return false;
+                dequeued = true;
+                return true;
+            });
+        const auto wakeTime = symaster_clock::now();
+        if (!dequeued && !m_queue.try_dequeue(data))
+            m_queue.wait_dequeue(data);
+        takePending(data);
+
+        // the terminating nullopt carries no timing information
+        if (data.has_value())
+            m_spinWaiter->recordWakeup(phase, lastPushTime(&pushCount), pushCount, wakeTime);
+        return data;
+    }
+
+    void push(const T &data, int64_t memSize)
     {
         // don't accept any new data if we are suspended
-        if (m_suspended)
+        if (m_suspended) {
+            m_droppedCount.fetch_add(1, std::memory_order_relaxed);
             return;
+        }
 
         // check if we can throttle the enqueueing speed of data
-        if (m_throttle != 0) {
+        const uint throttle = std::max(m_throttle.load(), m_restriction.load());
+        if (throttle != 0) {
             const auto timeNow = currentTimePoint();
             const auto durUsec = timeDiffUsec(timeNow, m_lastItemTime);
-            if (durUsec.count() < m_throttle) {
+            if (durUsec.count() < throttle) {
                 m_skippedElements++;
+                m_droppedCount.fetch_add(1, std::memory_order_relaxed);
                 return;
             }
             m_lastItemTime = timeNow;
         }
 
+        // publish the push time for subscribers measuring their wakeup latency
+        if (m_spinWait) {
+            const auto seq = m_pushSeq.load(std::memory_order_relaxed);
+            m_pushSeq.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            m_lastPushNs.store(symaster_clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+            m_pushSeq.store(seq + 2, std::memory_order_release);
+        }
+
+        // account for the memory the queued element keeps alive
+        const auto pendingBytes = m_pendingBytes.fetch_add(memSize, std::memory_order_relaxed) + memSize;
+        if (pendingBytes > m_peakPendingBytes.load(std::memory_order_relaxed))
+            m_peakPendingBytes.store(pendingBytes, std::memory_order_relaxed);
+
         // actually send the data to the subscriber
         m_queue.enqueue(std::optional<T>(data));
+        m_deliveredCount.fetch_add(1, std::memory_order_relaxed);
 
         // ping the eventfd, in case anyone is listening for messages
         if (m_notify) {
@@ -410,9 +629,18 @@ private:
         m_suspended = false;
         m_active = true;
         m_throttle = 0;
+        m_restriction = 0;
+        m_deliveredCount = 0;
+        m_droppedCount = 0;
+        m_peakPendingBytes = 0;
+        m_pushSeq = 0;
+        m_lastPushNs = 0;
+        if (m_spinWaiter)
+            m_spinWaiter->reset();
         m_lastItemTime = currentTimePoint();
         while (m_queue.pop()) {
         } // ensure the queue is empty
+        m_pendingBytes = 0;
     }
 };
 
@@ -528,10 +756,11 @@ public:
 
     void push(const T &data)
     {
-        if (!m_active)
+        if (!m_active || m_subs.empty())
             return;
+        const auto memSize = StreamSubscription<T>::elementMemorySize(data);
         for (auto &sub : m_subs)
-            sub->push(data);
+            sub->push(data, memSize);
     }
 
     void pushRawData(int typeId, const void *data, size_t size) override
@@ -544,8 +773,9 @@ public:
         }
 
         const T &entity = T::fromMemory(data, size);
+        const auto memSize = StreamSubscription<T>::elementMemorySize(entity);
         for (auto &sub : m_subs)
-            sub->push(entity);
+            sub->push(entity, memSize);
     }
 
     void terminate()
@@ -19,8 +19,10 @@
 
 #include "subscriptionwatcher.h"
 
+#include <algorithm>
 #include <sys/epoll.h>
 #include <sys/eventfd.h>
+#include <sys/timerfd.h>
 
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wpadded"
@@ -32,7 +34,11 @@ public:
 
     bool valid;
     int epollFD;
+    int timerFD;
     std::vector<std::shared_ptr<VariantStreamSubscription>> subs;
+
+    bool spinWait;
+    std::unique_ptr<AdaptiveSpinWaiter> spinWaiter;
 };
 #pragma GCC diagnostic pop
 
@@ -50,57 +56,171 @@ bool SubscriptionWatcher::isValid() const
     return d->valid;
 }
 
-SubscriptionWatcher::WaitResult SubscriptionWatcher::wait()
+bool SubscriptionWatcher::hasPendingData() const
 {
-    // skip all the epoll waiting in case we already have new data
     for (const auto &sub : d->subs) {
         if (sub->hasPending())
-            return NEWDATA;
+            return true;
     }
+    return false;
+}
 
-    // watch for new data
-    const int timeout = 40000; // 40msec
+symaster_timepoint SubscriptionWatcher::lastPushTime(uint64_t *pushCount) const
+{
+    symaster_timepoint latest;
+    *pushCount = 0;
+    for (const auto &sub : d->subs) {
+        uint64_t count;
+        latest = std::max(latest, sub->lastPushTime(&count));
+        *pushCount += count;
+    }
+    return latest;
+}
+
+std::optional<SubscriptionWatcher::WaitResult> SubscriptionWatcher::pollEventsFor(nanoseconds_t timeout)
+{
+    if (timeout.count() <= 0)
+        return std::nullopt;
+
+    // epoll_wait() only has millisecond resolution, which would turn short waits into busy loops,
+    // so we let a timer wake us up instead. Re-arming it also drops any stale expiration.
+    struct itimerspec spec = {};
+    spec.it_value.tv_sec = timeout.count() / 1000000000;
+    spec.it_value.tv_nsec = timeout.count() % 1000000000;
+    if (timerfd_settime(d->timerFD, 0, &spec, nullptr) < 0) {
+        qCritical("Unable to arm wait timer: %s", std::strerror(errno));
+        return ERROR;
+    }
+
+    return pollEvents(-1);
+}
+
+std::optional<SubscriptionWatcher::WaitResult> SubscriptionWatcher::pollEvents(int timeoutMsec)
+{
     struct epoll_event events[10];
-    int ret;
     uint64_t count = 0;
 
-    while (true) {
-        ret = epoll_wait(d->epollFD, &events[0], 10, timeout);
-        if (ret > 0) {
-            int i = 0;
-            bool newData = false;
-            for (; i < ret; i++) {
-                if (events[i].events & EPOLLHUP) {
-                    return DONE;
-                } else if (events[i].events & EPOLLERR) {
-                    qWarning("Eventfd has epoll error");
-                    //  return ERROR;
-                } else if (events[i].events & EPOLLIN) {
-                    auto efd = events[i].data.fd;
-                    ret = read(efd, &count, sizeof(count));
-                    if (ret < 0)
-                        qDebug("Eventfd read failed: %s", std::strerror(errno));
-
-                    newData = true;
-                }
+    int ret = epoll_wait(d->epollFD, &events[0], 10, timeoutMsec);
+    if (ret == 0)
+        return std::nullopt;
+    if (ret < 0) {
+        qCritical("Error during epoll wait: %s", std::strerror(errno));
+        return ERROR;
+    }
+
+    bool newData = false;
+    for (int i = 0; i < ret; i++) {
+        if (events[i].events & EPOLLHUP) {
+            return DONE;
+        } else if (events[i].events & EPOLLERR) {
+            qWarning("Eventfd has epoll error");
+            //  return ERROR;
+        } else if (events[i].events & EPOLLIN) {
+            auto efd = events[i].data.fd;
+            if (efd == d->timerFD) {
+                // our wait timed out
+                if (read(efd, &count, sizeof(count)) < 0)
+                    qDebug("Timerfd read failed: %s", std::strerror(errno));
+                continue;
             }
-            if (newData)
-                return NEWDATA;
 
-        } else if (ret == 0) {
+            if (read(efd, &count, sizeof(count)) < 0)
+                qDebug("Eventfd read failed: %s", std::strerror(errno));
+
+            newData = true;
+        }
+    }
+    if (newData)
+        return NEWDATA;
+
+    return std::nullopt;
+}
+
+SubscriptionWatcher::WaitResult SubscriptionWatcher::wait()
+{
+    // skip all the epoll waiting in case we already have new data
+    if (hasPendingData()) {
+        if (d->spinWait) {
+            uint64_t pushCount;
+            const auto pushTime = lastPushTime(&pushCount);
+            d->spinWaiter->recordArrival(pushTime, pushCount);
+        }
+        return NEWDATA;
+    }
+
+    // watch for new data
+    const int timeout = 40000; // 40msec
+
+    if (!d->spinWait) {
+        while (true) {
+            const auto res = pollEvents(timeout);
+            if (res.has_value())
+                return res.value();
+
             // we hit a timeout, check if we got any data in subscriptions, just in case
-            for (const auto &sub : d->subs) {
-                if (sub->hasPending())
-                    return NEWDATA;
-            }
+            if (hasPendingData())
+                return NEWDATA;
 
             // continue blocking indefinitely
-            continue;
-        } else {
-            qCritical("Error during epoll wait: %s", std::strerror(errno));
-            return ERROR;
         }
     }
+
+    // busy-poll around the time we expect new data, and only block otherwise
+    WaitResult result = NEWDATA;
+    const auto phase = d->spinWaiter->wait(
+        [this]() {
+            return hasPendingData();
+        },
+        [&](nanoseconds_t maxTime) {
+            const auto deadline = symaster_clock::now() + maxTime;
+            while (true) {
+                std::optional<WaitResult> res;
+                if (maxTime.count() >= 0) {
+                    const auto remaining = std::chrono::duration_cast<nanoseconds_t>(deadline - symaster_clock::now());
+                    if (remaining.count() <= 0)
+                        return false;
+                    res = pollEventsFor(remaining);
+                } else {
+                    res = pollEvents(timeout);
+                }
+
+                // notifications of elements we already took while polling may still be pending,
+                // so only trust the subscriptions themselves
+                if (res.has_value() && res.value() != NEWDATA) {
+                    result = res.value();
+                    return true;
+                }
+                if (hasPendingData())
+                    return true;
+            }
+        });
+    if (result != NEWDATA)
+        return result;
+
+    const auto wakeTime = symaster_clock::now();
+    uint64_t pushCount;
+    const auto pushTime = lastPushTime(&pushCount);
+    d->spinWaiter->recordWakeup(phase, pushTime, pushCount, wakeTime);
+
+    return NEWDATA;
+}
+
+void SubscriptionWatcher::setWaitStrategy(SubscriptionWaitStrategy strategy)
+{
+    // the subscriptions need to record when data was pushed for us to estimate arrival times
+    for (const auto &sub : d->subs)
+        sub->setWaitStrategy(strategy);
+
+    if (strategy == SubscriptionWaitStrategy::SPIN_THEN_BLOCK && !d->spinWaiter)
+        d->spinWaiter = std::make_unique<AdaptiveSpinWaiter>();
+    d->spinWait = strategy == SubscriptionWaitStrategy::SPIN_THEN_BLOCK;
+}
+
+WaitLatencyStats SubscriptionWatcher::waitLatencyStats() const
+{
+    if (!d->spinWaiter)
+        return WaitLatencyStats();
+    return d->spinWaiter->stats();
 }
 
 SubscriptionWatcher::SubscriptionWatcher(
@@ -109,6 +229,8 @@ SubscriptionWatcher::SubscriptionWatcher(
 {
     d->valid = false;
     d->epollFD = -1;
+    d->timerFD = -1;
+    d->spinWait = false;
 
     d->epollFD = epoll_create1(EPOLL_CLOEXEC);
     if (d->epollFD < 0) {
@@ -116,6 +238,20 @@ SubscriptionWatcher::SubscriptionWatcher(
         return;
     }
 
+    // timer for waits with sub-millisecond timeouts
+    d->timerFD = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (d->timerFD < 0) {
+        qCritical("Unable to create wait timer: %s", std::strerror(errno));
+        return;
+    }
+    struct epoll_event tevent;
+    tevent.events = EPOLLIN;
+    tevent.data.fd = d->timerFD;
+    if (epoll_ctl(d->epollFD, EPOLL_CTL_ADD, d->timerFD, &tevent) < 0) {
+        qCritical("Unable to add wait timer epoll watch: %s", std::strerror(errno));
+        return;
+    }
+
     // add eventfds to the list of watched file descriptors
     for (const auto &sub : subscriptions) {
         const auto efd = sub->enableNotify();
@@ -141,6 +277,8 @@ SubscriptionWatcher::SubscriptionWatcher(
 SubscriptionWatcher::~SubscriptionWatcher()
 {
     d->subs.clear();
+    if (d->timerFD >= 0)
+        close(d->timerFD);
     if (d->epollFD >= 0)
         close(d->epollFD);
 }
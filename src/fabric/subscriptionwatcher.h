@@ -41,10 +41,22 @@ public:
 
     WaitResult wait();
 
+    /**
+     * Select how wait() waits for new data, see StreamSubscription::setWaitStrategy().
+     * This also changes the wait strategy of all watched subscriptions.
+     */
+    void setWaitStrategy(SubscriptionWaitStrategy strategy);
+    WaitLatencyStats waitLatencyStats() const;
+
 private:
     class Private;
     Q_DISABLE_COPY(SubscriptionWatcher)
     std::unique_ptr<Private> d;
 
+    bool hasPendingData() const;
+    symaster_timepoint lastPushTime(uint64_t *pushCount) const;
+    std::optional<WaitResult> pollEvents(int timeoutMsec);
+    std::optional<WaitResult> pollEventsFor(nanoseconds_t timeout);
+
     explicit SubscriptionWatcher(std::initializer_list<std::shared_ptr<VariantStreamSubscription>> subscriptions);
 };
@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "threadsched.h"
+
+#include <QFile>
+#include <QStringList>
+#include <algorithm>
+
+#include "utils/cpuaffinity.h"
+
+using namespace Syntalos;
+
+QString Syntalos::threadSchedPolicyToString(ThreadSchedPolicy policy)
+{
+    switch (policy) {
+    case ThreadSchedPolicy::OTHER:
+        return QStringLiteral("other");
+    case ThreadSchedPolicy::REALTIME:
+        return QStringLiteral("realtime");
+    case ThreadSchedPolicy::DEADLINE:
+        return QStringLiteral("deadline");
+    }
+
+    return QStringLiteral("unknown");
+}
+
+static long long readProcValue(const QString &path, long long defaultValue)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+        return defaultValue;
+
+    bool ok = false;
+    const auto value = file.readAll().trimmed().toLongLong(&ok);
+    return ok ? value : defaultValue;
+}
+
+double Syntalos::availableRealtimeBandwidth()
+{
+    const auto cpuCount = std::max(get_online_cores_count(), 1);
+
+    // a runtime of -1 disables throttling of realtime tasks entirely
+    const auto rtRuntime = readProcValue(QStringLiteral("/proc/sys/kernel/sched_rt_runtime_us"), 950000);
+    const auto rtPeriod = readProcValue(QStringLiteral("/proc/sys/kernel/sched_rt_period_us"), 1000000);
+    if (rtRuntime < 0 || rtPeriod <= 0)
+        return cpuCount;
+
+    return cpuCount * std::min(static_cast<double>(rtRuntime) / rtPeriod, 1.0);
+}
+
+bool Syntalos::periodicThreadsFit(
+    const std::vector<PeriodicThreadRequest> &requests,
+    double availableCpus,
+    QString *errorMessage)
+{
+    double total = 0;
+    for (const auto &req : requests) {
+        if (!req.timing.isValid()) {
+            if (errorMessage != nullptr)
+                *errorMessage = QStringLiteral(
+                                    "The thread of \"%1\" requested %2µs of CPU time every %3µs with a deadline of "
+                                    "%4µs, which is impossible to satisfy.")
+                                    .arg(req.name)
+                                    .arg(req.timing.runtime.count())
+                                    .arg(req.timing.period.count())
+                                    .arg(req.timing.effectiveDeadline().count());
+            return false;
+        }
+
+        total += req.timing.utilization();
+    }
+
+    if (total <= availableCpus)
+        return true;
+
+    if (errorMessage != nullptr) {
+        QStringList threads;
+        for (const auto &req : requests)
+            threads.append(QStringLiteral("\"%1\" (%2%)").arg(req.name).arg(req.timing.utilization() * 100, 0, 'f', 1));
+
+        *errorMessage = QStringLiteral(
+                            "Periodic threads need %1 CPUs worth of realtime computing time, but only %2 are "
+                            "available: %3")
+                            .arg(total, 0, 'f', 2)
+                            .arg(availableCpus, 0, 'f', 2)
+                            .arg(threads.join(QStringLiteral(", ")));
+    }
+
+    return false;
+}
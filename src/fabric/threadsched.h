@@ -0,0 +1,107 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QString>
+#include <vector>
+
+#include "datactl/syclock.h"
+
+namespace Syntalos
+{
+
+/**
+ * @brief Timing of a thread that has a bounded amount of work to do at a regular interval
+ */
+struct PeriodicThreadTiming {
+    microseconds_t period{0};   /// Interval at which new work arrives
+    microseconds_t runtime{0};  /// CPU time the work of one period takes at most
+    microseconds_t deadline{0}; /// Time after the work arrived by which it must be done, the period if zero
+
+    microseconds_t effectiveDeadline() const
+    {
+        return deadline.count() > 0 ? deadline : period;
+    }
+
+    bool isValid() const
+    {
+        return runtime.count() > 0 && runtime <= effectiveDeadline() && effectiveDeadline() <= period;
+    }
+
+    /**
+     * Share of a single CPU this thread needs.
+     */
+    double utilization() const
+    {
+        return period.count() > 0 ? static_cast<double>(runtime.count()) / period.count() : 0;
+    }
+};
+
+/**
+ * @brief Scheduling class a module thread was run with
+ */
+enum class ThreadSchedPolicy {
+    OTHER,    /// Regular time-sharing scheduling, possibly with adjusted niceness
+    REALTIME, /// Fixed-priority realtime scheduling (SCHED_FIFO, or SCHED_RR if granted by RtKit)
+    DEADLINE  /// Earliest-deadline-first scheduling with reserved CPU bandwidth
+};
+
+QString threadSchedPolicyToString(ThreadSchedPolicy policy);
+
+/**
+ * @brief How well a periodic thread kept up with its deadlines
+ */
+struct PeriodicThreadStats {
+    uint64_t cycles{0};             /// Periods the thread has completed work for
+    uint64_t missedDeadlines{0};    /// Periods whose work was completed after the deadline
+    microseconds_t maxCycleTime{0}; /// Longest time the work of one period took
+    microseconds_t p99CycleTime{0}; /// Time the work of 99% of all periods took at most (approximately)
+};
+
+/**
+ * @brief A periodic thread that is supposed to run in a particular run
+ */
+struct PeriodicThreadRequest {
+    QString name; /// Human-readable name of the thread's owner, for error reporting
+    PeriodicThreadTiming timing;
+};
+
+/**
+ * CPU bandwidth the kernel grants realtime and deadline threads in total, in CPUs.
+ * E.g. 7.6 on a machine with 8 online cores that limits realtime tasks to 95% of the CPU time.
+ */
+double availableRealtimeBandwidth();
+
+/**
+ * Check whether the given periodic threads can all get the CPU time they need.
+ *
+ * This is the same admission test the kernel applies to SCHED_DEADLINE threads,
+ * so threads which pass it can get their bandwidth reserved.
+ * @param requests Periodic threads of a run.
+ * @param availableCpus CPU bandwidth available to realtime threads, see availableRealtimeBandwidth()
+ * @param errorMessage Set to a human-readable description of the first problem found.
+ * @return true if all threads fit.
+ */
+bool periodicThreadsFit(
+    const std::vector<PeriodicThreadRequest> &requests,
+    double availableCpus,
+    QString *errorMessage = nullptr);
+
+} // namespace Syntalos
@@ -54,6 +54,7 @@ GlobalConfigDialog::GlobalConfigDialog(QWidget *parent)
         ui->colorModeComboBox->setCurrentIndex(static_cast<int>(m_gc->appColorMode()));
     }
     ui->cbEmergencyOOMStop->setChecked(m_gc->emergencyOOMStop());
+    ui->cbWarmPythonWorkers->setChecked(m_gc->warmPythonWorkers());
 
     // advanced section
     ui->defaultNicenessSpinBox->setMaximum(20);
@@ -66,6 +67,7 @@ GlobalConfigDialog::GlobalConfigDialog(QWidget *parent)
 
     ui->cpuAffinityWarnButton->setVisible(false);
     ui->explicitCoreAffinitiesCheckBox->setChecked(m_gc->explicitCoreAffinities());
+    ui->vipsThreadBudgetSpinBox->setValue(m_gc->vipsThreadBudget());
 
     // devel section
     ui->cbDisplayDevModules->setChecked(m_gc->showDevelModules());
@@ -101,6 +103,12 @@ void GlobalConfigDialog::on_emergencyOOMStopCheckBox_toggled(bool checked)
         m_gc->setEmergencyOOMStop(checked);
 }
 
+void GlobalConfigDialog::on_cbWarmPythonWorkers_toggled(bool checked)
+{
+    if (m_acceptChanges)
+        m_gc->setWarmPythonWorkers(checked);
+}
+
 void GlobalConfigDialog::on_defaultNicenessSpinBox_valueChanged(int arg1)
 {
     if (m_acceptChanges)
@@ -120,6 +128,12 @@ void GlobalConfigDialog::on_explicitCoreAffinitiesCheckBox_toggled(bool checked)
     ui->cpuAffinityWarnButton->setVisible(checked);
 }
 
+void GlobalConfigDialog::on_vipsThreadBudgetSpinBox_valueChanged(int arg1)
+{
+    if (m_acceptChanges)
+        m_gc->setVipsThreadBudget(arg1);
+}
+
 void GlobalConfigDialog::on_cpuAffinityWarnButton_clicked()
 {
     QMessageBox::information(
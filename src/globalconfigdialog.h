@@ -40,10 +40,12 @@ public:
 private slots:
     void on_colorModeComboBox_currentIndexChanged(int index);
     void on_emergencyOOMStopCheckBox_toggled(bool checked);
+    void on_cbWarmPythonWorkers_toggled(bool checked);
 
     void on_defaultNicenessSpinBox_valueChanged(int arg1);
     void on_defaultRTPrioSpinBox_valueChanged(int arg1);
     void on_explicitCoreAffinitiesCheckBox_toggled(bool checked);
+    void on_vipsThreadBudgetSpinBox_valueChanged(int arg1);
     void on_cpuAffinityWarnButton_clicked();
 
     void on_cbDisplayDevModules_toggled(bool checked);
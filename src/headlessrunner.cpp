@@ -0,0 +1,383 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "headlessrunner.h"
+
+#include <QAbstractButton>
+#include <QApplication>
+#include <QDateTime>
+#include <QDebug>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QMessageBox>
+#include <csignal>
+
+#include "datactl/framebufferpool.h"
+#include "entitylistmodels.h"
+#include "projectloader.h"
+
+using namespace Syntalos;
+
+static volatile sig_atomic_t g_terminationRequested = 0;
+
+static void handleTerminationSignal(int)
+{
+    g_terminationRequested = 1;
+}
+
+static QString portDisplayName(AbstractStreamPort *port)
+{
+    return QStringLiteral("%1:%2").arg(port->owner()->name(), port->id());
+}
+
+HeadlessRunner::HeadlessRunner(QObject *parent)
+    : QObject(parent),
+      m_engine(new Engine),
+      m_durationMsec(0),
+      m_runCount(1),
+      m_ephemeral(false),
+      m_keepWarm(false)
+{
+    m_engine->setParent(this);
+
+    m_stopTimer = new QTimer(this);
+    m_stopTimer->setSingleShot(true);
+    connect(m_stopTimer, &QTimer::timeout, m_engine, &Engine::stop);
+
+    // nobody can answer dialogs in headless mode, and nobody can press the stop button
+    m_watchTimer = new QTimer(this);
+    m_watchTimer->setInterval(200);
+    connect(m_watchTimer, &QTimer::timeout, this, &HeadlessRunner::dismissModalDialogs);
+    connect(m_watchTimer, &QTimer::timeout, this, &HeadlessRunner::checkTerminationRequest);
+
+    connect(m_engine, &Engine::runStarted, this, &HeadlessRunner::onRunStarted);
+    connect(m_engine, &Engine::runFailed, this, &HeadlessRunner::onRunFailed);
+    connect(m_engine, &Engine::connectionHeatChangedAtPort, this, &HeadlessRunner::onConnectionHeatChanged);
+    connect(m_engine, &Engine::statusMessage, this, [](const QString &message) {
+        qInfo().noquote() << message;
+    });
+}
+
+HeadlessRunner::~HeadlessRunner()
+{
+    m_engine->removeAllModules();
+}
+
+void HeadlessRunner::setRunDuration(int msec)
+{
+    m_durationMsec = msec;
+}
+
+void HeadlessRunner::setRunCount(int count)
+{
+    m_runCount = count;
+}
+
+void HeadlessRunner::setEphemeral(bool ephemeral)
+{
+    m_ephemeral = ephemeral;
+}
+
+void HeadlessRunner::setKeepModulesWarm(bool keepWarm)
+{
+    m_keepWarm = keepWarm;
+}
+
+void HeadlessRunner::setExportBaseDir(const QString &dir)
+{
+    m_exportBaseDir = dir;
+}
+
+void HeadlessRunner::setTestSubjectId(const QString &id)
+{
+    m_subjectId = id;
+}
+
+void HeadlessRunner::setStatsFilename(const QString &fname)
+{
+    m_statsFname = fname;
+}
+
+bool HeadlessRunner::initialize()
+{
+    return m_engine->initialize();
+}
+
+/**
+ * Load a project file, like MainWindow does, but without asking any questions:
+ * Anything that would require a decision from the user is treated as error.
+ */
+bool HeadlessRunner::loadProject(const QString &fileName)
+{
+    ProjectLoader loader(m_engine);
+    if (!loader.open(fileName)) {
+        qCritical().noquote() << loader.lastError();
+        return false;
+    }
+    if (!loader.formatVersionMatches())
+        qWarning().noquote() << "Project was created with a different version of Syntalos, it may not run correctly.";
+
+    const auto rootObj = loader.mainSettings();
+    m_engine->removeAllModules();
+    m_engine->setExportBaseDir(
+        m_exportBaseDir.isEmpty() ? rootObj.value("export_base_dir").toString() : m_exportBaseDir);
+    m_engine->setExperimentId(rootObj.value("experiment_id").toString());
+    m_engine->setSimpleStorageNames(rootObj.value("simple_storage_names", true).toBool());
+
+    if (!loader.loadModules()) {
+        qCritical().noquote() << loader.lastError();
+        return false;
+    }
+
+    // use the full subject information the project has, if we know the selected subject
+    if (!m_subjectId.isEmpty()) {
+        TestSubjectListModel subjects;
+        subjects.fromVariantHash(loader.subjects());
+
+        TestSubject subject;
+        subject.id = m_subjectId;
+        subject.active = true;
+        bool subjectKnown = false;
+        for (int i = 0; i < subjects.rowCount(); i++) {
+            if (subjects.subject(i).id == m_subjectId) {
+                subject = subjects.subject(i);
+                subjectKnown = true;
+                break;
+            }
+        }
+        if (!subjectKnown)
+            qWarning().noquote() << "Test subject" << m_subjectId << "is not known to this project.";
+        m_engine->setTestSubject(subject);
+    }
+
+    m_projectFname = fileName;
+    qInfo().noquote() << "Loaded project" << fileName << "with" << m_engine->activeModules().size() << "modules";
+    return true;
+}
+
+int HeadlessRunner::exec()
+{
+    std::signal(SIGINT, handleTerminationSignal);
+    std::signal(SIGTERM, handleTerminationSignal);
+    m_watchTimer->start();
+
+    m_engine->resetSuccessRunsCounter();
+    m_engine->setRunCountExpectedMax(m_runCount);
+
+    bool allSucceeded = true;
+    for (int i = 1; i <= m_runCount; i++) {
+        qInfo().noquote() << QStringLiteral("Starting run %1 of %2").arg(i).arg(m_runCount);
+        m_runErrors.clear();
+        m_maxHeat.clear();
+
+        m_engine->setKeepModulesWarm(m_keepWarm && i < m_runCount);
+        const bool started = m_ephemeral ? m_engine->runEphemeral() : m_engine->run();
+        m_stopTimer->stop();
+
+        const bool success = started && !m_engine->hasFailed();
+        m_runStats.append(collectRunStats(i, success));
+        if (!success) {
+            allSucceeded = false;
+            break;
+        }
+        if (g_terminationRequested)
+            break;
+    }
+
+    m_engine->setKeepModulesWarm(false);
+    m_watchTimer->stop();
+    std::signal(SIGINT, SIG_DFL);
+    std::signal(SIGTERM, SIG_DFL);
+
+    if (!writeStats())
+        return 1;
+    return allSucceeded ? 0 : 1;
+}
+
+void HeadlessRunner::onRunStarted()
+{
+    if (m_durationMsec > 0)
+        m_stopTimer->start(m_durationMsec);
+}
+
+void HeadlessRunner::onRunFailed(AbstractModule *mod, const QString &message)
+{
+    const auto error = mod == nullptr ? message : QStringLiteral("%1: %2").arg(mod->name(), message);
+    qCritical().noquote() << "Run failed:" << error;
+    m_runErrors.append(error);
+}
+
+void HeadlessRunner::onConnectionHeatChanged(VarStreamInputPort *iport, ConnectionHeatLevel hlevel)
+{
+    if (hlevel > m_maxHeat.value(iport, ConnectionHeatLevel::NONE))
+        m_maxHeat[iport] = hlevel;
+}
+
+void HeadlessRunner::dismissModalDialogs()
+{
+    auto dialog = qobject_cast<QDialog *>(QApplication::activeModalWidget());
+    if (dialog == nullptr)
+        return;
+
+    // pick the escape button, which is the "No" or "Cancel" answer to any question
+    auto msgBox = qobject_cast<QMessageBox *>(dialog);
+    if (msgBox != nullptr) {
+        qWarning().noquote() << "Dismissing dialog:" << msgBox->windowTitle() << "-" << msgBox->text();
+        if (msgBox->escapeButton() != nullptr) {
+            msgBox->escapeButton()->click();
+            return;
+        }
+    } else {
+        qWarning().noquote() << "Dismissing dialog:" << dialog->windowTitle();
+    }
+    dialog->reject();
+}
+
+void HeadlessRunner::checkTerminationRequest()
+{
+    if (!g_terminationRequested)
+        return;
+    if (m_engine->isRunning()) {
+        qInfo().noquote() << "Termination requested, stopping run.";
+        m_engine->stop();
+    }
+}
+
+QJsonObject HeadlessRunner::collectRunStats(int runIndex, bool success)
+{
+    const auto durationMsec = m_engine->lastRunDuration().count();
+
+    QJsonArray modules;
+    QJsonArray connections;
+    for (auto mod : m_engine->activeModules()) {
+        const auto timings = m_engine->lastRunModuleTimings(mod);
+        QJsonObject modStats;
+        modStats.insert("name", mod->name());
+        modStats.insert("id", mod->id());
+        modStats.insert("prepare_msec", static_cast<qint64>(timings.prepare.count()));
+        modStats.insert("stop_msec", static_cast<qint64>(timings.stop.count()));
+        if (timings.hasStartSkew)
+            modStats.insert("start_skew_usec", static_cast<qint64>(timings.startSkew.count()));
+        modStats.insert("warm", timings.warm);
+        if (timings.hasThread)
+            modStats.insert("sched_policy", threadSchedPolicyToString(timings.schedPolicy));
+        if (timings.periodic.cycles > 0) {
+            modStats.insert("periodic_cycles", static_cast<qint64>(timings.periodic.cycles));
+            modStats.insert("missed_deadlines", static_cast<qint64>(timings.periodic.missedDeadlines));
+            modStats.insert("max_cycle_usec", static_cast<qint64>(timings.periodic.maxCycleTime.count()));
+            modStats.insert("p99_cycle_usec", static_cast<qint64>(timings.periodic.p99CycleTime.count()));
+        }
+
+        const auto memUsage = m_engine->lastRunModuleMemory(mod);
+        modStats.insert("peak_queued_bytes", memUsage.peakQueuedBytes);
+        if (memUsage.peakResidentBytes >= 0)
+            modStats.insert("peak_resident_bytes", memUsage.peakResidentBytes);
+        if (memUsage.throttledInputs > 0)
+            modStats.insert("memory_throttled_inputs", static_cast<int>(memUsage.throttledInputs));
+        modules.append(modStats);
+
+        for (auto &iport : mod->inPorts()) {
+            if (!iport->hasSubscription())
+                continue;
+            const auto sub = iport->subscriptionVar();
+            const auto delivered = sub->deliveredCount();
+
+            QJsonObject conStats;
+            conStats.insert("source", portDisplayName(iport->outPort()));
+            conStats.insert("target", portDisplayName(iport.get()));
+            conStats.insert("data_type", sub->dataTypeName());
+            conStats.insert("items", static_cast<qint64>(delivered));
+            conStats.insert("dropped", static_cast<qint64>(sub->droppedCount()));
+            conStats.insert("peak_queued_bytes", static_cast<qint64>(sub->peakPendingBytes()));
+            conStats.insert("items_per_sec", durationMsec > 0 ? delivered * 1000.0 / durationMsec : 0.0);
+            conStats.insert(
+                "max_heat", connectionHeatToHumanString(m_maxHeat.value(iport.get(), ConnectionHeatLevel::NONE)));
+
+            const auto waitStats = sub->waitLatencyStats();
+            if (waitStats.count > 0) {
+                QJsonObject waitLatency;
+                waitLatency.insert("p50", waitStats.p50Usec);
+                waitLatency.insert("p99", waitStats.p99Usec);
+                waitLatency.insert("p999", waitStats.p999Usec);
+                waitLatency.insert("max", waitStats.maxUsec);
+                waitLatency.insert("spin_wakeups", static_cast<qint64>(waitStats.spinWakeups));
+                waitLatency.insert("yield_wakeups", static_cast<qint64>(waitStats.yieldWakeups));
+                waitLatency.insert("block_wakeups", static_cast<qint64>(waitStats.blockWakeups));
+                conStats.insert("wait_latency_usec", waitLatency);
+            }
+            connections.append(conStats);
+        }
+    }
+
+    // counters of the shared frame pools accumulate over all runs of this process
+    QJsonArray framePools;
+    for (const auto &poolStats : FrameBufferPool::sharedStats()) {
+        QJsonObject poolObj;
+        poolObj.insert("buffer_size", static_cast<qint64>(poolStats.bufferSize));
+        poolObj.insert("huge_pages", poolStats.hugePages);
+        poolObj.insert("acquired", static_cast<qint64>(poolStats.acquired));
+        poolObj.insert("reused", static_cast<qint64>(poolStats.reused));
+        poolObj.insert("allocated", static_cast<qint64>(poolStats.allocated));
+        poolObj.insert("peak_in_use", static_cast<qint64>(poolStats.peakInUse));
+        framePools.append(poolObj);
+    }
+
+    QJsonObject run;
+    run.insert("index", runIndex);
+    run.insert("success", success);
+    run.insert("duration_msec", static_cast<qint64>(durationMsec));
+    run.insert("setup_msec", static_cast<qint64>(m_engine->lastRunSetupTime().count()));
+    if (!m_runErrors.isEmpty())
+        run.insert("errors", QJsonArray::fromStringList(m_runErrors));
+    run.insert("modules", modules);
+    run.insert("connections", connections);
+    run.insert("frame_pools", framePools);
+    return run;
+}
+
+bool HeadlessRunner::writeStats()
+{
+    if (m_statsFname.isEmpty())
+        return true;
+
+    QJsonObject root;
+    root.insert("project", QFileInfo(m_projectFname).absoluteFilePath());
+    root.insert("timestamp", QDateTime::currentDateTime().toString(Qt::ISODate));
+    root.insert("ephemeral", m_ephemeral);
+    root.insert("runs", m_runStats);
+    const auto data = QJsonDocument(root).toJson(QJsonDocument::Indented);
+
+    // "-" writes the statistics to stdout, so they can be piped into other tools
+    QFile file;
+    bool ok;
+    if (m_statsFname == QStringLiteral("-")) {
+        ok = file.open(stdout, QIODevice::WriteOnly);
+    } else {
+        file.setFileName(m_statsFname);
+        ok = file.open(QIODevice::WriteOnly | QIODevice::Truncate);
+    }
+    if (!ok || file.write(data) != data.size()) {
+        qCritical().noquote() << "Unable to write run statistics:" << file.errorString();
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QHash>
+#include <QJsonArray>
+#include <QObject>
+#include <QTimer>
+
+#include "engine.h"
+
+/**
+ * @brief Runs a Syntalos project without any user interface
+ *
+ * Loads a project file, runs it one or multiple times for a fixed
+ * duration and collects statistics about each run, so whole module
+ * graphs can be run from scripts and benchmarked on machines without a display.
+ */
+class HeadlessRunner : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit HeadlessRunner(QObject *parent = nullptr);
+    ~HeadlessRunner() override;
+
+    void setRunDuration(int msec);
+    void setRunCount(int count);
+    void setEphemeral(bool ephemeral);
+    void setKeepModulesWarm(bool keepWarm);
+    void setExportBaseDir(const QString &dir);
+    void setTestSubjectId(const QString &id);
+    void setStatsFilename(const QString &fname);
+
+    bool initialize();
+    bool loadProject(const QString &fileName);
+
+    /**
+     * Perform all runs and write out their statistics.
+     * @return Process exit code, 0 if all runs succeeded.
+     */
+    int exec();
+
+private slots:
+    void onRunStarted();
+    void onRunFailed(Syntalos::AbstractModule *mod, const QString &message);
+    void onConnectionHeatChanged(Syntalos::VarStreamInputPort *iport, ConnectionHeatLevel hlevel);
+    void dismissModalDialogs();
+    void checkTerminationRequest();
+
+private:
+    QJsonObject collectRunStats(int runIndex, bool success);
+    bool writeStats();
+
+    Syntalos::Engine *m_engine;
+    QString m_projectFname;
+    int m_durationMsec;
+    int m_runCount;
+    bool m_ephemeral;
+    bool m_keepWarm;
+    QString m_exportBaseDir;
+    QString m_subjectId;
+    QString m_statsFname;
+
+    QTimer *m_stopTimer;
+    QTimer *m_watchTimer;
+    QStringList m_runErrors;
+    QHash<Syntalos::VarStreamInputPort *, ConnectionHeatLevel> m_maxHeat;
+    QJsonArray m_runStats;
+};
@@ -53,3 +53,8 @@ double IntervalRunDialog::delayMin() const
 {
     return ui->spinBoxDelay->value();
 }
+
+bool IntervalRunDialog::keepModulesWarm() const
+{
+    return ui->cbKeepWarm->isChecked();
+}
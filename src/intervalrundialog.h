@@ -41,6 +41,7 @@ public:
     int runsN() const;
     double runDurationMin() const;
     double delayMin() const;
+    bool keepModulesWarm() const;
 
 private:
     Ui::IntervalRunDialog *ui;
@@ -22,6 +22,7 @@
 #include <QApplication>
 #include <QCommandLineParser>
 #include <QMessageBox>
+#include <limits>
 #pragma GCC diagnostic push
 #pragma GCC diagnostic ignored "-Wzero-as-null-pointer-constant"
 #include <gst/gst.h>
@@ -29,9 +30,22 @@
 #pragma GCC diagnostic pop
 #include <libusb.h>
 #include "datactl/vips8-q.h"
+#include "datactl/vipsbudget.h"
 
+#include "globalconfig.h"
+#include "headlessrunner.h"
 #include "mainwindow.h"
 
+static bool headlessModeRequested(int argc, char *argv[])
+{
+    for (int i = 1; i < argc; i++) {
+        if (qstrcmp(argv[i], "--headless") == 0)
+            return true;
+    }
+
+    return false;
+}
+
 int main(int argc, char *argv[])
 {
     // set random seed
@@ -52,6 +66,12 @@ int main(int argc, char *argv[])
     // initialize GStreamer so modules can use it if they need to
     gst_init(&argc, &argv);
 
+    // a headless run must not require a display, so we need to select the platform
+    // plugin before the application object is created
+    const bool headless = headlessModeRequested(argc, argv);
+    if (headless && qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+
     // set up GUI application and application details
     QApplication app(argc, argv);
     app.setApplicationName("Syntalos");
@@ -62,17 +82,85 @@ int main(int argc, char *argv[])
     app.setOrganizationName(QString());
     app.setOrganizationDomain(QString());
 
+    // limit the amount of threads libvips may use, so it doesn't compete with our module threads
+    Syntalos::VipsBudget::instance()->configure(Syntalos::GlobalConfig().vipsThreadBudget());
+
     // parse command-line arguments
     QCommandLineParser parser;
     parser.setApplicationDescription("Syntalos");
     parser.addHelpOption();
     parser.addVersionOption();
+    parser.addPositionalArgument("project", "Project file to open.", "[project]");
+
+    QCommandLineOption headlessOption(
+        "headless", "Run the given project without user interface, write log messages to stderr and exit.");
+    parser.addOption(headlessOption);
+    QCommandLineOption durationOption(
+        "duration", "Stop each headless run after this many seconds, instead of waiting for SIGINT.", "seconds");
+    parser.addOption(durationOption);
+    QCommandLineOption runsOption("runs", "Amount of consecutive headless runs (default: 1).", "count", "1");
+    parser.addOption(runsOption);
+    QCommandLineOption ephemeralOption("ephemeral", "Do not keep any data of headless runs.");
+    parser.addOption(ephemeralOption);
+    QCommandLineOption keepWarmOption(
+        "keep-warm", "Keep devices of supported modules connected between consecutive headless runs.");
+    parser.addOption(keepWarmOption);
+    QCommandLineOption exportDirOption(
+        "export-dir", "Store data of headless runs here, instead of the project's export directory.", "dir");
+    parser.addOption(exportDirOption);
+    QCommandLineOption subjectOption("subject", "ID of the test subject for headless runs.", "id");
+    parser.addOption(subjectOption);
+    QCommandLineOption statsOption(
+        "stats-json", "Write statistics of headless runs to this JSON file, or to stdout for \"-\".", "file");
+    parser.addOption(statsOption);
     parser.process(app);
 
     // fetch project filename to open
     const auto positionalArgs = parser.positionalArguments();
     const auto projectFname = positionalArgs.isEmpty() ? QString() : positionalArgs.last();
 
+    if (headless) {
+        if (projectFname.isEmpty()) {
+            qCritical().noquote() << "A project file is required for headless runs.";
+            return 1;
+        }
+
+        bool ok = true;
+        const auto durationSec = parser.isSet(durationOption) ? parser.value(durationOption).toDouble(&ok) : 0;
+        // QTimer takes the duration in milliseconds as int
+        if (!ok || durationSec < 0 || durationSec * 1000 > std::numeric_limits<int>::max()) {
+            qCritical().noquote() << "Invalid run duration:" << parser.value(durationOption);
+            return 1;
+        }
+        const auto runCount = parser.value(runsOption).toInt(&ok);
+        if (!ok || runCount < 1) {
+            qCritical().noquote() << "Invalid amount of runs:" << parser.value(runsOption);
+            return 1;
+        }
+
+        int rc = 1;
+        {
+            HeadlessRunner runner;
+            runner.setRunDuration(static_cast<int>(durationSec * 1000));
+            runner.setRunCount(runCount);
+            runner.setEphemeral(parser.isSet(ephemeralOption));
+            runner.setKeepModulesWarm(parser.isSet(keepWarmOption));
+            runner.setExportBaseDir(parser.value(exportDirOption));
+            if (parser.isSet(subjectOption))
+                runner.setTestSubjectId(parser.value(subjectOption));
+            runner.setStatsFilename(parser.value(statsOption));
+
+            if (!runner.initialize())
+                qCritical().noquote() << "Unable to initialize the Syntalos engine.";
+            else if (runner.loadProject(projectFname))
+                rc = runner.exec();
+        }
+
+        vips_shutdown();
+        libusb_exit(nullptr);
+        return rc;
+    }
+
     // ensure we only ever run one instance of the application
     KDBusService service(KDBusService::Unique);
 
@@ -63,15 +63,13 @@
 #include "globalconfig.h"
 #include "globalconfigdialog.h"
 #include "intervalrundialog.h"
+#include "projectloader.h"
 #include "sysinfodialog.h"
 #include "timingsdialog.h"
 
 #include "executils.h"
 #include "utils/tomlutils.h"
 
-// config format API level
-static const QString CONFIG_FILE_FORMAT_VERSION = QStringLiteral("1");
-
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent),
       ui(new Ui::MainWindow)
@@ -490,7 +488,11 @@ void MainWindow::runActionTriggered()
             qDebug().noquote() << QStringLiteral("New run: %1/%2")
                                       .arg(m_engine->successRunsCount() + 1)
                                       .arg(m_intervalRunDialog->runsN());
+
+            // keep devices of supported modules alive, unless this is the last run
+            m_engine->setKeepModulesWarm(m_intervalRunDialog->keepModulesWarm() && i < m_intervalRunDialog->runsN());
             m_engine->run();
+            qDebug().noquote().nospace() << "Run was set up in " << m_engine->lastRunSetupTime().count() << "msec";
 
             // stop immediately if the interval mode was suspended or an error occurred
             if (!m_isIntervalRun || m_engine->hasFailed())
@@ -530,6 +532,9 @@ void MainWindow::runActionTriggered()
             updateIntervalRunMessage();
         }
 
+        // release anything modules kept for a run that will not happen anymore
+        m_engine->setKeepModulesWarm(false);
+
         ui->runWarnWidget->setVisible(false);
         qDebug().noquote() << "Finished interval run session";
     } else {
@@ -568,6 +573,7 @@ void MainWindow::stopActionTriggered()
 {
     // we need to prevent any interval timer/loop from restarting the engine
     m_isIntervalRun = false;
+    m_engine->setKeepModulesWarm(false);
 
     // shutdown
     ui->actionStop->setEnabled(false);
@@ -661,39 +667,38 @@ bool MainWindow::saveConfiguration(const QString &fileName)
 
 bool MainWindow::loadConfiguration(const QString &fileName)
 {
-    KTar tar(fileName);
-    if (!tar.open(QIODevice::ReadOnly)) {
-        qCritical() << "Unable to open settings file for reading.";
-        return false;
-    }
-
-    setCurrentProjectFile(QString());
-    auto rootDir = tar.directory();
-
-    // load main settings
-    auto globalSettingsFile = rootDir->file("main.toml");
-    if (globalSettingsFile == nullptr) {
+    ProjectLoader loader(m_engine);
+    loader.setStatusCallback([this](const QString &message) {
+        setStatusText(message);
+    });
+    loader.setMissingModuleCallback([this](const QString &modId, const QString &) {
         QMessageBox::critical(
             this,
             QStringLiteral("Can not load settings"),
-            QStringLiteral("The settings file is damaged or is no valid Syntalos configuration bundle."));
-        setStatusText("");
-        return false;
-    }
+            QStringLiteral("Unable to find module '%1' - please install the module first, then "
+                           "attempt to load this configuration again.")
+                .arg(modId));
+        setStatusText("Failed to load settings.");
 
-    QString parseError;
-    const auto rootObj = parseTomlData(globalSettingsFile->data(), parseError);
-    if (!parseError.isEmpty()) {
-        QMessageBox::critical(
+        const auto reply = QMessageBox::question(
             this,
-            QStringLiteral("Can not load settings"),
-            QStringLiteral("The settings file is damaged or is no valid Syntalos configuration file. %1")
-                .arg(parseError));
+            QStringLiteral("Ignore missing module?"),
+            QStringLiteral("While installing thie missing module is the right solution to load this board, "
+                           "you can also enforce loading it. Please be aware that loading may fail. Load anyway?"),
+            QMessageBox::Yes | QMessageBox::No);
+        return reply == QMessageBox::Yes;
+    });
+
+    setCurrentProjectFile(QString());
+
+    // load main settings
+    if (!loader.open(fileName)) {
+        QMessageBox::critical(this, QStringLiteral("Can not load settings"), loader.lastError());
         setStatusText("");
         return false;
     }
 
-    if (rootObj.value("version_format").toString() != CONFIG_FILE_FORMAT_VERSION) {
+    if (!loader.formatVersionMatches()) {
         auto reply = QMessageBox::question(
             this,
             "Incompatible configuration",
@@ -708,190 +713,34 @@ bool MainWindow::loadConfiguration(const QString &fileName)
         }
     }
 
+    const auto rootObj = loader.mainSettings();
     setDataExportBaseDir(rootObj.value("export_base_dir").toString());
     ui->expIdEdit->setText(rootObj.value("experiment_id").toString());
     ui->cbSimpleStorageNames->setChecked(rootObj.value("simple_storage_names", true).toBool());
 
-    // load list of subjects
+    // load lists of subjects and experimenters
     m_subjectList->clear();
-    auto subjectsFile = rootDir->file("subjects.toml");
-    if (subjectsFile != nullptr) {
-        // not having a list of subjects is totally fine
-
-        setStatusText("Loading subject information...");
-        const auto subjData = parseTomlData(subjectsFile->data(), parseError);
-        if (parseError.isEmpty())
-            m_subjectList->fromVariantHash(subjData);
-        else
-            qWarning().noquote() << "Unable to load test-subject data:" << parseError;
-    }
-
-    // load list of experimenters
+    m_subjectList->fromVariantHash(loader.subjects());
     m_experimenterList->clear();
     changeExperimenter(EDLAuthor());
-    auto experimentersFile = rootDir->file("experimenters.toml");
-    if (experimentersFile != nullptr) {
-        // not having a list of subjects is totally fine
-
-        setStatusText("Loading experimenter data...");
-        const auto peopleData = parseTomlData(experimentersFile->data(), parseError);
-        if (parseError.isEmpty())
-            m_experimenterList->fromVariantHash(peopleData);
-        else
-            qWarning().noquote() << "Unable to load experimenter data:" << parseError;
-    }
+    m_experimenterList->fromVariantHash(loader.experimenters());
     setExperimenterSelectVisible(!m_experimenterList->isEmpty());
 
     setStatusText("Destroying old modules...");
     m_engine->removeAllModules();
-    auto rootEntries = rootDir->entries();
-    rootEntries.sort();
-
-    // load graph settings
-    auto graphFile = rootDir->file("graph.toml");
-    if (graphFile != nullptr) {
-        setStatusText("Caching graph settings...");
-        const auto graphConfig = parseTomlData(graphFile->data(), parseError);
-        if (parseError.isEmpty()) {
-            // the graph view will apply stored settings to new nodes automatically
-            // from here on.
-            ui->graphForm->graphView()->setSettings(graphConfig);
-            ui->graphForm->graphView()->restoreState();
-        } else {
-            qWarning().noquote() << "Unable to parse graph configuration:" << parseError;
-        }
-    }
 
-    // we load the modules in two passes, to ensure they can all register
-    // their interdependencies correctly.
-    QList<QPair<AbstractModule *, QPair<QVariantHash, QByteArray>>> modSettingsList;
-    QList<QPair<AbstractModule *, QVariantHash>> modDisplayGeometryList;
-
-    // add modules
-    QList<QPair<AbstractModule *, QVariantHash>> jSubInfo;
-    for (auto &ename : rootEntries) {
-        auto e = rootDir->entry(ename);
-        if (!e->isDirectory())
-            continue;
-        auto ifile = rootDir->file(QStringLiteral("%1/info.toml").arg(ename));
-        if (ifile == nullptr)
-            continue;
-
-        auto iobj = parseTomlData(ifile->data(), parseError);
-        if (!parseError.isEmpty())
-            qWarning().noquote().nospace() << "Issue while loading module info: " << parseError;
-
-        const auto modId = iobj.value("id").toString();
-        const auto modName = iobj.value("name").toString();
-        const auto uiDisplayGeometry = iobj.value("ui_display_geometry").toHash();
-        const auto jSubs = iobj.value("subscriptions").toHash();
-
-        setStatusText(QStringLiteral("Instantiating module: %1(%2)").arg(modId, modName));
-        auto mod = m_engine->createModule(modId, modName);
-        if (mod == nullptr) {
-            QMessageBox::critical(
-                this,
-                QStringLiteral("Can not load settings"),
-                QStringLiteral("Unable to find module '%1' - please install the module first, then "
-                               "attempt to load this configuration again.")
-                    .arg(modId));
-            setStatusText("Failed to load settings.");
-
-            const auto reply = QMessageBox::question(
-                this,
-                QStringLiteral("Ignore missing module?"),
-                QStringLiteral("While installing thie missing module is the right solution to load this board, "
-                               "you can also enforce loading it. Please be aware that loading may fail. Load anyway?"),
-                QMessageBox::Yes | QMessageBox::No);
-            if (reply == QMessageBox::Yes) {
-                qWarning().noquote().nospace()
-                    << QStringLiteral("Module %1[%2] was missing, but trying to load board anyway.")
-                           .arg(modId, modName);
-                continue;
-            }
-            return false;
-        }
-        auto sfile = rootDir->file(QStringLiteral("%1/%2.toml").arg(ename).arg(modId));
-        QVariantHash modSettings;
-        if (sfile != nullptr) {
-            modSettings = parseTomlData(sfile->data(), parseError);
-            if (!parseError.isEmpty())
-                qWarning().noquote().nospace()
-                    << "Issue while loading module configuration for " << mod->name() << ": " << parseError;
-        }
-        sfile = rootDir->file(QStringLiteral("%1/%2.dat").arg(ename).arg(modId));
-        QByteArray modSettingsEx;
-        if (sfile != nullptr)
-            modSettingsEx = sfile->data();
-
-        // save display geometries - we apply them after settings have been loaded,
-        // as some modules do odd things in their settings loading phase which impact
-        // display UI geometry loading
-        if (!uiDisplayGeometry.isEmpty())
-            modDisplayGeometryList.append(qMakePair(mod, uiDisplayGeometry));
-
-        // store subscription info to connect modules later
-        jSubInfo.append(qMakePair(mod, jSubs));
-
-        // store module-owned configuration for later
-        modSettingsList.append(qMakePair(mod, qMakePair(modSettings, modSettingsEx)));
+    // the graph view will apply stored settings to new nodes automatically from here on
+    const auto graphConfig = loader.graphSettings();
+    if (!graphConfig.isEmpty()) {
+        ui->graphForm->graphView()->setSettings(graphConfig);
+        ui->graphForm->graphView()->restoreState();
     }
 
-    QDir confBaseDir(QString("%1/..").arg(fileName));
-
-    // load module-owned configurations
-    for (auto &pair : modSettingsList) {
-        const auto mod = pair.first;
-        const auto settings = pair.second;
-        setStatusText(QStringLiteral("Loading settings for module: %1(%2)").arg(mod->id()).arg(mod->name()));
-        if (!mod->loadSettings(confBaseDir.absolutePath(), settings.first, settings.second)) {
-            QMessageBox::critical(
-                this,
-                QStringLiteral("Can not load settings"),
-                QStringLiteral("Unable to load module settings for '%1'.").arg(mod->name()));
-            setStatusText("Failed to load settings.");
-            return false;
-        }
-    }
-
-    // apply module view geometries
-    for (auto &pair : modDisplayGeometryList)
-        pair.first->restoreDisplayUiGeometry(pair.second);
-
-    // create module connections
-    setStatusText("Restoring streams and subscriptions...");
-    for (auto &pair : jSubInfo) {
-        auto mod = pair.first;
-        const auto jSubs = pair.second;
-        for (const QString &iPortId : jSubs.keys()) {
-            const auto modPortPair = jSubs.value(iPortId).toList();
-            if (modPortPair.size() != 2) {
-                qWarning().noquote() << "Malformed project data: Invalid project port pair in" << mod->name()
-                                     << "settings.";
-                continue;
-            }
-            const auto srcModName = modPortPair[0].toString();
-            const auto srcModOutPortId = modPortPair[1].toString();
-            const auto srcMod = m_engine->moduleByName(srcModName);
-            if (srcMod == nullptr) {
-                qWarning().noquote() << "Error when loading project: Source module" << srcModName << "plugged into"
-                                     << iPortId << "of" << mod->name() << "was not found. Skipped connection.";
-                continue;
-            }
-            auto inPort = mod->inPortById(iPortId);
-            if (inPort.get() == nullptr) {
-                qWarning().noquote() << "Error when loading project: Module" << mod->name()
-                                     << "has no input port with ID" << iPortId;
-                continue;
-            }
-            auto outPort = srcMod->outPortById(srcModOutPortId);
-            if (outPort.get() == nullptr) {
-                qWarning().noquote() << "Error when loading project: Module" << srcMod->name()
-                                     << "has no output port with ID" << srcModOutPortId;
-                continue;
-            }
-            inPort->setSubscription(outPort.get(), outPort->subscribe());
-        }
+    // add modules, load their settings and connect them
+    if (!loader.loadModules()) {
+        QMessageBox::critical(this, QStringLiteral("Can not load settings"), loader.lastError());
+        setStatusText("Failed to load settings.");
+        return false;
     }
 
     // we are ready now
@@ -136,3 +136,28 @@ MemInfo read_meminfo()
 
     return m;
 }
+
+/**
+ * Read the resident set size of process @p pid in KiB.
+ * Returns -errno if the value could not be read, e.g. because the process has exited.
+ */
+long long read_process_rss_kib(pid_t pid)
+{
+    char path[64];
+    char buf[4096] = {0};
+
+    snprintf(path, sizeof(path), "/proc/%d/status", (int)pid);
+    FILE *fd = fopen(path, "r");
+    if (fd == NULL)
+        return -errno;
+
+    const size_t len = fread(buf, 1, sizeof(buf) - 1, fd);
+    const int read_errno = ferror(fd) ? errno : 0;
+    fclose(fd);
+    if (read_errno != 0)
+        return -read_errno;
+    if (len == 0)
+        return -ENODATA;
+
+    return get_entry("VmRSS:", buf);
+}
@@ -22,6 +22,8 @@
 
 #pragma once
 
+#include <sys/types.h>
+
 typedef struct {
     long long memTotalKiB;
     long long memAvailableMiB;
@@ -29,3 +31,5 @@ typedef struct {
 } MemInfo;
 
 MemInfo read_meminfo();
+
+long long read_process_rss_kib(pid_t pid);
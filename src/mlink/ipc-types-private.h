@@ -36,6 +36,17 @@ static const uint64_t SY_IOX_QUEUE_CAPACITY = 1U;
 // number of elements to keep for late connectors
 static const uint64_t SY_IOX_HISTORY_SIZE = 0U;
 
+// number of elements the master keeps for late connectors of streams it exports
+static const uint64_t SY_IOX_EXPORT_HISTORY_SIZE = 2U;
+
+// number of elements to hold in the IPC queue of ports with batch delivery,
+// as well as the maximum number of elements delivered in one batch
+static const uint64_t SY_IOX_BATCH_QUEUE_CAPACITY = 64U;
+
+// number of received chunks a subscriber may hold on to beyond its callback,
+// chunks come from a small shared mempool, so this must stay low
+static const uint32_t SY_IOX_RETAINED_CHUNKS_MAX = 3U;
+
 /**
  * @brief Action performed to modify a module port
  */
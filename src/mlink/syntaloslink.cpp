@@ -22,6 +22,8 @@
 #include <QDebug>
 #include <QBuffer>
 #include <QCoreApplication>
+#include <chrono>
+#include <mutex>
 #include <signal.h>
 #include <sys/prctl.h>
 #include <iceoryx_posh/runtime/posh_runtime.hpp>
@@ -33,6 +35,7 @@
 #include <iceoryx_hoofs/posix_wrapper/signal_watcher.hpp>
 #include <iceoryx_hoofs/log/logmanager.hpp>
 
+#include "datactl/framebufferpool.h"
 #include "ipc-types-private.h"
 #include "rtkit.h"
 #include "cpuaffinity.h"
@@ -72,6 +75,16 @@ std::unique_ptr<SyntalosLink> initSyntalosModuleLink()
     return std::unique_ptr<SyntalosLink>(new SyntalosLink(rtNameStr));
 }
 
+/**
+ * Subscriber of a connected input port. It is shared with the chunks handed
+ * out by InputPortInfo::retainCurrentData(), which may be dropped on any thread.
+ */
+struct PortSubscription {
+    std::mutex mutex;
+    std::unique_ptr<iox::popo::UntypedSubscriber> sub;
+    uint32_t retainedCount = 0;
+};
+
 /**
  * Reference for a module input port
  */
@@ -81,6 +94,7 @@ public:
     explicit Private(const InputPortChange &pc)
     {
         connected = false;
+        currentPayload = nullptr;
         id = pc.id;
         title = pc.title;
         dataTypeId = pc.dataTypeId;
@@ -89,7 +103,11 @@ public:
 
     int index;
     bool connected;
-    std::unique_ptr<iox::popo::UntypedSubscriber> ioxSub;
+    std::shared_ptr<PortSubscription> subscr;
+
+    // chunk currently passed to the data callback, and its retained reference
+    const void *currentPayload;
+    std::shared_ptr<const void> currentRetained;
 
     QString id;
     QString title;
@@ -97,6 +115,8 @@ public:
     QVariantHash metadata;
 
     NewDataRawFn newDataCb;
+    NewDataBatchRawFn newDataBatchCb;
+    std::vector<RawDataChunk> batch;
     uint throttleItemsPerSec;
 };
 
@@ -125,6 +145,34 @@ void InputPortInfo::setNewDataRawCallback(NewDataRawFn callback)
     d->newDataCb = std::move(callback);
 }
 
+void InputPortInfo::setNewDataBatchRawCallback(NewDataBatchRawFn callback)
+{
+    d->newDataBatchCb = std::move(callback);
+}
+
+std::shared_ptr<const void> InputPortInfo::retainCurrentData()
+{
+    if (d->currentPayload == nullptr)
+        return nullptr;
+    if (d->currentRetained)
+        return d->currentRetained;
+
+    auto subscr = d->subscr;
+    {
+        std::lock_guard<std::mutex> lock(subscr->mutex);
+        if (subscr->retainedCount >= SY_IOX_RETAINED_CHUNKS_MAX)
+            return nullptr;
+        subscr->retainedCount++;
+    }
+
+    d->currentRetained = std::shared_ptr<const void>(d->currentPayload, [subscr](const void *payload) {
+        std::lock_guard<std::mutex> lock(subscr->mutex);
+        subscr->sub->release(payload);
+        subscr->retainedCount--;
+    });
+    return d->currentRetained;
+}
+
 void InputPortInfo::setThrottleItemsPerSec(uint itemsPerSec)
 {
     d->throttleItemsPerSec = itemsPerSec;
@@ -277,12 +325,13 @@ public:
 
     std::unique_ptr<iox::popo::UntypedSubscriber> makeUntypedSubscriber(
         const iox::capro::IdString_t &instanceId,
-        const iox::capro::IdString_t &channelId)
+        const iox::capro::IdString_t &channelId,
+        uint64_t queueCapacity = SY_IOX_QUEUE_CAPACITY)
     {
         iox::popo::SubscriberOptions subOptn;
 
-        // number of elements held for processing by default
-        subOptn.queueCapacity = SY_IOX_QUEUE_CAPACITY;
+        // number of elements held for processing
+        subOptn.queueCapacity = queueCapacity;
 
         // number of samples to get if for whatever reason we connected too late
         subOptn.historyRequest = SY_IOX_HISTORY_SIZE;
@@ -328,6 +377,9 @@ public:
     std::vector<std::shared_ptr<OutputPortInfo>> outPortInfo;
     SyncTimer *syTimer;
 
+    int eventIntervalUsec;
+    std::chrono::steady_clock::time_point lastEventsTime;
+
     LoadScriptFn loadScriptCb;
     PrepareStartFn prepareStartCb;
     StartFn startCb;
@@ -340,6 +392,7 @@ SyntalosLink::SyntalosLink(const QString &instanceId, QObject *parent)
       d(new SyntalosLink::Private(instanceId))
 {
     d->syTimer = new SyncTimer;
+    d->eventIntervalUsec = 0;
 
     // immediately upon creation, we send a message that we are idle now
     setState(ModuleState::IDLE);
@@ -373,28 +426,43 @@ void SyntalosLink::awaitData(int timeoutUsec)
 {
     if (timeoutUsec < 0) {
         auto notificationVector = d->waitSet.wait();
-        for (auto &notification : notificationVector) {
+        for (auto &notification : notificationVector)
             processNotification(notification);
-            qApp->processEvents();
-        }
     } else {
         auto notificationVector = d->waitSet.timedWait(iox::units::Duration::fromMicroseconds(timeoutUsec));
-        for (auto &notification : notificationVector) {
+        for (auto &notification : notificationVector)
             processNotification(notification);
-            qApp->processEvents();
-        }
     }
+
+    processEventsIfDue();
 }
 
 void SyntalosLink::awaitDataForever()
 {
     while (!iox::posix::hasTerminationRequested()) {
         auto notificationVector = d->waitSet.wait();
-        for (auto &notification : notificationVector) {
+        for (auto &notification : notificationVector)
             processNotification(notification);
-            qApp->processEvents();
-        }
+
+        processEventsIfDue();
+    }
+}
+
+void SyntalosLink::setEventProcessingInterval(int intervalUsec)
+{
+    d->eventIntervalUsec = intervalUsec;
+}
+
+void SyntalosLink::processEventsIfDue()
+{
+    if (d->eventIntervalUsec > 0) {
+        const auto now = std::chrono::steady_clock::now();
+        if (now - d->lastEventsTime < std::chrono::microseconds(d->eventIntervalUsec))
+            return;
+        d->lastEventsTime = now;
     }
+
+    qApp->processEvents();
 }
 
 void SyntalosLink::processNotification(const iox::popo::NotificationInfo *notification)
@@ -566,7 +634,13 @@ void SyntalosLink::processNotification(const iox::popo::NotificationInfo *notifi
 
                     // connect the port
                     iport->d->connected = true;
-                    iport->d->ioxSub = d->makeUntypedSubscriber(request->instanceId, request->channelId);
+                    // chunks retained from a previous subscriber keep it alive until they are dropped
+                    iport->d->subscr = std::make_shared<PortSubscription>();
+                    // ports with batch delivery get a deeper queue, so there is something to batch
+                    iport->d->subscr->sub = d->makeUntypedSubscriber(
+                        request->instanceId,
+                        request->channelId,
+                        iport->d->newDataBatchCb ? SY_IOX_BATCH_QUEUE_CAPACITY : SY_IOX_QUEUE_CAPACITY);
 
                     response->success = true;
                     response.send().or_else([&](auto &error) {
@@ -685,6 +759,10 @@ void SyntalosLink::processNotification(const iox::popo::NotificationInfo *notifi
                     if (d->stopCb)
                         d->stopCb();
 
+                    // frames received during the run were copied into pooled buffers,
+                    // which we do not need to keep around until the next run
+                    FrameBufferPool::trimShared();
+
                     response->success = true;
                     response.send().or_else([&](auto &error) {
                         std::cerr << "Could not respond to Stop! Error: " << error << std::endl;
@@ -732,17 +810,61 @@ void SyntalosLink::processNotification(const iox::popo::NotificationInfo *notifi
         if (!iport->d->connected)
             continue;
 
-        iport->d->ioxSub->take()
+        const auto subscr = iport->d->subscr;
+        if (iport->d->newDataBatchCb) {
+            // drain everything that is queued, and hand it over in one go
+            auto &batch = iport->d->batch;
+            batch.clear();
+            {
+                std::lock_guard<std::mutex> lock(subscr->mutex);
+                while (batch.size() < SY_IOX_BATCH_QUEUE_CAPACITY) {
+                    const auto result = subscr->sub->take();
+                    if (result.has_error()) {
+                        if (result.get_error() != iox::popo::ChunkReceiveResult::NO_CHUNK_AVAILABLE)
+                            qWarning().noquote() << "Failed to receive new input data batch!";
+                        break;
+                    }
+
+                    const auto payload = result.value();
+                    const auto chunkHeader = iox::mepoo::ChunkHeader::fromUserPayload(payload);
+                    batch.push_back({payload, chunkHeader->usedSizeOfChunk()});
+                }
+            }
+            if (batch.empty())
+                continue;
+
+            iport->d->newDataBatchCb(batch);
+
+            // release memory chunks
+            std::lock_guard<std::mutex> lock(subscr->mutex);
+            for (const auto &chunk : batch)
+                subscr->sub->release(chunk.data);
+            batch.clear();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(subscr->mutex);
+        subscr->sub->take()
             .and_then([&](const void *payload) {
+                // the callback may retain the chunk, which needs the lock
+                lock.unlock();
+
                 const auto chunkHeader = iox::mepoo::ChunkHeader::fromUserPayload(payload);
                 const auto size = chunkHeader->usedSizeOfChunk();
 
                 // call raw data received callback
+                iport->d->currentPayload = payload;
                 if (iport->d->newDataCb)
                     iport->d->newDataCb(payload, size);
-
-                // release memory chunk
-                iport->d->ioxSub->release(payload);
+                iport->d->currentPayload = nullptr;
+
+                // release memory chunk, unless someone still holds on to it
+                if (iport->d->currentRetained) {
+                    iport->d->currentRetained.reset();
+                } else {
+                    lock.lock();
+                    subscr->sub->release(payload);
+                }
             })
             .or_else([](auto &result) {
                 if (result != iox::popo::ChunkReceiveResult::NO_CHUNK_AVAILABLE) {
@@ -978,4 +1100,28 @@ bool SyntalosLink::submitOutput(const std::shared_ptr<OutputPortInfo> &oport, co
     return true;
 }
 
+void *SyntalosLink::loanOutputMemory(const std::shared_ptr<OutputPortInfo> &oport, size_t size)
+{
+    void *memory = nullptr;
+    oport->d->ioxPub->loan(size)
+        .and_then([&](auto &payload) {
+            memory = payload;
+        })
+        .or_else([&](auto &error) {
+            std::cerr << "Unable to loan sample. Error: " << error << std::endl;
+        });
+
+    return memory;
+}
+
+void SyntalosLink::publishLoanedOutput(const std::shared_ptr<OutputPortInfo> &oport, void *payload)
+{
+    oport->d->ioxPub->publish(payload);
+}
+
+void SyntalosLink::releaseLoanedOutput(const std::shared_ptr<OutputPortInfo> &oport, void *payload)
+{
+    oport->d->ioxPub->release(payload);
+}
+
 } // namespace Syntalos
@@ -43,6 +43,15 @@ using StopFn = std::function<void()>;
 using ShutdownFn = std::function<void()>;
 using NewDataRawFn = std::function<void(const void *data, size_t size)>;
 
+/**
+ * @brief A received, still serialized data element
+ */
+struct RawDataChunk {
+    const void *data;
+    size_t size;
+};
+using NewDataBatchRawFn = std::function<void(const std::vector<RawDataChunk> &chunks)>;
+
 /**
  * @brief Reference for an input port
  */
@@ -60,6 +69,28 @@ public:
      * The data memory block passed to this function is only valid during the call.
      */
     void setNewDataRawCallback(NewDataRawFn callback);
+
+    /**
+     * @brief Keep the data passed to the running data callback alive beyond the call
+     *
+     * May only be called from within the data callback. The memory stays valid and
+     * unchanged until the returned pointer is dropped, which may happen on any thread.
+     * Only very few chunks can be held at a time, so nullptr is returned if the
+     * limit is reached - callers must copy the data in that case.
+     */
+    std::shared_ptr<const void> retainCurrentData();
+
+    /**
+     * @brief Sets a function to be called with all data that arrived since the last call
+     *
+     * If set, this function is used instead of the single-element callback, and all
+     * queued elements are delivered at once. The queue is deepened for this when the
+     * port is connected, so the callback should be set before that happens, and it should
+     * only be used for small, high-rate data. The memory blocks are only valid during the call.
+     */
+    void setNewDataBatchRawCallback(NewDataBatchRawFn callback);
+
+
     void setThrottleItemsPerSec(uint itemsPerSec);
 
 private:
@@ -125,6 +156,14 @@ public:
     void awaitData(int timeoutUsec = -1);
     void awaitDataForever();
 
+    /**
+     * @brief Limit how often the Qt event loop is run while waiting for data
+     *
+     * By default, events are processed every time we wake up to handle notifications.
+     * With a positive interval, they are processed at most once per interval.
+     */
+    void setEventProcessingInterval(int intervalUsec);
+
     ModuleState state() const;
     void setState(ModuleState state);
 
@@ -150,6 +189,16 @@ public:
 
     bool submitOutput(const std::shared_ptr<OutputPortInfo> &oport, const BaseDataType &data);
 
+    /**
+     * @brief Borrow shared memory of the given size to construct an output element in-place
+     *
+     * The memory must be passed to either publishLoanedOutput() or releaseLoanedOutput()
+     * exactly once. Returns nullptr if no memory could be loaned.
+     */
+    void *loanOutputMemory(const std::shared_ptr<OutputPortInfo> &oport, size_t size);
+    void publishLoanedOutput(const std::shared_ptr<OutputPortInfo> &oport, void *payload);
+    void releaseLoanedOutput(const std::shared_ptr<OutputPortInfo> &oport, void *payload);
+
 private:
     explicit SyntalosLink(const QString &instanceId, QObject *parent = nullptr);
     friend std::unique_ptr<SyntalosLink> initSyntalosModuleLink();
@@ -160,6 +209,7 @@ private:
     QScopedPointer<Private> d;
 
     void processNotification(const iox::popo::NotificationInfo *notification);
+    void processEventsIfDue();
 };
 
 std::unique_ptr<SyntalosLink> initSyntalosModuleLink();
@@ -255,7 +255,7 @@ void ModuleEventThread::moduleEventThreadFunc(QList<AbstractModule *> mods, Opti
     }
 
     // wait for us to start
-    waitCondition->wait();
+    waitCondition->wait(mods);
 
     // check if any module signals that it will actually not be doing anything
     // (if so, we don't need to call it and can maybe even terminate this thread)
@@ -0,0 +1,283 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "projectloader.h"
+
+#include <KTar>
+#include <QDebug>
+#include <QDir>
+
+#include "utils/tomlutils.h"
+
+using namespace Syntalos;
+
+ProjectLoader::ProjectLoader(Engine *engine)
+    : m_engine(engine)
+{
+}
+
+ProjectLoader::~ProjectLoader() {}
+
+void ProjectLoader::setStatusCallback(StatusFn callback)
+{
+    m_statusFn = std::move(callback);
+}
+
+void ProjectLoader::setMissingModuleCallback(MissingModuleFn callback)
+{
+    m_missingModuleFn = std::move(callback);
+}
+
+void ProjectLoader::setStatus(const QString &message)
+{
+    if (m_statusFn)
+        m_statusFn(message);
+}
+
+QVariantHash ProjectLoader::readOptionalToml(const QString &fileName, const QString &what)
+{
+    auto file = m_tar->directory()->file(fileName);
+    if (file == nullptr)
+        return QVariantHash();
+
+    QString parseError;
+    const auto data = parseTomlData(file->data(), parseError);
+    if (!parseError.isEmpty()) {
+        qWarning().noquote() << "Unable to load" << what << "data:" << parseError;
+        return QVariantHash();
+    }
+
+    return data;
+}
+
+/**
+ * Open a project file and read its global settings. Module data is only
+ * loaded by a following call to loadModules().
+ */
+bool ProjectLoader::open(const QString &fileName)
+{
+    m_fileName = fileName;
+    m_lastError.clear();
+    m_mainSettings.clear();
+    m_subjects.clear();
+    m_experimenters.clear();
+    m_graphSettings.clear();
+
+    m_tar.reset(new KTar(fileName));
+    if (!m_tar->open(QIODevice::ReadOnly)) {
+        m_lastError = QStringLiteral("Unable to open project file '%1' for reading.").arg(fileName);
+        return false;
+    }
+
+    auto globalSettingsFile = m_tar->directory()->file("main.toml");
+    if (globalSettingsFile == nullptr) {
+        m_lastError = QStringLiteral("The settings file is damaged or is no valid Syntalos configuration bundle.");
+        return false;
+    }
+
+    QString parseError;
+    m_mainSettings = parseTomlData(globalSettingsFile->data(), parseError);
+    if (!parseError.isEmpty()) {
+        m_lastError = QStringLiteral("The settings file is damaged or is no valid Syntalos configuration file. %1")
+                          .arg(parseError);
+        return false;
+    }
+
+    // not having any of these is totally fine
+    setStatus(QStringLiteral("Loading subject information..."));
+    m_subjects = readOptionalToml(QStringLiteral("subjects.toml"), QStringLiteral("test-subject"));
+    setStatus(QStringLiteral("Loading experimenter data..."));
+    m_experimenters = readOptionalToml(QStringLiteral("experimenters.toml"), QStringLiteral("experimenter"));
+    m_graphSettings = readOptionalToml(QStringLiteral("graph.toml"), QStringLiteral("graph configuration"));
+
+    return true;
+}
+
+/**
+ * Create all modules of the opened project in the engine, load their settings
+ * and connect them. Modules are added to the ones the engine already has,
+ * so callers usually remove all modules first.
+ */
+bool ProjectLoader::loadModules()
+{
+    if (!m_tar) {
+        m_lastError = QStringLiteral("No project file was opened.");
+        return false;
+    }
+
+    auto rootDir = m_tar->directory();
+    auto rootEntries = rootDir->entries();
+    rootEntries.sort();
+
+    // we load the modules in two passes, to ensure they can all register
+    // their interdependencies correctly.
+    QList<QPair<AbstractModule *, QPair<QVariantHash, QByteArray>>> modSettingsList;
+    QList<QPair<AbstractModule *, QVariantHash>> modDisplayGeometryList;
+
+    // add modules
+    QList<QPair<AbstractModule *, QVariantHash>> jSubInfo;
+    QString parseError;
+    for (auto &ename : rootEntries) {
+        auto e = rootDir->entry(ename);
+        if (!e->isDirectory())
+            continue;
+        auto ifile = rootDir->file(QStringLiteral("%1/info.toml").arg(ename));
+        if (ifile == nullptr)
+            continue;
+
+        auto iobj = parseTomlData(ifile->data(), parseError);
+        if (!parseError.isEmpty())
+            qWarning().noquote().nospace() << "Issue while loading module info: " << parseError;
+
+        const auto modId = iobj.value("id").toString();
+        const auto modName = iobj.value("name").toString();
+        const auto uiDisplayGeometry = iobj.value("ui_display_geometry").toHash();
+        const auto jSubs = iobj.value("subscriptions").toHash();
+
+        setStatus(QStringLiteral("Instantiating module: %1(%2)").arg(modId, modName));
+        auto mod = m_engine->createModule(modId, modName);
+        if (mod == nullptr) {
+            if (m_missingModuleFn && m_missingModuleFn(modId, modName)) {
+                qWarning().noquote().nospace()
+                    << QStringLiteral("Module %1[%2] was missing, but trying to load board anyway.")
+                           .arg(modId, modName);
+                continue;
+            }
+
+            m_lastError = QStringLiteral("Unable to find module '%1' - please install the module first, then "
+                                         "attempt to load this configuration again.")
+                              .arg(modId);
+            return false;
+        }
+        auto sfile = rootDir->file(QStringLiteral("%1/%2.toml").arg(ename).arg(modId));
+        QVariantHash modSettings;
+        if (sfile != nullptr) {
+            modSettings = parseTomlData(sfile->data(), parseError);
+            if (!parseError.isEmpty())
+                qWarning().noquote().nospace()
+                    << "Issue while loading module configuration for " << mod->name() << ": " << parseError;
+        }
+        sfile = rootDir->file(QStringLiteral("%1/%2.dat").arg(ename).arg(modId));
+        QByteArray modSettingsEx;
+        if (sfile != nullptr)
+            modSettingsEx = sfile->data();
+
+        // save display geometries - we apply them after settings have been loaded,
+        // as some modules do odd things in their settings loading phase which impact
+        // display UI geometry loading
+        if (!uiDisplayGeometry.isEmpty())
+            modDisplayGeometryList.append(qMakePair(mod, uiDisplayGeometry));
+
+        // store subscription info to connect modules later
+        jSubInfo.append(qMakePair(mod, jSubs));
+
+        // store module-owned configuration for later
+        modSettingsList.append(qMakePair(mod, qMakePair(modSettings, modSettingsEx)));
+    }
+
+    QDir confBaseDir(QString("%1/..").arg(m_fileName));
+
+    // load module-owned configurations
+    for (auto &pair : modSettingsList) {
+        const auto mod = pair.first;
+        const auto settings = pair.second;
+        setStatus(QStringLiteral("Loading settings for module: %1(%2)").arg(mod->id()).arg(mod->name()));
+        if (!mod->loadSettings(confBaseDir.absolutePath(), settings.first, settings.second)) {
+            m_lastError = QStringLiteral("Unable to load module settings for '%1'.").arg(mod->name());
+            return false;
+        }
+    }
+
+    // apply module view geometries
+    for (auto &pair : modDisplayGeometryList)
+        pair.first->restoreDisplayUiGeometry(pair.second);
+
+    // create module connections
+    setStatus(QStringLiteral("Restoring streams and subscriptions..."));
+    for (auto &pair : jSubInfo) {
+        auto mod = pair.first;
+        const auto jSubs = pair.second;
+        for (const QString &iPortId : jSubs.keys()) {
+            const auto modPortPair = jSubs.value(iPortId).toList();
+            if (modPortPair.size() != 2) {
+                qWarning().noquote() << "Malformed project data: Invalid project port pair in" << mod->name()
+                                     << "settings.";
+                continue;
+            }
+            const auto srcModName = modPortPair[0].toString();
+            const auto srcModOutPortId = modPortPair[1].toString();
+            const auto srcMod = m_engine->moduleByName(srcModName);
+            if (srcMod == nullptr) {
+                qWarning().noquote() << "Error when loading project: Source module" << srcModName << "plugged into"
+                                     << iPortId << "of" << mod->name() << "was not found. Skipped connection.";
+                continue;
+            }
+            auto inPort = mod->inPortById(iPortId);
+            if (inPort.get() == nullptr) {
+                qWarning().noquote() << "Error when loading project: Module" << mod->name()
+                                     << "has no input port with ID" << iPortId;
+                continue;
+            }
+            auto outPort = srcMod->outPortById(srcModOutPortId);
+            if (outPort.get() == nullptr) {
+                qWarning().noquote() << "Error when loading project: Module" << srcMod->name()
+                                     << "has no output port with ID" << srcModOutPortId;
+                continue;
+            }
+            inPort->setSubscription(outPort.get(), outPort->subscribe());
+        }
+    }
+
+    return true;
+}
+
+QString ProjectLoader::fileName() const
+{
+    return m_fileName;
+}
+
+QString ProjectLoader::lastError() const
+{
+    return m_lastError;
+}
+
+bool ProjectLoader::formatVersionMatches() const
+{
+    return m_mainSettings.value("version_format").toString() == CONFIG_FILE_FORMAT_VERSION;
+}
+
+QVariantHash ProjectLoader::mainSettings() const
+{
+    return m_mainSettings;
+}
+
+QVariantHash ProjectLoader::subjects() const
+{
+    return m_subjects;
+}
+
+QVariantHash ProjectLoader::experimenters() const
+{
+    return m_experimenters;
+}
+
+QVariantHash ProjectLoader::graphSettings() const
+{
+    return m_graphSettings;
+}
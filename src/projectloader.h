@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU Lesser General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <QString>
+#include <QVariantHash>
+#include <functional>
+#include <memory>
+
+#include "engine.h"
+
+class KTar;
+
+// config format API level
+static const QString CONFIG_FILE_FORMAT_VERSION = QStringLiteral("1");
+
+/**
+ * @brief Loads Syntalos project files into an engine
+ *
+ * Loading happens in two steps: open() reads the global project settings,
+ * which the caller can apply (or use to ask the user questions), then
+ * loadModules() creates all modules, loads their settings and restores
+ * their connections.
+ * The main window and the headless runner both use this, so projects are
+ * always interpreted the same way.
+ */
+class ProjectLoader
+{
+public:
+    using StatusFn = std::function<void(const QString &message)>;
+    using MissingModuleFn = std::function<bool(const QString &modId, const QString &modName)>;
+
+    explicit ProjectLoader(Syntalos::Engine *engine);
+    ~ProjectLoader();
+
+    /**
+     * Receive progress messages while loading.
+     */
+    void setStatusCallback(StatusFn callback);
+
+    /**
+     * Decide whether loading should continue if a module is not installed.
+     * Without a callback, a missing module is an error.
+     */
+    void setMissingModuleCallback(MissingModuleFn callback);
+
+    bool open(const QString &fileName);
+    bool loadModules();
+
+    QString fileName() const;
+    QString lastError() const;
+
+    bool formatVersionMatches() const;
+    QVariantHash mainSettings() const;
+    QVariantHash subjects() const;
+    QVariantHash experimenters() const;
+    QVariantHash graphSettings() const;
+
+private:
+    Q_DISABLE_COPY(ProjectLoader)
+
+    void setStatus(const QString &message);
+    QVariantHash readOptionalToml(const QString &fileName, const QString &what);
+
+    Syntalos::Engine *m_engine;
+    std::unique_ptr<KTar> m_tar;
+    QString m_fileName;
+    QString m_lastError;
+    StatusFn m_statusFn;
+    MissingModuleFn m_missingModuleFn;
+
+    QVariantHash m_mainSettings;
+    QVariantHash m_subjects;
+    QVariantHash m_experimenters;
+    QVariantHash m_graphSettings;
+};
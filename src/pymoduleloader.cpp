@@ -231,7 +231,16 @@ public:
             }
         }
 
+        GlobalConfig gconf;
+        setKeepProcessWarm(gconf.warmPythonWorkers());
+
         setInitialized();
+        if (keepProcessWarm()) {
+            // the worker keeps the environment it was launched with
+            setOutputCaptured(true);
+            setPythonVirtualEnv(virtualEnvDir());
+            warmUpProcess();
+        }
         return true;
     }
 
@@ -337,6 +346,7 @@ public:
     {
         auto mod = new PythonModule(parent);
         mod->setPythonInfo(m_pyFname, rootDir(), m_useVEnv);
+        mod->setPythonPreloadModules(m_preloadImports);
         mod->setupPorts(m_portDefInput, m_portDefOutput);
         return mod;
     }
@@ -349,6 +359,10 @@ public:
     {
         m_useVEnv = enabled;
     }
+    void setPreloadImports(const QStringList &imports)
+    {
+        m_preloadImports = imports;
+    }
     void setPortDef(const QVariantList &defInput, const QVariantList &defOutput)
     {
         m_portDefInput = defInput;
@@ -364,6 +378,7 @@ private:
 
     QString m_pyFname;
     bool m_useVEnv;
+    QStringList m_preloadImports;
 
     QVariantList m_portDefInput;
     QVariantList m_portDefOutput;
@@ -402,6 +417,7 @@ ModuleInfo *loadPythonModuleInfo(const QString &modId, const QString &modDir, co
     modInfo->setRootDir(modDir);
     modInfo->setMainPyScriptFname(pyFile);
     modInfo->setUseVEnv(useVEnv);
+    modInfo->setPreloadImports(modDef.value("preload_imports").toStringList());
 
     const auto portsDef = modData.value("ports").toHash();
     if (!portsDef.isEmpty())
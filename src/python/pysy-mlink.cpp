@@ -33,6 +33,7 @@
 #include <pybind11/stl.h>
 #include <pybind11/stl_bind.h>
 #include <pybind11/eigen.h>
+#include <pybind11/numpy.h>
 #include <stdexcept>
 
 #include <syntaloslink.h>
@@ -58,6 +59,7 @@ SyntalosLink *PyBridge::link()
 }
 
 using PyNewDataFn = std::function<void(const py::object &obj)>;
+using PyNewDataBatchFn = std::function<void(const py::object &batch)>;
 
 SyntalosPyError::SyntalosPyError(const char *what_arg)
     : std::runtime_error(what_arg){};
@@ -115,6 +117,12 @@ static void await_data(int timeout_usec)
     pb->link()->awaitData(timeout_usec);
 }
 
+static void set_event_processing_interval(int interval_usec)
+{
+    auto pb = PyBridge::instance();
+    pb->link()->setEventProcessingInterval(interval_usec);
+}
+
 static void schedule_delayed_call(int delay_msec, const std::function<void()> &fn)
 {
     if (delay_msec < 0)
@@ -124,6 +132,273 @@ static void schedule_delayed_call(int delay_msec, const std::function<void()> &f
     });
 }
 
+/**
+ * The pyvips module and the attributes we need from it, looked up once.
+ * They are intentionally leaked, so we never touch them during interpreter shutdown.
+ */
+struct PyVipsHandles {
+    py::object image;
+    py::object ffi;
+};
+
+static const PyVipsHandles &pyvips_handles()
+{
+    static const auto handles = []() {
+        auto pyvips = py::module_::import("pyvips");
+        return new PyVipsHandles{pyvips.attr("Image"), pyvips.attr("ffi")};
+    }();
+    return *handles;
+}
+
+static py::dtype vips_format_to_dtype(VipsBandFormat format)
+{
+    switch (format) {
+    case VIPS_FORMAT_UCHAR:
+        return py::dtype::of<uint8_t>();
+    case VIPS_FORMAT_CHAR:
+        return py::dtype::of<int8_t>();
+    case VIPS_FORMAT_USHORT:
+        return py::dtype::of<uint16_t>();
+    case VIPS_FORMAT_SHORT:
+        return py::dtype::of<int16_t>();
+    case VIPS_FORMAT_UINT:
+        return py::dtype::of<uint32_t>();
+    case VIPS_FORMAT_INT:
+        return py::dtype::of<int32_t>();
+    case VIPS_FORMAT_FLOAT:
+        return py::dtype::of<float>();
+    case VIPS_FORMAT_DOUBLE:
+        return py::dtype::of<double>();
+    default:
+        throw SyntalosPyError("This image band format can not be represented as NumPy array.");
+    }
+}
+
+static VipsBandFormat dtype_to_vips_format(const py::dtype &dtype)
+{
+    const auto kind = dtype.kind();
+    const auto size = dtype.itemsize();
+    if (kind == 'u') {
+        if (size == 1)
+            return VIPS_FORMAT_UCHAR;
+        if (size == 2)
+            return VIPS_FORMAT_USHORT;
+        if (size == 4)
+            return VIPS_FORMAT_UINT;
+    } else if (kind == 'i') {
+        if (size == 1)
+            return VIPS_FORMAT_CHAR;
+        if (size == 2)
+            return VIPS_FORMAT_SHORT;
+        if (size == 4)
+            return VIPS_FORMAT_INT;
+    } else if (kind == 'f') {
+        if (size == 4)
+            return VIPS_FORMAT_FLOAT;
+        if (size == 8)
+            return VIPS_FORMAT_DOUBLE;
+    }
+
+    throw SyntalosPyError("Unsupported array data type for frames.");
+}
+
+static void retainedChunkPostClose(VipsImage *, gpointer userData)
+{
+    delete static_cast<std::shared_ptr<const void> *>(userData);
+}
+
+static void pyObjectPostClose(VipsImage *, gpointer userData)
+{
+    // VIPS may drop the last image reference on any thread
+    py::gil_scoped_acquire gil;
+    delete static_cast<py::object *>(userData);
+}
+
+/**
+ * Create a frame from received data. If possible, the frame refers to the shared memory
+ * chunk directly, otherwise (if too many chunks are held already) its data is copied.
+ */
+static Frame frame_from_port_data(InputPortInfo *iport, const void *data, size_t size)
+{
+    auto chunk = iport->retainCurrentData();
+    if (!chunk) {
+        // the VIPS operation cache may still be holding on to images of previous frames
+        vips_cache_drop_all();
+        chunk = iport->retainCurrentData();
+    }
+    if (!chunk)
+        return Frame::fromMemory(data, size);
+
+    auto frame = Frame::viewFromMemory(data, size);
+
+    // keep the chunk for as long as VIPS uses the image
+    auto chunkRef = new std::shared_ptr<const void>(std::move(chunk));
+    g_signal_connect(frame.mat.get_image(), "postclose", G_CALLBACK(retainedChunkPostClose), chunkRef);
+
+    return frame;
+}
+
+static void image_array_layout(
+    int width,
+    int height,
+    int bands,
+    size_t elemSize,
+    std::vector<ssize_t> &shape,
+    std::vector<ssize_t> &strides)
+{
+    const auto esize = static_cast<ssize_t>(elemSize);
+    if (bands == 1) {
+        shape = {height, width};
+        strides = {width * esize, esize};
+    } else {
+        shape = {height, width, bands};
+        strides = {width * bands * esize, bands * esize, esize};
+    }
+}
+
+static py::array frame_get_array(const Frame &frame)
+{
+    // lazy images (e.g. with swapped channels) need to be evaluated once,
+    // for images which are in memory already this just adds a reference
+    auto img = new vips::VImage(frame.mat.copy_memory());
+    py::capsule owner(img, [](void *ptr) {
+        delete static_cast<vips::VImage *>(ptr);
+    });
+
+    std::vector<ssize_t> shape, strides;
+    image_array_layout(
+        img->width(), img->height(), img->bands(), VIPS_IMAGE_SIZEOF_ELEMENT(img->get_image()), shape, strides);
+    py::array array(vips_format_to_dtype(img->format()), shape, strides, img->data(), owner);
+
+    // the memory may be shared with other modules, so it must not be modified
+    array.attr("setflags")(py::arg("write") = false);
+    return array;
+}
+
+static void frame_set_array(Frame &frame, const py::array &value)
+{
+    // we can only refer to contiguous memory, anything else is copied once here
+    auto array = py::array::ensure(value, py::array::c_style);
+    if (!array)
+        throw SyntalosPyError("Unable to convert value to a contiguous array.");
+
+    int bands;
+    if (array.ndim() == 2)
+        bands = 1;
+    else if (array.ndim() == 3)
+        bands = static_cast<int>(array.shape(2));
+    else
+        throw SyntalosPyError(
+            "Frame arrays must have two (height, width) or three (height, width, channels) dimensions.");
+    const auto format = dtype_to_vips_format(array.dtype());
+
+    VipsImage *image = vips_image_new_from_memory(
+        array.data(),
+        array.nbytes(),
+        static_cast<int>(array.shape(1)),
+        static_cast<int>(array.shape(0)),
+        bands,
+        format);
+    if (image == nullptr)
+        throw SyntalosPyError("Unable to create image from array.");
+
+    // the image holds a reference on the array until VIPS is done with it
+    g_signal_connect(image, "postclose", G_CALLBACK(pyObjectPostClose), new py::object(array));
+    frame.mat = vips::VImage(image);
+}
+
+/**
+ * Shared memory loaned from an output port, returned to it unless it was published.
+ */
+struct OutputLoan {
+    SyntalosLink *link;
+    std::shared_ptr<OutputPortInfo> oport;
+    void *payload;
+    bool published;
+
+    ~OutputLoan()
+    {
+        if (!published)
+            link->releaseLoanedOutput(oport, payload);
+    }
+};
+
+/**
+ * A frame which is constructed directly in the shared memory of an output port.
+ */
+struct LoanedFrame {
+    std::shared_ptr<OutputLoan> loan;
+    py::object array;
+    bool submitted;
+
+    uint64_t index;
+    milliseconds_t time;
+    int width;
+    int height;
+    int channels;
+    VipsBandFormat format;
+
+    unsigned char *pixels() const
+    {
+        return static_cast<unsigned char *>(loan->payload) + Frame::HeaderSize;
+    }
+
+    size_t dataSize() const
+    {
+        return static_cast<size_t>(width) * height * channels * vips_format_sizeof_unsafe(format);
+    }
+
+    py::object get_array() const
+    {
+        if (submitted)
+            throw SyntalosPyError("This frame has already been submitted.");
+        return array;
+    }
+};
+
+/**
+ * Merge consecutive signal blocks into a single one, if they all have the same number of channels.
+ * Returns a list of the individual blocks otherwise.
+ */
+template<typename T>
+static py::object signal_blocks_to_py(const std::vector<RawDataChunk> &chunks)
+{
+    std::vector<T> blocks;
+    blocks.reserve(chunks.size());
+    Eigen::Index tsCount = 0;
+    Eigen::Index rowCount = 0;
+    bool stackable = true;
+    for (const auto &chunk : chunks) {
+        blocks.push_back(T::fromMemory(chunk.data, chunk.size));
+        const auto &block = blocks.back();
+        tsCount += block.timestamps.size();
+        rowCount += block.data.rows();
+        if (block.data.cols() != blocks.front().data.cols())
+            stackable = false;
+    }
+
+    if (!stackable) {
+        py::list list;
+        for (auto &block : blocks)
+            list.append(py::cast(std::move(block)));
+        return list;
+    }
+
+    T stacked(0, blocks.empty() ? 1 : blocks.front().data.cols());
+    stacked.timestamps.resize(tsCount);
+    stacked.data.resize(rowCount, stacked.data.cols());
+    Eigen::Index tsPos = 0;
+    Eigen::Index rowPos = 0;
+    for (const auto &block : blocks) {
+        stacked.timestamps.segment(tsPos, block.timestamps.size()) = block.timestamps;
+        stacked.data.middleRows(rowPos, block.data.rows()) = block.data;
+        tsPos += block.timestamps.size();
+        rowPos += block.data.rows();
+    }
+
+    return py::cast(std::move(stacked));
+}
+
 struct InputPort {
     InputPort(const std::shared_ptr<InputPortInfo> &iport)
         : _iport(iport)
@@ -141,35 +416,76 @@ struct InputPort {
         }
 
         _iport->setNewDataRawCallback([this](const void *data, size_t size) {
+            auto obj = _data_to_py(data, size);
+            if (obj)
+                _on_data_cb(obj);
+        });
+    }
+
+    PyNewDataFn get_on_data() const
+    {
+        return _on_data_cb;
+    }
+
+    void set_on_data_batch(const PyNewDataBatchFn &fn)
+    {
+        _on_data_batch_cb = fn;
+        if (!_on_data_batch_cb) {
+            _iport->setNewDataBatchRawCallback(nullptr);
+            return;
+        }
+
+        // frames are large and come from a small memory pool, we can not queue many of them
+        if (_dataTypeId == syDataTypeId<Frame>()) {
+            _on_data_batch_cb = nullptr;
+            throw SyntalosPyError("Batch delivery is not available for frames, use on_data instead.");
+        }
+
+        _iport->setNewDataBatchRawCallback([this](const std::vector<RawDataChunk> &chunks) {
             switch (_dataTypeId) {
-            case syDataTypeId<ControlCommand>():
-                _on_data_cb(py::cast(ControlCommand::fromMemory(data, size)));
-                break;
-            case syDataTypeId<TableRow>():
-                _on_data_cb(py::cast(TableRow::fromMemory(data, size)));
-                break;
-            case syDataTypeId<Frame>():
-                _on_data_cb(py::cast(Frame::fromMemory(data, size)));
-                break;
-            case syDataTypeId<FirmataControl>():
-                _on_data_cb(py::cast(FirmataControl::fromMemory(data, size)));
-                break;
-            case syDataTypeId<FirmataData>():
-                _on_data_cb(py::cast(FirmataData::fromMemory(data, size)));
-                break;
             case syDataTypeId<IntSignalBlock>():
-                _on_data_cb(py::cast(IntSignalBlock::fromMemory(data, size)));
+                _on_data_batch_cb(signal_blocks_to_py<IntSignalBlock>(chunks));
                 break;
             case syDataTypeId<FloatSignalBlock>():
-                _on_data_cb(py::cast(FloatSignalBlock::fromMemory(data, size)));
+                _on_data_batch_cb(signal_blocks_to_py<FloatSignalBlock>(chunks));
                 break;
+            default:
+                py::list list;
+                for (const auto &chunk : chunks) {
+                    auto obj = _data_to_py(chunk.data, chunk.size);
+                    if (obj)
+                        list.append(obj);
+                }
+                _on_data_batch_cb(list);
             }
         });
     }
 
-    PyNewDataFn get_on_data() const
+    PyNewDataBatchFn get_on_data_batch() const
     {
-        return _on_data_cb;
+        return _on_data_batch_cb;
+    }
+
+    py::object _data_to_py(const void *data, size_t size)
+    {
+        switch (_dataTypeId) {
+        case syDataTypeId<ControlCommand>():
+            return py::cast(ControlCommand::fromMemory(data, size));
+        case syDataTypeId<TableRow>():
+            return py::cast(TableRow::fromMemory(data, size));
+        case syDataTypeId<Frame>():
+            return py::cast(frame_from_port_data(_iport.get(), data, size));
+        case syDataTypeId<FirmataControl>():
+            return py::cast(FirmataControl::fromMemory(data, size));
+        case syDataTypeId<FirmataData>():
+            return py::cast(FirmataData::fromMemory(data, size));
+        case syDataTypeId<IntSignalBlock>():
+            return py::cast(IntSignalBlock::fromMemory(data, size));
+        case syDataTypeId<FloatSignalBlock>():
+            return py::cast(FloatSignalBlock::fromMemory(data, size));
+        default:
+            return py::object();
+        }
     }
 
     QVariantHash metadata() const
@@ -188,6 +504,7 @@ struct InputPort {
     int _dataTypeId;
     const std::shared_ptr<InputPortInfo> _iport;
     PyNewDataFn _on_data_cb;
+    PyNewDataBatchFn _on_data_batch_cb;
 };
 
 struct OutputPort {
@@ -198,29 +515,106 @@ struct OutputPort {
         _dataTypeId = _oport->dataTypeId();
     }
 
+    bool _submit_loaned_frame_private(LoanedFrame &lframe)
+    {
+        auto slink = PyBridge::instance()->link();
+        if (lframe.submitted)
+            throw SyntalosPyError("This frame has already been submitted.");
+        if (lframe.loan->oport != _oport)
+            throw SyntalosPyError("Loaned frames can only be submitted on the port they were loaned from.");
+
+        Frame::writeHeader(
+            lframe.loan->payload,
+            lframe.index,
+            lframe.time,
+            lframe.width,
+            lframe.height,
+            lframe.channels,
+            lframe.format);
+
+        // if nobody but us refers to the pixel data anymore, we can hand out the memory as-is
+        if (lframe.array.ref_count() == 1) {
+            lframe.array = py::none();
+            lframe.submitted = true;
+            lframe.loan->published = true;
+            slink->publishLoanedOutput(_oport, lframe.loan->payload);
+            return true;
+        }
+
+        // otherwise the data could still be modified after publication, so we need to
+        // publish a copy, and keep the original memory until all references to it are gone
+        const auto memSize = Frame::HeaderSize + lframe.dataSize();
+        auto payload = slink->loanOutputMemory(_oport, memSize);
+        if (payload == nullptr)
+            return false;
+        std::memcpy(payload, lframe.loan->payload, memSize);
+        slink->publishLoanedOutput(_oport, payload);
+
+        lframe.array = py::none();
+        lframe.submitted = true;
+        lframe.loan.reset();
+        return true;
+    }
+
     bool _submit_output_private(const py::object &pyObj)
     {
         auto slink = PyBridge::instance()->link();
         switch (_oport->dataTypeId()) {
         case syDataTypeId<ControlCommand>():
-            return slink->submitOutput(_oport, py::cast<ControlCommand>(pyObj));
+            return slink->submitOutput(_oport, py::cast<const ControlCommand &>(pyObj));
         case syDataTypeId<TableRow>():
             return slink->submitOutput(_oport, py::cast<TableRow>(pyObj));
         case syDataTypeId<Frame>():
-            return slink->submitOutput(_oport, py::cast<Frame>(pyObj));
+            if (py::isinstance<LoanedFrame>(pyObj))
+                return _submit_loaned_frame_private(py::cast<LoanedFrame &>(pyObj));
+            return slink->submitOutput(_oport, py::cast<const Frame &>(pyObj));
         case syDataTypeId<FirmataControl>():
-            return slink->submitOutput(_oport, py::cast<FirmataControl>(pyObj));
+            return slink->submitOutput(_oport, py::cast<const FirmataControl &>(pyObj));
         case syDataTypeId<FirmataData>():
-            return slink->submitOutput(_oport, py::cast<FirmataData>(pyObj));
+            return slink->submitOutput(_oport, py::cast<const FirmataData &>(pyObj));
         case syDataTypeId<IntSignalBlock>():
-            return slink->submitOutput(_oport, py::cast<IntSignalBlock>(pyObj));
+            return slink->submitOutput(_oport, py::cast<const IntSignalBlock &>(pyObj));
         case syDataTypeId<FloatSignalBlock>():
-            return slink->submitOutput(_oport, py::cast<FloatSignalBlock>(pyObj));
+            return slink->submitOutput(_oport, py::cast<const FloatSignalBlock &>(pyObj));
         default:
             return false;
         }
     }
 
+    LoanedFrame loan_frame(int width, int height, int channels, const py::object &dtype)
+    {
+        if (_dataTypeId != syDataTypeId<Frame>())
+            throw SyntalosPyError("Frames can only be loaned from ports which carry frames.");
+        if (width <= 0 || height <= 0 || channels <= 0)
+            throw SyntalosPyError("Frame dimensions must be positive.");
+
+        const auto npDtype = py::dtype::from_args(dtype);
+        LoanedFrame lframe;
+        lframe.submitted = false;
+        lframe.index = 0;
+        lframe.time = milliseconds_t(0);
+        lframe.width = width;
+        lframe.height = height;
+        lframe.channels = channels;
+        lframe.format = dtype_to_vips_format(npDtype);
+
+        auto slink = PyBridge::instance()->link();
+        auto payload = slink->loanOutputMemory(_oport, Frame::HeaderSize + lframe.dataSize());
+        if (payload == nullptr)
+            throw SyntalosPyError("Unable to loan memory for a new frame.");
+        lframe.loan = std::shared_ptr<OutputLoan>(new OutputLoan{slink, _oport, payload, false});
+
+        // the array keeps the loaned memory alive, even if the frame itself is gone
+        std::vector<ssize_t> shape, strides;
+        image_array_layout(width, height, channels, npDtype.itemsize(), shape, strides);
+        py::capsule owner(new std::shared_ptr<OutputLoan>(lframe.loan), [](void *ptr) {
+            delete static_cast<std::shared_ptr<OutputLoan> *>(ptr);
+        });
+        lframe.array = py::array(npDtype, shape, strides, lframe.pixels(), owner);
+
+        return lframe;
+    }
+
     void submit(const py::object &pyObj)
     {
         if (!_submit_output_private(pyObj))
@@ -388,16 +782,14 @@ static FirmataControl new_firmatactl_with_name(FirmataCommandKind kind, const st
 
 static py::object vips_image_to_py(const Frame &frame)
 {
-    auto pyvips = py::module_::import("pyvips");
-    auto PyVipsImage = pyvips.attr("Image");
-    auto ffi = pyvips.attr("ffi");
+    const auto &pyvips = pyvips_handles();
 
     // create a FFI pointer to our image
     auto py_ptr = py::cast(reinterpret_cast<uintptr_t>(g_object_ref(frame.mat.get_image())));
-    auto vimg_ffi_ptr = ffi.attr("cast")("VipsImage*", py_ptr);
+    auto vimg_ffi_ptr = pyvips.ffi.attr("cast")("VipsImage*", py_ptr);
 
     // construct our image
-    return PyVipsImage(vimg_ffi_ptr);
+    return pyvips.image(vimg_ffi_ptr);
 }
 
 static void vips_image_from_py(Frame &frame, const py::object &obj)
@@ -405,7 +797,7 @@ static void vips_image_from_py(Frame &frame, const py::object &obj)
     if (!hasattr(obj, "vobject"))
         throw SyntalosPyError("The passed instance is not a VIPS Image.");
 
-    auto ffi = py::module_::import("pyvips").attr("ffi");
+    const auto &ffi = pyvips_handles().ffi;
 
     // we need to persist the image into memory on the Python side, otherwise we will deadlock
     // with the PyVIPS integration when the memory copy happens at a later time in the C++ code.
@@ -447,6 +839,13 @@ PYBIND11_MODULE(syntalos_mlink, m)
             &InputPort::get_on_data,
             &InputPort::set_on_data,
             "Set function to be called when new data arrives.")
+        .def_property(
+            "on_data_batch",
+            &InputPort::get_on_data_batch,
+            &InputPort::set_on_data_batch,
+            "Set function to be called with all data that arrived since its last call, instead of calling on_data "
+            "for every element. Signal blocks are merged into a single block, other data is passed as list. "
+            "Set this before the run is started, and only use it for small, high-rate data.")
         .def_property_readonly("metadata", &InputPort::metadata, "Obtain the metadata associated with this input port.")
         .def(
             "set_throttle_items_per_sec",
@@ -460,6 +859,15 @@ PYBIND11_MODULE(syntalos_mlink, m)
             "submit",
             &OutputPort::submit,
             "Submit the given entity to the output port for transfer to its destination(s).")
+        .def(
+            "loan_frame",
+            &OutputPort::loan_frame,
+            py::arg("width"),
+            py::arg("height"),
+            py::arg("channels") = 1,
+            py::arg("dtype") = py::str("uint8"),
+            "Borrow memory for a new frame directly from this port. Write the image data to the frame's array and "
+            "submit it, to avoid any copy of the data.")
         .def_readonly("name", &OutputPort::_id)
         .def("set_metadata_value", &OutputPort::set_metadata_value, "Set (immutable) metadata value for this port.")
         .def(
@@ -499,7 +907,17 @@ PYBIND11_MODULE(syntalos_mlink, m)
         .def(py::init<>())
         .def_readwrite("index", &Frame::index, "Number of the frame.")
         .def_readwrite("time_msec", &Frame::time, "Time when the frame was recorded.")
-        .def_property("img", &vips_image_to_py, &vips_image_from_py, "Frame image data.");
+        .def_property("img", &vips_image_to_py, &vips_image_from_py, "Frame image data.")
+        .def_property(
+            "array",
+            &frame_get_array,
+            &frame_set_array,
+            "Frame image data as read-only NumPy array, without copying it. Color images are in RGB(A) order.");
+
+    py::class_<LoanedFrame>(m, "LoanedFrame", "A video frame whose data is written directly to shared memory.")
+        .def_readwrite("index", &LoanedFrame::index, "Number of the frame.")
+        .def_readwrite("time_msec", &LoanedFrame::time, "Time when the frame was recorded.")
+        .def_property_readonly("array", &LoanedFrame::get_array, "Writable NumPy array of the frame image data.");
 
     /**
      ** Control Command
@@ -558,15 +976,47 @@ PYBIND11_MODULE(syntalos_mlink, m)
 
     py::class_<IntSignalBlock>(m, "IntSignalBlock", "A block of timestamped integer signal data.")
         .def(py::init<>())
-        .def_readwrite("timestamps", &IntSignalBlock::timestamps, "Timestamps of the data blocks.")
-        .def_readwrite("data", &IntSignalBlock::data, "The data matrix.")
+        .def_property(
+            "timestamps",
+            [](IntSignalBlock &block) -> VectorXu & {
+                return block.timestamps;
+            },
+            [](IntSignalBlock &block, const VectorXu &value) {
+                block.timestamps = value;
+            },
+            "Timestamps of the data blocks.")
+        .def_property(
+            "data",
+            [](IntSignalBlock &block) -> MatrixXi & {
+                return block.data;
+            },
+            [](IntSignalBlock &block, const MatrixXi &value) {
+                block.data = value;
+            },
+            "The data matrix.")
         .def_property_readonly("length", &IntSignalBlock::length)
         .def_property_readonly("rows", &IntSignalBlock::rows)
         .def_property_readonly("cols", &IntSignalBlock::cols);
     py::class_<FloatSignalBlock>(m, "FloatSignalBlock", "A block of timestamped float signal data.")
         .def(py::init<>())
-        .def_readwrite("timestamps", &FloatSignalBlock::timestamps, "Timestamps of the data blocks.")
-        .def_readwrite("data", &FloatSignalBlock::data, "The data matrix.")
+        .def_property(
+            "timestamps",
+            [](FloatSignalBlock &block) -> VectorXu & {
+                return block.timestamps;
+            },
+            [](FloatSignalBlock &block, const VectorXu &value) {
+                block.timestamps = value;
+            },
+            "Timestamps of the data blocks.")
+        .def_property(
+            "data",
+            [](FloatSignalBlock &block) -> MatrixXd & {
+                return block.data;
+            },
+            [](FloatSignalBlock &block, const MatrixXd &value) {
+                block.data = value;
+            },
+            "The data matrix.")
         .def_property_readonly("length", &FloatSignalBlock::length)
         .def_property_readonly("rows", &FloatSignalBlock::rows)
         .def_property_readonly("cols", &FloatSignalBlock::cols);
@@ -603,6 +1053,12 @@ PYBIND11_MODULE(syntalos_mlink, m)
         "is_running",
         is_running,
         "Return True if the experiment is still running, False if we are supposed to shut down.");
+    m.def(
+        "set_event_processing_interval",
+        set_event_processing_interval,
+        py::arg("interval_usec"),
+        "Process internal events (e.g. delayed calls) at most once per interval while waiting for data, instead of "
+        "on every wakeup. Reduces overhead for high-rate data, at the cost of delayed calls being less precise.");
     m.def(
         "schedule_delayed_call",
         &schedule_delayed_call,
@@ -22,6 +22,7 @@
 #include "pyw-config.h"
 
 #include <QDir>
+#include <QElapsedTimer>
 #include <QCoreApplication>
 #include <iostream>
 #include <stdlib.h>
@@ -38,6 +39,8 @@ Q_LOGGING_CATEGORY(logPyWorker, "pyworker")
 PyWorker::PyWorker(SyntalosLink *slink, QObject *parent)
     : QObject(parent),
       m_link(slink),
+      m_pyInitialized(false),
+      m_pyMain(nullptr),
       m_running(false)
 {
     // set up callbacks
@@ -68,6 +71,14 @@ PyWorker::PyWorker(SyntalosLink *slink, QObject *parent)
     // switch to unbuffered mode so our parent receives Python output
     // (e.g. from print() & Co.) faster.
     setenv("PYTHONUNBUFFERED", "1", 1);
+
+    // we were launched ahead of time, so get the expensive imports out of the way now
+    const auto preloadModules = QString::fromUtf8(qgetenv("SYNTALOS_PY_PRELOAD")).split(',', Qt::SkipEmptyParts);
+    if (!preloadModules.isEmpty()) {
+        QTimer::singleShot(0, this, [this, preloadModules]() {
+            preloadPythonModules(preloadModules);
+        });
+    }
 }
 
 PyWorker::~PyWorker()
@@ -115,10 +126,10 @@ static void ensureModuleImportPaths()
         qPrintable(QStringLiteral("sys.path.insert(0, '%1')").arg(qApp->applicationDirPath().replace("'", "\\'"))));
 }
 
-bool PyWorker::loadPythonScript(const QString &script, const QString &wdir)
+bool PyWorker::initPython()
 {
-    if (!wdir.isEmpty())
-        QDir::setCurrent(wdir);
+    if (m_pyInitialized)
+        return true;
 
     PyConfig config;
     PyConfig_InitPythonConfig(&config);
@@ -155,6 +166,67 @@ bool PyWorker::loadPythonScript(const QString &script, const QString &wdir)
     // make sure we find the syntalos_mlink module even if it isn't installed yet
     ensureModuleImportPaths();
 
+    return true;
+}
+
+void PyWorker::preloadPythonModules(const QStringList &modules)
+{
+    if (!initPython())
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+    for (const auto &modName : modules) {
+        // failures are not fatal here, the script will report them properly if it needs the module
+        auto pyMod = PyImport_ImportModule(qPrintable(modName.trimmed()));
+        if (pyMod == nullptr) {
+            qCDebug(logPyWorker).noquote() << "Unable to preload Python module" << modName;
+            PyErr_Clear();
+            continue;
+        }
+        Py_DECREF(pyMod);
+    }
+
+    qCDebug(logPyWorker).noquote() << "Preloaded" << modules.join(", ") << "in" << timer.elapsed() << "msec";
+}
+
+/**
+ * Drop everything a previously loaded script has defined. Imported modules stay
+ * cached, which is what makes reusing a worker for another run fast.
+ */
+static void resetMainNamespace(PyObject *mainDict)
+{
+    PyDict_Clear(mainDict);
+
+    auto pyName = PyUnicode_FromString("__main__");
+    PyDict_SetItemString(mainDict, "__name__", pyName);
+    Py_DECREF(pyName);
+    PyDict_SetItemString(mainDict, "__builtins__", PyEval_GetBuiltins());
+}
+
+/**
+ * Forget everything the previous script registered with our link. The data callbacks
+ * reference the script's InputPort wrappers, which are freed once __main__ is cleared.
+ */
+void PyWorker::resetLinkState()
+{
+    for (const auto &iport : m_link->inputPorts()) {
+        iport->setNewDataRawCallback(nullptr);
+        iport->setNewDataBatchRawCallback(nullptr);
+    }
+    m_link->setEventProcessingInterval(0);
+}
+
+bool PyWorker::loadPythonScript(const QString &script, const QString &wdir)
+{
+    if (!wdir.isEmpty())
+        QDir::setCurrent(wdir);
+
+    // we may be reused for another run, in which case Python is already set up
+    const bool reused = m_pyInitialized;
+    if (!initPython())
+        return false;
+
     // pass our Syntalos link to the Python code
     {
         auto mlink_mod = py::module_::import("syntalos_mlink");
@@ -166,11 +238,15 @@ bool PyWorker::loadPythonScript(const QString &script, const QString &wdir)
     PyObject *mainModule = PyImport_AddModule("__main__");
     if (mainModule == nullptr) {
         raiseError("Can not execute Python code: No __main__ module.");
-
-        Py_Finalize();
         return false;
     }
     PyObject *mainDict = PyModule_GetDict(mainModule);
+    if (reused) {
+        resetLinkState();
+        resetMainNamespace(mainDict);
+        Py_XDECREF(m_pyMain);
+        m_pyMain = nullptr;
+    }
 
     // load script
     auto res = PyRun_String(qPrintable(script), Py_file_input, mainDict, mainDict);
@@ -333,16 +409,14 @@ void PyWorker::emitPyError()
     if (message.isEmpty())
         message = QStringLiteral("An unknown Python error occured.");
 
-    raiseError(QStringLiteral("Python:\n%1").arg(message));
-
     Py_XDECREF(excTraceback);
     Py_XDECREF(excType);
     Py_XDECREF(excValue);
 
-    if (m_pyInitialized) {
-        Py_Finalize();
-        m_pyInitialized = false;
-    }
+    // This terminates the worker. We never finalize and reuse the interpreter after an error,
+    // as extension modules like NumPy can not be initialized twice in the same process.
+    // A fresh worker is launched for the next run instead.
+    raiseError(QStringLiteral("Python:\n%1").arg(message));
 }
 
 #pragma GCC diagnostic push
@@ -48,6 +48,8 @@ public:
     void awaitData(int timeoutUsec = -1);
 
     void raiseError(const QString &message);
+    bool initPython();
+    void preloadPythonModules(const QStringList &modules);
     bool loadPythonScript(const QString &script, const QString &wdir);
 
     QByteArray changeSettings(const QByteArray &oldSettings);
@@ -72,5 +74,6 @@ private:
     bool m_running;
     QByteArray m_settings;
 
+    void resetLinkState();
     void emitPyError();
 };
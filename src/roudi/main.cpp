@@ -17,8 +17,14 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
 #include <signal.h>
+#include <string>
 #include <sys/prctl.h>
+#include <vector>
 
 #include <iceoryx_posh/iceoryx_posh_config.hpp>
 #include <iceoryx_posh/internal/log/posh_logging.hpp>
@@ -28,6 +34,43 @@
 static constexpr uint32_t ONE_KILOBYTE = 1024U;
 static constexpr uint32_t ONE_MEGABYTE = 1024U * 1024;
 
+/**
+ * Parse a mempool layout in "SIZE:COUNT,SIZE:COUNT,..." notation, as
+ * written by the Syntalos engine.
+ */
+static bool parseMemPoolLayout(const char *str, std::vector<iox::mepoo::MePooConfig::Entry> &pools)
+{
+    std::string layout(str);
+    size_t pos = 0;
+    while (pos < layout.size()) {
+        auto end = layout.find(',', pos);
+        if (end == std::string::npos)
+            end = layout.size();
+        const auto part = layout.substr(pos, end - pos);
+        pos = end + 1;
+
+        const auto sep = part.find(':');
+        if (sep == std::string::npos)
+            return false;
+
+        try {
+            const auto size = std::stoul(part.substr(0, sep));
+            const auto count = std::stoul(part.substr(sep + 1));
+            if (size == 0 || count == 0 || size > UINT32_MAX || count > UINT32_MAX)
+                return false;
+            pools.push_back({static_cast<uint32_t>(size), static_cast<uint32_t>(count)});
+        } catch (const std::exception &) {
+            return false;
+        }
+    }
+
+    // RouDi expects the pools to be ordered by increasing chunk size
+    std::sort(pools.begin(), pools.end(), [](const auto &a, const auto &b) {
+        return a.m_size < b.m_size;
+    });
+    return !pools.empty();
+}
+
 int main(int argc, char *argv[])
 {
     using iox::roudi::IceOryxRouDiApp;
@@ -47,15 +90,30 @@ int main(int argc, char *argv[])
     // tear down the daemon if our main process dies
     prctl(PR_SET_PDEATHSIG, SIGTERM);
 
+    // the engine may request a mempool layout matching the streams of its projects
+    std::vector<iox::mepoo::MePooConfig::Entry> pools;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "--mempools") != 0 || i + 1 >= argc)
+            continue;
+        if (!parseMemPoolLayout(argv[++i], pools)) {
+            std::cerr << "Invalid mempool layout: " << argv[i] << std::endl;
+            return 1;
+        }
+    }
+
     // set a default configuration that works for Syntalos
+    if (pools.empty()) {
+        pools.push_back({ONE_KILOBYTE, 50});
+        pools.push_back({ONE_KILOBYTE * 512, 50});
+        pools.push_back({ONE_MEGABYTE, 20});
+        pools.push_back({ONE_MEGABYTE * 6, 20});
+        pools.push_back({ONE_MEGABYTE * 24, 10});
+    }
+
     iox::RouDiConfig_t roudiConfig;
     iox::mepoo::MePooConfig mpConfig;
-
-    mpConfig.addMemPool({ONE_KILOBYTE, 50});
-    mpConfig.addMemPool({ONE_KILOBYTE * 512, 50});
-    mpConfig.addMemPool({ONE_MEGABYTE, 20});
-    mpConfig.addMemPool({ONE_MEGABYTE * 6, 20});
-    mpConfig.addMemPool({ONE_MEGABYTE * 24, 10});
+    for (const auto &pool : pools)
+        mpConfig.addMemPool(pool);
 
     /// use the Shared Memory Segment for the current user
     auto currentGroup = iox::posix::PosixGroup::getGroupOfCurrentProcess();
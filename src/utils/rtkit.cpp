@@ -38,6 +38,31 @@
 #ifndef RLIMIT_RTTIME
 #define RLIMIT_RTTIME 15
 #endif
+
+#ifndef SCHED_DEADLINE
+#define SCHED_DEADLINE 6
+#endif
+#ifndef SCHED_FLAG_RESET_ON_FORK
+#define SCHED_FLAG_RESET_ON_FORK 0x01
+#endif
+#ifndef SCHED_FLAG_RECLAIM
+#define SCHED_FLAG_RECLAIM 0x02
+#endif
+
+/**
+ * Scheduling attributes as used by the sched_setattr syscall,
+ * which has no wrapper in older C libraries.
+ */
+struct SchedAttrCompat {
+    uint32_t size;
+    uint32_t sched_policy;
+    uint64_t sched_flags;
+    int32_t sched_nice;
+    uint32_t sched_priority;
+    uint64_t sched_runtime;
+    uint64_t sched_deadline;
+    uint64_t sched_period;
+};
 static const auto RTKIT_SERVICE_NAME = QStringLiteral("org.freedesktop.RealtimeKit1");
 static const auto RTKIT_OBJECT_PATH = QStringLiteral("/org/freedesktop/RealtimeKit1");
 static const auto RTKIT_INTERFACE_NAME = QStringLiteral("org.freedesktop.RealtimeKit1");
@@ -94,8 +119,8 @@ bool RtKit::makeRealtime(pid_t thread, uint priority)
         struct sched_param sp = {};
         sp.sched_priority = priority;
 
-        if (pthread_setschedparam(pthread_self(), SCHED_OTHER | SCHED_RESET_ON_FORK, &sp) == 0) {
-            qCDebug(logRtKit).noquote() << "Realtime priority obtained via SCHED_OTHER | SCHED_RESET_ON_FORK directly";
+        if (pthread_setschedparam(pthread_self(), SCHED_FIFO | SCHED_RESET_ON_FORK, &sp) == 0) {
+            qCDebug(logRtKit).noquote() << "Realtime priority obtained via SCHED_FIFO | SCHED_RESET_ON_FORK directly";
             return true;
         }
         thread = gettid();
@@ -186,3 +211,30 @@ bool setCurrentThreadRealtime(int priority)
 
     return rtkit.makeRealtime(0, priority);
 }
+
+bool setCurrentThreadDeadline(uint64_t runtimeNs, uint64_t deadlineNs, uint64_t periodNs)
+{
+    SchedAttrCompat attr = {};
+    attr.size = sizeof(attr);
+    attr.sched_policy = SCHED_DEADLINE;
+    // deadline tasks may only spawn new threads if those do not inherit the policy, and we let
+    // them use idle CPU time beyond their runtime, so an occasional slow period does not stall them
+    attr.sched_flags = SCHED_FLAG_RESET_ON_FORK | SCHED_FLAG_RECLAIM;
+    attr.sched_runtime = runtimeNs;
+    attr.sched_deadline = deadlineNs;
+    attr.sched_period = periodNs;
+
+    // RtKit can not grant this policy, so we either have CAP_SYS_NICE or we can't use it at all
+    auto ret = syscall(SYS_sched_setattr, 0, &attr, 0);
+    if (ret != 0 && errno == EINVAL) {
+        // kernels older than 4.13 do not know about bandwidth reclaiming
+        attr.sched_flags = SCHED_FLAG_RESET_ON_FORK;
+        ret = syscall(SYS_sched_setattr, 0, &attr, 0);
+    }
+    if (ret != 0) {
+        qCDebug(logRtKit).noquote() << "Unable to set SCHED_DEADLINE policy:" << strerror(errno);
+        return false;
+    }
+
+    return true;
+}
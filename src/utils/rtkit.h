@@ -21,6 +21,7 @@
 
 #include <QLoggingCategory>
 #include <QObject>
+#include <cstdint>
 
 Q_DECLARE_LOGGING_CATEGORY(logRtKit)
 
@@ -50,3 +51,11 @@ private:
 
 bool setCurrentThreadNiceness(int nice);
 bool setCurrentThreadRealtime(int priority);
+
+/**
+ * Schedule the current thread with SCHED_DEADLINE, reserving @p runtimeNs of CPU time
+ * in every period of @p periodNs, which has to be used within @p deadlineNs.
+ * If the kernel supports it, the thread may use idle CPU time beyond its reserved runtime.
+ * The kernel only permits this if the thread may run on all CPUs.
+ */
+bool setCurrentThreadDeadline(uint64_t runtimeNs, uint64_t deadlineNs, uint64_t periodNs);
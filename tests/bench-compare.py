@@ -0,0 +1,84 @@
+#!/usr/bin/env python3
+#
+# Copyright (C) 2024 Matthias Klumpp <mak@debian.org>
+#
+# SPDX-License-Identifier: LGPL-3.0+
+
+"""
+Compare two JSON result files written by the Syntalos benchmarks
+(e.g. bench-streams --json results.json or bench-framepool) and report regressions.
+"""
+
+import sys
+import json
+import argparse
+
+# metric name, JSON path, True if larger values are better
+METRICS = [
+    ('items/s', ('items_per_sec',), True),
+    ('p50', ('latency_usec', 'p50'), False),
+    ('p99', ('latency_usec', 'p99'), False),
+    ('p999', ('latency_usec', 'p999'), False),
+    ('allocs', ('allocs_per_item',), False),
+    ('faults', ('faults_per_item',), False),
+]
+
+
+def load_results(fname):
+    with open(fname, 'r', encoding='utf-8') as f:
+        data = json.load(f)
+    return {r['name']: r for r in data.get('results', [])}
+
+
+def metric_value(result, path):
+    value = result
+    for key in path:
+        value = value.get(key) if isinstance(value, dict) else None
+    return value
+
+
+def main():
+    parser = argparse.ArgumentParser(description='Compare Syntalos benchmark results.')
+    parser.add_argument('baseline', help='JSON results of the baseline build')
+    parser.add_argument('current', help='JSON results of the build to check')
+    parser.add_argument(
+        '--threshold',
+        type=float,
+        default=10.0,
+        help='Report changes for the worse larger than this percentage as regression (default: 10)',
+    )
+    args = parser.parse_args()
+
+    baseline = load_results(args.baseline)
+    current = load_results(args.current)
+
+    regressions = []
+    print('{:<28} {:>8} {:>14} {:>14} {:>9}'.format('scenario', 'metric', 'baseline', 'current', 'change'))
+    for name in sorted(set(baseline) & set(current)):
+        for label, path, higher_is_better in METRICS:
+            old = metric_value(baseline[name], path)
+            new = metric_value(current[name], path)
+            if old is None or new is None or old < 0 or new < 0:
+                continue
+
+            change = ((new - old) / old * 100.0) if old != 0 else 0.0
+            worse = -change if higher_is_better else change
+            marker = ''
+            if worse > args.threshold:
+                marker = '  !'
+                regressions.append((name, label, change))
+            print('{:<28} {:>8} {:>14.2f} {:>14.2f} {:>+8.1f}%{}'.format(name, label, old, new, change, marker))
+
+    for name in sorted(set(baseline) ^ set(current)):
+        print('{:<28} only present in {}'.format(name, 'baseline' if name in baseline else 'current'))
+
+    if regressions:
+        print('\n{} regression(s) above {:.0f}%:'.format(len(regressions), args.threshold))
+        for name, label, change in regressions:
+            print('  {} {}: {:+.1f}%'.format(name, label, change))
+        return 1
+    return 0
+
+
+if __name__ == '__main__':
+    sys.exit(main())
@@ -0,0 +1,237 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include <iostream>
+#include <sys/resource.h>
+
+#include "datactl/framebufferpool.h"
+
+/*
+ * Frame buffer pool benchmark
+ *
+ * Simulates a camera producing frames into new images, with a consumer that reads every
+ * frame while a few of them are still in flight (e.g. queued for a video writer).
+ * Frame memory is either freshly allocated for every frame by libvips, or taken from
+ * a frame buffer pool with regular or huge pages. For each variant, the frame rate and
+ * the number of minor page faults per frame are reported.
+ */
+
+using namespace Syntalos;
+using bench_clock = std::chrono::steady_clock;
+
+enum class Strategy {
+    VIPS_COPY, /// a new VIPS image for every frame
+    POOL,      /// pooled buffers with regular pages
+    POOL_HUGE  /// pooled buffers with transparent huge pages
+};
+
+struct Scenario {
+    Strategy strategy;
+    int width;
+    int height;
+    int bands;
+
+    size_t frameSize() const
+    {
+        return static_cast<size_t>(width) * height * bands;
+    }
+
+    QString name() const
+    {
+        return QStringLiteral("%1/%2x%3x%4")
+            .arg(strategyName(strategy), QString::number(width), QString::number(height), QString::number(bands));
+    }
+
+    static QString strategyName(Strategy strategy)
+    {
+        switch (strategy) {
+        case Strategy::VIPS_COPY:
+            return QStringLiteral("vipscopy");
+        case Strategy::POOL:
+            return QStringLiteral("pool");
+        case Strategy::POOL_HUGE:
+            return QStringLiteral("pool-huge");
+        }
+        return QStringLiteral("unknown");
+    }
+};
+
+struct ScenarioResult {
+    Scenario scenario;
+    size_t frames;
+    double durationSec;
+    double framesPerSec;
+    double faultsPerFrame;
+};
+
+// keeps the compiler from optimizing away reading the frames
+static volatile uint64_t g_checksumSink = 0;
+
+static long minorFaults()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_minflt;
+}
+
+/**
+ * Read every cache line of an image, like a consumer looking at all pixels would.
+ */
+static uint64_t consumeImage(const vips::VImage &image, size_t size)
+{
+    const auto data = static_cast<const uint8_t *>(image.data());
+    uint64_t sum = 0;
+    for (size_t i = 0; i < size; i += 64)
+        sum += data[i];
+    return sum;
+}
+
+static ScenarioResult runScenario(const Scenario &scenario, size_t frames, size_t window)
+{
+    const auto frameSize = scenario.frameSize();
+    std::vector<uint8_t> source(frameSize);
+    for (size_t i = 0; i < frameSize; i++)
+        source[i] = i % 251;
+
+    std::shared_ptr<FrameBufferPool> pool;
+    if (scenario.strategy != Strategy::VIPS_COPY)
+        pool = std::make_shared<FrameBufferPool>(frameSize, window + 1, scenario.strategy == Strategy::POOL_HUGE);
+
+    ScenarioResult res;
+    res.scenario = scenario;
+    res.frames = frames;
+
+    // images in flight, the oldest one is dropped once the window is full
+    std::deque<vips::VImage> inFlight;
+
+    const auto faultsStart = minorFaults();
+    const auto timeStart = bench_clock::now();
+    for (size_t i = 0; i < frames; i++) {
+        vips::VImage image;
+        if (pool) {
+            image = pool->copyImage(source.data(), scenario.width, scenario.height, scenario.bands, VIPS_FORMAT_UCHAR);
+        } else {
+            image = vips::VImage::new_from_memory_copy(
+                source.data(), frameSize, scenario.width, scenario.height, scenario.bands, VIPS_FORMAT_UCHAR);
+        }
+
+        g_checksumSink = g_checksumSink + consumeImage(image, frameSize);
+        inFlight.push_back(image);
+        if (inFlight.size() > window)
+            inFlight.pop_front();
+    }
+    inFlight.clear();
+
+    res.durationSec = std::chrono::duration<double>(bench_clock::now() - timeStart).count();
+    res.framesPerSec = res.durationSec > 0 ? frames / res.durationSec : 0;
+    res.faultsPerFrame = static_cast<double>(minorFaults() - faultsStart) / frames;
+
+    return res;
+}
+
+static QJsonObject resultToJson(const ScenarioResult &res)
+{
+    QJsonObject obj;
+    obj.insert("name", res.scenario.name());
+    obj.insert("strategy", Scenario::strategyName(res.scenario.strategy));
+    obj.insert("frame_bytes", static_cast<qint64>(res.scenario.frameSize()));
+    obj.insert("items", static_cast<qint64>(res.frames));
+    obj.insert("duration_sec", res.durationSec);
+    obj.insert("items_per_sec", res.framesPerSec);
+    obj.insert("faults_per_item", res.faultsPerFrame);
+    return obj;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    if (VIPS_INIT(argv[0]) != 0) {
+        std::cerr << "Unable to initialize VIPS" << std::endl;
+        return 1;
+    }
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmark for the Syntalos frame buffer pool");
+    parser.addHelpOption();
+    QCommandLineOption jsonOption("json", "Write results as JSON to <file>.", "file");
+    QCommandLineOption framesOption("frames", "Number of frames to produce per scenario.", "count", "2000");
+    QCommandLineOption windowOption("window", "Number of frames held by consumers at the same time.", "count", "8");
+    QCommandLineOption filterOption("filter", "Only run scenarios whose name contains <text>.", "text");
+    parser.addOption(jsonOption);
+    parser.addOption(framesOption);
+    parser.addOption(windowOption);
+    parser.addOption(filterOption);
+    parser.process(app);
+
+    const size_t frames = std::max(1ULL, parser.value(framesOption).toULongLong());
+    const size_t window = std::max(1ULL, parser.value(windowOption).toULongLong());
+
+    std::vector<Scenario> scenarios;
+    for (const auto strategy : {Strategy::VIPS_COPY, Strategy::POOL, Strategy::POOL_HUGE}) {
+        scenarios.push_back({strategy, 640, 480, 1});
+        scenarios.push_back({strategy, 1920, 1080, 3});
+        scenarios.push_back({strategy, 4096, 3000, 1});
+    }
+
+    QJsonArray jsonResults;
+    printf("%-28s %12s %12s %12s\n", "scenario", "frames/s", "GiB/s", "faults/frame");
+    for (const auto &scenario : scenarios) {
+        if (parser.isSet(filterOption) && !scenario.name().contains(parser.value(filterOption)))
+            continue;
+
+        const auto res = runScenario(scenario, frames, window);
+        printf(
+            "%-28s %12.0f %12.2f %12.2f\n",
+            qPrintable(scenario.name()),
+            res.framesPerSec,
+            res.framesPerSec * scenario.frameSize() / (1024.0 * 1024.0 * 1024.0),
+            res.faultsPerFrame);
+        fflush(stdout);
+        jsonResults.append(resultToJson(res));
+    }
+
+    if (parser.isSet(jsonOption)) {
+        QJsonObject root;
+        root.insert("benchmark", "framepool");
+        root.insert("version", 1);
+        root.insert("cpu_arch", QSysInfo::currentCpuArchitecture());
+        root.insert("frames", static_cast<qint64>(frames));
+        root.insert("window", static_cast<qint64>(window));
+        root.insert("results", jsonResults);
+
+        QFile file(parser.value(jsonOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            std::cerr << "Unable to write results to " << qPrintable(file.fileName()) << std::endl;
+            return 1;
+        }
+        file.write(QJsonDocument(root).toJson());
+    }
+
+    return 0;
+}
@@ -0,0 +1,484 @@
+/*
+ * Copyright (C) 2024 Matthias Klumpp <matthias@tenstral.net>
+ *
+ * Licensed under the GNU General Public License Version 3
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the license, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QFile>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QSysInfo>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "datactl/frametype.h"
+#include "streams/stream.h"
+
+/*
+ * Stream fabric benchmark
+ *
+ * Connects a producer to a number of consumers, either directly or through a transformer,
+ * and pushes elements through the streams as fast as the consumers can take them.
+ * The producer keeps at most a fixed number of elements in flight, so queues do not grow
+ * without bounds and latencies stay meaningful.
+ *
+ * Results can be written as JSON, and be compared between builds with bench-compare.py.
+ */
+
+#if defined(__SANITIZE_ADDRESS__)
+#define BENCH_COUNT_ALLOCS 0
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer)
+#define BENCH_COUNT_ALLOCS 0
+#endif
+#endif
+#if !defined(BENCH_COUNT_ALLOCS) && defined(__GLIBC__)
+#define BENCH_COUNT_ALLOCS 1
+#endif
+
+// number of heap allocations of the whole process, only its difference over a run is meaningful
+static std::atomic<uint64_t> g_allocCount{0};
+
+#if BENCH_COUNT_ALLOCS
+// interpose the C allocator, so we also see allocations of Qt, Eigen and VIPS
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t nmemb, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void __libc_free(void *ptr);
+
+void *malloc(size_t size)
+{
+    g_allocCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t nmemb, size_t size)
+{
+    g_allocCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(nmemb, size);
+}
+
+void *realloc(void *ptr, size_t size)
+{
+    g_allocCount.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr)
+{
+    __libc_free(ptr);
+}
+}
+#endif
+
+using bench_clock = std::chrono::steady_clock;
+
+enum class Topology {
+    DIRECT,   /// producer -> consumers
+    TRANSFORM /// producer -> transformer -> consumers
+};
+
+enum class Payload {
+    FRAME,
+    INT_SIGNAL,
+    FLOAT_SIGNAL,
+    TABLE_ROW
+};
+
+struct Scenario {
+    Topology topology;
+    Payload payload;
+    int subscribers;
+
+    QString name() const
+    {
+        return QStringLiteral("%1/%2/%3sub")
+            .arg(topologyName(topology), payloadName(payload), QString::number(subscribers));
+    }
+
+    static QString topologyName(Topology topology)
+    {
+        return topology == Topology::DIRECT ? QStringLiteral("direct") : QStringLiteral("transform");
+    }
+
+    static QString payloadName(Payload payload)
+    {
+        switch (payload) {
+        case Payload::FRAME:
+            return QStringLiteral("frame");
+        case Payload::INT_SIGNAL:
+            return QStringLiteral("intsignal");
+        case Payload::FLOAT_SIGNAL:
+            return QStringLiteral("floatsignal");
+        case Payload::TABLE_ROW:
+            return QStringLiteral("tablerow");
+        }
+        return QStringLiteral("unknown");
+    }
+};
+
+struct ScenarioResult {
+    Scenario scenario;
+    size_t items;
+    double durationSec;
+    double itemsPerSec;
+    double latencyP50Usec;
+    double latencyP99Usec;
+    double latencyP999Usec;
+    double allocsPerItem;
+};
+
+/**
+ * Shared state of one benchmark run.
+ */
+struct RunState {
+    size_t items;
+    size_t window;
+
+    // push time of every element, written by the producer before pushing it
+    std::vector<int64_t> pushTimeNs;
+
+    // number of elements each consumer has received so far
+    std::vector<std::atomic<size_t>> received;
+
+    // push-to-receive latencies, one preallocated vector per consumer
+    std::vector<std::vector<int64_t>> latencies;
+
+    RunState(size_t itemCount, size_t windowSize, int consumers)
+        : items(itemCount),
+          window(windowSize),
+          pushTimeNs(itemCount, 0),
+          received(consumers),
+          latencies(consumers)
+    {
+        for (auto &r : received)
+            r = 0;
+        for (auto &l : latencies)
+            l.reserve(itemCount);
+    }
+
+    size_t minReceived() const
+    {
+        size_t min = items;
+        for (const auto &r : received)
+            min = std::min(min, r.load(std::memory_order_acquire));
+        return min;
+    }
+};
+
+static int64_t nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(bench_clock::now().time_since_epoch()).count();
+}
+
+/*
+ * Payload construction and identification. The element index is stored
+ * in each payload, so consumers can look up its push time.
+ */
+
+template<typename T>
+struct PayloadTraits;
+
+template<>
+struct PayloadTraits<Frame> {
+    static vips::VImage &image()
+    {
+        static vips::VImage img = vips::VImage::black(640, 480, vips::VImage::option()->set("bands", 3))
+                                      .cast(VIPS_FORMAT_UCHAR)
+                                      .copy_memory();
+        return img;
+    }
+
+    static Frame make(size_t index)
+    {
+        return Frame(image(), index, milliseconds_t(0));
+    }
+
+    static size_t indexOf(const Frame &frame)
+    {
+        return frame.index;
+    }
+};
+
+template<typename T>
+struct SignalPayloadTraits {
+    static T make(size_t index)
+    {
+        T block(60, 16);
+        block.timestamps.setConstant(static_cast<quint32>(index));
+        block.data.setConstant(1);
+        return block;
+    }
+
+    static size_t indexOf(const T &block)
+    {
+        return block.timestamps[0];
+    }
+};
+
+template<>
+struct PayloadTraits<IntSignalBlock> : SignalPayloadTraits<IntSignalBlock> {
+};
+
+template<>
+struct PayloadTraits<FloatSignalBlock> : SignalPayloadTraits<FloatSignalBlock> {
+};
+
+template<>
+struct PayloadTraits<TableRow> {
+    static TableRow make(size_t index)
+    {
+        TableRow row;
+        row.reserve(5);
+        row.append(QString::number(index));
+        row.append(QStringLiteral("event"));
+        row.append(QStringLiteral("left"));
+        row.append(QStringLiteral("42.5"));
+        row.append(QStringLiteral("ok"));
+        return row;
+    }
+
+    static size_t indexOf(const TableRow &row)
+    {
+        return row.data.first().toULongLong();
+    }
+};
+
+template<typename T>
+static void producer(RunState *state, DataStream<T> *stream)
+{
+    for (size_t i = 0; i < state->items; i++) {
+        // don't run away from the slowest consumer
+        while (i - state->minReceived() >= state->window)
+            std::this_thread::yield();
+
+        auto data = PayloadTraits<T>::make(i);
+        state->pushTimeNs[i] = nowNs();
+        stream->push(data);
+    }
+}
+
+template<typename T>
+static void transformer(StreamSubscription<T> *sub, DataStream<T> *outStream)
+{
+    while (true) {
+        auto data = sub->next();
+        if (!data.has_value())
+            break;
+        outStream->push(data.value());
+    }
+}
+
+template<typename T>
+static void consumer(RunState *state, int consumerIdx, StreamSubscription<T> *sub)
+{
+    auto &latencies = state->latencies[consumerIdx];
+    auto &received = state->received[consumerIdx];
+    while (received.load(std::memory_order_relaxed) < state->items) {
+        auto data = sub->next();
+        if (!data.has_value())
+            break;
+
+        const auto index = PayloadTraits<T>::indexOf(data.value());
+        latencies.push_back(nowNs() - state->pushTimeNs[index]);
+        received.fetch_add(1, std::memory_order_release);
+    }
+}
+
+static double percentileUsec(std::vector<int64_t> &sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+    const auto idx = std::min(sorted.size() - 1, static_cast<size_t>(p * sorted.size()));
+    return sorted[idx] / 1000.0;
+}
+
+template<typename T>
+static ScenarioResult runScenario(const Scenario &scenario, size_t items, size_t window)
+{
+    RunState state(items, window, scenario.subscribers);
+
+    auto prodStream = std::make_shared<DataStream<T>>();
+    auto transStream = std::make_shared<DataStream<T>>();
+    auto consumerSource = scenario.topology == Topology::DIRECT ? prodStream : transStream;
+
+    std::shared_ptr<StreamSubscription<T>> transSub;
+    if (scenario.topology == Topology::TRANSFORM)
+        transSub = prodStream->subscribe();
+    std::vector<std::shared_ptr<StreamSubscription<T>>> subs;
+    for (int i = 0; i < scenario.subscribers; i++)
+        subs.push_back(consumerSource->subscribe());
+
+    prodStream->start();
+    transStream->start();
+
+    // warm up lazily initialized state, like the frame image
+    PayloadTraits<T>::make(0);
+
+    const auto allocsStart = g_allocCount.load();
+    const auto timeStart = bench_clock::now();
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < scenario.subscribers; i++)
+        threads.emplace_back(consumer<T>, &state, i, subs[i].get());
+    if (transSub)
+        threads.emplace_back(transformer<T>, transSub.get(), transStream.get());
+    producer<T>(&state, prodStream.get());
+
+    // consumers finish once they have seen every element, the transformer once its input ends
+    for (size_t i = 0; i < static_cast<size_t>(scenario.subscribers); i++)
+        threads[i].join();
+    const auto timeEnd = bench_clock::now();
+    const auto allocsEnd = g_allocCount.load();
+
+    prodStream->terminate();
+    for (auto &t : threads) {
+        if (t.joinable())
+            t.join();
+    }
+    transStream->terminate();
+
+    std::vector<int64_t> allLatencies;
+    allLatencies.reserve(items * scenario.subscribers);
+    for (const auto &l : state.latencies)
+        allLatencies.insert(allLatencies.end(), l.begin(), l.end());
+    std::sort(allLatencies.begin(), allLatencies.end());
+
+    ScenarioResult res;
+    res.scenario = scenario;
+    res.items = items;
+    res.durationSec = std::chrono::duration<double>(timeEnd - timeStart).count();
+    res.itemsPerSec = items / res.durationSec;
+    res.latencyP50Usec = percentileUsec(allLatencies, 0.50);
+    res.latencyP99Usec = percentileUsec(allLatencies, 0.99);
+    res.latencyP999Usec = percentileUsec(allLatencies, 0.999);
+    res.allocsPerItem = BENCH_COUNT_ALLOCS ? static_cast<double>(allocsEnd - allocsStart) / items : -1;
+    return res;
+}
+
+static ScenarioResult runScenario(const Scenario &scenario, size_t items, size_t window)
+{
+    switch (scenario.payload) {
+    case Payload::FRAME:
+        return runScenario<Frame>(scenario, items, window);
+    case Payload::INT_SIGNAL:
+        return runScenario<IntSignalBlock>(scenario, items, window);
+    case Payload::FLOAT_SIGNAL:
+        return runScenario<FloatSignalBlock>(scenario, items, window);
+    case Payload::TABLE_ROW:
+        return runScenario<TableRow>(scenario, items, window);
+    }
+    return {};
+}
+
+static QJsonObject resultToJson(const ScenarioResult &res)
+{
+    QJsonObject latency;
+    latency.insert("p50", res.latencyP50Usec);
+    latency.insert("p99", res.latencyP99Usec);
+    latency.insert("p999", res.latencyP999Usec);
+
+    QJsonObject obj;
+    obj.insert("name", res.scenario.name());
+    obj.insert("topology", Scenario::topologyName(res.scenario.topology));
+    obj.insert("payload", Scenario::payloadName(res.scenario.payload));
+    obj.insert("subscribers", res.scenario.subscribers);
+    obj.insert("items", static_cast<qint64>(res.items));
+    obj.insert("duration_sec", res.durationSec);
+    obj.insert("items_per_sec", res.itemsPerSec);
+    obj.insert("latency_usec", latency);
+    obj.insert("allocs_per_item", res.allocsPerItem);
+    return obj;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    if (VIPS_INIT(argv[0]) != 0) {
+        std::cerr << "Unable to initialize VIPS" << std::endl;
+        return 1;
+    }
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Benchmark for the Syntalos stream fabric");
+    parser.addHelpOption();
+    QCommandLineOption jsonOption("json", "Write results as JSON to <file>.", "file");
+    QCommandLineOption itemsOption("items", "Number of elements to push per scenario.", "count", "20000");
+    QCommandLineOption windowOption("window", "Maximum number of elements in flight.", "count", "64");
+    QCommandLineOption filterOption("filter", "Only run scenarios whose name contains <text>.", "text");
+    parser.addOption(jsonOption);
+    parser.addOption(itemsOption);
+    parser.addOption(windowOption);
+    parser.addOption(filterOption);
+    parser.process(app);
+
+    const size_t items = std::max(1ULL, parser.value(itemsOption).toULongLong());
+    const size_t window = std::max(1ULL, parser.value(windowOption).toULongLong());
+
+    std::vector<Scenario> scenarios;
+    for (const auto topology : {Topology::DIRECT, Topology::TRANSFORM}) {
+        for (const auto payload : {Payload::FRAME, Payload::INT_SIGNAL, Payload::FLOAT_SIGNAL, Payload::TABLE_ROW}) {
+            for (const auto subscribers : {1, 4})
+                scenarios.push_back({topology, payload, subscribers});
+        }
+    }
+
+    QJsonArray jsonResults;
+    printf("%-28s %14s %10s %10s %10s %12s\n", "scenario", "items/s", "p50 us", "p99 us", "p999 us", "allocs/item");
+    for (const auto &scenario : scenarios) {
+        if (parser.isSet(filterOption) && !scenario.name().contains(parser.value(filterOption)))
+            continue;
+
+        const auto res = runScenario(scenario, items, window);
+        printf(
+            "%-28s %14.0f %10.1f %10.1f %10.1f %12.2f\n",
+            qPrintable(scenario.name()),
+            res.itemsPerSec,
+            res.latencyP50Usec,
+            res.latencyP99Usec,
+            res.latencyP999Usec,
+            res.allocsPerItem);
+        fflush(stdout);
+        jsonResults.append(resultToJson(res));
+    }
+
+    if (parser.isSet(jsonOption)) {
+        QJsonObject root;
+        root.insert("benchmark", "streams");
+        root.insert("version", 1);
+        root.insert("cpu_arch", QSysInfo::currentCpuArchitecture());
+        root.insert("cpu_count", static_cast<int>(std::thread::hardware_concurrency()));
+        root.insert("items", static_cast<qint64>(items));
+        root.insert("window", static_cast<qint64>(window));
+        root.insert("results", jsonResults);
+
+        QFile file(parser.value(jsonOption));
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            std::cerr << "Unable to write results to " << qPrintable(file.fileName()) << std::endl;
+            return 1;
+        }
+        file.write(QJsonDocument(root).toJson());
+    }
+
+    return 0;
+}
@@ -0,0 +1,247 @@
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QtTest>
+#include <opencv2/imgproc.hpp>
+
+#include "datactl/vipsutils.h"
+#include "framestage.h"
+
+// roughly 5 megapixels, a common machine vision sensor size
+static const int BENCH_WIDTH = 2448;
+static const int BENCH_HEIGHT = 2048;
+
+static cv::Mat createRawFrame(ArvPixelFormat format, int width, int height)
+{
+    cv::Mat raw;
+    cv::RNG rng(42);
+    switch (format) {
+    case ARV_PIXEL_FORMAT_MONO_8:
+    case ARV_PIXEL_FORMAT_BAYER_RG_8:
+        raw = cv::Mat(height, width, CV_8UC1);
+        rng.fill(raw, cv::RNG::UNIFORM, 0, 256);
+        break;
+    case ARV_PIXEL_FORMAT_MONO_12:
+        raw = cv::Mat(height, width, CV_16UC1);
+        rng.fill(raw, cv::RNG::UNIFORM, 0, 4096);
+        break;
+    case ARV_PIXEL_FORMAT_MONO_16:
+    case ARV_PIXEL_FORMAT_BAYER_RG_16:
+        raw = cv::Mat(height, width, CV_16UC1);
+        rng.fill(raw, cv::RNG::UNIFORM, 0, 65536);
+        break;
+    case ARV_PIXEL_FORMAT_RGB_8_PACKED:
+    case ARV_PIXEL_FORMAT_BGR_8_PACKED:
+        raw = cv::Mat(height, width, CV_8UC3);
+        rng.fill(raw, cv::RNG::UNIFORM, cv::Scalar::all(0), cv::Scalar::all(256));
+        break;
+    default:
+        qFatal("Unsupported test pixel format");
+    }
+
+    return raw;
+}
+
+/**
+ * Reference implementation, this is how the Aravis camera module used to
+ * process frames before the fused frame stage existed.
+ */
+static vips::VImage processFrameRef(ArvPixelFormat format, const cv::Mat &raw, bool invert, int flip, int rot)
+{
+    cv::Mat img;
+    switch (format) {
+    case ARV_PIXEL_FORMAT_MONO_8:
+    case ARV_PIXEL_FORMAT_MONO_16:
+    case ARV_PIXEL_FORMAT_BGR_8_PACKED:
+        img = raw.clone();
+        break;
+    case ARV_PIXEL_FORMAT_MONO_12:
+        img = raw * 16;
+        break;
+    case ARV_PIXEL_FORMAT_RGB_8_PACKED:
+        cv::cvtColor(raw, img, cv::COLOR_RGB2BGR);
+        break;
+    case ARV_PIXEL_FORMAT_BAYER_RG_8:
+    case ARV_PIXEL_FORMAT_BAYER_RG_16:
+        cv::cvtColor(raw, img, cv::COLOR_BayerBG2BGR);
+        break;
+    default:
+        qFatal("Unsupported test pixel format");
+    }
+
+    if (invert) {
+        int bits = img.depth() == CV_8U ? 8 : 16;
+        cv::subtract((1 << bits) - 1, img, img);
+    }
+
+    if (flip != -100)
+        cv::flip(img, img, flip);
+
+    switch (rot) {
+    case 1:
+        cv::transpose(img, img);
+        cv::flip(img, img, 0);
+        break;
+
+    case 2:
+        cv::flip(img, img, -1);
+        break;
+
+    case 3:
+        cv::transpose(img, img);
+        cv::flip(img, img, 1);
+        break;
+    }
+
+    return cvMatToVips(img);
+}
+
+static bool imagesEqual(vips::VImage a, vips::VImage b)
+{
+    if (a.width() != b.width() || a.height() != b.height() || a.bands() != b.bands()
+        || a.format() != b.format())
+        return false;
+
+    size_t sizeA, sizeB;
+    void *dataA = a.write_to_memory(&sizeA);
+    void *dataB = b.write_to_memory(&sizeB);
+    const bool equal = sizeA == sizeB && memcmp(dataA, dataB, sizeA) == 0;
+    g_free(dataA);
+    g_free(dataB);
+
+    return equal;
+}
+
+class TestArvFrameStage : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase()
+    {
+        QVERIFY(VIPS_INIT("test-arvframestage") == 0);
+    }
+
+    void matchesReference_data()
+    {
+        QTest::addColumn<uint>("format");
+
+        QTest::newRow("Mono8") << (uint)ARV_PIXEL_FORMAT_MONO_8;
+        QTest::newRow("Mono12") << (uint)ARV_PIXEL_FORMAT_MONO_12;
+        QTest::newRow("Mono16") << (uint)ARV_PIXEL_FORMAT_MONO_16;
+        QTest::newRow("RGB8Packed") << (uint)ARV_PIXEL_FORMAT_RGB_8_PACKED;
+        QTest::newRow("BGR8Packed") << (uint)ARV_PIXEL_FORMAT_BGR_8_PACKED;
+        QTest::newRow("BayerRG8") << (uint)ARV_PIXEL_FORMAT_BAYER_RG_8;
+        QTest::newRow("BayerRG16") << (uint)ARV_PIXEL_FORMAT_BAYER_RG_16;
+    }
+
+    void matchesReference()
+    {
+        QFETCH(uint, format);
+
+        // odd dimensions, to catch any mixup of width and height
+        const auto raw = createRawFrame(format, 203, 117);
+
+        FrameStage stage;
+        stage.setInputFormat(format, raw.cols, raw.rows);
+        QVERIFY(stage.canProcessRaw());
+
+        for (const auto invert : {false, true}) {
+            for (const auto flip : {-100, 0, 1, -1}) {
+                for (int rot = 0; rot < 4; rot++) {
+                    stage.setTransform(invert, flip, rot);
+                    const auto image = stage.processRaw(raw.data, raw.total() * raw.elemSize());
+                    QVERIFY(!image.is_null());
+                    QCOMPARE(image.width(), stage.outputWidth());
+                    QCOMPARE(image.height(), stage.outputHeight());
+
+                    if (!imagesEqual(image, processFrameRef(format, raw, invert, flip, rot)))
+                        QFAIL(qPrintable(
+                            QStringLiteral("Mismatch for invert=%1 flip=%2 rot=%3").arg(invert).arg(flip).arg(rot)));
+                }
+            }
+        }
+    }
+
+    void decodedMatchesReference()
+    {
+        // frames that went through a decoder are in BGR order
+        const auto raw = createRawFrame(ARV_PIXEL_FORMAT_BGR_8_PACKED, 64, 48);
+
+        FrameStage stage;
+        stage.setTransform(true, 1, 3);
+        QVERIFY(imagesEqual(stage.process(raw), processFrameRef(ARV_PIXEL_FORMAT_BGR_8_PACKED, raw, true, 1, 3)));
+    }
+
+    void truncatedFrameIsDropped()
+    {
+        const auto raw = createRawFrame(ARV_PIXEL_FORMAT_MONO_8, 64, 48);
+
+        FrameStage stage;
+        stage.setInputFormat(ARV_PIXEL_FORMAT_MONO_8, raw.cols, raw.rows);
+        QVERIFY(stage.processRaw(raw.data, raw.total() - 1).is_null());
+    }
+
+    void pooledBuffersOutliveStage()
+    {
+        const auto raw = createRawFrame(ARV_PIXEL_FORMAT_MONO_8, 64, 48);
+
+        vips::VImage image;
+        {
+            FrameStage stage;
+            stage.setInputFormat(ARV_PIXEL_FORMAT_MONO_8, raw.cols, raw.rows);
+            image = stage.processRaw(raw.data, raw.total());
+        }
+        QVERIFY(imagesEqual(image, cvMatToVips(raw)));
+    }
+
+    void benchmarkFormat_data()
+    {
+        QTest::addColumn<uint>("format");
+        QTest::addColumn<bool>("fused");
+        QTest::addColumn<int>("rot");
+
+        const QList<QPair<QString, uint>> formats = {
+            {"Mono8",      ARV_PIXEL_FORMAT_MONO_8      },
+            {"Mono12",     ARV_PIXEL_FORMAT_MONO_12     },
+            {"BGR8Packed", ARV_PIXEL_FORMAT_BGR_8_PACKED},
+            {"BayerRG8",   ARV_PIXEL_FORMAT_BAYER_RG_8  },
+            {"BayerRG16",  ARV_PIXEL_FORMAT_BAYER_RG_16 },
+        };
+        for (const auto &fmt : formats) {
+            QTest::newRow(qPrintable(fmt.first + "-reference")) << fmt.second << false << 0;
+            QTest::newRow(qPrintable(fmt.first + "-fused")) << fmt.second << true << 0;
+            QTest::newRow(qPrintable(fmt.first + "-reference-rot90")) << fmt.second << false << 1;
+            QTest::newRow(qPrintable(fmt.first + "-fused-rot90")) << fmt.second << true << 1;
+        }
+    }
+
+    void benchmarkFormat()
+    {
+        QFETCH(uint, format);
+        QFETCH(bool, fused);
+        QFETCH(int, rot);
+
+        const int frameCount = 60;
+        const auto raw = createRawFrame(format, BENCH_WIDTH, BENCH_HEIGHT);
+        const auto rawSize = raw.total() * raw.elemSize();
+
+        FrameStage stage;
+        stage.setInputFormat(format, raw.cols, raw.rows);
+        stage.setTransform(false, -100, rot);
+
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < frameCount; i++) {
+            vips::VImage image;
+            if (fused)
+                image = stage.processRaw(raw.data, rawSize);
+            else
+                image = processFrameRef(format, raw, false, -100, rot);
+            QVERIFY(!image.is_null());
+        }
+
+        QTest::setBenchmarkResult(frameCount * 1000000000.0 / timer.nsecsElapsed(), QTest::FramesPerSecond);
+    }
+};
+
+QTEST_MAIN(TestArvFrameStage)
+#include "test-arvframestage.moc"
@@ -0,0 +1,238 @@
+#include <QDebug>
+#include <QtTest>
+#include <random>
+#include <vector>
+
+#include "unpackkernels.h"
+
+using namespace QArv;
+
+// roughly 5 megapixels, a common machine vision sensor size
+static const int BENCH_WIDTH = 2448;
+static const int BENCH_HEIGHT = 2048;
+
+/**
+ * Reference implementation, this is the scalar Mono12PackedDecoder
+ * from before the vectorized kernels existed.
+ */
+static void mono12PackedRef(const uchar *dta, size_t size, uint16_t *out, int w, int h)
+{
+    int line = 0;
+    auto linestart = out;
+    int outcurrent = 0;
+    const uchar *inptr = dta;
+    uint16_t pixel;
+    uchar *bytes = reinterpret_cast<uchar *>(&pixel);
+    while (inptr < dta + size) {
+        bytes[0] = inptr[1] << 4;
+        bytes[1] = inptr[0];
+        linestart[outcurrent++] = pixel;
+
+        if (outcurrent == w) {
+            if (++line == h)
+                break;
+            linestart = out + line * w;
+            outcurrent = 0;
+        }
+
+        bytes[0] = inptr[1] & 0xF0;
+        bytes[1] = inptr[2];
+        linestart[outcurrent++] = pixel;
+
+        if (outcurrent == w) {
+            if (++line == h)
+                break;
+            linestart = out + line * w;
+            outcurrent = 0;
+        }
+
+        inptr += 3;
+    }
+}
+
+/**
+ * Reference implementation, this is the scalar MonoUnpackedDecoder
+ * from before the vectorized kernels existed.
+ */
+template<typename InputType, typename OutputType, uint bitsPerPixel>
+static void monoUnpackedRef(const InputType *dta, OutputType *out, int w, int h)
+{
+    const bool typeIsSigned = std::is_signed<InputType>::value;
+    const uint zeroBits = 8 * sizeof(OutputType) - bitsPerPixel;
+    const uint signedShiftBits = bitsPerPixel - 1;
+
+    for (int i = 0; i < h; i++) {
+        auto line = out + i * w;
+        for (int j = 0; j < w; j++) {
+            OutputType tmp;
+            if (typeIsSigned)
+                tmp = dta[i * w + j] + (1 << signedShiftBits);
+            else
+                tmp = dta[i * w + j];
+            line[j] = tmp << (zeroBits);
+        }
+    }
+}
+
+template<typename T>
+static std::vector<T> randomData(size_t count, unsigned int seed)
+{
+    std::mt19937 rng(seed);
+    std::vector<T> data(count);
+    for (auto &v : data)
+        v = static_cast<T>(rng());
+    return data;
+}
+
+static void addIsaRows()
+{
+    QTest::addColumn<int>("isa");
+
+    for (const auto isa : {Unpack::Isa::SCALAR, Unpack::Isa::SSSE3, Unpack::Isa::AVX2}) {
+        if (Unpack::isaSupported(isa))
+            QTest::newRow(Unpack::isaName(isa)) << static_cast<int>(isa);
+    }
+}
+
+class TestArvUnpack : public QObject
+{
+    Q_OBJECT
+private slots:
+    void mono12Packed_data()
+    {
+        addIsaRows();
+    }
+
+    void mono12Packed()
+    {
+        QFETCH(int, isa);
+
+        // odd sizes, so the vectorized kernels leave a tail and a triplet spans two lines
+        for (const auto &size : {QSize(1, 1), QSize(7, 5), QSize(33, 17), QSize(641, 3), QSize(1280, 960)}) {
+            const auto pixels = static_cast<size_t>(size.width()) * size.height();
+            const auto srcSize = ((pixels + 1) / 2) * 3;
+            const auto src = randomData<uint8_t>(srcSize, pixels);
+
+            std::vector<uint16_t> expected(pixels, 0);
+            mono12PackedRef(src.data(), srcSize, expected.data(), size.width(), size.height());
+
+            std::vector<uint16_t> result(pixels, 0);
+            QCOMPARE(
+                Unpack::mono12Packed(src.data(), srcSize, result.data(), pixels, static_cast<Unpack::Isa>(isa)),
+                pixels);
+            QVERIFY(result == expected);
+        }
+    }
+
+    void mono12PackedTruncated_data()
+    {
+        addIsaRows();
+    }
+
+    void mono12PackedTruncated()
+    {
+        QFETCH(int, isa);
+
+        // a short frame must neither be read nor written beyond its end
+        const auto src = randomData<uint8_t>(100, 1);
+        std::vector<uint16_t> result(200, 0xAAAA);
+        QCOMPARE(
+            Unpack::mono12Packed(src.data(), 100, result.data(), 200, static_cast<Unpack::Isa>(isa)),
+            static_cast<size_t>(66));
+        QCOMPARE(result[65], static_cast<uint16_t>((src[98] << 8) | (src[97] & 0xF0)));
+        QCOMPARE(result[66], static_cast<uint16_t>(0xAAAA));
+    }
+
+    void monoUnpacked_data()
+    {
+        addIsaRows();
+    }
+
+    void monoUnpacked()
+    {
+        QFETCH(int, isa);
+        const auto w = 1001;
+        const auto h = 13;
+        const auto pixels = static_cast<size_t>(w) * h;
+
+        // Mono10, Mono12 and Mono14
+        const auto src16 = randomData<uint16_t>(pixels, 2);
+        for (const auto bits : {10u, 12u, 14u}) {
+            std::vector<uint16_t> expected(pixels);
+            if (bits == 10)
+                monoUnpackedRef<uint16_t, uint16_t, 10>(src16.data(), expected.data(), w, h);
+            else if (bits == 12)
+                monoUnpackedRef<uint16_t, uint16_t, 12>(src16.data(), expected.data(), w, h);
+            else
+                monoUnpackedRef<uint16_t, uint16_t, 14>(src16.data(), expected.data(), w, h);
+
+            std::vector<uint16_t> result(pixels);
+            Unpack::shiftLeft16(src16.data(), result.data(), pixels, 16 - bits, static_cast<Unpack::Isa>(isa));
+            QVERIFY(result == expected);
+        }
+
+        // Mono8Signed
+        const auto src8 = randomData<int8_t>(pixels, 3);
+        std::vector<uint8_t> expected8(pixels);
+        monoUnpackedRef<int8_t, uint8_t, 8>(src8.data(), expected8.data(), w, h);
+
+        std::vector<uint8_t> result8(pixels);
+        Unpack::signedToUnsigned8(src8.data(), result8.data(), pixels, static_cast<Unpack::Isa>(isa));
+        QVERIFY(result8 == expected8);
+    }
+
+    void benchmarkMono12PackedReference()
+    {
+        const auto pixels = static_cast<size_t>(BENCH_WIDTH) * BENCH_HEIGHT;
+        const auto src = randomData<uint8_t>(pixels / 2 * 3, 1);
+        std::vector<uint16_t> result(pixels);
+        QBENCHMARK {
+            mono12PackedRef(src.data(), src.size(), result.data(), BENCH_WIDTH, BENCH_HEIGHT);
+        }
+    }
+
+    void benchmarkMono12Packed_data()
+    {
+        addIsaRows();
+    }
+
+    void benchmarkMono12Packed()
+    {
+        QFETCH(int, isa);
+        const auto pixels = static_cast<size_t>(BENCH_WIDTH) * BENCH_HEIGHT;
+        const auto src = randomData<uint8_t>(pixels / 2 * 3, 1);
+        std::vector<uint16_t> result(pixels);
+        QBENCHMARK {
+            Unpack::mono12Packed(src.data(), src.size(), result.data(), pixels, static_cast<Unpack::Isa>(isa));
+        }
+    }
+
+    void benchmarkMono12Reference()
+    {
+        const auto pixels = static_cast<size_t>(BENCH_WIDTH) * BENCH_HEIGHT;
+        const auto src = randomData<uint16_t>(pixels, 1);
+        std::vector<uint16_t> result(pixels);
+        QBENCHMARK {
+            monoUnpackedRef<uint16_t, uint16_t, 12>(src.data(), result.data(), BENCH_WIDTH, BENCH_HEIGHT);
+        }
+    }
+
+    void benchmarkMono12_data()
+    {
+        addIsaRows();
+    }
+
+    void benchmarkMono12()
+    {
+        QFETCH(int, isa);
+        const auto pixels = static_cast<size_t>(BENCH_WIDTH) * BENCH_HEIGHT;
+        const auto src = randomData<uint16_t>(pixels, 1);
+        std::vector<uint16_t> result(pixels);
+        QBENCHMARK {
+            Unpack::shiftLeft16(src.data(), result.data(), pixels, 4, static_cast<Unpack::Isa>(isa));
+        }
+    }
+};
+
+QTEST_MAIN(TestArvUnpack)
+#include "test-arvunpack.moc"
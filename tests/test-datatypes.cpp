@@ -0,0 +1,102 @@
+#include <QDebug>
+#include <QtTest>
+#include <vector>
+
+#include "datactl/datatypes.h"
+#include "datactl/frametype.h"
+
+template<typename T>
+static std::vector<unsigned char> toMemory(const T &data)
+{
+    std::vector<unsigned char> buffer(data.memorySize());
+    if (!data.writeToMemory(buffer.data(), buffer.size()))
+        return {};
+    return buffer;
+}
+
+class TestDataTypes : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase()
+    {
+        QVERIFY(VIPS_INIT("test-datatypes") == 0);
+    }
+
+    void intSignalBlockRoundtrip()
+    {
+        IntSignalBlock block(32, 5);
+        for (int i = 0; i < 32; i++)
+            block.timestamps[i] = 1000 + i;
+        block.data.setRandom();
+
+        const auto buffer = toMemory(block);
+        QVERIFY(!buffer.empty());
+        QCOMPARE(block.toBytes().size(), static_cast<int>(buffer.size()));
+
+        const auto result = IntSignalBlock::fromMemory(buffer.data(), buffer.size());
+        QCOMPARE(result.rows(), static_cast<size_t>(32));
+        QCOMPARE(result.cols(), static_cast<size_t>(5));
+        QVERIFY(result.timestamps == block.timestamps);
+        QVERIFY(result.data == block.data);
+    }
+
+    void floatSignalBlockRoundtrip()
+    {
+        FloatSignalBlock block(7, 3);
+        block.timestamps.setLinSpaced(7, 10, 70);
+        block.data.setRandom();
+
+        const auto bytes = block.toBytes();
+        const auto result = FloatSignalBlock::fromMemory(bytes.constData(), bytes.size());
+        QVERIFY(result.timestamps == block.timestamps);
+        QVERIFY(result.data == block.data);
+    }
+
+    void signalBlockTruncated()
+    {
+        IntSignalBlock block(16, 2);
+        block.data.setRandom();
+
+        // a short buffer must not be read beyond its end, and yields an empty block
+        const auto buffer = toMemory(block);
+        const auto result = IntSignalBlock::fromMemory(buffer.data(), buffer.size() - 1);
+        QCOMPARE(result.length(), static_cast<size_t>(0));
+        QCOMPARE(result.data.size(), static_cast<Eigen::Index>(0));
+
+        std::vector<unsigned char> small(buffer.size() - 1);
+        QVERIFY(!block.writeToMemory(small.data(), small.size()));
+    }
+
+    void frameViewFromMemory()
+    {
+        std::vector<uchar> pixels(64 * 48 * 3);
+        for (size_t i = 0; i < pixels.size(); i++)
+            pixels[i] = static_cast<uchar>(i % 251);
+        const auto image = vips::VImage::new_from_memory_copy(
+            pixels.data(), pixels.size(), 64, 48, 3, VIPS_FORMAT_UCHAR);
+
+        Frame frame(image, 42, milliseconds_t(1234));
+        const auto buffer = toMemory(frame);
+        QCOMPARE(buffer.size(), Frame::HeaderSize + pixels.size());
+
+        const auto copy = Frame::fromMemory(buffer.data(), buffer.size());
+        const auto view = Frame::viewFromMemory(buffer.data(), buffer.size());
+        for (const auto &f : {copy, view}) {
+            QCOMPARE(f.index, static_cast<uint64_t>(42));
+            QCOMPARE(f.time.count(), static_cast<int64_t>(1234));
+            QCOMPARE(f.mat.width(), 64);
+            QCOMPARE(f.mat.height(), 48);
+            QCOMPARE(f.mat.bands(), 3);
+            QCOMPARE(std::memcmp(f.mat.data(), pixels.data(), pixels.size()), 0);
+        }
+
+        // only the view refers to the buffer itself
+        const void *bufferPixels = buffer.data() + Frame::HeaderSize;
+        QCOMPARE(static_cast<const void *>(view.mat.data()), bufferPixels);
+        QVERIFY(static_cast<const void *>(copy.mat.data()) != bufferPixels);
+    }
+};
+
+QTEST_MAIN(TestDataTypes)
+#include "test-datatypes.moc"
@@ -0,0 +1,136 @@
+#include <QDebug>
+#include <QtTest>
+#include <cstring>
+
+#include "datactl/framebufferpool.h"
+
+using namespace Syntalos;
+
+class TestFrameBufferPool : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase()
+    {
+        QVERIFY(VIPS_INIT("test-framebufferpool") == 0);
+
+        // cached operations would keep our images alive, and their buffers in use
+        vips_cache_set_max(0);
+    }
+
+    void buffersAreRecycled()
+    {
+        auto pool = std::make_shared<FrameBufferPool>(640 * 480, 2);
+        auto a = pool->acquire();
+        auto b = pool->acquire();
+        auto c = pool->acquire();
+        QCOMPARE(pool->stats().inUse, static_cast<size_t>(3));
+
+        // only two buffers are kept for reuse, the third one is freed
+        pool->release(a);
+        pool->release(b);
+        pool->release(c);
+        auto stats = pool->stats();
+        QCOMPARE(stats.inUse, static_cast<size_t>(0));
+        QCOMPARE(stats.peakInUse, static_cast<size_t>(3));
+        QCOMPARE(stats.cached, static_cast<size_t>(2));
+
+        auto d = pool->acquire();
+        QVERIFY(d == a || d == b);
+        pool->release(d);
+
+        stats = pool->stats();
+        QCOMPARE(stats.acquired, static_cast<uint64_t>(4));
+        QCOMPARE(stats.reused, static_cast<uint64_t>(1));
+        QCOMPARE(stats.allocated, static_cast<uint64_t>(3));
+
+        pool->trim();
+        QCOMPARE(pool->stats().cached, static_cast<size_t>(0));
+    }
+
+    void imagesReleaseBuffers()
+    {
+        const int width = 1280;
+        const int height = 1024;
+        auto pool = std::make_shared<FrameBufferPool>(width * height * 3, 4, true);
+        QVERIFY(pool->hugePages());
+
+        std::vector<uchar> pixels(width * height * 3);
+        for (size_t i = 0; i < pixels.size(); i++)
+            pixels[i] = i % 251;
+
+        {
+            auto image = pool->copyImage(pixels.data(), width, height, 3, VIPS_FORMAT_UCHAR);
+            QCOMPARE(pool->stats().inUse, static_cast<size_t>(1));
+
+            // derived images keep the buffer in use too
+            auto cropped = image.extract_area(16, 16, 64, 64);
+            image = vips::VImage();
+            QCOMPARE(pool->stats().inUse, static_cast<size_t>(1));
+
+            const auto pixel = cropped.getpoint(0, 0);
+            QCOMPARE(static_cast<int>(pixel[0]), static_cast<int>(pixels[(16 * width + 16) * 3]));
+        }
+
+        QCOMPARE(pool->stats().inUse, static_cast<size_t>(0));
+        QCOMPARE(pool->stats().cached, static_cast<size_t>(1));
+
+        // oversized data is rejected
+        std::vector<uchar> large(width * height * 4);
+        QVERIFY_EXCEPTION_THROWN(
+            pool->copyImage(large.data(), width, height, 4, VIPS_FORMAT_UCHAR), vips::VError);
+        QCOMPARE(pool->stats().inUse, static_cast<size_t>(0));
+    }
+
+    void hugePageBuffersAreAligned()
+    {
+        auto pool = std::make_shared<FrameBufferPool>(3 * 1024 * 1024, 4, true);
+        pool->reserve(2);
+        QCOMPARE(pool->stats().cached, static_cast<size_t>(2));
+
+        auto buffer = pool->acquire();
+        QCOMPARE(reinterpret_cast<uintptr_t>(buffer) % (2 * 1024 * 1024), static_cast<uintptr_t>(0));
+        std::memset(buffer, 0xAB, pool->bufferSize());
+        pool->release(buffer);
+
+        QCOMPARE(pool->stats().reused, static_cast<uint64_t>(1));
+        QCOMPARE(pool->stats().allocated, static_cast<uint64_t>(2));
+    }
+
+    void sharedPools()
+    {
+        auto small = FrameBufferPool::shared(640 * 480);
+        auto large = FrameBufferPool::shared(1920 * 1080 * 3);
+        QCOMPARE(FrameBufferPool::shared(640 * 480), small);
+        QVERIFY(small != large);
+        QVERIFY(!small->hugePages());
+        QVERIFY(large->hugePages());
+
+        large->release(large->acquire());
+        bool found = false;
+        for (const auto &stats : FrameBufferPool::sharedStats()) {
+            if (stats.bufferSize != large->bufferSize())
+                continue;
+            QVERIFY(stats.acquired >= 1);
+            QVERIFY(stats.cached >= 1);
+            found = true;
+        }
+        QVERIFY(found);
+
+        FrameBufferPool::trimShared();
+        QCOMPARE(large->stats().cached, static_cast<size_t>(0));
+
+        // rounding 3 MiB up to 4 MiB of huge pages would waste too much memory
+        QVERIFY(!FrameBufferPool::shared(3 * 1024 * 1024)->hugePages());
+
+        // pools nobody holds on to anymore are dropped
+        auto unused = FrameBufferPool::shared(1000);
+        unused->release(unused->acquire());
+        unused.reset();
+        FrameBufferPool::trimShared();
+        QCOMPARE(FrameBufferPool::shared(1000)->stats().acquired, static_cast<uint64_t>(0));
+    }
+};
+
+QTEST_MAIN(TestFrameBufferPool)
+#include "test-framebufferpool.moc"
@@ -0,0 +1,129 @@
+#include <QDebug>
+#include <QSize>
+#include <QtTest>
+
+#include "ioxmempool.h"
+#include "datactl/frametype.h"
+
+using namespace Syntalos;
+
+class TestIoxMemPool : public QObject
+{
+    Q_OBJECT
+private slots:
+    void layoutStringRoundtrip()
+    {
+        const auto layout = defaultIoxMemPoolLayout();
+        const auto str = ioxMemPoolLayoutToString(layout);
+        QCOMPARE(str, QStringLiteral("1024:50,524288:50,1048576:20,6291456:20,25165824:10"));
+        QCOMPARE(ioxMemPoolLayoutFromString(str), layout);
+
+        // pools are sorted by size, bad input is rejected as a whole
+        const auto parsed = ioxMemPoolLayoutFromString(QStringLiteral("4096:2, 1024:8"));
+        QCOMPARE(parsed.size(), static_cast<size_t>(2));
+        QCOMPARE(parsed[0].chunkSize, static_cast<uint64_t>(1024));
+        QVERIFY(ioxMemPoolLayoutFromString(QStringLiteral("1024:8,4096")).empty());
+        QVERIFY(ioxMemPoolLayoutFromString(QStringLiteral("1024:0")).empty());
+        QVERIFY(ioxMemPoolLayoutFromString(QStringLiteral("abc:2")).empty());
+    }
+
+    void frameSizeEstimate()
+    {
+        QHash<QString, QVariant> mdata;
+        QCOMPARE(estimateStreamElementMemorySize(syDataTypeId<Frame>(), mdata), static_cast<uint64_t>(0));
+
+        mdata["size"] = QSize(640, 480);
+        QCOMPARE(
+            estimateStreamElementMemorySize(syDataTypeId<Frame>(), mdata),
+            static_cast<uint64_t>(Frame::HeaderSize + 640 * 480 * 3));
+
+        mdata["has_color"] = false;
+        mdata["depth"] = VIPS_FORMAT_USHORT;
+        QCOMPARE(
+            estimateStreamElementMemorySize(syDataTypeId<Frame>(), mdata),
+            static_cast<uint64_t>(Frame::HeaderSize + 640 * 480 * 2));
+    }
+
+    void signalSizeEstimate()
+    {
+        QHash<QString, QVariant> mdata;
+        mdata["signal_names"] = QStringList() << "A" << "B" << "C" << "D";
+        mdata["block_size"] = 200;
+
+        FloatSignalBlock block(200, 4);
+        QCOMPARE(
+            estimateStreamElementMemorySize(syDataTypeId<FloatSignalBlock>(), mdata),
+            static_cast<uint64_t>(block.memorySize()));
+    }
+
+    void detectsMismatch()
+    {
+        const auto layout = defaultIoxMemPoolLayout();
+        QString error;
+
+        // a 4K color camera with two external subscribers fits into the 24 MiB pool
+        std::vector<IoxChunkRequirement> reqs = {
+            {QStringLiteral("Camera/Video"), 3840 * 2160 * 3 + Frame::HeaderSize, 8}
+        };
+        QVERIFY(ioxMemPoolLayoutSatisfies(layout, reqs, &error));
+
+        // ...but not a second one
+        reqs.push_back({QStringLiteral("Camera 2/Video"), 3840 * 2160 * 3 + Frame::HeaderSize, 8});
+        QVERIFY(!ioxMemPoolLayoutSatisfies(layout, reqs, &error));
+        QVERIFY(error.contains(QStringLiteral("Camera 2/Video")));
+
+        // elements larger than any pool are reported too
+        reqs = {
+            {QStringLiteral("Huge/Frames"), 64 * 1024 * 1024, 1}
+        };
+        QVERIFY(!ioxMemPoolLayoutSatisfies(layout, reqs, &error));
+        QVERIFY(error.contains(QStringLiteral("Huge/Frames")));
+    }
+
+    void growsLayout()
+    {
+        const auto base = defaultIoxMemPoolLayout();
+        const std::vector<IoxChunkRequirement> reqs = {
+            {QStringLiteral("Camera/Video"),  3840 * 2160 * 3 + Frame::HeaderSize, 12},
+            {QStringLiteral("Huge/Frames"),   40 * 1024 * 1024,                    3 },
+            {QStringLiteral("Signals/Float"), 64 * 1024,                           80},
+        };
+
+        const auto layout = ioxMemPoolLayoutFor(reqs, base);
+        QVERIFY(ioxMemPoolLayoutSatisfies(layout, reqs));
+        QCOMPARE(layout.size(), base.size() + 1);
+        QVERIFY(ioxMemPoolLayoutTotalSize(layout) > ioxMemPoolLayoutTotalSize(base));
+
+        // existing pools never shrink
+        for (size_t i = 0; i < base.size(); i++) {
+            QCOMPARE(layout[i].chunkSize, base[i].chunkSize);
+            QVERIFY(layout[i].chunkCount >= base[i].chunkCount);
+        }
+
+        // a satisfied layout is left alone
+        QCOMPARE(ioxMemPoolLayoutFor(reqs, layout), layout);
+    }
+
+    void clampsLayout()
+    {
+        const auto layout = defaultIoxMemPoolLayout();
+        const auto totalSize = ioxMemPoolLayoutTotalSize(layout);
+
+        // layouts within the limit are not touched
+        QCOMPARE(ioxMemPoolLayoutClamped(layout, totalSize), layout);
+
+        const auto clamped = ioxMemPoolLayoutClamped(layout, totalSize / 2);
+        QCOMPARE(clamped.size(), layout.size());
+        QVERIFY(ioxMemPoolLayoutTotalSize(clamped) <= totalSize / 2);
+        for (size_t i = 0; i < layout.size(); i++) {
+            QCOMPARE(clamped[i].chunkSize, layout[i].chunkSize);
+            QVERIFY(clamped[i].chunkCount >= 1);
+        }
+
+        // we can not go below one chunk per pool
+        QVERIFY(ioxMemPoolLayoutClamped(layout, 1024).empty());
+    }
+};
+
+QTEST_MAIN(TestIoxMemPool)
+#include "test-ioxmempool.moc"
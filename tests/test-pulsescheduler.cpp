@@ -0,0 +1,114 @@
+#include <QDebug>
+#include <QtTest>
+#include <map>
+#include <random>
+
+#include "pulsescheduler.h"
+
+using us = microseconds_t;
+
+class TestPulseScheduler : public QObject
+{
+    Q_OBJECT
+private slots:
+    void expiresInOrder()
+    {
+        PulseScheduler sched(us(500), 16);
+        sched.schedulePulseEnd(4, false, us(20000)); // beyond one revolution of the wheel
+        sched.schedulePulseEnd(5, false, us(1200));
+        sched.schedulePulseEnd(3, false, us(1000));
+        QCOMPARE(sched.pendingCount(), static_cast<size_t>(3));
+        QCOMPARE(sched.nextDeadline().value(), us(1000));
+
+        QVERIFY(sched.takeDue(us(999)).empty());
+
+        auto due = sched.takeDue(us(1300));
+        QCOMPARE(due.size(), static_cast<size_t>(2));
+        QCOMPARE(due[0].pinId, static_cast<uint8_t>(3));
+        QCOMPARE(due[1].pinId, static_cast<uint8_t>(5));
+
+        QVERIFY(sched.takeDue(us(19999)).empty());
+        due = sched.takeDue(us(20000));
+        QCOMPARE(due.size(), static_cast<size_t>(1));
+        QCOMPARE(due[0].pinId, static_cast<uint8_t>(4));
+        QVERIFY(!sched.nextDeadline().has_value());
+    }
+
+    void overlappingPulsesMerge()
+    {
+        PulseScheduler sched;
+        sched.schedulePulseEnd(1, false, us(30000));
+        sched.schedulePulseEnd(1, false, us(35000));
+        sched.schedulePulseEnd(1, false, us(32000));
+        QCOMPARE(sched.pendingCount(), static_cast<size_t>(1));
+
+        QVERIFY(sched.takeDue(us(34999)).empty());
+        const auto due = sched.takeDue(us(35000));
+        QCOMPARE(due.size(), static_cast<size_t>(1));
+        QCOMPARE(due[0].deadline, us(35000));
+    }
+
+    void cancelledIsDropped()
+    {
+        PulseScheduler sched;
+        sched.schedulePulseEnd(2, false, us(4000));
+        QVERIFY(sched.cancel(2));
+        QVERIFY(!sched.cancel(2));
+        QVERIFY(!sched.isPending(2));
+        QVERIFY(sched.takeDue(us(50000)).empty());
+    }
+
+    void overdueIsTakenNext()
+    {
+        PulseScheduler sched;
+        QVERIFY(sched.takeDue(us(100000)).empty());
+        sched.schedulePulseEnd(6, false, us(5000));
+        QCOMPARE(sched.takeDue(us(100001)).size(), static_cast<size_t>(1));
+    }
+
+    void matchesReference()
+    {
+        // random schedule, cancel and expire operations compared to a trivial implementation
+        PulseScheduler sched(us(500), 64);
+        std::map<uint8_t, int64_t> ref;
+        std::mt19937 rng(1);
+        int64_t now = 0;
+
+        for (int i = 0; i < 100000; i++) {
+            const auto op = rng() % 4;
+            const auto pin = static_cast<uint8_t>(rng() % 20);
+            if (op < 2) {
+                const int64_t deadline = now + static_cast<int64_t>(rng() % 60000) - 500;
+                sched.schedulePulseEnd(pin, false, us(deadline));
+                auto it = ref.find(pin);
+                if (it == ref.end() || it->second < deadline)
+                    ref[pin] = deadline;
+            } else if (op == 2) {
+                sched.cancel(pin);
+                ref.erase(pin);
+            } else {
+                now += rng() % 3000;
+                const auto due = sched.takeDue(us(now));
+                size_t expected = 0;
+                for (auto it = ref.begin(); it != ref.end();) {
+                    if (it->second <= now) {
+                        expected++;
+                        it = ref.erase(it);
+                    } else {
+                        ++it;
+                    }
+                }
+                QCOMPARE(due.size(), expected);
+                for (size_t j = 0; j < due.size(); j++) {
+                    QVERIFY(due[j].deadline <= us(now));
+                    if (j > 0)
+                        QVERIFY(due[j - 1].deadline <= due[j].deadline);
+                }
+            }
+            QCOMPARE(sched.pendingCount(), ref.size());
+        }
+    }
+};
+
+QTEST_MAIN(TestPulseScheduler)
+#include "test-pulsescheduler.moc"
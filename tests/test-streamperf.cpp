@@ -255,6 +255,96 @@ private slots:
                 t.join();
         }
     }
+
+    void runSpinWait()
+    {
+        Barrier barrier(2);
+        std::shared_ptr<DataStream<MyDataFrame>> stream(new DataStream<MyDataFrame>());
+        auto sub = stream->subscribe();
+        sub->setWaitStrategy(SubscriptionWaitStrategy::SPIN_THEN_BLOCK);
+        QCOMPARE(sub->waitStrategy(), SubscriptionWaitStrategy::SPIN_THEN_BLOCK);
+        stream->start();
+
+        // produce at a steady 2kHz, so the subscription can learn when to expect data
+        std::thread producer([&]() {
+            barrier.wait();
+            auto nextPush = symaster_clock::now();
+            for (size_t i = 1; i <= 500; ++i) {
+                nextPush += microseconds_t(500);
+                std::this_thread::sleep_until(nextPush);
+                MyDataFrame data;
+                data.id = i;
+                stream->push(data);
+            }
+            stream->terminate();
+        });
+
+        size_t lastId = 0;
+        barrier.wait();
+        while (true) {
+            auto data = sub->next();
+            if (!data.has_value())
+                break;
+            QCOMPARE(data->id, lastId + 1);
+            lastId = data->id;
+        }
+        producer.join();
+        QCOMPARE(lastId, static_cast<size_t>(500));
+
+        const auto stats = sub->waitLatencyStats();
+        std::cout << "Spin-wait latency: p50=" << stats.p50Usec << "µs p99=" << stats.p99Usec
+                  << "µs max=" << stats.maxUsec << "µs (spin: " << stats.spinWakeups
+                  << ", yield: " << stats.yieldWakeups << ", block: " << stats.blockWakeups << ")" << std::endl;
+        QVERIFY(stats.count > 0);
+        QCOMPARE(stats.spinWakeups + stats.yieldWakeups + stats.blockWakeups, stats.count);
+        QVERIFY(stats.intervalUsec > 250 && stats.intervalUsec < 1000);
+        QVERIFY(stats.p50Usec <= stats.p99Usec && stats.p99Usec <= stats.maxUsec);
+    }
+
+    void runPendingBytes()
+    {
+        std::shared_ptr<DataStream<MyDataFrame>> stream(new DataStream<MyDataFrame>());
+        auto sub = stream->subscribe();
+        stream->start();
+
+        // our test type can not tell its size, so it is accounted with the size of its struct
+        const auto elementSize = static_cast<int64_t>(sizeof(MyDataFrame));
+        for (size_t i = 0; i < 10; ++i) {
+            MyDataFrame data;
+            data.id = i;
+            stream->push(data);
+        }
+        QCOMPARE(sub->approxPendingBytes(), 10 * elementSize);
+
+        for (size_t i = 0; i < 4; ++i)
+            QVERIFY(sub->peekNext().has_value());
+        QCOMPARE(sub->approxPendingBytes(), 6 * elementSize);
+        QCOMPARE(sub->peakPendingBytes(), 10 * elementSize);
+
+        sub->clearPending();
+        QCOMPARE(sub->approxPendingBytes(), static_cast<int64_t>(0));
+
+        // restricting the rate never loosens an existing throttle
+        sub->restrictItemsPerSec(10);
+        QCOMPARE(sub->throttleValue(), 100000U);
+        sub->restrictItemsPerSec(1000);
+        QCOMPARE(sub->throttleValue(), 100000U);
+
+        const auto droppedBefore = sub->droppedCount();
+        for (size_t i = 0; i < 5; ++i)
+            stream->push(MyDataFrame());
+        QVERIFY(sub->droppedCount() - droppedBefore >= 4);
+
+        // lifting the restriction keeps the subscriber's own throttle
+        sub->setThrottleItemsPerSec(100);
+        QCOMPARE(sub->throttleValue(), 100000U);
+        sub->clearItemsPerSecRestriction();
+        QCOMPARE(sub->throttleValue(), 10000U);
+        sub->setThrottleItemsPerSec(0);
+        QCOMPARE(sub->throttleValue(), 0U);
+
+        stream->terminate();
+    }
 };
 
 QTEST_MAIN(TestStreamPerf)
@@ -0,0 +1,107 @@
+#include <QDebug>
+#include <QThread>
+#include <QtTest>
+
+#include "moduleapi.h"
+#include "threadsched.h"
+
+using namespace Syntalos;
+
+class PeriodicTestModule : public AbstractModule
+{
+public:
+    using AbstractModule::beginPeriodicCycle;
+    using AbstractModule::endPeriodicCycle;
+    using AbstractModule::periodicThreadStats;
+    using AbstractModule::setPeriodicTiming;
+
+    explicit PeriodicTestModule(QObject *parent = nullptr)
+        : AbstractModule(parent)
+    {
+    }
+
+    bool prepare(const TestSubject &) override
+    {
+        return true;
+    }
+};
+
+class TestThreadSched : public QObject
+{
+    Q_OBJECT
+private slots:
+    void timingValidity()
+    {
+        PeriodicThreadTiming timing;
+        QVERIFY(!timing.isValid());
+
+        // the deadline defaults to the period
+        timing.period = microseconds_t(1000);
+        timing.runtime = microseconds_t(200);
+        QVERIFY(timing.isValid());
+        QCOMPARE(timing.effectiveDeadline(), microseconds_t(1000));
+        QCOMPARE(timing.utilization(), 0.2);
+
+        timing.deadline = microseconds_t(100);
+        QVERIFY(!timing.isValid());
+        timing.deadline = microseconds_t(2000);
+        QVERIFY(!timing.isValid());
+    }
+
+    void admission()
+    {
+        const PeriodicThreadTiming camera{microseconds_t(10000), microseconds_t(2500), microseconds_t(0)};
+        const PeriodicThreadTiming daq{microseconds_t(1000), microseconds_t(600), microseconds_t(800)};
+        std::vector<PeriodicThreadRequest> requests = {
+            {QStringLiteral("Camera"), camera},
+            {QStringLiteral("DAQ"),    daq   },
+        };
+        QVERIFY(periodicThreadsFit(requests, 0.95));
+        QVERIFY(periodicThreadsFit(requests, 1.9));
+
+        QString error;
+        requests.push_back({QStringLiteral("Camera 2"), camera});
+        QVERIFY(!periodicThreadsFit(requests, 0.95, &error));
+        QVERIFY(error.contains(QStringLiteral("Camera 2")));
+        QVERIFY(periodicThreadsFit(requests, 1.9));
+
+        // impossible timings are rejected no matter how much CPU time we have
+        requests.push_back({QStringLiteral("Broken"), {microseconds_t(1000), microseconds_t(2000), microseconds_t(0)}});
+        QVERIFY(!periodicThreadsFit(requests, 64, &error));
+        QVERIFY(error.contains(QStringLiteral("Broken")));
+
+        QVERIFY(availableRealtimeBandwidth() > 0);
+    }
+
+    void missedDeadlines()
+    {
+        PeriodicTestModule mod;
+        mod.setPeriodicTiming({microseconds_t(50000), microseconds_t(5000), microseconds_t(10000)});
+
+        mod.beginPeriodicCycle();
+        mod.endPeriodicCycle();
+
+        mod.beginPeriodicCycle();
+        QThread::msleep(20);
+        mod.endPeriodicCycle();
+
+        // ending a cycle that was never started is ignored
+        mod.endPeriodicCycle();
+
+        const auto stats = mod.periodicThreadStats();
+        QCOMPARE(stats.cycles, static_cast<uint64_t>(2));
+        QCOMPARE(stats.missedDeadlines, static_cast<uint64_t>(1));
+        QVERIFY(stats.maxCycleTime >= microseconds_t(20000));
+        QCOMPARE(stats.p99CycleTime, stats.maxCycleTime);
+
+        // a single slow cycle does not move the percentile
+        for (int i = 0; i < 300; i++) {
+            mod.beginPeriodicCycle();
+            mod.endPeriodicCycle();
+        }
+        QVERIFY(mod.periodicThreadStats().p99CycleTime < microseconds_t(5000));
+    }
+};
+
+QTEST_MAIN(TestThreadSched)
+#include "test-threadsched.moc"
@@ -0,0 +1,146 @@
+#include <QDebug>
+#include <QtTest>
+#include <opencv2/imgproc.hpp>
+
+#include "ledkernel.h"
+
+/**
+ * Reference implementation, this is how the TriLED tracker used to
+ * find each LED before the fused detection kernel existed.
+ */
+static cv::Point findMaxColorBrightnessRef(
+    const cv::Mat &image,
+    const cv::Mat &imageGray,
+    cv::Scalar minColors,
+    cv::Scalar maxColors)
+{
+    double maxVal;
+    cv::Point maxLoc;
+    cv::Mat colorMaskMat;
+    cv::Mat colorMat;
+
+    cv::inRange(image, minColors, maxColors, colorMaskMat);
+    cv::morphologyEx(colorMaskMat, colorMaskMat, cv::MORPH_CLOSE, cv::Mat::ones(6, 6, colorMaskMat.type()));
+
+    imageGray.copyTo(colorMat, colorMaskMat);
+    cv::minMaxLoc(colorMat, nullptr, &maxVal, nullptr, &maxLoc, cv::Mat());
+    if (((maxLoc.x == 0) && (maxLoc.y == 0)) && (maxVal == 0)) {
+        maxLoc.x = -1;
+        maxLoc.y = -1;
+    }
+
+    return maxLoc;
+}
+
+static void drawLed(cv::Mat &frame, const cv::Point &pos, const cv::Scalar &color)
+{
+    // colored halo with an overexposed center, like a real LED seen by a camera
+    cv::circle(frame, pos, 9, color, -1);
+    cv::circle(frame, pos, 3, cv::Scalar(250, 250, 250), -1);
+}
+
+static cv::Mat createTestFrame(int width, int height, const cv::Point &offset, int seed)
+{
+    cv::Mat frame(height, width, CV_8UC3);
+    cv::RNG rng(seed);
+    rng.fill(frame, cv::RNG::UNIFORM, cv::Scalar(0, 0, 0), cv::Scalar(90, 90, 90));
+
+    // sprinkle some single-pixel noise that falls into the LED color ranges
+    for (int i = 0; i < 200; i++) {
+        const cv::Point pos(rng.uniform(0, width), rng.uniform(0, height));
+        frame.at<cv::Vec3b>(pos) = cv::Vec3b(20, 20, static_cast<uchar>(rng.uniform(180, 256)));
+    }
+
+    drawLed(frame, cv::Point(width / 2, height / 2) + offset, cv::Scalar(20, 20, 230));
+    drawLed(frame, cv::Point(width / 2 + 40, height / 2) + offset, cv::Scalar(50, 240, 100));
+    drawLed(frame, cv::Point(width / 2 + 20, height / 2 + 35) + offset, cv::Scalar(230, 120, 30));
+
+    return frame;
+}
+
+class TestTriLedKernel : public QObject
+{
+    Q_OBJECT
+private slots:
+
+    void fullFrameMatchesReference()
+    {
+        LedDetector detector;
+        std::array<cv::Point, 3> positions;
+
+        for (int i = 0; i < 8; i++) {
+            const auto frame = createTestFrame(640, 480, cv::Point(i * 13, i * -7), i);
+            detector.detect(frame, positions);
+
+            cv::Mat gray;
+            cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+            QVERIFY(cv::norm(gray, detector.grayFrame(), cv::NORM_INF) == 0);
+
+            QCOMPARE(
+                positions[LedDetector::LedRed],
+                findMaxColorBrightnessRef(frame, gray, cv::Scalar(0, 0, 180), cv::Scalar(80, 80, 255)));
+            QCOMPARE(
+                positions[LedDetector::LedGreen],
+                findMaxColorBrightnessRef(frame, gray, cv::Scalar(0, 220, 0), cv::Scalar(110, 255, 180)));
+            QCOMPARE(
+                positions[LedDetector::LedBlue],
+                findMaxColorBrightnessRef(frame, gray, cv::Scalar(210, 0, 0), cv::Scalar(255, 240, 70)));
+        }
+    }
+
+    void lostLedsFallBackToFullFrame()
+    {
+        LedDetector detector;
+        detector.setSearchRadius(32);
+        std::array<cv::Point, 3> positions;
+
+        // find the LEDs once, then move them far away so the search area misses them
+        detector.detect(createTestFrame(640, 480, cv::Point(-200, -150), 1), positions);
+        QVERIFY(positions[LedDetector::LedGreen].x >= 0);
+
+        const auto frame = createTestFrame(640, 480, cv::Point(200, 150), 2);
+        detector.detect(frame, positions);
+
+        cv::Mat gray;
+        cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+        QCOMPARE(
+            positions[LedDetector::LedGreen],
+            findMaxColorBrightnessRef(frame, gray, cv::Scalar(0, 220, 0), cv::Scalar(110, 255, 180)));
+    }
+
+    void benchmarkReference()
+    {
+        const auto frame = createTestFrame(1920, 1200, cv::Point(0, 0), 1);
+        QBENCHMARK {
+            cv::Mat gray;
+            cv::cvtColor(frame, gray, cv::COLOR_BGR2GRAY);
+            findMaxColorBrightnessRef(frame, gray, cv::Scalar(0, 0, 180), cv::Scalar(80, 80, 255));
+            findMaxColorBrightnessRef(frame, gray, cv::Scalar(0, 220, 0), cv::Scalar(110, 255, 180));
+            findMaxColorBrightnessRef(frame, gray, cv::Scalar(210, 0, 0), cv::Scalar(255, 240, 70));
+        }
+    }
+
+    void benchmarkFullFrame()
+    {
+        const auto frame = createTestFrame(1920, 1200, cv::Point(0, 0), 1);
+        LedDetector detector;
+        std::array<cv::Point, 3> positions;
+        QBENCHMARK {
+            detector.detect(frame, positions);
+        }
+    }
+
+    void benchmarkSearchRadius()
+    {
+        const auto frame = createTestFrame(1920, 1200, cv::Point(0, 0), 1);
+        LedDetector detector;
+        detector.setSearchRadius(96);
+        std::array<cv::Point, 3> positions;
+        QBENCHMARK {
+            detector.detect(frame, positions);
+        }
+    }
+};
+
+QTEST_MAIN(TestTriLedKernel)
+#include "test-triledkernel.moc"
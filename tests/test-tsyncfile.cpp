@@ -2,6 +2,7 @@
 #include <QDebug>
 #include <QtTest>
 #include <iostream>
+#include <random>
 
 #include "datactl/syclock.h"
 #include "datactl/timesync.h"
@@ -14,7 +15,11 @@ class TestTSyncFile : public QObject
     Q_OBJECT
 private slots:
 
-    void tsyncFileRWForDTypes(TSyncFileDataType dt1, TSyncFileDataType dt2, int values_n = 142000)
+    void tsyncFileRWForDTypes(
+        TSyncFileDataType dt1,
+        TSyncFileDataType dt2,
+        int values_n = 142000,
+        TSyncFileEncoding encoding = TSyncFileEncoding::RAW)
     {
         auto tsFilename = QStringLiteral("/tmp/tstest-%1").arg(createRandomString(8));
 
@@ -22,6 +27,7 @@ private slots:
         auto tswriter = new TimeSyncFileWriter;
         tswriter->setFileName(tsFilename);
         tswriter->setTimeDataTypes(dt1, dt2);
+        tswriter->setEncoding(encoding);
         auto ret = tswriter->open(
             QStringLiteral("UnittestDummyModule"), QUuid("a12975f1-84b7-4350-8683-7a5fe9ed968f"), microseconds_t(1500));
         QVERIFY2(ret, qPrintable(tswriter->lastError()));
@@ -47,6 +53,7 @@ private slots:
         QCOMPARE(tsreader->tolerance().count(), 1500);
         QCOMPARE(tsreader->timeDTypes(), qMakePair(dt1, dt2));
         QCOMPARE(tsreader->syncMode(), TSyncFileMode::CONTINUOUS);
+        QCOMPARE(tsreader->encoding(), encoding);
 
         const auto timesRead = tsreader->times();
         QCOMPARE((int)timesRead.size(), values_n);
@@ -83,6 +90,146 @@ private slots:
         tsyncFileRWForDTypes(TSyncFileDataType::UINT32, TSyncFileDataType::UINT64);
     }
 
+    void runTestTSyncDeltaInt32_UInt64()
+    {
+        tsyncFileRWForDTypes(TSyncFileDataType::INT32, TSyncFileDataType::UINT64, 142000, TSyncFileEncoding::DELTA);
+    }
+
+    void runTestTSyncDeltaUInt64_UInt64()
+    {
+        tsyncFileRWForDTypes(TSyncFileDataType::UINT64, TSyncFileDataType::UINT64, 142000, TSyncFileEncoding::DELTA);
+    }
+
+    void runTestTSyncDeltaDamagedBlock()
+    {
+        const auto tsFilename = QStringLiteral("/tmp/tstest-%1").arg(createRandomString(8));
+        const int blockSize = 100;
+        const int values_n = 1000;
+
+        auto tswriter = new TimeSyncFileWriter;
+        tswriter->setFileName(tsFilename);
+        tswriter->setTimeDataTypes(TSyncFileDataType::INT32, TSyncFileDataType::UINT64);
+        tswriter->setEncoding(TSyncFileEncoding::DELTA);
+        tswriter->setChunkSize(blockSize);
+        QVERIFY2(
+            tswriter->open(QStringLiteral("UnittestDummyModule"), QUuid::createUuid()),
+            qPrintable(tswriter->lastError()));
+        for (int i = 0; i < values_n; ++i)
+            tswriter->writeTimes(microseconds_t(i * 1000), microseconds_t(i * 1000 + i * 51));
+        delete tswriter;
+
+        // overwrite some values in the second data block with an overlong varint
+        QFile file(tsFilename + QStringLiteral(".tsync"));
+        QVERIFY(file.open(QIODevice::ReadWrite));
+        auto data = file.readAll();
+        const QByteArray blockTerm("\x00\x00\x00\x00\x00\x00\x26\x11", 8);
+        const auto headerEnd = data.indexOf(blockTerm);
+        const auto firstBlockEnd = data.indexOf(blockTerm, headerEnd + 16);
+        QVERIFY(headerEnd > 0 && firstBlockEnd > headerEnd);
+        data.replace(firstBlockEnd + 16 + 20, 12, QByteArray(12, '\xFF'));
+        file.seek(0);
+        file.write(data);
+        file.close();
+
+        TimeSyncFileReader tsreader;
+        QVERIFY2(tsreader.open(file.fileName()), qPrintable(tsreader.lastError()));
+        file.remove();
+
+        // only the damaged block is missing
+        const auto timesRead = tsreader.times();
+        QCOMPARE((int)timesRead.size(), values_n - blockSize);
+        for (size_t i = 0; i < timesRead.size(); ++i) {
+            const long idx = (long)i < blockSize ? (long)i : (long)i + blockSize;
+            QCOMPARE(timesRead[i].first, idx * 1000);
+            QCOMPARE(timesRead[i].second, idx * 1000 + idx * 51);
+        }
+    }
+
+    /**
+     * Write the given times with @p encoding, read them back and return the file size.
+     */
+    qint64 writeReadTimes(
+        const std::vector<std::pair<long long, long long>> &times,
+        TSyncFileDataType dt1,
+        TSyncFileDataType dt2,
+        TSyncFileEncoding encoding,
+        qint64 *writeUsec)
+    {
+        const auto tsFilename = QStringLiteral("/tmp/tstest-%1").arg(createRandomString(8));
+
+        auto tswriter = new TimeSyncFileWriter;
+        tswriter->setFileName(tsFilename);
+        tswriter->setTimeDataTypes(dt1, dt2);
+        tswriter->setEncoding(encoding);
+        if (!tswriter->open(QStringLiteral("UnittestDummyModule"), QUuid::createUuid()))
+            qFatal("Unable to open tsync file: %s", qPrintable(tswriter->lastError()));
+
+        QElapsedTimer timer;
+        timer.start();
+        for (const auto &pair : times)
+            tswriter->writeTimes((long)pair.first, (long)pair.second);
+        delete tswriter;
+        *writeUsec = timer.nsecsElapsed() / 1000;
+
+        QFile file(tsFilename + QStringLiteral(".tsync"));
+        const auto size = file.size();
+
+        TimeSyncFileReader tsreader;
+        if (!tsreader.open(file.fileName()))
+            qFatal("Unable to read tsync file: %s", qPrintable(tsreader.lastError()));
+        file.remove();
+
+        if (tsreader.encoding() != encoding || tsreader.times() != times)
+            return -1;
+        return size;
+    }
+
+    void compareEncodings(
+        const QString &name,
+        const std::vector<std::pair<long long, long long>> &times,
+        TSyncFileDataType dt1,
+        TSyncFileDataType dt2)
+    {
+        qint64 rawUsec, deltaUsec;
+        const auto rawSize = writeReadTimes(times, dt1, dt2, TSyncFileEncoding::RAW, &rawUsec);
+        const auto deltaSize = writeReadTimes(times, dt1, dt2, TSyncFileEncoding::DELTA, &deltaUsec);
+        QVERIFY2(rawSize > 0, "Raw times were not read back correctly");
+        QVERIFY2(deltaSize > 0, "Delta-encoded times were not read back correctly");
+
+        qDebug().noquote().nospace() << name << ": raw " << rawSize << " bytes in " << rawUsec << " µs, delta "
+                                     << deltaSize << " bytes in " << deltaUsec << " µs ("
+                                     << QString::number(100.0 * deltaSize / rawSize, 'f', 1) << "%)";
+        QVERIFY(deltaSize * 2 < rawSize);
+    }
+
+    void runEncodingComparison()
+    {
+        std::mt19937 gen(42);
+
+        // one hour of a 30 fps camera: frame index and master time with a few µs of
+        // scheduling jitter and the occasional dropped frame
+        std::vector<std::pair<long long, long long>> cameraTimes;
+        std::normal_distribution<double> jitter(0, 80);
+        std::uniform_int_distribution<int> drop(0, 999);
+        long long masterTime = 1200;
+        for (long long i = 0; i < 30 * 60 * 60; i++) {
+            masterTime += 33333 + (drop(gen) == 0 ? 33333 : 0);
+            cameraTimes.push_back(std::make_pair(i, masterTime + (long long)jitter(gen)));
+        }
+
+        // sync points of an acquisition device: device time and master time, with
+        // a negative start offset and the device clock slowly drifting
+        std::vector<std::pair<long long, long long>> deviceTimes;
+        std::uniform_int_distribution<int> offset(-40, 40);
+        for (long long i = 0; i < 100000; i++) {
+            const auto deviceTime = i * 1000 - 25000;
+            deviceTimes.push_back(std::make_pair(deviceTime, deviceTime + (i / 97) + offset(gen)));
+        }
+
+        compareEncodings("camera", cameraTimes, TSyncFileDataType::UINT32, TSyncFileDataType::UINT64);
+        compareEncodings("device", deviceTimes, TSyncFileDataType::INT64, TSyncFileDataType::INT64);
+    }
+
     void runBenchmark()
     {
         QBENCHMARK {
@@ -0,0 +1,120 @@
+#include <QDebug>
+#include <QtTest>
+#include <opencv2/imgproc.hpp>
+
+#include "datactl/vipsutils.h"
+
+static cv::Mat createColorMat(int width, int height, int type)
+{
+    cv::Mat mat(height, width, type);
+    cv::RNG rng(42);
+    rng.fill(mat, cv::RNG::UNIFORM, cv::Scalar::all(0), cv::Scalar::all(256));
+    return mat;
+}
+
+static std::vector<uchar> vipsPixels(vips::VImage image)
+{
+    size_t size;
+    auto data = static_cast<uchar *>(image.write_to_memory(&size));
+    std::vector<uchar> pixels(data, data + size);
+    g_free(data);
+    return pixels;
+}
+
+class TestVipsUtils : public QObject
+{
+    Q_OBJECT
+private slots:
+    void initTestCase()
+    {
+        QVERIFY(VIPS_INIT("test-vipsutils") == 0);
+    }
+
+    void grayIsShared()
+    {
+        auto mat = createColorMat(203, 117, CV_8UC1);
+        const auto image = cvMatToVips(mat);
+        QCOMPARE(image.width(), 203);
+        QCOMPARE(image.height(), 117);
+        QCOMPARE(image.bands(), 1);
+
+        // the image wraps the Mat's buffer and holds a reference on it
+        QVERIFY(cvMatIsShared(mat));
+        QCOMPARE(static_cast<const void *>(image.data()), static_cast<const void *>(mat.data));
+    }
+
+    void colorIsSwappedLazily()
+    {
+        const auto mat = createColorMat(64, 48, CV_8UC3);
+        const auto orig = mat.clone();
+        const auto image = cvMatToVips(mat);
+        QCOMPARE(image.bands(), 3);
+        QCOMPARE(image.interpretation(), VIPS_INTERPRETATION_RGB);
+
+        cv::Mat rgb;
+        cv::cvtColor(mat, rgb, cv::COLOR_BGR2RGB);
+        QVERIFY(vipsPixels(image) == std::vector<uchar>(rgb.datastart, rgb.dataend));
+
+        // the original BGR data was not touched
+        QCOMPARE(cv::norm(mat, orig, cv::NORM_INF), 0.0);
+    }
+
+    void roundTripReturnsOriginal()
+    {
+        const auto mat = createColorMat(64, 48, CV_8UC4);
+        const auto result = vipsToCvMat(cvMatToVips(mat));
+        QCOMPARE(static_cast<const void *>(result.data), static_cast<const void *>(mat.data));
+        QCOMPARE(result.type(), CV_8UC4);
+    }
+
+    void nonContinuousIsCopied()
+    {
+        const auto mat = createColorMat(64, 48, CV_8UC3);
+        const auto roi = mat(cv::Rect(3, 5, 31, 17));
+        QVERIFY(!roi.isContinuous());
+
+        const auto image = cvMatToVips(roi);
+        QCOMPARE(image.width(), 31);
+        QCOMPARE(image.height(), 17);
+
+        cv::Mat rgb;
+        cv::cvtColor(roi, rgb, cv::COLOR_BGR2RGB);
+        QVERIFY(vipsPixels(image) == std::vector<uchar>(rgb.datastart, rgb.dataend));
+    }
+
+    void vipsImageToBgr()
+    {
+        // an image which did not originate from OpenCV, in RGB order
+        const auto mat = createColorMat(203, 117, CV_8UC3);
+        cv::Mat rgb;
+        cv::cvtColor(mat, rgb, cv::COLOR_BGR2RGB);
+        const auto image = vips::VImage::new_from_memory_copy(
+            rgb.data, rgb.total() * rgb.elemSize(), rgb.cols, rgb.rows, 3, VIPS_FORMAT_UCHAR);
+
+        const auto result = vipsToCvMat(image);
+        QCOMPARE(result.cols, 203);
+        QCOMPARE(result.rows, 117);
+        QCOMPARE(cv::norm(result, mat, cv::NORM_INF), 0.0);
+
+        // the Mat keeps the image data alive on its own
+        const auto copy = result;
+        QVERIFY(cvMatIsShared(copy));
+    }
+
+    void vipsGrayIsWrapped()
+    {
+        const auto mat = createColorMat(64, 48, CV_8UC1);
+        auto image = vips::VImage::new_from_memory_copy(
+            mat.data, mat.total() * mat.elemSize(), mat.cols, mat.rows, 1, VIPS_FORMAT_UCHAR);
+
+        cv::Mat result = vipsToCvMat(image);
+        QCOMPARE(static_cast<const void *>(result.data), image.data());
+
+        // the image stays valid after we dropped our own reference
+        image = vips::VImage();
+        QCOMPARE(cv::norm(result, mat, cv::NORM_INF), 0.0);
+    }
+};
+
+QTEST_MAIN(TestVipsUtils)
+#include "test-vipsutils.moc"
@@ -41,6 +41,7 @@ int displayTSyncMetadata(const QString &fname)
               << "CollectionID: " << tsr->collectionId().toString(QUuid::WithoutBraces).toStdString() << "\n"
               << "CreationTimestampUnix: " << tsr->creationTime() << "\n"
               << "Mode: " << tsyncFileModeToString(tsr->syncMode()).toStdString() << "\n"
+              << "Encoding: " << tsyncFileEncodingToString(tsr->encoding()).toStdString() << "\n"
               << "TimeDTypes: " << tsyncFileDataTypeToString(tsr->timeDTypes().first).toStdString() << "; "
               << tsyncFileDataTypeToString(tsr->timeDTypes().second).toStdString() << "\n"
               << "TimeUnits: " << tsyncFileTimeUnitToString(tsr->timeUnits().first).toStdString() << "; "